@@ -128,9 +128,84 @@ namespace AssetStudio
 
     public class ImportedSubmesh
     {
-        public List<ImportedVertex> VertexList { get; set; }
-        public List<ImportedFace> FaceList { get; set; }
+        private List<ImportedVertex> vertexList;
+        private List<ImportedFace> faceList;
+
+        //Built from the packed streams on first read when only they were set
+        public List<ImportedVertex> VertexList
+        {
+            get
+            {
+                if (vertexList == null && Positions != null)
+                {
+                    vertexList = UnpackVertices();
+                }
+                return vertexList;
+            }
+            set => vertexList = value;
+        }
+        public int[] Indices { get; set; } //three per triangle, used by the exporter instead of FaceList when set
+        //Built from Indices on first read when only Indices was set
+        public List<ImportedFace> FaceList
+        {
+            get
+            {
+                if (faceList == null && Indices != null)
+                {
+                    faceList = new List<ImportedFace>(Indices.Length / 3);
+                    for (int i = 0; i + 2 < Indices.Length; i += 3)
+                    {
+                        faceList.Add(new ImportedFace { VertexIndices = new[] { Indices[i], Indices[i + 1], Indices[i + 2] } });
+                    }
+                }
+                return faceList;
+            }
+            set => faceList = value;
+        }
         public string Material { get; set; }
+        //Packed vertex streams, used by the exporter instead of VertexList when Positions is set.
+        //Weights and BoneIndices are optional, without them the skin is read from VertexList.
+        public float[] Positions { get; set; } //xyz
+        public float[] Normals { get; set; } //xyz
+        public float[] UV0 { get; set; } //uv
+        public float[] Tangents { get; set; } //xyzw
+        public float[] Colours { get; set; } //rgba
+        public float[] Weights { get; set; } //four per vertex
+        public int[] BoneIndices { get; set; } //four per vertex
+
+        private List<ImportedVertex> UnpackVertices()
+        {
+            var count = Positions.Length / 3;
+            var vertices = new List<ImportedVertex>(count);
+            for (int i = 0; i < count; i++)
+            {
+                var vertex = Colours != null ? new ImportedVertexWithColour() : new ImportedVertex();
+                vertex.Position = new Vector3(Positions[i * 3], Positions[i * 3 + 1], Positions[i * 3 + 2]);
+                if (Normals != null)
+                {
+                    vertex.Normal = new Vector3(Normals[i * 3], Normals[i * 3 + 1], Normals[i * 3 + 2]);
+                }
+                if (UV0 != null)
+                {
+                    vertex.UV = new[] { UV0[i * 2], UV0[i * 2 + 1] };
+                }
+                if (Tangents != null)
+                {
+                    vertex.Tangent = new Vector4(Tangents[i * 4], Tangents[i * 4 + 1], Tangents[i * 4 + 2], Tangents[i * 4 + 3]);
+                }
+                if (Colours != null)
+                {
+                    ((ImportedVertexWithColour)vertex).Colour = new Color(Colours[i * 4], Colours[i * 4 + 1], Colours[i * 4 + 2], Colours[i * 4 + 3]);
+                }
+                if (Weights != null && BoneIndices != null)
+                {
+                    vertex.Weights = new[] { Weights[i * 4], Weights[i * 4 + 1], Weights[i * 4 + 2], Weights[i * 4 + 3] };
+                    vertex.BoneIndices = new[] { BoneIndices[i * 4], BoneIndices[i * 4 + 1], BoneIndices[i * 4 + 2], BoneIndices[i * 4 + 3] };
+                }
+                vertices.Add(vertex);
+            }
+            return vertices;
+        }
     }
 
     public class ImportedVertex
@@ -239,14 +314,14 @@ namespace AssetStudio
         public string ClipName { get; set; }
         public List<Tuple<float, int, int>> Channels { get; set; }
         public List<ImportedMorphKeyframe> KeyframeList { get; set; }
-        public List<ushort> MorphedVertexIndices { get; set; }
+        public List<int> MorphedVertexIndices { get; set; }
     }
 
     public class ImportedMorphKeyframe
     {
         public string Name { get; set; }
         public List<ImportedVertex> VertexList { get; set; }
-        public List<ushort> MorphedVertexIndices { get; set; }
+        public List<int> MorphedVertexIndices { get; set; }
         public float Weight { get; set; }
     }
 
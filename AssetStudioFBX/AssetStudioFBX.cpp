@@ -1,6 +1,7 @@
 #include <fbxsdk.h>
 #include <fbxsdk/fileio/fbxiosettings.h>
 #include "AssetStudioFBX.h"
+#include "AssetStudioFBXRotation.h"
 
 namespace AssetStudio
 {
@@ -22,6 +23,17 @@ namespace AssetStudio
 		*pScene = FbxScene::Create(*pSdkManager, "");
 	}
 
+	void Fbx::InitExportSettings(FbxManager* pSdkManager)
+	{
+		IOS_REF.SetBoolProp(EXP_FBX_MATERIAL, true);
+		IOS_REF.SetBoolProp(EXP_FBX_TEXTURE, true);
+		IOS_REF.SetBoolProp(EXP_FBX_EMBEDDED, false);
+		IOS_REF.SetBoolProp(EXP_FBX_SHAPE, true);
+		IOS_REF.SetBoolProp(EXP_FBX_GOBO, true);
+		IOS_REF.SetBoolProp(EXP_FBX_ANIMATION, true);
+		IOS_REF.SetBoolProp(EXP_FBX_GLOBAL_SETTINGS, true);
+	}
+
 	Vector3 Fbx::QuaternionToEuler(Quaternion q)
 	{
 		FbxAMatrix lMatrixRot;
@@ -37,4 +49,32 @@ namespace AssetStudio
 		FbxQuaternion lQuaternion = lMatrixRot.GetQ();
 		return Quaternion((float)lQuaternion[0], (float)lQuaternion[1], (float)lQuaternion[2], (float)lQuaternion[3]);
 	}
+
+	void Fbx::QuaternionToEuler(array<Quaternion>^ q, array<Vector3>^ v, int count)
+	{
+		if (count < 0 || count > q->Length || count > v->Length)
+		{
+			throw gcnew ArgumentOutOfRangeException("count");
+		}
+		if (count > 0)
+		{
+			pin_ptr<Quaternion> pQ = &q[0];
+			pin_ptr<Vector3> pV = &v[0];
+			QuaternionsToEuler((const float*)pQ, (float*)pV, count);
+		}
+	}
+
+	void Fbx::EulerToQuaternion(array<Vector3>^ v, array<Quaternion>^ q, int count)
+	{
+		if (count < 0 || count > v->Length || count > q->Length)
+		{
+			throw gcnew ArgumentOutOfRangeException("count");
+		}
+		if (count > 0)
+		{
+			pin_ptr<Vector3> pV = &v[0];
+			pin_ptr<Quaternion> pQ = &q[0];
+			EulersToQuaternion((const float*)pV, (float*)pQ, count);
+		}
+	}
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "AssetStudioFBXScene.h"
+#include "AssetStudioFBXAnimation.h"
+
 #ifdef IOS_REF
 #undef  IOS_REF
 #define IOS_REF (*(pSdkManager->GetIOSettings()))
@@ -9,20 +12,9 @@ using namespace System;
 using namespace System::Collections::Generic;
 using namespace System::IO;
 using namespace System::Runtime::InteropServices;
-
-#define WITH_MARSHALLED_STRING(name,str,block)\
-	{ \
-		char* name; \
-		try \
-		{ \
-			name = StringToCharArray(str); \
-			block \
-		} \
-		finally \
-		{ \
-			Marshal::FreeHGlobal((IntPtr)name); \
-		} \
-	}
+using namespace System::Threading;
+using namespace System::Threading::Tasks;
+using namespace System::Collections::Concurrent;
 
 static char* FBXVersion[] =
 {
@@ -36,50 +28,456 @@ static char* FBXVersion[] =
 
 namespace AssetStudio {
 
+	struct PreparedSubmesh;
+	struct MorphShape;
+
+	//Appends the keys to the curve buffer, times in seconds and values xyz
+	void CopyKeys(List<ImportedKeyframe<Vector3>^>^ keys, SceneCurve& curve);
+	//Names and file names in the SDK are UTF-8
+	String^ Utf8ToString(const char* s);
+
+	//UTF-8 copies of the strings handed to the SDK during one export. Each distinct string is converted once,
+	//the copies live in large blocks that are all released when the arena is destroyed.
+	ref class StringArena
+	{
+	public:
+		StringArena();
+		~StringArena();
+		!StringArena();
+
+		const char* Intern(String^ s);
+
+		property int Count { int get() { return strings->Count; } }
+		property Int64 Bytes { Int64 get() { return bytes; } }
+
+	private:
+		Dictionary<String^, IntPtr>^ strings;
+		std::vector<char*>* pBlocks;
+		char* pNext;
+		int remaining;
+		Int64 bytes;
+
+		char* Allocate(int size);
+	};
+
+	ref class TextureWriter
+	{
+	public:
+		TextureWriter(int capacity, int threadCount);
+		~TextureWriter();
+
+		void Enqueue(String^ path, array<Byte>^ data);
+		void Drain();
+
+		property int FilesWritten { int get() { return filesWritten; } }
+		//Files left alone because they already held the same bytes
+		property int FilesSkipped { int get() { return filesSkipped; } }
+		property Int64 BytesWritten { Int64 get() { return bytesWritten; } }
+		property TimeSpan StallTime { TimeSpan get() { return stallTime; } }
+		//Paths of the files written or skipped so far, complete after Drain
+		property array<String^>^ Files { array<String^>^ get() { return files->ToArray(); } }
+
+	private:
+		BlockingCollection<KeyValuePair<String^, array<Byte>^>>^ queue;
+		array<Thread^>^ threads;
+		Exception^ error;
+		int filesWritten;
+		int filesSkipped;
+		Int64 bytesWritten;
+		TimeSpan stallTime;
+		ConcurrentQueue<String^>^ files;
+
+		void Run();
+		void Join();
+	};
+
+	ref class SceneIndex
+	{
+	public:
+		SceneIndex(IImported^ imported);
+
+		Dictionary<ImportedFrame^, String^>^ FramePaths;
+		Dictionary<String^, ImportedFrame^>^ FramesByPath;
+		Dictionary<String^, ImportedMesh^>^ MeshesByPath;
+		Dictionary<ImportedFrame^, ImportedMesh^>^ FrameMeshes;
+		HashSet<String^>^ BonePaths;
+
+		//Names of the frames leading to meshes and their bones, nullptr when there are no meshes
+		HashSet<String^>^ SearchHierarchy();
+
+	private:
+		IImported^ imported;
+
+		void IndexFrame(ImportedFrame^ frame, String^ parentPath);
+		void SearchHierarchy(ImportedFrame^ frame, HashSet<String^>^ exportFrames);
+	};
+
+	//Timings and counts of one export
+	public ref class ExportStatistics
+	{
+	public:
+		ExportStatistics();
+
+		//Wall time per stage in the order the stages first ran: Hierarchy, Mesh, Skin, Materials, Morphs, Animation, Write, Textures.
+		//Skin and Materials run inside the mesh stage and are not counted in Mesh.
+		property Dictionary<String^, TimeSpan>^ StageTimes;
+		property TimeSpan TotalTime;
+
+		property int Nodes;
+		property int Meshes;
+		property Int64 ControlPoints;
+		property int Clusters;
+		property int SkippedClusters;
+		property int Shapes;
+		property int Curves;
+		property Int64 Keys;
+		property int TexturesWritten;
+		property int TexturesSkipped; //already on disk with the same content
+		property List<String^>^ TextureFiles; //full paths of the textures written or skipped
+		property Int64 BytesOut; //FBX file and textures
+		//Private bytes outside the managed heap above the level at the start of the export, sampled at the end of every stage
+		property Int64 PeakNativeBytes;
+		//Largest working set of the process seen at the end of a stage or by the memory budget
+		property Int64 PeakWorkingSet;
+		property Int64 SpilledBytes; //geometry moved to a temporary file to stay under the memory budget
+		property int NodeIndexHits;
+		property int NodeIndexMisses;
+		//Submeshes attached to the geometry of an earlier identical submesh, and those that got their own
+		property int InstanceHits;
+		property int InstanceMisses;
+		//Triangles that went through the mesh optimisation stage and their simulated vertex cache misses before and after it
+		property Int64 OptimizedTriangles;
+		property Int64 CacheMissesBefore;
+		property Int64 CacheMissesAfter;
+		property Int64 WeldedVertices;
+		property double AcmrBefore { double get() { return OptimizedTriangles > 0 ? (double)CacheMissesBefore / OptimizedTriangles : 0; } }
+		property double AcmrAfter { double get() { return OptimizedTriangles > 0 ? (double)CacheMissesAfter / OptimizedTriangles : 0; } }
+
+		virtual String^ ToString() override;
+	};
+
+	//Settings of one export, each writer reads the ones it supports. The defaults match the export settings of AssetStudioGUI.
+	public ref class FbxExportOptions
+	{
+	public:
+		FbxExportOptions();
+
+		property bool EulerFilter;
+		property float FilterPrecision;
+		//A positive tolerance drops the keys of that channel that linear interpolation reproduces within it, rotation is in degrees
+		property float PositionTolerance;
+		property float RotationTolerance;
+		property float ScaleTolerance;
+		property bool AllFrames;
+		property bool AllBones;
+		property bool Skins;
+		property float BoneSize;
+		property float ScaleFactor;
+		property bool FlatInbetween;
+		property int VersionIndex;
+		property bool IsAscii; //SDK exporter only
+		//SDK exporter only, welds vertices within WeldTolerance (negative to skip) and reorders every submesh for the vertex cache
+		property bool OptimizeMeshes;
+		property float WeldTolerance;
+		//A positive budget in bytes releases the source data of the imported model as it is exported, see MemoryBudget
+		property Int64 MemoryBudget;
+		property String^ TracePath; //SDK exporter only, nullptr or the path of a Chrome trace-event file
+	};
+
+	//Keeps an export under a working set budget by releasing IImported source data once it is committed to the scene or file.
+	//Released data is gone for good, an IImported exported with a budget cannot be exported again. A budget of 0 disables it.
+	ref class MemoryBudget
+	{
+	public:
+		MemoryBudget(Int64 bytes, ExportStatistics^ statistics);
+
+		property bool Enabled { bool get() { return bytes > 0; } }
+		//Set once the budget could not be kept even after a collection
+		property bool Exceeded { bool get() { return exceeded; } }
+
+		//Samples the working set, over budget after collecting the released data first. True if still over budget.
+		bool OverBudget();
+		void Release(ImportedSubmesh^ submesh);
+		void Release(ImportedTexture^ texture);
+		void Release(ImportedMorph^ morph);
+
+	private:
+		Int64 bytes;
+		bool exceeded;
+		ExportStatistics^ statistics;
+		Diagnostics::Process^ process;
+
+		Int64 Sample();
+	};
+
+	//Fills the stage times of ExportStatistics and, given a trace path, records Chrome trace events
+	ref class ExportProfiler
+	{
+	public:
+		ExportProfiler(ExportStatistics^ statistics, String^ tracePath);
+
+		property ExportStatistics^ Statistics { ExportStatistics^ get() { return statistics; } }
+
+		Int64 Now();
+		void AddSpan(String^ name, String^ category, Int64 start, Int64 end);
+		void AddStage(String^ stage, String^ enclosing, Int64 start, Int64 end);
+		//Sets the total time and writes the trace file
+		void Finish();
+
+	private:
+		ExportStatistics^ statistics;
+		String^ tracePath;
+		Diagnostics::Stopwatch^ stopwatch;
+		Diagnostics::Process^ process;
+		Int64 memoryBaseline;
+		Text::StringBuilder^ events;
+
+		Int64 NativeBytes();
+	};
+
+	//Times a stage or a named trace span until it is destroyed, meant for stack semantics
+	ref class ProfileScope
+	{
+	public:
+		ProfileScope(ExportProfiler^ profiler, String^ stage);
+		ProfileScope(ExportProfiler^ profiler, String^ stage, String^ enclosing);
+		ProfileScope(ExportProfiler^ profiler, String^ stage, String^ enclosing, String^ name, String^ category);
+		~ProfileScope();
+
+	private:
+		ExportProfiler^ profiler;
+		String^ stage;
+		String^ enclosing;
+		String^ name;
+		String^ category;
+		Int64 start;
+	};
+
+	//Node, mesh, shape and key counts of a built scene, as Fbx::Exporter::CollectStatistics reads them from the FbxScene
+	void CollectSceneStatistics(const Scene& scene, ExportStatistics^ statistics);
+
+	//SHA-256 of texture bytes, kept by texture deduplication for the textures a memory budget releases
+	array<Byte>^ TextureDigest(array<Byte>^ data);
+	bool SameDigest(array<Byte>^ a, array<Byte>^ b);
+
+	//Converts IImported into the SDK-independent Scene with the same frame, joint and lookup rules as Fbx::Exporter.
+	//Under a memory budget, geometry and morph data of imported are released once copied into the scene, so peak memory stays near one copy.
+	ref class SceneBuilder
+	{
+	public:
+		//With budget enabled, submeshes are spilled to a temporary file set as Scene::Spill, which the caller deletes
+		SceneBuilder(IImported^ imported, Scene* scene, TextureWriter^ textureWriter, String^ exportDir, MemoryBudget^ budget);
+
+		void Build(bool allFrames, bool allBones, bool skins, float boneSize, float scaleFactor, bool flatInbetween, const TrackFilter& filter);
+
+	private:
+		IImported^ imported;
+		Scene* scene;
+		TextureWriter^ textureWriter;
+		String^ exportDir;
+		MemoryBudget^ budget;
+		SceneIndex^ sceneIndex;
+
+		List<String^>^ framePaths;
+		List<String^>^ frameNames;
+		List<List<int>^>^ frameChildren; //in order, the root frames at 0 and the children of frame i at i + 1
+		Dictionary<String^, int>^ nodePathIndex;
+		Dictionary<String^, int>^ nodeNameIndex;
+		Dictionary<String^, int>^ meshIndex;
+		List<KeyValuePair<int, ImportedMesh^>>^ meshFrames;
+		size_t spilledMeshes;
+
+		SceneTrack* pFilteringTracks;
+		const float* pFilteringRests;
+		const TrackFilter* pTrackFilter;
+
+		Dictionary<String^, ImportedMaterial^>^ importedMaterials;
+		Dictionary<String^, ImportedTexture^>^ importedTextures;
+		Dictionary<String^, int>^ materialIndex;
+		Dictionary<String^, int>^ textureIndex;
+		Dictionary<UInt64, int>^ textureContentIndex;
+		List<ImportedTexture^>^ textureSources;
+		Dictionary<int, array<Byte>^>^ textureDigests;
+
+		void BuildFrame(ImportedFrame^ frame, int parent, HashSet<String^>^ exportFrames);
+		void IndexNames(int node);
+		int FindFrame(String^ path, bool recursive);
+		int FindChildFrame(int frame, array<String^>^ splitPath, int start);
+		void BuildMesh(int frame, ImportedMesh^ importedMesh, bool skins);
+		void SpillMeshes();
+		int BuildMaterial(String^ name);
+		int BuildTexture(String^ name);
+		void BuildMorphs(bool flatInbetween);
+		void AddShapeDeltas(ImportedMorphKeyframe^ keyframe, const SceneSubmesh& submesh, int meshVertexIndex, float sign, std::vector<int>& slots, SceneShape& shape);
+		void BuildAnimations(const TrackFilter& filter);
+		void FilterAnimationTrack(int i);
+	};
+
 	public ref class Fbx
 	{
 	public:
 		static Vector3 QuaternionToEuler(Quaternion q);
 		static Quaternion EulerToQuaternion(Vector3 v);
+		//Batch conversions, count elements of the source are converted into the destination.
+		//QuaternionToEuler uses the widest SIMD path of the processor, EulerToQuaternion is scalar.
+		static void QuaternionToEuler(array<Quaternion>^ q, array<Vector3>^ v, int count);
+		static void EulerToQuaternion(array<Vector3>^ v, array<Quaternion>^ q, int count);
 		static char* StringToCharArray(String^ s);
 		static void Init(FbxManager** pSdkManager, FbxScene** pScene);
+		//The EXP_FBX_* settings every export uses
+		static void InitExportSettings(FbxManager* pSdkManager);
+
+		ref class Session;
 
 		ref class Exporter
 		{
 		public:
-			static void Export(String^ path, IImported^ imported, bool eulerFilter, float filterPrecision, bool allFrames, bool allBones, bool skins, float boneSize, float scaleFactor, bool flatInbetween, int versionIndex, bool isAscii);
+			//optimizeMeshes reorders triangles and vertices of every submesh without blend shapes for the vertex cache,
+			//after welding vertices whose attributes match within weldTolerance. A negative weldTolerance only reorders.
+			static ExportStatistics^ Export(String^ path, IImported^ imported, FbxExportOptions^ options);
+			//SDK-free binary writer, FBX 2016 and the default version are written as 7.5, older versions as 7.4.
+			//A memory budget releases the meshes and morphs of imported as they are copied, so imported cannot be exported again,
+			//and over the budget finished geometry is also spilled to a temporary file until the file is written.
+			static ExportStatistics^ ExportBinary(String^ path, IImported^ imported, FbxExportOptions^ options);
+			//Writes the scene ExportBinary would write as a snapshot for AssetStudioFBXBatch, textures are written next to it.
+			//The output format, optimisation and version are chosen in the batch manifest instead. Releases imported like ExportBinary.
+			static ExportStatistics^ ExportSnapshot(String^ path, IImported^ imported, FbxExportOptions^ options);
 			static void ExportMorph(String^ path, IImported^ imported, bool morphMask, bool flatInbetween, bool skins, float boneSize, float scaleFactor, int versionIndex, bool isAscii);
 
+		internal:
+			//Export on the manager and scene of session, or on its own ones when session is nullptr
+			static ExportStatistics^ Export(String^ path, IImported^ imported, FbxExportOptions^ options, Session^ session);
+
 		private:
 			HashSet<String^>^ frameNames;
 			bool exportSkins;
 			float boneSize;
+			bool optimizeMeshes;
+			float weldTolerance;
 
 			IImported^ imported;
+			String^ exportDir;
 
-			char* cDest;
+			StringArena^ names;
 			FbxManager* pSdkManager;
 			FbxScene* pScene;
 			FbxExporter* pExporter;
-			FbxArray<FbxSurfacePhong*>* pMaterials;
-			FbxArray<FbxFileTexture*>* pTextures;
 			FbxArray<FbxNode*>* pMeshNodes;
+			TextureWriter^ textureWriter;
+			ExportProfiler^ profiler;
+			MemoryBudget^ budget;
+
+			Dictionary<String^, ImportedMaterial^>^ importedMaterials;
+			Dictionary<String^, ImportedTexture^>^ importedTextures;
+			Dictionary<String^, IntPtr>^ materialIndex;
+			Dictionary<String^, IntPtr>^ textureIndex;
+			Dictionary<UInt64, IntPtr>^ textureContentIndex;
+			Dictionary<IntPtr, ImportedTexture^>^ textureSources;
+			Dictionary<IntPtr, array<Byte>^>^ textureDigests;
+			Dictionary<UInt64, IntPtr>^ geometryIndex;
 
-			Exporter(String^ path, IImported^ imported, bool allFrames, bool allBones, bool skins, float boneSize, float scaleFactor, int versionIndex, bool isAscii, bool normals);
+			SceneIndex^ sceneIndex;
+			Dictionary<String^, IntPtr>^ meshNodeIndex;
+
+			ImportedMesh^ preparingMesh;
+			bool preparingNormals;
+			int preparingBoneCount;
+			bool preparingOptimize;
+			PreparedSubmesh* pPreparedSubmeshes;
+
+			List<ImportedMorphKeyframe^>^ morphKeyframes;
+			List<Tuple<float, int, int>^>^ morphChannels;
+			int morphVertexOffset;
+			int morphVertexCount;
+			MorphShape* pMorphShapes;
+
+			SceneTrack* pFilteringTracks;
+			const float* pFilteringRests;
+			const TrackFilter* pTrackFilter;
+
+			Dictionary<String^, IntPtr>^ nodePathIndex;
+			Dictionary<IntPtr, String^>^ nodePaths;
+			Dictionary<String^, IntPtr>^ nodeNameIndex;
+			Dictionary<String^, IntPtr>^ nodeLookupCache;
+			int nodeIndexHits;
+			int nodeIndexMisses;
+			int clustersCreated;
+			int clustersSkipped;
+			int instanceHits;
+			int instanceMisses;
+			Int64 optimizedTriangles;
+			Int64 cacheMissesBefore;
+			Int64 cacheMissesAfter;
+			Int64 weldedVertices;
+
+			Session^ session;
+
+			Exporter(String^ path, IImported^ imported, bool allFrames, bool allBones, bool skins, float boneSize, float scaleFactor, int versionIndex, bool isAscii, bool normals, bool optimizeMeshes, float weldTolerance, ExportProfiler^ profiler, MemoryBudget^ budget, Session^ session);
 			~Exporter();
 
 			void Exporter::LinkTexture(ImportedMaterialTexture^ texture, FbxFileTexture* pTexture, FbxProperty& prop);
 			void SetJointsNode(FbxNode* pNode, HashSet<String^>^ boneNames, bool allBones);
-			HashSet<String^>^ SearchHierarchy();
-			void SearchHierarchy(ImportedFrame^ frame, HashSet<String^>^ exportFrames);
 			void SetJointsFromImportedMeshes(bool allBones);
 			void ExportFrame(FbxNode* pParentNode, ImportedFrame^ frame);
-			void ExportMesh(FbxNode* pFrameNode, ImportedMesh^ meshList, bool normals);
+			void IndexNodeNames(FbxNode* pNode);
+			//Without skin or morphs, identical submeshes share one FbxMesh between their nodes when instancing is set.
+			//optimize runs OptimizeSubmesh on every submesh while it is prepared.
+			void ExportMesh(FbxNode* pFrameNode, ImportedMesh^ meshList, bool normals, bool instancing, bool optimize);
+			void PrepareSubmesh(int i);
 			FbxNode* FindNodeByPath(String ^ path, bool recursive);
+			FbxNode* FindChildByPath(FbxNode* pNode, array<String^>^ splitPath, int start);
+			ImportedMaterial^ FindMaterial(String^ name);
+			ImportedTexture^ FindTexture(String^ name);
+			FbxSurfacePhong* ExportMaterial(ImportedMaterial^ mat);
 			FbxFileTexture* ExportTexture(ImportedTexture^ matTex);
-			void ExportAnimations(bool eulerFilter, float filterValue, bool flatInbetween);
-			void ExportKeyframedAnimation(ImportedKeyframedAnimation^ parser, FbxString& kTakeName, FbxAnimCurveFilterUnroll* eulerFilter, float filterPrecision, bool flatInbetween);
+			void DrainTextures();
+			void CollectStatistics(String^ path, ExportStatistics^ statistics);
+			void ExportAnimations(const TrackFilter& filter, bool flatInbetween);
+			void ExportKeyframedAnimation(ImportedKeyframedAnimation^ parser, FbxString& kTakeName, const TrackFilter& filter, bool flatInbetween);
+			void FilterAnimationTrack(int i);
 			void ExportMorphs(IImported^ imported, bool morphMask, bool flatInbetween);
+			void PrepareMorphChannel(int i);
+		};
+
+		//Keeps one FbxManager with its IOSettings and one FbxScene across exports, the scene is cleared after each of them.
+		//Saves the SDK startup of Exporter::Export for every file when many small models are exported. Not thread-safe, use one session per thread.
+		ref class Session
+		{
+		public:
+			Session();
+			~Session();
+			!Session();
+
+			ExportStatistics^ Export(String^ path, IImported^ imported, FbxExportOptions^ options);
+
+			property int Exports { int get() { return exports; } }
+			//Creating the manager, its IOSettings and the scene, the part of the startup a cold export pays on every file
+			property TimeSpan ColdStartup { TimeSpan get() { return coldStartup; } }
+			//Sum of the Startup stage over the exports of this session
+			property TimeSpan WarmStartup { TimeSpan get() { return warmStartup; } }
+
+		internal:
+			FbxManager* pSdkManager;
+			FbxScene* pScene;
+
+		private:
+			int exports;
+			TimeSpan coldStartup;
+			TimeSpan warmStartup;
+		};
+	};
+
+	//Binary glTF 2.0 writer over the same SDK-independent scene as Fbx::Exporter::ExportBinary
+	public ref class Gltf
+	{
+	public:
+		ref class Exporter
+		{
+		public:
+			//Textures are written next to the .glb and referenced by URI. glTF has no unit setting, so there is no scale factor.
+			//A memory budget releases the meshes, morphs and textures of imported and spills geometry like ExportBinary.
+			//BoneSize, ScaleFactor and FlatInbetween do not apply, blend shape inbetweens stay in their channels.
+			static ExportStatistics^ Export(String^ path, IImported^ imported, FbxExportOptions^ options);
 		};
 	};
 }
@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include "AssetStudioFBXAnimation.h"
+
+namespace AssetStudio
+{
+	void SortKeys(SceneCurve& keys)
+	{
+		const int count = (int)keys.Times.size();
+		bool increasing = true;
+		for (int i = 1; i < count && increasing; i++)
+		{
+			increasing = keys.Times[i] > keys.Times[i - 1];
+		}
+		if (increasing)
+		{
+			return;
+		}
+
+		std::vector<int> order(count);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&keys](int a, int b) { return keys.Times[a] < keys.Times[b]; });
+		std::vector<float> times;
+		std::vector<float> values;
+		times.reserve(count);
+		values.reserve(count * 3);
+		for (int i = 0; i < count; i++)
+		{
+			int k = order[i];
+			if (!times.empty() && times.back() == keys.Times[k])
+			{
+				values.resize(values.size() - 3);
+				times.pop_back();
+			}
+			times.push_back(keys.Times[k]);
+			values.insert(values.end(), &keys.Values[k * 3], &keys.Values[k * 3] + 3);
+		}
+		keys.Times.swap(times);
+		keys.Values.swap(values);
+	}
+
+	void ReduceKeys(SceneCurve& keys, float tolerance, const float* rest)
+	{
+		if (tolerance <= 0 || keys.Times.empty())
+		{
+			return;
+		}
+		SortKeys(keys);
+		keys.Linear = true;
+
+		const int count = (int)keys.Times.size();
+		float* t = keys.Times.data();
+		float* v = keys.Values.data();
+
+		bool constant = true;
+		for (int i = 1; i < count && constant; i++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				constant = constant && std::fabs(v[i * 3 + c] - v[c]) <= tolerance;
+			}
+		}
+		if (constant)
+		{
+			bool atRest = rest != NULL;
+			for (int c = 0; c < 3 && atRest; c++)
+			{
+				atRest = std::fabs(v[c] - rest[c]) <= tolerance;
+			}
+			keys.Times.resize(atRest ? 0 : 1);
+			keys.Values.resize(atRest ? 0 : 3);
+			return;
+		}
+
+		//slope cone from the last kept key: a segment ending at key j is valid when its slope keeps every skipped key within tolerance
+		const float inf = std::numeric_limits<float>::infinity();
+		float lo[3] = { -inf, -inf, -inf };
+		float hi[3] = { inf, inf, inf };
+		int anchor = 0;
+		int kept = 1;
+		for (int j = 1; j < count; j++)
+		{
+			float dt = t[j] - t[anchor];
+			bool valid = true;
+			for (int c = 0; c < 3; c++)
+			{
+				float slope = (v[j * 3 + c] - v[anchor * 3 + c]) / dt;
+				valid = valid && slope >= lo[c] && slope <= hi[c];
+			}
+			if (!valid)
+			{
+				//the previous key ends the segment and anchors the next one
+				anchor = j - 1;
+				t[kept] = t[anchor];
+				std::copy(&v[anchor * 3], &v[anchor * 3] + 3, &v[kept * 3]);
+				anchor = kept++;
+				dt = t[j] - t[anchor];
+				for (int c = 0; c < 3; c++)
+				{
+					lo[c] = -inf;
+					hi[c] = inf;
+				}
+			}
+			for (int c = 0; c < 3; c++)
+			{
+				lo[c] = std::max(lo[c], (v[j * 3 + c] - tolerance - v[anchor * 3 + c]) / dt);
+				hi[c] = std::min(hi[c], (v[j * 3 + c] + tolerance - v[anchor * 3 + c]) / dt);
+			}
+		}
+		t[kept] = t[count - 1];
+		std::copy(&v[(count - 1) * 3], &v[(count - 1) * 3] + 3, &v[kept * 3]);
+		kept++;
+		keys.Times.resize(kept);
+		keys.Values.resize(kept * 3);
+	}
+
+	//Shifts every angle by whole turns to the one nearest to the previous key, returns the summed distance
+	static float NearestTurns(const float* previous, float* angles)
+	{
+		float distance = 0;
+		for (int c = 0; c < 3; c++)
+		{
+			angles[c] -= 360.0f * std::floor((angles[c] - previous[c]) / 360.0f + 0.5f);
+			distance += std::fabs(angles[c] - previous[c]);
+		}
+		return distance;
+	}
+
+	void UnrollEulers(SceneCurve& keys, float precision)
+	{
+		const int count = (int)keys.Times.size();
+		float* v = keys.Values.data();
+		for (int i = 1; i < count; i++)
+		{
+			float* previous = &v[(i - 1) * 3];
+			float* current = &v[i * 3];
+			float distance = std::fabs(current[0] - previous[0]) + std::fabs(current[1] - previous[1]) + std::fabs(current[2] - previous[2]);
+
+			//(x, y, z) and (x + 180, 180 - y, z + 180) are the same rotation, try both at the nearest turns
+			float wrapped[3] = { current[0], current[1], current[2] };
+			float flipped[3] = { current[0] + 180.0f, 180.0f - current[1], current[2] + 180.0f };
+			float wrappedDistance = NearestTurns(previous, wrapped);
+			float flippedDistance = NearestTurns(previous, flipped);
+			const float* best = flippedDistance < wrappedDistance ? flipped : wrapped;
+			float bestDistance = std::min(wrappedDistance, flippedDistance);
+			if (distance - bestDistance > precision)
+			{
+				std::copy(best, best + 3, current);
+			}
+		}
+	}
+
+	void FilterTrack(SceneTrack& track, const TrackFilter& filter, const float* rest)
+	{
+		if (filter.EulerFilter && track.Rotations.Times.size() > 1)
+		{
+			SortKeys(track.Rotations);
+			UnrollEulers(track.Rotations, filter.FilterPrecision);
+		}
+		ReduceKeys(track.Scalings, filter.Reduction.Scale, rest);
+		ReduceKeys(track.Rotations, filter.Reduction.Rotation, rest + 3);
+		ReduceKeys(track.Translations, filter.Reduction.Position, rest + 6);
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "AssetStudioFBXScene.h"
+
+namespace AssetStudio
+{
+	//Per channel tolerances of the keyframe reduction, zero keeps every key of that channel
+	struct KeyReduction
+	{
+		float Position;
+		float Rotation; //degrees
+		float Scale;
+	};
+
+	//Everything done to the keys of a track before its curves are created
+	struct TrackFilter
+	{
+		bool EulerFilter;
+		float FilterPrecision; //degrees
+		KeyReduction Reduction;
+	};
+
+	//Sorts the keys by time, for keys at the same time the last one wins
+	void SortKeys(SceneCurve& keys);
+	//Drops every key that the line between its kept neighbours reproduces within tolerance on x, y and z, in one pass.
+	//A curve that stays within tolerance of rest is cleared, any other constant curve keeps a single key.
+	//Marks the curve Linear, cubic auto tangents through the kept keys could overshoot the tolerance.
+	void ReduceKeys(SceneCurve& keys, float tolerance, const float* rest);
+	//Rewrites each euler key as the equivalent rotation closest to the key before it, like FbxAnimCurveFilterUnroll.
+	//A key is only changed when that brings it more than precision degrees closer.
+	void UnrollEulers(SceneCurve& keys, float precision);
+	//Sorts, unrolls and reduces the keys of the track. rest holds the scale, rotation and translation of the node, three floats each.
+	void FilterTrack(SceneTrack& track, const TrackFilter& filter, const float* rest);
+}
@@ -0,0 +1,531 @@
+#include <string.h>
+#include <stdexcept>
+#include "AssetStudioFBXBinaryWriter.h"
+
+#ifdef _MSC_VER
+#define FBX_FSEEK _fseeki64
+#else
+#define FBX_FSEEK fseeko
+#endif
+
+namespace AssetStudio
+{
+	static const unsigned char HeaderMagic[23] = { 'K', 'a', 'y', 'd', 'a', 'r', 'a', ' ', 'F', 'B', 'X', ' ', 'B', 'i', 'n', 'a', 'r', 'y', ' ', ' ', 0x00, 0x1a, 0x00 };
+	static const unsigned char FooterMagic[16] = { 0xf8, 0x5a, 0x8c, 0x6a, 0xde, 0xf5, 0xd9, 0x7e, 0xec, 0xe9, 0x0c, 0xe3, 0x75, 0x8f, 0x29, 0x0b };
+	//small arrays are not worth a zlib header
+	static const size_t CompressThreshold = 128;
+
+	FbxBinaryWriter::FbxBinaryWriter(const char* path, int version, bool compress)
+		: version(version), compress(compress), position(0), arrayBytes(0), compressedArrayBytes(0)
+	{
+		file = fopen(path, "wb");
+		if (file == NULL)
+		{
+			throw std::runtime_error(std::string("Failed to open ") + path);
+		}
+		setvbuf(file, NULL, _IOFBF, 1 << 20);
+
+		Write(HeaderMagic, sizeof(HeaderMagic));
+		unsigned int fileVersion = (unsigned int)version;
+		Write(&fileVersion, 4);
+	}
+
+	FbxBinaryWriter::~FbxBinaryWriter()
+	{
+		if (file != NULL)
+		{
+			fclose(file);
+		}
+	}
+
+	void FbxBinaryWriter::Write(const void* data, size_t length)
+	{
+		if (length > 0 && fwrite(data, 1, length, file) != length)
+		{
+			throw std::runtime_error("Failed to write FBX file");
+		}
+		position += (long long)length;
+	}
+
+	void FbxBinaryWriter::WriteOffset(unsigned long long value)
+	{
+		if (version >= 7500)
+		{
+			Write(&value, 8);
+		}
+		else
+		{
+			if (value > 0xFFFFFFFFULL)
+			{
+				throw std::runtime_error("FBX 7.4 files are limited to 4 GB, export as 7.5");
+			}
+			unsigned int value32 = (unsigned int)value;
+			Write(&value32, 4);
+		}
+	}
+
+	void FbxBinaryWriter::WriteNullRecord()
+	{
+		static const unsigned char zeros[25] = { 0 };
+		Write(zeros, version >= 7500 ? 25 : 13);
+	}
+
+	void FbxBinaryWriter::Patch(long long offset, unsigned long long value)
+	{
+		if (FBX_FSEEK(file, offset, SEEK_SET) != 0)
+		{
+			throw std::runtime_error("Failed to seek in FBX file");
+		}
+		long long end = position;
+		position = offset;
+		WriteOffset(value);
+		position = end;
+		if (FBX_FSEEK(file, end, SEEK_SET) != 0)
+		{
+			throw std::runtime_error("Failed to seek in FBX file");
+		}
+	}
+
+	void FbxBinaryWriter::BeginNode(const char* name)
+	{
+		CloseProperties();
+
+		size_t nameLength = strlen(name);
+		if (nameLength > 255)
+		{
+			throw std::runtime_error("FBX node name too long");
+		}
+
+		OpenNode node;
+		node.Offset = position;
+		node.NumProperties = 0;
+		node.HasChildren = false;
+		WriteOffset(0);
+		WriteOffset(0);
+		WriteOffset(0);
+		unsigned char length = (unsigned char)nameLength;
+		Write(&length, 1);
+		Write(name, nameLength);
+		node.PropertyStart = position;
+		nodes.push_back(node);
+	}
+
+	void FbxBinaryWriter::CloseProperties()
+	{
+		if (nodes.empty() || nodes.back().HasChildren)
+		{
+			return;
+		}
+
+		OpenNode& node = nodes.back();
+		int width = version >= 7500 ? 8 : 4;
+		Patch(node.Offset + width, node.NumProperties);
+		Patch(node.Offset + width * 2, (unsigned long long)(position - node.PropertyStart));
+		node.HasChildren = true;
+	}
+
+	void FbxBinaryWriter::EndNode()
+	{
+		if (nodes.empty())
+		{
+			throw std::runtime_error("EndNode without BeginNode");
+		}
+
+		//a record with children, or without properties, is terminated by a null record
+		bool sentinel = nodes.back().HasChildren || nodes.back().NumProperties == 0;
+		CloseProperties();
+		if (sentinel)
+		{
+			WriteNullRecord();
+		}
+		Patch(nodes.back().Offset, (unsigned long long)position);
+		nodes.pop_back();
+	}
+
+	void FbxBinaryWriter::BeginProperty(char type)
+	{
+		if (nodes.empty() || nodes.back().HasChildren)
+		{
+			throw std::runtime_error("FBX properties must precede child nodes");
+		}
+		nodes.back().NumProperties++;
+		Write(&type, 1);
+	}
+
+	void FbxBinaryWriter::AddBool(bool value)
+	{
+		BeginProperty('C');
+		unsigned char c = value ? 1 : 0;
+		Write(&c, 1);
+	}
+
+	void FbxBinaryWriter::AddInt16(short value)
+	{
+		BeginProperty('Y');
+		Write(&value, 2);
+	}
+
+	void FbxBinaryWriter::AddInt32(int value)
+	{
+		BeginProperty('I');
+		Write(&value, 4);
+	}
+
+	void FbxBinaryWriter::AddInt64(long long value)
+	{
+		BeginProperty('L');
+		Write(&value, 8);
+	}
+
+	void FbxBinaryWriter::AddFloat(float value)
+	{
+		BeginProperty('F');
+		Write(&value, 4);
+	}
+
+	void FbxBinaryWriter::AddDouble(double value)
+	{
+		BeginProperty('D');
+		Write(&value, 8);
+	}
+
+	void FbxBinaryWriter::AddString(const char* value)
+	{
+		AddString(std::string(value));
+	}
+
+	void FbxBinaryWriter::AddString(const std::string& value)
+	{
+		BeginProperty('S');
+		unsigned int length = (unsigned int)value.size();
+		Write(&length, 4);
+		Write(value.data(), value.size());
+	}
+
+	void FbxBinaryWriter::AddRaw(const void* data, size_t length)
+	{
+		BeginProperty('R');
+		unsigned int length32 = (unsigned int)length;
+		Write(&length32, 4);
+		Write(data, length);
+	}
+
+	void FbxBinaryWriter::AddArray(const float* data, size_t count)
+	{
+		AddArray('f', data, count, 4);
+	}
+
+	void FbxBinaryWriter::AddArray(const double* data, size_t count)
+	{
+		AddArray('d', data, count, 8);
+	}
+
+	void FbxBinaryWriter::AddArray(const int* data, size_t count)
+	{
+		AddArray('i', data, count, 4);
+	}
+
+	void FbxBinaryWriter::AddArray(const long long* data, size_t count)
+	{
+		AddArray('l', data, count, 8);
+	}
+
+	void FbxBinaryWriter::AddArray(char type, const void* data, size_t count, size_t elementSize)
+	{
+		BeginProperty(type);
+		size_t length = count * elementSize;
+		arrayBytes += length;
+
+		unsigned int header[3];
+		header[0] = (unsigned int)count;
+		if (compress && length >= CompressThreshold)
+		{
+			deflated.clear();
+			Deflate((const unsigned char*)data, length, deflated);
+			if (deflated.size() < length)
+			{
+				header[1] = 1;
+				header[2] = (unsigned int)deflated.size();
+				Write(header, sizeof(header));
+				Write(&deflated[0], deflated.size());
+				compressedArrayBytes += deflated.size();
+				return;
+			}
+		}
+
+		header[1] = 0;
+		header[2] = (unsigned int)length;
+		Write(header, sizeof(header));
+		Write(data, length);
+		compressedArrayBytes += length;
+	}
+
+	void FbxBinaryWriter::Finish(const unsigned char* footerId)
+	{
+		while (!nodes.empty())
+		{
+			EndNode();
+		}
+		WriteNullRecord();
+
+		static const unsigned char zeros[128] = { 0 };
+		Write(footerId, 16);
+		Write(zeros, 4);
+		//pad to 16 bytes, a full 16 bytes when already aligned
+		size_t padding = (size_t)(((position + 15) & ~15LL) - position);
+		Write(zeros, padding == 0 ? 16 : padding);
+		unsigned int fileVersion = (unsigned int)version;
+		Write(&fileVersion, 4);
+		Write(zeros, 120);
+		Write(FooterMagic, sizeof(FooterMagic));
+
+		if (fclose(file) != 0)
+		{
+			file = NULL;
+			throw std::runtime_error("Failed to write FBX file");
+		}
+		file = NULL;
+	}
+
+	struct DeflateBits
+	{
+		std::vector<unsigned char>& output;
+		unsigned int buffer;
+		int count;
+
+		DeflateBits(std::vector<unsigned char>& output) : output(output), buffer(0), count(0) {}
+
+		void Put(unsigned int bits, int length)
+		{
+			buffer |= bits << count;
+			count += length;
+			while (count >= 8)
+			{
+				output.push_back((unsigned char)buffer);
+				buffer >>= 8;
+				count -= 8;
+			}
+		}
+
+		void Flush()
+		{
+			if (count > 0)
+			{
+				output.push_back((unsigned char)buffer);
+			}
+			buffer = 0;
+			count = 0;
+		}
+
+	private:
+		DeflateBits& operator=(const DeflateBits&);
+	};
+
+	static const unsigned short LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static const unsigned char LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	static const unsigned short DistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	static const unsigned char DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	static const int WindowSize = 32768;
+	static const int MaxMatch = 258;
+	static const int HashBits = 15;
+
+	static unsigned int ReverseBits(unsigned int code, int length)
+	{
+		unsigned int reversed = 0;
+		for (int i = 0; i < length; i++)
+		{
+			reversed = (reversed << 1) | (code & 1);
+			code >>= 1;
+		}
+		return reversed;
+	}
+
+	static int HighestBit(unsigned int value)
+	{
+		int bit = 0;
+		while (value >>= 1)
+		{
+			bit++;
+		}
+		return bit;
+	}
+
+	//fixed Huffman codes of RFC 1951 3.2.6, stored bit-reversed for LSB-first output
+	struct FixedCodes
+	{
+		unsigned short Literal[288];
+		unsigned char LiteralLength[288];
+		unsigned char Distance[30];
+
+		FixedCodes()
+		{
+			for (int i = 0; i < 288; i++)
+			{
+				unsigned int code;
+				int length;
+				if (i < 144)
+				{
+					code = 0x30 + i;
+					length = 8;
+				}
+				else if (i < 256)
+				{
+					code = 0x190 + (i - 144);
+					length = 9;
+				}
+				else if (i < 280)
+				{
+					code = i - 256;
+					length = 7;
+				}
+				else
+				{
+					code = 0xC0 + (i - 280);
+					length = 8;
+				}
+				Literal[i] = (unsigned short)ReverseBits(code, length);
+				LiteralLength[i] = (unsigned char)length;
+			}
+			for (int i = 0; i < 30; i++)
+			{
+				Distance[i] = (unsigned char)ReverseBits(i, 5);
+			}
+		}
+	};
+
+	static void PutSymbol(DeflateBits& bits, const FixedCodes& codes, int symbol)
+	{
+		bits.Put(codes.Literal[symbol], codes.LiteralLength[symbol]);
+	}
+
+	static void PutMatch(DeflateBits& bits, const FixedCodes& codes, int length, int distance)
+	{
+		int l = length - 3;
+		int lengthCode;
+		if (l < 8)
+		{
+			lengthCode = l;
+		}
+		else if (length == MaxMatch)
+		{
+			lengthCode = 28;
+		}
+		else
+		{
+			int high = HighestBit(l);
+			lengthCode = 4 * (high - 1) + ((l >> (high - 2)) & 3);
+		}
+		PutSymbol(bits, codes, 257 + lengthCode);
+		if (LengthExtra[lengthCode] > 0)
+		{
+			bits.Put(length - LengthBase[lengthCode], LengthExtra[lengthCode]);
+		}
+
+		int d = distance - 1;
+		int distanceCode;
+		if (d < 4)
+		{
+			distanceCode = d;
+		}
+		else
+		{
+			int high = HighestBit(d);
+			distanceCode = 2 * high + ((d >> (high - 1)) & 1);
+		}
+		bits.Put(codes.Distance[distanceCode], 5);
+		if (DistanceExtra[distanceCode] > 0)
+		{
+			bits.Put(distance - DistanceBase[distanceCode], DistanceExtra[distanceCode]);
+		}
+	}
+
+	static unsigned int Adler32(const unsigned char* data, size_t length)
+	{
+		unsigned int a = 1, b = 0;
+		while (length > 0)
+		{
+			size_t block = length < 5552 ? length : 5552;
+			length -= block;
+			for (size_t i = 0; i < block; i++)
+			{
+				a += data[i];
+				b += a;
+			}
+			data += block;
+			a %= 65521;
+			b %= 65521;
+		}
+		return (b << 16) | a;
+	}
+
+	void Deflate(const unsigned char* data, size_t length, std::vector<unsigned char>& output)
+	{
+		static const FixedCodes codes;
+
+		output.reserve(output.size() + length / 2 + 64);
+		output.push_back(0x78);
+		output.push_back(0x01);
+
+		DeflateBits bits(output);
+		bits.Put(1, 1); //BFINAL
+		bits.Put(1, 2); //BTYPE fixed Huffman
+
+		std::vector<int> head(1 << HashBits, -1);
+		size_t i = 0;
+		while (i < length)
+		{
+			int bestLength = 0;
+			size_t bestDistance = 0;
+			if (i + 3 <= length)
+			{
+				unsigned int h = ((data[i] << 16) | (data[i + 1] << 8) | data[i + 2]) * 2654435761U >> (32 - HashBits);
+				int candidate = head[h];
+				head[h] = (int)i;
+				if (candidate >= 0 && i - candidate <= WindowSize)
+				{
+					size_t limit = length - i < (size_t)MaxMatch ? length - i : (size_t)MaxMatch;
+					const unsigned char* a = data + candidate;
+					const unsigned char* b = data + i;
+					size_t n = 0;
+					while (n < limit && a[n] == b[n])
+					{
+						n++;
+					}
+					if (n >= 3)
+					{
+						bestLength = (int)n;
+						bestDistance = i - candidate;
+					}
+				}
+			}
+
+			if (bestLength > 0)
+			{
+				PutMatch(bits, codes, bestLength, (int)bestDistance);
+				size_t end = i + bestLength;
+				for (i++; i < end; i++)
+				{
+					if (i + 3 <= length)
+					{
+						unsigned int h = ((data[i] << 16) | (data[i + 1] << 8) | data[i + 2]) * 2654435761U >> (32 - HashBits);
+						head[h] = (int)i;
+					}
+				}
+			}
+			else
+			{
+				PutSymbol(bits, codes, data[i]);
+				i++;
+			}
+		}
+		PutSymbol(bits, codes, 256);
+		bits.Flush();
+
+		unsigned int adler = Adler32(data, length);
+		output.push_back((unsigned char)(adler >> 24));
+		output.push_back((unsigned char)(adler >> 16));
+		output.push_back((unsigned char)(adler >> 8));
+		output.push_back((unsigned char)adler);
+	}
+}
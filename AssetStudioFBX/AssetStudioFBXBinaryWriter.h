@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace AssetStudio
+{
+	//Streams FBX binary records to disk. Record sizes are patched in place once a node is closed,
+	//so apart from the array being compressed nothing is held in memory.
+	//Versions below 7500 use 32-bit record offsets, 7500 and above use 64-bit offsets.
+	class FbxBinaryWriter
+	{
+	public:
+		FbxBinaryWriter(const char* path, int version, bool compress);
+		~FbxBinaryWriter();
+
+		void BeginNode(const char* name);
+		void EndNode();
+
+		void AddBool(bool value);
+		void AddInt16(short value);
+		void AddInt32(int value);
+		void AddInt64(long long value);
+		void AddFloat(float value);
+		void AddDouble(double value);
+		void AddString(const char* value);
+		void AddString(const std::string& value);
+		void AddRaw(const void* data, size_t length);
+		void AddArray(const float* data, size_t count);
+		void AddArray(const double* data, size_t count);
+		void AddArray(const int* data, size_t count);
+		void AddArray(const long long* data, size_t count);
+
+		//Writes the closing null record and the footer, the file is unusable until this is called
+		void Finish(const unsigned char* footerId);
+
+		int Version() const { return version; }
+		unsigned long long BytesWritten() const { return (unsigned long long)position; }
+		unsigned long long ArrayBytes() const { return arrayBytes; }
+		unsigned long long CompressedArrayBytes() const { return compressedArrayBytes; }
+
+	private:
+		struct OpenNode
+		{
+			long long Offset;
+			long long PropertyStart;
+			unsigned long long NumProperties;
+			bool HasChildren;
+		};
+
+		FILE* file;
+		int version;
+		bool compress;
+		long long position;
+		unsigned long long arrayBytes;
+		unsigned long long compressedArrayBytes;
+		std::vector<OpenNode> nodes;
+		std::vector<unsigned char> deflated;
+
+		FbxBinaryWriter(const FbxBinaryWriter&);
+		FbxBinaryWriter& operator=(const FbxBinaryWriter&);
+
+		void Write(const void* data, size_t length);
+		void WriteOffset(unsigned long long value);
+		void WriteNullRecord();
+		void Patch(long long offset, unsigned long long value);
+		void BeginProperty(char type);
+		void CloseProperties();
+		void AddArray(char type, const void* data, size_t count, size_t elementSize);
+	};
+
+	//zlib stream (RFC 1950) of fixed Huffman deflate blocks, appended to output
+	void Deflate(const unsigned char* data, size_t length, std::vector<unsigned char>& output);
+}
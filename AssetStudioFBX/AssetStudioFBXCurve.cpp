@@ -0,0 +1,81 @@
+#include <fbxsdk.h>
+#include <algorithm>
+#include <numeric>
+#include "AssetStudioFBXCurve.h"
+
+namespace AssetStudio
+{
+	void AddCurveKeys(FbxAnimCurve* const* pCurves, const SceneCurve& keys)
+	{
+		const int count = (int)keys.Times.size();
+		if (count == 0)
+		{
+			return;
+		}
+
+		//same conversion as FbxTime::SetSecondDouble, kept branch free so it vectorizes
+		const double ticksPerSecond = (double)FBXSDK_TC_SECOND;
+		const float* pTimes = keys.Times.data();
+		std::vector<FbxLongLong> ticks(count);
+		for (int i = 0; i < count; i++)
+		{
+			ticks[i] = (FbxLongLong)(pTimes[i] * ticksPerSecond);
+		}
+
+		std::vector<int> order(count);
+		std::iota(order.begin(), order.end(), 0);
+		bool increasing = true;
+		for (int i = 1; i < count && increasing; i++)
+		{
+			increasing = ticks[i] > ticks[i - 1];
+		}
+		if (!increasing)
+		{
+			std::stable_sort(order.begin(), order.end(), [&ticks](int a, int b) { return ticks[a] < ticks[b]; });
+			int kept = 0;
+			for (int i = 0; i < count; i++)
+			{
+				if (kept > 0 && ticks[order[kept - 1]] == ticks[order[i]])
+				{
+					order[kept - 1] = order[i];
+				}
+				else
+				{
+					order[kept++] = order[i];
+				}
+			}
+			order.resize(kept);
+		}
+
+		const FbxAnimCurveDef::EInterpolationType interpolation = keys.Linear ? FbxAnimCurveDef::eInterpolationLinear : FbxAnimCurveDef::eInterpolationCubic;
+		const float* pValues = keys.Values.data();
+		for (int c = 0; c < 3; c++)
+		{
+			FbxAnimCurve* pCurve = pCurves[c];
+			int existing = pCurve->KeyGetCount();
+			if (existing == 0 || pCurve->KeyGetTime(existing - 1).Get() < ticks[order[0]])
+			{
+				//every key goes after the current ones, grow the buffer once and append
+				pCurve->ResizeKeyBuffer(existing + (int)order.size());
+				for (size_t k = 0; k < order.size(); k++)
+				{
+					int i = order[k];
+					int index = pCurve->KeyAppendFast(FbxTime(ticks[i]), pValues[i * 3 + c]);
+					pCurve->KeySetInterpolation(index, interpolation);
+					pCurve->KeySetTangentMode(index, FbxAnimCurveDef::eTangentAuto);
+				}
+			}
+			else
+			{
+				//another track already keyed this curve past our first key, merge key by key
+				int last = 0;
+				for (size_t k = 0; k < order.size(); k++)
+				{
+					int i = order[k];
+					FbxTime lTime(ticks[i]);
+					pCurve->KeySet(pCurve->KeyAdd(lTime, &last), lTime, pValues[i * 3 + c], interpolation);
+				}
+			}
+		}
+	}
+}
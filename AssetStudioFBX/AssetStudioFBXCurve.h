@@ -0,0 +1,10 @@
+#pragma once
+
+#include "AssetStudioFBXScene.h"
+
+namespace AssetStudio
+{
+	//Appends the keys to the x, y and z curves in one pass. Unsorted times are sorted, for keys at the same time the last one wins.
+	//Keys are cubic with auto tangents, or linear for a reduced curve.
+	void AddCurveKeys(FbxAnimCurve* const* pCurves, const SceneCurve& keys);
+}
@@ -0,0 +1,160 @@
+#include <fbxsdk.h>
+#include "AssetStudioFBX.h"
+
+using namespace System::Diagnostics;
+using namespace System::Text;
+
+namespace AssetStudio
+{
+	ExportStatistics::ExportStatistics()
+	{
+		StageTimes = gcnew Dictionary<String^, TimeSpan>();
+		TextureFiles = gcnew List<String^>();
+		TotalTime = TimeSpan::Zero;
+	}
+
+	String^ ExportStatistics::ToString()
+	{
+		StringBuilder^ sb = gcnew StringBuilder();
+		sb->AppendFormat("{0:F0} ms", TotalTime.TotalMilliseconds);
+		for each (KeyValuePair<String^, TimeSpan> stage in StageTimes)
+		{
+			sb->AppendFormat(", {0} {1:F0} ms", stage.Key, stage.Value.TotalMilliseconds);
+		}
+		sb->AppendFormat("; {0} nodes, {1} meshes, {2} control points, {3} clusters ({4} skipped), {5} shapes", Nodes, Meshes, ControlPoints, Clusters, SkippedClusters, Shapes);
+		sb->AppendFormat(", {0} curves, {1} keys, {2} textures ({3} unchanged), {4} bytes out, {5} peak native bytes", Curves, Keys, TexturesWritten, TexturesSkipped, BytesOut, PeakNativeBytes);
+		sb->AppendFormat(", {0} peak working set, {1} bytes spilled", PeakWorkingSet, SpilledBytes);
+		sb->AppendFormat("; node index {0} hits, {1} misses", NodeIndexHits, NodeIndexMisses);
+		sb->AppendFormat("; geometry instances {0} hits, {1} misses", InstanceHits, InstanceMisses);
+		if (OptimizedTriangles > 0)
+		{
+			sb->AppendFormat("; ACMR {0:F3} -> {1:F3} over {2} triangles, {3} vertices welded", AcmrBefore, AcmrAfter, OptimizedTriangles, WeldedVertices);
+		}
+		return sb->ToString();
+	}
+
+	ExportProfiler::ExportProfiler(ExportStatistics^ statistics, String^ tracePath)
+	{
+		this->statistics = statistics;
+		this->tracePath = tracePath;
+		process = Process::GetCurrentProcess();
+		memoryBaseline = NativeBytes();
+		events = String::IsNullOrEmpty(tracePath) ? nullptr : gcnew StringBuilder();
+		stopwatch = Stopwatch::StartNew();
+	}
+
+	Int64 ExportProfiler::Now()
+	{
+		return stopwatch->ElapsedTicks;
+	}
+
+	Int64 ExportProfiler::NativeBytes()
+	{
+		process->Refresh();
+		return process->PrivateMemorySize64 - GC::GetTotalMemory(false);
+	}
+
+	static void AppendJsonString(StringBuilder^ sb, String^ value)
+	{
+		sb->Append('"');
+		for each (Char c in value)
+		{
+			if (c == '"' || c == '\\')
+			{
+				sb->Append('\\')->Append(c);
+			}
+			else if (c < ' ')
+			{
+				sb->AppendFormat("\\u{0:x4}", (int)c);
+			}
+			else
+			{
+				sb->Append(c);
+			}
+		}
+		sb->Append('"');
+	}
+
+	void ExportProfiler::AddSpan(String^ name, String^ category, Int64 start, Int64 end)
+	{
+		if (events == nullptr)
+		{
+			return;
+		}
+		//complete events, timestamps in microseconds from the start of the export
+		double toMicroseconds = 1e6 / Stopwatch::Frequency;
+		if (events->Length > 0)
+		{
+			events->Append(",\n");
+		}
+		events->Append("{\"name\":");
+		AppendJsonString(events, name != nullptr ? name : "");
+		events->Append(",\"cat\":");
+		AppendJsonString(events, category);
+		events->AppendFormat(Globalization::CultureInfo::InvariantCulture, ",\"ph\":\"X\",\"ts\":{0:F3},\"dur\":{1:F3},\"pid\":{2},\"tid\":{3}}}", start * toMicroseconds, (end - start) * toMicroseconds, process->Id, Thread::CurrentThread->ManagedThreadId);
+	}
+
+	void ExportProfiler::AddStage(String^ stage, String^ enclosing, Int64 start, Int64 end)
+	{
+		TimeSpan elapsed = TimeSpan::FromSeconds((double)(end - start) / Stopwatch::Frequency);
+		TimeSpan total;
+		statistics->StageTimes->TryGetValue(stage, total);
+		statistics->StageTimes[stage] = total + elapsed;
+		if (enclosing != nullptr)
+		{
+			statistics->StageTimes->TryGetValue(enclosing, total);
+			statistics->StageTimes[enclosing] = total - elapsed;
+		}
+		statistics->PeakNativeBytes = Math::Max(statistics->PeakNativeBytes, NativeBytes() - memoryBaseline);
+		statistics->PeakWorkingSet = Math::Max(statistics->PeakWorkingSet, process->WorkingSet64);
+	}
+
+	void ExportProfiler::Finish()
+	{
+		statistics->TotalTime = stopwatch->Elapsed;
+		if (events != nullptr)
+		{
+			File::WriteAllText(tracePath, String::Concat("{\"traceEvents\":[\n", events->ToString(), "\n]}\n"));
+		}
+	}
+
+	ProfileScope::ProfileScope(ExportProfiler^ profiler, String^ stage)
+	{
+		this->profiler = profiler;
+		this->stage = stage;
+		enclosing = nullptr;
+		name = stage;
+		category = "stage";
+		start = profiler->Now();
+	}
+
+	ProfileScope::ProfileScope(ExportProfiler^ profiler, String^ stage, String^ enclosing)
+	{
+		this->profiler = profiler;
+		this->stage = stage;
+		this->enclosing = enclosing;
+		name = stage;
+		category = "stage";
+		start = profiler->Now();
+	}
+
+	ProfileScope::ProfileScope(ExportProfiler^ profiler, String^ stage, String^ enclosing, String^ name, String^ category)
+	{
+		this->profiler = profiler;
+		this->stage = stage;
+		this->enclosing = enclosing;
+		this->name = name;
+		this->category = category;
+		start = profiler->Now();
+	}
+
+	ProfileScope::~ProfileScope()
+	{
+		Int64 end = profiler->Now();
+		if (stage != nullptr)
+		{
+			profiler->AddStage(stage, enclosing, start, end);
+		}
+		profiler->AddSpan(name, category, start, end);
+	}
+}
@@ -1,10 +1,41 @@
 #include <fbxsdk.h>
 #include <fbxsdk/fileio/fbxiosettings.h>
+#include <stdexcept>
 #include "AssetStudioFBX.h"
+#include "AssetStudioFBXMesh.h"
+#include "AssetStudioFBXCurve.h"
+#include "AssetStudioFBXHash.h"
+#include "AssetStudioFBXSceneSpill.h"
 
 namespace AssetStudio
 {
-	void Fbx::Exporter::Export(String^ path, IImported^ imported, bool eulerFilter, float filterPrecision, bool allFrames, bool allBones, bool skins, float boneSize, float scaleFactor, bool flatInbetween, int versionIndex, bool isAscii)
+	FbxExportOptions::FbxExportOptions()
+	{
+		EulerFilter = true;
+		FilterPrecision = 0.25f;
+		PositionTolerance = 0;
+		RotationTolerance = 0;
+		ScaleTolerance = 0;
+		AllFrames = false;
+		AllBones = true;
+		Skins = true;
+		BoneSize = 10;
+		ScaleFactor = 1;
+		FlatInbetween = false;
+		VersionIndex = 3;
+		IsAscii = false;
+		OptimizeMeshes = false;
+		WeldTolerance = -1;
+		MemoryBudget = 0;
+		TracePath = nullptr;
+	}
+
+	ExportStatistics^ Fbx::Exporter::Export(String^ path, IImported^ imported, FbxExportOptions^ options)
+	{
+		return Export(path, imported, options, nullptr);
+	}
+
+	ExportStatistics^ Fbx::Exporter::Export(String^ path, IImported^ imported, FbxExportOptions^ options, Session^ session)
 	{
 		FileInfo^ file = gcnew FileInfo(path);
 		DirectoryInfo^ dir = file->Directory;
@@ -12,17 +43,173 @@ namespace AssetStudio
 		{
 			dir->Create();
 		}
-		String^ currentDir = Directory::GetCurrentDirectory();
-		Directory::SetCurrentDirectory(dir->FullName);
-		path = Path::GetFileName(path);
+		path = file->FullName;
 
-		Exporter^ exporter = gcnew Exporter(path, imported, allFrames, allBones, skins, boneSize, scaleFactor, versionIndex, isAscii, true);
-		exporter->ExportMorphs(imported, false, flatInbetween);
-		exporter->ExportAnimations(eulerFilter, filterPrecision, flatInbetween);
-		exporter->pExporter->Export(exporter->pScene);
-		delete exporter;
+		ExportStatistics^ statistics = gcnew ExportStatistics();
+		ExportProfiler^ profiler = gcnew ExportProfiler(statistics, options->TracePath);
+		MemoryBudget^ budget = gcnew MemoryBudget(options->MemoryBudget, statistics);
+		Exporter^ exporter = gcnew Exporter(path, imported, options->AllFrames, options->AllBones, options->Skins, options->BoneSize, options->ScaleFactor, options->VersionIndex, options->IsAscii, true, options->OptimizeMeshes, options->WeldTolerance, profiler, budget, session);
+		try
+		{
+			{
+				ProfileScope scope(profiler, "Morphs");
+				exporter->ExportMorphs(imported, false, options->FlatInbetween);
+			}
+			{
+				ProfileScope scope(profiler, "Animation");
+				TrackFilter filter = { options->EulerFilter, options->FilterPrecision, { options->PositionTolerance, options->RotationTolerance, options->ScaleTolerance } };
+				exporter->ExportAnimations(filter, options->FlatInbetween);
+			}
+			{
+				ProfileScope scope(profiler, "Write");
+				exporter->pExporter->Export(exporter->pScene);
+			}
+			{
+				ProfileScope scope(profiler, "Textures");
+				exporter->DrainTextures();
+			}
+			exporter->CollectStatistics(path, statistics);
+		}
+		finally
+		{
+			delete exporter;
+		}
+		profiler->Finish();
+		if (budget->Exceeded)
+		{
+			//only the source data can be released, the FbxScene itself has to stay whole until it is written
+			Logger::Warning(String::Format("{0}: working set went over the memory budget of {1} bytes, peak {2} bytes", Path::GetFileName(path), options->MemoryBudget, statistics->PeakWorkingSet));
+		}
+		Logger::Debug(String::Format("{0}: {1}", Path::GetFileName(path), statistics));
+		return statistics;
+	}
+
+	ExportStatistics^ Fbx::Exporter::ExportBinary(String^ path, IImported^ imported, FbxExportOptions^ options)
+	{
+		FileInfo^ file = gcnew FileInfo(path);
+		DirectoryInfo^ dir = file->Directory;
+		if (!dir->Exists)
+		{
+			dir->Create();
+		}
+		path = file->FullName;
+
+		int version = options->VersionIndex == 0 || options->VersionIndex == 5 ? 7500 : 7400;
+		ExportStatistics^ statistics = gcnew ExportStatistics();
+		ExportProfiler^ profiler = gcnew ExportProfiler(statistics, nullptr);
+		MemoryBudget^ budget = gcnew MemoryBudget(options->MemoryBudget, statistics);
+		Scene* scene = new Scene();
+		TextureWriter^ textureWriter = gcnew TextureWriter(16, 2);
+		char* pPath = NULL;
+		try
+		{
+			SceneBuilder^ builder = gcnew SceneBuilder(imported, scene, textureWriter, Path::GetDirectoryName(path), budget);
+			TrackFilter filter = { options->EulerFilter, options->FilterPrecision, { options->PositionTolerance, options->RotationTolerance, options->ScaleTolerance } };
+			SceneWriteStats stats;
+			try
+			{
+				{
+					ProfileScope scope(profiler, "Build");
+					builder->Build(options->AllFrames, options->AllBones, options->Skins, options->BoneSize, options->ScaleFactor, options->FlatInbetween, filter);
+				}
+				ProfileScope scope(profiler, "Write");
+				pPath = StringToCharArray(path);
+				stats = WriteBinaryFbx(*scene, pPath, version, true);
+			}
+			catch (const std::exception& e)
+			{
+				throw gcnew Exception(gcnew String("Failed to write FBX: ") + gcnew String(e.what()));
+			}
+			{
+				ProfileScope scope(profiler, "Textures");
+				textureWriter->Drain();
+			}
+
+			CollectSceneStatistics(*scene, statistics);
+			statistics->TexturesWritten = textureWriter->FilesWritten;
+			statistics->TexturesSkipped = textureWriter->FilesSkipped;
+			statistics->TextureFiles->AddRange(textureWriter->Files);
+			statistics->BytesOut = (Int64)stats.FileBytes + textureWriter->BytesWritten;
+			statistics->SpilledBytes = scene->Spill != NULL ? (Int64)scene->Spill->Bytes() : 0;
+			Logger::Debug(String::Format("Binary FBX {0}: {1} objects, {2} bytes, arrays {3} -> {4} bytes", version, stats.Objects, stats.FileBytes, stats.ArrayBytes, stats.CompressedArrayBytes));
+			for (int i = 0; i < SceneStageCount; i++)
+			{
+				Logger::Debug(String::Format("Binary FBX {0}: {1:F3}s", gcnew String(SceneStageName((SceneStage)i)), stats.StageSeconds[i]));
+			}
+		}
+		finally
+		{
+			delete textureWriter;
+			delete scene->Spill;
+			delete scene;
+			Marshal::FreeHGlobal((IntPtr)pPath);
+		}
+		profiler->Finish();
+		if (budget->Exceeded)
+		{
+			Logger::Warning(String::Format("{0}: working set went over the memory budget of {1} bytes, peak {2} bytes", Path::GetFileName(path), options->MemoryBudget, statistics->PeakWorkingSet));
+		}
+		Logger::Debug(String::Format("{0}: {1}", Path::GetFileName(path), statistics));
+		return statistics;
+	}
+
+	ExportStatistics^ Fbx::Exporter::ExportSnapshot(String^ path, IImported^ imported, FbxExportOptions^ options)
+	{
+		FileInfo^ file = gcnew FileInfo(path);
+		DirectoryInfo^ dir = file->Directory;
+		if (!dir->Exists)
+		{
+			dir->Create();
+		}
+		path = file->FullName;
+
+		ExportStatistics^ statistics = gcnew ExportStatistics();
+		ExportProfiler^ profiler = gcnew ExportProfiler(statistics, nullptr);
+		MemoryBudget^ budget = gcnew MemoryBudget(options->MemoryBudget, statistics);
+		Scene* scene = new Scene();
+		TextureWriter^ textureWriter = gcnew TextureWriter(16, 2);
+		char* pPath = NULL;
+		try
+		{
+			SceneBuilder^ builder = gcnew SceneBuilder(imported, scene, textureWriter, Path::GetDirectoryName(path), budget);
+			TrackFilter filter = { options->EulerFilter, options->FilterPrecision, { options->PositionTolerance, options->RotationTolerance, options->ScaleTolerance } };
+			try
+			{
+				{
+					ProfileScope scope(profiler, "Build");
+					builder->Build(options->AllFrames, options->AllBones, options->Skins, options->BoneSize, options->ScaleFactor, options->FlatInbetween, filter);
+				}
+				ProfileScope scope(profiler, "Write");
+				pPath = StringToCharArray(path);
+				WriteSceneSnapshot(*scene, pPath);
+			}
+			catch (const std::exception& e)
+			{
+				throw gcnew Exception(gcnew String("Failed to write snapshot: ") + gcnew String(e.what()));
+			}
+			{
+				ProfileScope scope(profiler, "Textures");
+				textureWriter->Drain();
+			}
 
-		Directory::SetCurrentDirectory(currentDir);
+			CollectSceneStatistics(*scene, statistics);
+			statistics->TexturesWritten = textureWriter->FilesWritten;
+			statistics->TexturesSkipped = textureWriter->FilesSkipped;
+			statistics->TextureFiles->AddRange(textureWriter->Files);
+			file->Refresh();
+			statistics->BytesOut = file->Length + textureWriter->BytesWritten;
+			statistics->SpilledBytes = scene->Spill != NULL ? (Int64)scene->Spill->Bytes() : 0;
+		}
+		finally
+		{
+			delete textureWriter;
+			delete scene->Spill;
+			delete scene;
+			Marshal::FreeHGlobal((IntPtr)pPath);
+		}
+		profiler->Finish();
+		Logger::Debug(String::Format("{0}: {1}", Path::GetFileName(path), statistics));
+		return statistics;
 	}
 
 	void Fbx::Exporter::ExportMorph(String^ path, IImported^ imported, bool morphMask, bool flatInbetween, bool skins, float boneSize, float scaleFactor, int versionIndex, bool isAscii)
@@ -33,77 +220,110 @@ namespace AssetStudio
 		{
 			dir->Create();
 		}
-		String^ currentDir = Directory::GetCurrentDirectory();
-		Directory::SetCurrentDirectory(dir->FullName);
-		path = Path::GetFileName(path);
+		path = file->FullName;
 
-		Exporter^ exporter = gcnew Exporter(path, imported, false, true, skins, boneSize, scaleFactor, versionIndex, isAscii, false);
+		Exporter^ exporter = gcnew Exporter(path, imported, false, true, skins, boneSize, scaleFactor, versionIndex, isAscii, false, false, -1, gcnew ExportProfiler(gcnew ExportStatistics(), nullptr), gcnew MemoryBudget(0, gcnew ExportStatistics()), nullptr);
 		exporter->ExportMorphs(imported, morphMask, flatInbetween);
 		exporter->pExporter->Export(exporter->pScene);
+		exporter->DrainTextures();
 		delete exporter;
-
-		Directory::SetCurrentDirectory(currentDir);
 	}
 
-	Fbx::Exporter::Exporter(String^ path, IImported^ imported, bool allFrames, bool allBones, bool skins, float boneSize, float scaleFactor, int versionIndex, bool isAscii, bool normals)
+	Fbx::Exporter::Exporter(String^ path, IImported^ imported, bool allFrames, bool allBones, bool skins, float boneSize, float scaleFactor, int versionIndex, bool isAscii, bool normals, bool optimizeMeshes, float weldTolerance, ExportProfiler^ profiler, MemoryBudget^ budget, Session^ session)
 	{
 		this->imported = imported;
+		this->profiler = profiler;
+		this->budget = budget;
 		exportSkins = skins;
 		this->boneSize = boneSize;
+		this->optimizeMeshes = optimizeMeshes;
+		this->weldTolerance = weldTolerance;
+		this->session = session;
+		exportDir = Path::GetDirectoryName(path);
+		textureWriter = nullptr;
 
-		cDest = NULL;
+		names = gcnew StringArena();
 		pSdkManager = NULL;
 		pScene = NULL;
 		pExporter = NULL;
-		pMaterials = NULL;
-		pTextures = NULL;
 		pMeshNodes = NULL;
+		preparingMesh = nullptr;
+		pPreparedSubmeshes = NULL;
+		morphKeyframes = nullptr;
+		morphChannels = nullptr;
+		pMorphShapes = NULL;
+		pFilteringTracks = NULL;
+		pFilteringRests = NULL;
+		pTrackFilter = NULL;
+
+		nodePathIndex = gcnew Dictionary<String^, IntPtr>();
+		nodePaths = gcnew Dictionary<IntPtr, String^>();
+		nodeNameIndex = gcnew Dictionary<String^, IntPtr>();
+		nodeLookupCache = gcnew Dictionary<String^, IntPtr>();
+		nodeIndexHits = 0;
+		nodeIndexMisses = 0;
+		clustersCreated = 0;
+		clustersSkipped = 0;
+		instanceHits = 0;
+		instanceMisses = 0;
+		optimizedTriangles = 0;
+		cacheMissesBefore = 0;
+		cacheMissesAfter = 0;
+		weldedVertices = 0;
 
-		pin_ptr<FbxManager*> pSdkManagerPin = &pSdkManager;
-		pin_ptr<FbxScene*> pScenePin = &pScene;
-		Init(pSdkManagerPin, pScenePin);
-
-		IOS_REF.SetBoolProp(EXP_FBX_MATERIAL, true);
-		IOS_REF.SetBoolProp(EXP_FBX_TEXTURE, true);
-		IOS_REF.SetBoolProp(EXP_FBX_EMBEDDED, false);
-		IOS_REF.SetBoolProp(EXP_FBX_SHAPE, true);
-		IOS_REF.SetBoolProp(EXP_FBX_GOBO, true);
-		IOS_REF.SetBoolProp(EXP_FBX_ANIMATION, true);
-		IOS_REF.SetBoolProp(EXP_FBX_GLOBAL_SETTINGS, true);
+		{
+			ProfileScope scope(profiler, "Startup");
+			if (session != nullptr)
+			{
+				//a failed earlier export may have left objects behind
+				pSdkManager = session->pSdkManager;
+				pScene = session->pScene;
+				pScene->Clear();
+			}
+			else
+			{
+				pin_ptr<FbxManager*> pSdkManagerPin = &pSdkManager;
+				pin_ptr<FbxScene*> pScenePin = &pScene;
+				Init(pSdkManagerPin, pScenePin);
+				InitExportSettings(pSdkManager);
+			}
 
-		FbxGlobalSettings& globalSettings = pScene->GetGlobalSettings();
-		globalSettings.SetSystemUnit(FbxSystemUnit(scaleFactor));
+			FbxGlobalSettings& globalSettings = pScene->GetGlobalSettings();
+			globalSettings.SetSystemUnit(FbxSystemUnit(scaleFactor));
 
-		cDest = StringToCharArray(path);
-		pExporter = FbxExporter::Create(pScene, "");
+			pExporter = FbxExporter::Create(pScene, "");
 
-		int pFileFormat = 0;
-		if (versionIndex == 0)
-		{
-			pFileFormat = 3;
-			if (isAscii)
+			int pFileFormat = 0;
+			if (versionIndex == 0)
 			{
-				pFileFormat = 4;
+				pFileFormat = 3;
+				if (isAscii)
+				{
+					pFileFormat = 4;
+				}
 			}
-		}
-		else
-		{
-			pExporter->SetFileExportVersion(FBXVersion[versionIndex]);
-			if (isAscii)
+			else
 			{
-				pFileFormat = 1;
+				pExporter->SetFileExportVersion(FBXVersion[versionIndex]);
+				if (isAscii)
+				{
+					pFileFormat = 1;
+				}
 			}
-		}
 
-		if (!pExporter->Initialize(cDest, pFileFormat, pSdkManager->GetIOSettings()))
-		{
-			throw gcnew Exception(gcnew String("Failed to initialize FbxExporter: ") + gcnew String(pExporter->GetStatus().GetErrorString()));
+			if (!pExporter->Initialize(names->Intern(path), pFileFormat, pSdkManager->GetIOSettings()))
+			{
+				throw gcnew Exception(gcnew String("Failed to initialize FbxExporter: ") + Utf8ToString(pExporter->GetStatus().GetErrorString()));
+			}
 		}
 
+		sceneIndex = gcnew SceneIndex(imported);
+		meshNodeIndex = gcnew Dictionary<String^, IntPtr>();
+
 		frameNames = nullptr;
 		if (!allFrames)
 		{
-			frameNames = SearchHierarchy();
+			frameNames = sceneIndex->SearchHierarchy();
 			if (!frameNames)
 			{
 				return;
@@ -111,72 +331,125 @@ namespace AssetStudio
 		}
 
 		pMeshNodes = imported->MeshList != nullptr ? new FbxArray<FbxNode*>(imported->MeshList->Count) : NULL;
-		ExportFrame(pScene->GetRootNode(), imported->RootFrame);
+		{
+			ProfileScope scope(profiler, "Hierarchy");
+			ExportFrame(pScene->GetRootNode(), imported->RootFrame);
+			IndexNodeNames(pScene->GetRootNode());
+			if (imported->MeshList != nullptr)
+			{
+				SetJointsFromImportedMeshes(allBones);
+			}
+			else
+			{
+				SetJointsNode(pScene->GetRootNode()->GetChild(0), nullptr, true);
+			}
+		}
 
 		if (imported->MeshList != nullptr)
 		{
-			SetJointsFromImportedMeshes(allBones);
 
-			pMaterials = new FbxArray<FbxSurfacePhong*>();
-			pTextures = new FbxArray<FbxFileTexture*>();
-			pMaterials->Reserve(imported->MaterialList->Count);
-			pTextures->Reserve(imported->TextureList->Count);
+			importedMaterials = gcnew Dictionary<String^, ImportedMaterial^>(imported->MaterialList->Count);
+			for each (ImportedMaterial^ mat in imported->MaterialList)
+			{
+				if (mat->Name != nullptr && !importedMaterials->ContainsKey(mat->Name))
+				{
+					importedMaterials->Add(mat->Name, mat);
+				}
+			}
+			importedTextures = gcnew Dictionary<String^, ImportedTexture^>(imported->TextureList->Count);
+			for each (ImportedTexture^ tex in imported->TextureList)
+			{
+				if (tex->Name != nullptr && !importedTextures->ContainsKey(tex->Name))
+				{
+					importedTextures->Add(tex->Name, tex);
+				}
+			}
+			materialIndex = gcnew Dictionary<String^, IntPtr>(imported->MaterialList->Count);
+			textureIndex = gcnew Dictionary<String^, IntPtr>(imported->TextureList->Count);
+			textureContentIndex = gcnew Dictionary<UInt64, IntPtr>(imported->TextureList->Count);
+			textureSources = gcnew Dictionary<IntPtr, ImportedTexture^>(imported->TextureList->Count);
+			textureDigests = gcnew Dictionary<IntPtr, array<Byte>^>();
+			geometryIndex = gcnew Dictionary<UInt64, IntPtr>();
+			textureWriter = gcnew TextureWriter(16, 2);
+
+			//morphs add shapes to the meshes and address their vertices by index, so these are never instanced or optimized,
+			//and read the base positions from the submeshes, those are released after ExportMorphs
+			HashSet<String^>^ morphedMeshes = gcnew HashSet<String^>();
+			if (imported->MorphList != nullptr)
+			{
+				for each (ImportedMorph^ morph in imported->MorphList)
+				{
+					if (morph->Path != nullptr)
+					{
+						morphedMeshes->Add(morph->Path);
+					}
+				}
+			}
 
 			for (int i = 0; i < pMeshNodes->GetCount(); i++)
 			{
 				FbxNode* meshNode = pMeshNodes->GetAt(i);
-				String^ meshPath = gcnew String(meshNode->GetName());
-				FbxNode* rootNode = meshNode;
-				while ((rootNode = rootNode->GetParent()) != pScene->GetRootNode())
+				ImportedMesh^ mesh = sceneIndex->MeshesByPath[nodePaths[(IntPtr)meshNode]];
+				{
+					ProfileScope scope(profiler, "Mesh", nullptr, mesh->Path, "mesh");
+					bool morphed = morphedMeshes->Contains(mesh->Path);
+					ExportMesh(meshNode, mesh, normals, !morphed, optimizeMeshes && !morphed);
+				}
+				if (budget->Enabled)
 				{
-					meshPath = gcnew String(rootNode->GetName()) + "/" + meshPath;
+					if (!morphedMeshes->Contains(mesh->Path))
+					{
+						for each (ImportedSubmesh^ submesh in mesh->SubmeshList)
+						{
+							budget->Release(submesh);
+						}
+					}
+					budget->OverBudget();
 				}
-				ImportedMesh^ mesh = ImportedHelpers::FindMesh(meshPath, imported->MeshList);
-				ExportMesh(meshNode, mesh, normals);
 			}
 		}
-		else
-		{
-			SetJointsNode(pScene->GetRootNode()->GetChild(0), nullptr, true);
-		}
 	}
 
 	Fbx::Exporter::~Exporter()
 	{
-		if (pMeshNodes != NULL)
+		if (textureWriter != nullptr)
 		{
-			delete pMeshNodes;
-		}
-		if (pMaterials != NULL)
-		{
-			delete pMaterials;
+			delete textureWriter;
 		}
-		if (pTextures != NULL)
+		if (pMeshNodes != NULL)
 		{
-			delete pTextures;
+			delete pMeshNodes;
 		}
 		if (pExporter != NULL)
 		{
 			pExporter->Destroy();
 		}
-		if (pScene != NULL)
-		{
-			pScene->Destroy();
-		}
-		if (pSdkManager != NULL)
+		if (session != nullptr)
 		{
-			pSdkManager->Destroy();
+			//the manager and scene belong to the session, only the content of this export goes
+			if (pScene != NULL)
+			{
+				pScene->Clear();
+			}
 		}
-		if (cDest != NULL)
+		else
 		{
-			Marshal::FreeHGlobal((IntPtr)cDest);
+			if (pScene != NULL)
+			{
+				pScene->Destroy();
+			}
+			if (pSdkManager != NULL)
+			{
+				pSdkManager->Destroy();
+			}
 		}
+		delete names;
 	}
 
 	void Fbx::Exporter::SetJointsNode(FbxNode* pNode, HashSet<String^>^ boneNames, bool allBones)
 	{
-		String^ nodeName = gcnew String(pNode->GetName());
-		if (allBones || boneNames->Contains(nodeName))
+		String^ nodePath;
+		if (allBones || (nodePaths->TryGetValue((IntPtr)pNode, nodePath) && boneNames->Contains(nodePath)))
 		{
 			FbxSkeleton* pJoint = FbxSkeleton::Create(pSdkManager, "");
 			pJoint->Size.Set((double)boneSize);
@@ -200,76 +473,14 @@ namespace AssetStudio
 		}
 	}
 
-	HashSet<String^>^ Fbx::Exporter::SearchHierarchy()
-	{
-		if (imported->MeshList == nullptr || imported->MeshList->Count == 0)
-		{
-			return nullptr;
-		}
-		HashSet<String^>^ exportFrames = gcnew HashSet<String^>();
-		SearchHierarchy(imported->RootFrame, exportFrames);
-		return exportFrames;
-	}
-
-	void Fbx::Exporter::SearchHierarchy(ImportedFrame^ frame, HashSet<String^>^ exportFrames)
-	{
-		ImportedMesh^ meshListSome = ImportedHelpers::FindMesh(frame, imported->MeshList);
-		if (meshListSome != nullptr)
-		{
-			ImportedFrame^ parent = frame;
-			while (parent != nullptr)
-			{
-				exportFrames->Add(parent->Name);
-				parent = parent->Parent;
-			}
-
-			List<ImportedBone^>^ boneList = meshListSome->BoneList;
-			if (boneList != nullptr)
-			{
-				for (int i = 0; i < boneList->Count; i++)
-				{
-					String^ boneName = boneList[i]->Path->Substring(boneList[i]->Path->LastIndexOf('/') + 1);
-					if (!exportFrames->Contains(boneName))
-					{
-						ImportedFrame^ boneParent = imported->RootFrame->FindFrameByPath(boneList[i]->Path);
-						while (boneParent != nullptr)
-						{
-							exportFrames->Add(boneParent->Name);
-							boneParent = boneParent->Parent;
-						}
-					}
-				}
-			}
-		}
-
-		for (int i = 0; i < frame->Count; i++)
-		{
-			SearchHierarchy(frame[i], exportFrames);
-		}
-	}
-
 	void Fbx::Exporter::SetJointsFromImportedMeshes(bool allBones)
 	{
 		if (!exportSkins)
 		{
 			return;
 		}
-		HashSet<String^>^ boneNames = gcnew HashSet<String^>();
-		for (int i = 0; i < imported->MeshList->Count; i++)
-		{
-			ImportedMesh^ meshList = imported->MeshList[i];
-			List<ImportedBone^>^ boneList = meshList->BoneList;
-			if (boneList != nullptr)
-			{
-				for (int j = 0; j < boneList->Count; j++)
-				{
-					ImportedBone^ bone = boneList[j];
-					boneNames->Add(bone->Path);
-				}
-			}
-		}
 
-		SetJointsNode(pScene->GetRootNode()->GetChild(0), boneNames, allBones);
+		SetJointsNode(pScene->GetRootNode()->GetChild(0), sceneIndex->BonePaths, allBones);
 	}
 
 	void Fbx::Exporter::ExportFrame(FbxNode* pParentNode, ImportedFrame^ frame)
@@ -277,26 +488,30 @@ namespace AssetStudio
 		String^ frameName = frame->Name;
 		if ((frameNames == nullptr) || frameNames->Contains(frameName))
 		{
-			FbxNode* pFrameNode = NULL;
-			char* pName = NULL;
-			try
-			{
-				pName = StringToCharArray(frameName);
-				pFrameNode = FbxNode::Create(pScene, pName);
-			}
-			finally
-			{
-				Marshal::FreeHGlobal((IntPtr)pName);
-			}
+			FbxNode* pFrameNode = FbxNode::Create(pScene, names->Intern(frameName));
 
 			pFrameNode->LclScaling.Set(FbxDouble3(frame->LocalScale.X, frame->LocalScale.Y, frame->LocalScale.Z));
 			pFrameNode->LclRotation.Set(FbxDouble3(frame->LocalRotation.X, frame->LocalRotation.Y, frame->LocalRotation.Z));
 			pFrameNode->LclTranslation.Set(FbxDouble3(frame->LocalPosition.X, frame->LocalPosition.Y, frame->LocalPosition.Z));
 			pParentNode->AddChild(pFrameNode);
 
-			if (imported->MeshList != nullptr && ImportedHelpers::FindMesh(frame, imported->MeshList) != nullptr)
+			String^ framePath = sceneIndex->FramePaths[frame];
+			nodePaths->Add((IntPtr)pFrameNode, framePath);
+			//FindChild returns the first child with a matching name, so only index paths reachable along first matches
+			IntPtr indexedParent;
+			bool parentIndexed = frame->Parent == nullptr || (nodePathIndex->TryGetValue(sceneIndex->FramePaths[frame->Parent], indexedParent) && indexedParent == (IntPtr)pParentNode);
+			if (parentIndexed && !nodePathIndex->ContainsKey(framePath))
+			{
+				nodePathIndex->Add(framePath, (IntPtr)pFrameNode);
+			}
+
+			if (sceneIndex->FrameMeshes->ContainsKey(frame))
 			{
 				pMeshNodes->Add(pFrameNode);
+				if (!meshNodeIndex->ContainsKey(framePath))
+				{
+					meshNodeIndex->Add(framePath, (IntPtr)pFrameNode);
+				}
 			}
 
 			for (int i = 0; i < frame->Count; i++)
@@ -306,7 +521,24 @@ namespace AssetStudio
 		}
 	}
 
-	void Fbx::Exporter::ExportMesh(FbxNode* pFrameNode, ImportedMesh^ meshList, bool normals)
+	void Fbx::Exporter::IndexNodeNames(FbxNode* pNode)
+	{
+		//Same visiting order as FbxNode::FindChild with pRecursive, the first node seen for a name wins
+		for (int i = 0; i < pNode->GetChildCount(); i++)
+		{
+			String^ childName = Utf8ToString(pNode->GetChild(i)->GetName());
+			if (!nodeNameIndex->ContainsKey(childName))
+			{
+				nodeNameIndex->Add(childName, (IntPtr)pNode->GetChild(i));
+			}
+		}
+		for (int i = 0; i < pNode->GetChildCount(); i++)
+		{
+			IndexNodeNames(pNode->GetChild(i));
+		}
+	}
+
+	void Fbx::Exporter::ExportMesh(FbxNode* pFrameNode, ImportedMesh^ meshList, bool normals, bool instancing, bool optimize)
 	{
 		int lastSlash = meshList->Path->LastIndexOf('/');
 		String^ frameName = lastSlash < 0 ? meshList->Path : meshList->Path->Substring(lastSlash + 1);
@@ -336,89 +568,144 @@ namespace AssetStudio
 				}
 			}
 
-			for (int i = 0; i < meshList->SubmeshList->Count; i++)
+			int meshClustersCreated = 0;
+			int meshClustersSkipped = 0;
+
+			//convert every submesh to native buffers in parallel, then attach them to the scene in order
+			int submeshCount = meshList->SubmeshList->Count;
+			std::vector<PreparedSubmesh> preparedSubmeshes(submeshCount);
+			if (submeshCount > 0)
 			{
-				char* pName = NULL;
-				FbxArray<FbxCluster*>* pClusterArray = NULL;
+				preparingMesh = meshList;
+				preparingNormals = normals;
+				preparingBoneCount = hasBones ? boneList->Count : 0;
+				preparingOptimize = optimize;
+				pPreparedSubmeshes = &preparedSubmeshes[0];
 				try
 				{
-					pName = StringToCharArray(frameName + "_" + i);
-					FbxMesh* pMesh = FbxMesh::Create(pScene, "");
-
-					if (hasBones)
+					if (submeshCount > 1)
+					{
+						Parallel::For(0, submeshCount, gcnew Action<int>(this, &Fbx::Exporter::PrepareSubmesh));
+					}
+					else
 					{
-						pClusterArray = new FbxArray<FbxCluster*>();
-						pClusterArray->Reserve(boneList->Count);
+						PrepareSubmesh(0);
+					}
+				}
+				finally
+				{
+					preparingMesh = nullptr;
+					pPreparedSubmeshes = NULL;
+				}
+			}
+			if (optimize)
+			{
+				Int64 triangles = 0, missesBefore = 0, missesAfter = 0, welded = 0;
+				for (int i = 0; i < submeshCount; i++)
+				{
+					triangles += (Int64)preparedSubmeshes[i].Polygons.size() / 3;
+					missesBefore += preparedSubmeshes[i].CacheMissesBefore;
+					missesAfter += preparedSubmeshes[i].CacheMissesAfter;
+					welded += preparedSubmeshes[i].WeldedVertices;
+				}
+				optimizedTriangles += triangles;
+				cacheMissesBefore += missesBefore;
+				cacheMissesAfter += missesAfter;
+				weldedVertices += welded;
+				if (triangles > 0)
+				{
+					Logger::Debug(String::Format("{0}: ACMR {1:F3} -> {2:F3}, {3} vertices welded", meshList->Path, (double)missesBefore / triangles, (double)missesAfter / triangles, welded));
+				}
+			}
 
-						for (int i = 0; i < boneList->Count; i++)
-						{
-							FbxNode* pNode = pBoneNodeList->GetAt(i);
-							FbxString lClusterName = pNode->GetNameOnly() + FbxString("Cluster");
-							FbxCluster* pCluster = FbxCluster::Create(pSdkManager, lClusterName.Buffer());
-							pCluster->SetLink(pNode);
-							pCluster->SetLinkMode(FbxCluster::eTotalOne);
-							pClusterArray->Add(pCluster);
-						}
+			for (int i = 0; i < submeshCount; i++)
+			{
+				const char* pName = names->Intern(frameName + "_" + i);
+				ImportedSubmesh^ meshObj = meshList->SubmeshList[i];
+				const PreparedSubmesh& prepared = preparedSubmeshes[i];
+				bool packed = meshObj->Positions != nullptr && meshObj->Positions->Length > 0;
+				List<ImportedVertex^>^ vertexList = packed ? nullptr : meshObj->VertexList;
+				int vertexCount = prepared.VertexCount;
+				ImportedMaterial^ mat = FindMaterial(meshObj->Material);
+
+				//the material is set on the node, only whether the geometry has a material layer has to match
+				FbxMesh* pMesh = NULL;
+				UInt64 geometryHash = 0;
+				if (instancing && !hasBones)
+				{
+					geometryHash = HashGeometry(prepared, mat != nullptr);
+					IntPtr foundMesh;
+					if (geometryIndex->TryGetValue(geometryHash, foundMesh) && SameGeometry(prepared, mat != nullptr, (FbxMesh*)foundMesh.ToPointer()))
+					{
+						pMesh = (FbxMesh*)foundMesh.ToPointer();
+						instanceHits++;
+					}
+					else
+					{
+						instanceMisses++;
 					}
+				}
+				bool instanced = pMesh != NULL;
 
-					ImportedSubmesh^ meshObj = meshList->SubmeshList[i];
-					List<ImportedFace^>^ faceList = meshObj->FaceList;
-					List<ImportedVertex^>^ vertexList = meshObj->VertexList;
+				VertexElements elements = {};
+				if (!instanced)
+				{
+					pMesh = FbxMesh::Create(pScene, "");
+					if (instancing && !hasBones && !geometryIndex->ContainsKey(geometryHash))
+					{
+						geometryIndex->Add(geometryHash, (IntPtr)pMesh);
+					}
 
-					pMesh->InitControlPoints(vertexList->Count);
-					FbxVector4* pControlPoints = pMesh->GetControlPoints();
+					pMesh->InitControlPoints(vertexCount);
+					elements.ControlPoints = pMesh->GetControlPoints();
 
-					FbxGeometryElementNormal* lGeometryElementNormal = NULL;
 					//if (normals)
 					{
-						lGeometryElementNormal = pMesh->GetElementNormal();
-						if (!lGeometryElementNormal)
+						elements.Normal = pMesh->GetElementNormal();
+						if (!elements.Normal)
 						{
-							lGeometryElementNormal = pMesh->CreateElementNormal();
+							elements.Normal = pMesh->CreateElementNormal();
 						}
-						lGeometryElementNormal->SetMappingMode(FbxGeometryElement::eByControlPoint);
-						lGeometryElementNormal->SetReferenceMode(FbxGeometryElement::eDirect);
+						elements.Normal->SetMappingMode(FbxGeometryElement::eByControlPoint);
+						elements.Normal->SetReferenceMode(FbxGeometryElement::eDirect);
 					}
 
-					FbxGeometryElementUV* lGeometryElementUV = pMesh->GetElementUV();
-					if (!lGeometryElementUV)
+					elements.UV = pMesh->GetElementUV();
+					if (!elements.UV)
 					{
-						lGeometryElementUV = pMesh->CreateElementUV("");
+						elements.UV = pMesh->CreateElementUV("");
 					}
-					lGeometryElementUV->SetMappingMode(FbxGeometryElement::eByControlPoint);
-					lGeometryElementUV->SetReferenceMode(FbxGeometryElement::eDirect);
+					elements.UV->SetMappingMode(FbxGeometryElement::eByControlPoint);
+					elements.UV->SetReferenceMode(FbxGeometryElement::eDirect);
 
-					FbxGeometryElementTangent* lGeometryElementTangent = NULL;
 					if (normals)
 					{
-						lGeometryElementTangent = pMesh->GetElementTangent();
-						if (!lGeometryElementTangent)
+						elements.Tangent = pMesh->GetElementTangent();
+						if (!elements.Tangent)
 						{
-							lGeometryElementTangent = pMesh->CreateElementTangent();
+							elements.Tangent = pMesh->CreateElementTangent();
 						}
-						lGeometryElementTangent->SetMappingMode(FbxGeometryElement::eByControlPoint);
-						lGeometryElementTangent->SetReferenceMode(FbxGeometryElement::eDirect);
+						elements.Tangent->SetMappingMode(FbxGeometryElement::eByControlPoint);
+						elements.Tangent->SetReferenceMode(FbxGeometryElement::eDirect);
 					}
 
-					bool vertexColours = vertexList->Count > 0 && dynamic_cast<ImportedVertexWithColour^>(vertexList[0]) != nullptr;
+					bool vertexColours = packed ? meshObj->Colours != nullptr : vertexList->Count > 0 && dynamic_cast<ImportedVertexWithColour^>(vertexList[0]) != nullptr;
 					if (vertexColours)
 					{
-						FbxGeometryElementVertexColor* lGeometryElementVertexColor = pMesh->CreateElementVertexColor();
-						lGeometryElementVertexColor->SetMappingMode(FbxGeometryElement::eByControlPoint);
-						lGeometryElementVertexColor->SetReferenceMode(FbxGeometryElement::eDirect);
-						for (int j = 0; j < vertexList->Count; j++)
-						{
-							ImportedVertexWithColour^ vert = (ImportedVertexWithColour^)vertexList[j];
-							lGeometryElementVertexColor->GetDirectArray().Add(FbxColor(vert->Colour.R, vert->Colour.G, vert->Colour.B, vert->Colour.A));
-						}
+						elements.VertexColor = pMesh->CreateElementVertexColor();
+						elements.VertexColor->SetMappingMode(FbxGeometryElement::eByControlPoint);
+						elements.VertexColor->SetReferenceMode(FbxGeometryElement::eDirect);
 					}
+				}
 
-					FbxNode* pMeshNode = FbxNode::Create(pScene, pName);
-					pMeshNode->SetNodeAttribute(pMesh);
-					pFrameNode->AddChild(pMeshNode);
+				FbxNode* pMeshNode = FbxNode::Create(pScene, pName);
+				pMeshNode->SetNodeAttribute(pMesh);
+				pFrameNode->AddChild(pMeshNode);
 
-					ImportedMaterial^ mat = ImportedHelpers::FindMaterial(meshObj->Material, imported->MaterialList);
-					if (mat != nullptr)
+				if (mat != nullptr)
+				{
+					ProfileScope materialScope(profiler, "Materials", "Mesh");
+					if (!instanced)
 					{
 						FbxGeometryElementMaterial* lGeometryElementMaterial = pMesh->GetElementMaterial();
 						if (!lGeometryElementMaterial)
@@ -427,179 +714,111 @@ namespace AssetStudio
 						}
 						lGeometryElementMaterial->SetMappingMode(FbxGeometryElement::eByPolygon);
 						lGeometryElementMaterial->SetReferenceMode(FbxGeometryElement::eIndexToDirect);
+					}
 
-						char* pMatName = NULL;
-						try
+					FbxSurfacePhong* pMat = ExportMaterial(mat);
+					pMeshNode->AddMaterial(pMat);
+
+					bool hasTexture = false;
+
+					for each (ImportedMaterialTexture^ texture in mat->Textures)
+					{
+						auto pTexture = ExportTexture(FindTexture(texture->Name));
+						if (pTexture != NULL)
 						{
-							pMatName = StringToCharArray(mat->Name);
-							int foundMat = -1;
-							for (int j = 0; j < pMaterials->GetCount(); j++)
+							if (texture->Dest == 0)
 							{
-								FbxSurfacePhong* pMatTemp = pMaterials->GetAt(j);
-								if (strcmp(pMatTemp->GetName(), pMatName) == 0)
-								{
-									foundMat = j;
-									break;
-								}
+								LinkTexture(texture, pTexture, pMat->Diffuse);
+								hasTexture = true;
 							}
-
-							FbxSurfacePhong* pMat;
-							if (foundMat >= 0)
+							else if (texture->Dest == 1)
 							{
-								pMat = pMaterials->GetAt(foundMat);
+								LinkTexture(texture, pTexture, pMat->NormalMap);
+								hasTexture = true;
 							}
-							else
+							else if (texture->Dest == 2)
 							{
-								FbxString lShadingName = "Phong";
-								Color diffuse = mat->Diffuse;
-								Color ambient = mat->Ambient;
-								Color emissive = mat->Emissive;
-								Color specular = mat->Specular;
-								Color reflection = mat->Reflection;
-								pMat = FbxSurfacePhong::Create(pScene, pMatName);
-								pMat->Diffuse.Set(FbxDouble3(diffuse.R, diffuse.G, diffuse.B));
-								pMat->DiffuseFactor.Set(FbxDouble(diffuse.A));
-								pMat->Ambient.Set(FbxDouble3(ambient.R, ambient.G, ambient.B));
-								pMat->AmbientFactor.Set(FbxDouble(ambient.A));
-								pMat->Emissive.Set(FbxDouble3(emissive.R, emissive.G, emissive.B));
-								pMat->EmissiveFactor.Set(FbxDouble(emissive.A));
-								pMat->Specular.Set(FbxDouble3(specular.R, specular.G, specular.B));
-								pMat->SpecularFactor.Set(FbxDouble(specular.A));
-								pMat->Reflection.Set(FbxDouble3(reflection.R, reflection.G, reflection.B));
-								pMat->ReflectionFactor.Set(FbxDouble(reflection.A));
-								pMat->Shininess.Set(FbxDouble(mat->Shininess));
-								pMat->TransparencyFactor.Set(FbxDouble(mat->Transparency));
-								pMat->ShadingModel.Set(lShadingName);
-								foundMat = pMaterials->GetCount();
-								pMaterials->Add(pMat);
+								LinkTexture(texture, pTexture, pMat->Specular);
+								hasTexture = true;
 							}
-							pMeshNode->AddMaterial(pMat);
-
-							bool hasTexture = false;
-
-							for each (ImportedMaterialTexture^ texture in mat->Textures)
+							else if (texture->Dest == 3)
 							{
-								auto pTexture = ExportTexture(ImportedHelpers::FindTexture(texture->Name, imported->TextureList));
-								if (pTexture != NULL)
-								{
-									if (texture->Dest == 0)
-									{
-										LinkTexture(texture, pTexture, pMat->Diffuse);
-										hasTexture = true;
-									}
-									else if (texture->Dest == 1)
-									{
-										LinkTexture(texture, pTexture, pMat->NormalMap);
-										hasTexture = true;
-									}
-									else if (texture->Dest == 2)
-									{
-										LinkTexture(texture, pTexture, pMat->Specular);
-										hasTexture = true;
-									}
-									else if (texture->Dest == 3)
-									{
-										LinkTexture(texture, pTexture, pMat->Bump);
-										hasTexture = true;
-									}
-								}
+								LinkTexture(texture, pTexture, pMat->Bump);
+								hasTexture = true;
 							}
-
-							if (hasTexture)
-							{
-								pMeshNode->SetShadingMode(FbxNode::eTextureShading);
-							}
-						}
-						finally
-						{
-							Marshal::FreeHGlobal((IntPtr)pMatName);
 						}
 					}
 
-					for (int j = 0; j < vertexList->Count; j++)
+					if (hasTexture)
 					{
-						ImportedVertex^ vertex = vertexList[j];
-						Vector3 coords = vertex->Position;
-						pControlPoints[j] = FbxVector4(coords.X, coords.Y, coords.Z, 0);
-						//if (normals)
-						{
-							Vector3 normal = vertex->Normal;
-							lGeometryElementNormal->GetDirectArray().Add(FbxVector4(normal.X, normal.Y, normal.Z, 0));
-						}
-						array<float>^ uv = vertex->UV;
-						if (uv != nullptr)
-							lGeometryElementUV->GetDirectArray().Add(FbxVector2(uv[0], uv[1]));
-						if (normals)
-						{
-							Vector4 tangent = vertex->Tangent;
-							lGeometryElementTangent->GetDirectArray().Add(FbxVector4(tangent.X, tangent.Y, tangent.Z, tangent.W));
-						}
-
-						if (hasBones && vertex->BoneIndices != nullptr)
-						{
-							auto boneIndices = vertex->BoneIndices;
-							auto weights4 = vertex->Weights;
-							for (int k = 0; k < weights4->Length; k++)
-							{
-								if (boneIndices[k] < boneList->Count && weights4[k] > 0)
-								{
-									FbxCluster* pCluster = pClusterArray->GetAt(boneIndices[k]);
-									pCluster->AddControlPointIndex(j, weights4[k]);
-								}
-							}
-						}
+						pMeshNode->SetShadingMode(FbxNode::eTextureShading);
 					}
+				}
 
-					for (int j = 0; j < faceList->Count; j++)
-					{
-						ImportedFace^ face = faceList[j];
-						pMesh->BeginPolygon(0);
-						pMesh->AddPolygon(face->VertexIndices[0]);
-						pMesh->AddPolygon(face->VertexIndices[1]);
-						pMesh->AddPolygon(face->VertexIndices[2]);
-						pMesh->EndPolygon();
-					}
+				if (!instanced)
+				{
+					CommitVertexBuffers(prepared, elements);
+					CommitTriangles(prepared, pMesh);
+				}
+				if (prepared.DroppedTriangles > 0)
+				{
+					Logger::Warning(String::Format("{0}: dropped {1} triangles with out of range vertex indices", meshList->Path, prepared.DroppedTriangles));
+				}
 
-					if (hasBones)
+				if (hasBones)
+				{
+					//clusters only for bones with influences, each filled from its bucket in one copy
+					ProfileScope skinScope(profiler, "Skin", "Mesh");
+					FbxSkin* pSkin = NULL;
+					FbxAMatrix lMeshMatrix = pMeshNode->EvaluateGlobalTransform();
+					for (int j = 0; j < boneList->Count; j++)
 					{
-						FbxSkin* pSkin = FbxSkin::Create(pScene, "");
-						FbxAMatrix lMeshMatrix = pMeshNode->EvaluateGlobalTransform();
-						for (int j = 0; j < boneList->Count; j++)
+						int start = prepared.ClusterStart.empty() ? 0 : prepared.ClusterStart[j];
+						int count = prepared.ClusterStart.empty() ? 0 : prepared.ClusterStart[j + 1] - start;
+						FbxNode* pNode = pBoneNodeList->GetAt(j);
+						if (count == 0 || pNode == NULL)
 						{
-							FbxCluster* pCluster = pClusterArray->GetAt(j);
-							if (pCluster->GetControlPointIndicesCount() > 0)
+							clustersSkipped++;
+							meshClustersSkipped++;
+							continue;
+						}
+
+						FbxString lClusterName = pNode->GetNameOnly() + FbxString("Cluster");
+						FbxCluster* pCluster = FbxCluster::Create(pSdkManager, lClusterName.Buffer());
+						pCluster->SetLink(pNode);
+						pCluster->SetLinkMode(FbxCluster::eTotalOne);
+						pCluster->SetControlPointIWCount(count);
+						memcpy(pCluster->GetControlPointIndices(), &prepared.ClusterIndices[start], count * sizeof(int));
+						memcpy(pCluster->GetControlPointWeights(), &prepared.ClusterWeights[start], count * sizeof(double));
+
+						auto boneMatrix = boneList[j]->Matrix;
+						FbxAMatrix lBoneMatrix;
+						for (int m = 0; m < 4; m++)
+						{
+							for (int n = 0; n < 4; n++)
 							{
-								auto boneMatrix = boneList[j]->Matrix;
-								FbxAMatrix lBoneMatrix;
-								for (int m = 0; m < 4; m++)
-								{
-									for (int n = 0; n < 4; n++)
-									{
-										lBoneMatrix.mData[m][n] = boneMatrix[m, n];
-									}
-								}
-
-								pCluster->SetTransformMatrix(lMeshMatrix);
-								pCluster->SetTransformLinkMatrix(lMeshMatrix * lBoneMatrix.Inverse());
-
-								pSkin->AddCluster(pCluster);
+								lBoneMatrix.mData[m][n] = boneMatrix[m, n];
 							}
 						}
 
-						if (pSkin->GetClusterCount() > 0)
+						pCluster->SetTransformMatrix(lMeshMatrix);
+						pCluster->SetTransformLinkMatrix(lMeshMatrix * lBoneMatrix.Inverse());
+
+						if (pSkin == NULL)
 						{
+							pSkin = FbxSkin::Create(pScene, "");
 							pMesh->AddDeformer(pSkin);
 						}
+						pSkin->AddCluster(pCluster);
+						clustersCreated++;
+						meshClustersCreated++;
 					}
 				}
-				finally
-				{
-					if (pClusterArray != NULL)
-					{
-						delete pClusterArray;
-					}
-					Marshal::FreeHGlobal((IntPtr)pName);
-				}
+			}
+
+			if (hasBones)
+			{
+				Logger::Debug(String::Format("{0}: {1} skin clusters created, {2} skipped", meshList->Path, meshClustersCreated, meshClustersSkipped));
 			}
 		}
 		finally
@@ -611,41 +830,294 @@ namespace AssetStudio
 		}
 	}
 
-	FbxNode* Fbx::Exporter::FindNodeByPath(String ^ path, bool recursive)
+	void Fbx::Exporter::PrepareSubmesh(int i)
 	{
-		array<String^>^ splitPath = path->Split('/');
-		FbxNode* lNode = pScene->GetRootNode();
-		for (int i = 0; i < splitPath->Length; i++)
+		ImportedSubmesh^ meshObj = preparingMesh->SubmeshList[i];
+		PreparedSubmesh& prepared = pPreparedSubmeshes[i];
+		bool packed = meshObj->Positions != nullptr && meshObj->Positions->Length > 0;
+		//VertexList of a packed submesh would be built from the streams, it is only read for a skin without packed influences
+		List<ImportedVertex^>^ vertexList = packed ? nullptr : meshObj->VertexList;
+
+		if (packed)
 		{
-			String^ frameName = splitPath[i];
-			char* pNodeName = NULL;
-			try
+			int vertexCount = meshObj->Positions->Length / 3;
+			pin_ptr<float> pPositions = &meshObj->Positions[0];
+			pin_ptr<float> pNormals = nullptr;
+			pin_ptr<float> pUV0 = nullptr;
+			pin_ptr<float> pTangents = nullptr;
+			pin_ptr<float> pColours = nullptr;
+			if (meshObj->Normals != nullptr && meshObj->Normals->Length >= vertexCount * 3)
 			{
-				pNodeName = StringToCharArray(frameName);
-				FbxNode* foundNode;
-				if (recursive && i == 0)
+				pNormals = &meshObj->Normals[0];
+			}
+			if (meshObj->UV0 != nullptr && meshObj->UV0->Length >= vertexCount * 2)
+			{
+				pUV0 = &meshObj->UV0[0];
+			}
+			if (meshObj->Tangents != nullptr && meshObj->Tangents->Length >= vertexCount * 4)
+			{
+				pTangents = &meshObj->Tangents[0];
+			}
+			if (meshObj->Colours != nullptr && meshObj->Colours->Length >= vertexCount * 4)
+			{
+				pColours = &meshObj->Colours[0];
+			}
+
+			VertexBuffers buffers;
+			buffers.VertexCount = vertexCount;
+			buffers.Positions = pPositions;
+			buffers.Normals = pNormals;
+			buffers.UV0 = pUV0;
+			buffers.Tangents = pTangents;
+			buffers.Colours = pColours;
+			PrepareVertexBuffers(buffers, preparingNormals, prepared);
+		}
+		else
+		{
+			int vertexCount = vertexList->Count;
+			bool vertexColours = vertexCount > 0 && dynamic_cast<ImportedVertexWithColour^>(vertexList[0]) != nullptr;
+			prepared.VertexCount = vertexCount;
+			prepared.ControlPoints.resize(vertexCount);
+			prepared.Normals.reserve(vertexCount);
+			prepared.UV.reserve(vertexCount);
+			for (int j = 0; j < vertexCount; j++)
+			{
+				ImportedVertex^ vertex = vertexList[j];
+				Vector3 coords = vertex->Position;
+				prepared.ControlPoints[j] = FbxVector4(coords.X, coords.Y, coords.Z, 0);
+				Vector3 normal = vertex->Normal;
+				prepared.Normals.push_back(FbxVector4(normal.X, normal.Y, normal.Z, 0));
+				array<float>^ uv = vertex->UV;
+				if (uv != nullptr)
+				{
+					prepared.UV.push_back(FbxVector2(uv[0], uv[1]));
+				}
+				if (preparingNormals)
+				{
+					Vector4 tangent = vertex->Tangent;
+					prepared.Tangents.push_back(FbxVector4(tangent.X, tangent.Y, tangent.Z, tangent.W));
+				}
+				if (vertexColours)
 				{
-					foundNode = lNode->FindChild(pNodeName);
+					ImportedVertexWithColour^ vert = (ImportedVertexWithColour^)vertex;
+					prepared.Colours.push_back(FbxColor(vert->Colour.R, vert->Colour.G, vert->Colour.B, vert->Colour.A));
+				}
+			}
+		}
+
+		array<int>^ packedBones = packed ? meshObj->BoneIndices : nullptr;
+		array<float>^ packedWeights = packed ? meshObj->Weights : nullptr;
+		bool packedSkin = packedBones != nullptr && packedWeights != nullptr && packedBones->Length >= prepared.VertexCount * 4 && packedWeights->Length >= prepared.VertexCount * 4;
+		if (preparingBoneCount > 0 && !packedSkin && vertexList == nullptr)
+		{
+			vertexList = meshObj->VertexList;
+		}
+		if (preparingBoneCount > 0 && (packedSkin || vertexList != nullptr))
+		{
+			//four influences per vertex, kept per vertex until the optimisation has welded and renumbered them
+			prepared.InfluenceBones.assign((size_t)prepared.VertexCount * 4, -1);
+			prepared.InfluenceWeights.assign((size_t)prepared.VertexCount * 4, 0);
+			int skinVertexCount = packedSkin ? prepared.VertexCount : Math::Min(vertexList->Count, prepared.VertexCount);
+			for (int j = 0; j < skinVertexCount; j++)
+			{
+				array<int>^ boneIndices;
+				array<float>^ weights4;
+				int first = 0;
+				int count;
+				if (packedSkin)
+				{
+					boneIndices = packedBones;
+					weights4 = packedWeights;
+					first = j * 4;
+					count = 4;
 				}
 				else
 				{
-					foundNode = lNode->FindChild(pNodeName, false);
+					ImportedVertex^ vertex = vertexList[j];
+					if (vertex->BoneIndices == nullptr)
+					{
+						continue;
+					}
+					boneIndices = vertex->BoneIndices;
+					weights4 = vertex->Weights;
+					count = Math::Min(4, Math::Min(boneIndices->Length, weights4->Length));
 				}
-				if (foundNode == NULL)
+				for (int k = 0; k < count; k++)
 				{
-					//throw gcnew Exception(gcnew String("Couldn't find path ") + path);
-					return NULL;
+					int bone = boneIndices[first + k];
+					if (bone >= 0 && bone < preparingBoneCount && weights4[first + k] > 0)
+					{
+						prepared.InfluenceBones[j * 4 + k] = bone;
+						prepared.InfluenceWeights[j * 4 + k] = weights4[first + k];
+					}
 				}
-				lNode = foundNode;
 			}
-			finally
+		}
+
+		array<int>^ indices = meshObj->Indices;
+		if (indices == nullptr && meshObj->FaceList != nullptr)
+		{
+			List<ImportedFace^>^ faceList = meshObj->FaceList;
+			indices = gcnew array<int>(faceList->Count * 3);
+			for (int j = 0; j < faceList->Count; j++)
+			{
+				array<int>^ vertexIndices = faceList[j]->VertexIndices;
+				indices[j * 3] = vertexIndices[0];
+				indices[j * 3 + 1] = vertexIndices[1];
+				indices[j * 3 + 2] = vertexIndices[2];
+			}
+		}
+		if (indices != nullptr && indices->Length >= 3)
+		{
+			pin_ptr<int> pIndices = &indices[0];
+			PrepareTriangles(pIndices, indices->Length, prepared);
+		}
+		else
+		{
+			prepared.DroppedTriangles = 0;
+		}
+
+		if (preparingOptimize)
+		{
+			OptimizeSubmesh(prepared, weldTolerance);
+		}
+		BucketInfluences(prepared, preparingBoneCount);
+	}
+
+	FbxNode* Fbx::Exporter::FindNodeByPath(String ^ path, bool recursive)
+	{
+		IntPtr lNode;
+		if (!recursive)
+		{
+			if (nodePathIndex->TryGetValue(path, lNode))
+			{
+				nodeIndexHits++;
+				return (FbxNode*)lNode.ToPointer();
+			}
+			nodeIndexMisses++;
+			return NULL;
+		}
+
+		if (nodeLookupCache->TryGetValue(path, lNode))
+		{
+			if (lNode == IntPtr::Zero)
+			{
+				nodeIndexMisses++;
+				return NULL;
+			}
+			nodeIndexHits++;
+			return (FbxNode*)lNode.ToPointer();
+		}
+
+		FbxNode* foundNode = NULL;
+		int slash = path->IndexOf('/');
+		String^ firstName = slash < 0 ? path : path->Substring(0, slash);
+		IntPtr firstNode;
+		if (nodeNameIndex->TryGetValue(firstName, firstNode))
+		{
+			if (slash < 0)
 			{
-				Marshal::FreeHGlobal((IntPtr)pNodeName);
+				foundNode = (FbxNode*)firstNode.ToPointer();
+			}
+			else
+			{
+				String^ firstPath = nodePaths[firstNode];
+				IntPtr indexedNode;
+				if (nodePathIndex->TryGetValue(firstPath, indexedNode) && indexedNode == firstNode)
+				{
+					if (nodePathIndex->TryGetValue(firstPath + path->Substring(slash), lNode))
+					{
+						foundNode = (FbxNode*)lNode.ToPointer();
+					}
+				}
+				else
+				{
+					//the first match is shadowed by an earlier sibling with the same path, walk its children instead
+					foundNode = FindChildByPath((FbxNode*)firstNode.ToPointer(), path->Split('/'), 1);
+				}
 			}
 		}
+
+		if (foundNode != NULL)
+		{
+			nodeIndexHits++;
+		}
+		else
+		{
+			nodeIndexMisses++;
+		}
+		nodeLookupCache->Add(path, (IntPtr)foundNode);
+		return foundNode;
+	}
+
+	FbxNode* Fbx::Exporter::FindChildByPath(FbxNode* pNode, array<String^>^ splitPath, int start)
+	{
+		FbxNode* lNode = pNode;
+		for (int i = start; i < splitPath->Length; i++)
+		{
+			FbxNode* foundNode = lNode->FindChild(names->Intern(splitPath[i]), false);
+			if (foundNode == NULL)
+			{
+				//throw gcnew Exception(gcnew String("Couldn't find path ") + path);
+				return NULL;
+			}
+			lNode = foundNode;
+		}
 		return lNode;
 	}
 
+	ImportedMaterial^ Fbx::Exporter::FindMaterial(String^ name)
+	{
+		ImportedMaterial^ mat = nullptr;
+		if (name != nullptr)
+		{
+			importedMaterials->TryGetValue(name, mat);
+		}
+		return mat;
+	}
+
+	ImportedTexture^ Fbx::Exporter::FindTexture(String^ name)
+	{
+		ImportedTexture^ tex = nullptr;
+		if (!String::IsNullOrEmpty(name))
+		{
+			importedTextures->TryGetValue(name, tex);
+		}
+		return tex;
+	}
+
+	FbxSurfacePhong* Fbx::Exporter::ExportMaterial(ImportedMaterial^ mat)
+	{
+		IntPtr foundMat;
+		if (materialIndex->TryGetValue(mat->Name, foundMat))
+		{
+			return (FbxSurfacePhong*)foundMat.ToPointer();
+		}
+
+		FbxString lShadingName = "Phong";
+		Color diffuse = mat->Diffuse;
+		Color ambient = mat->Ambient;
+		Color emissive = mat->Emissive;
+		Color specular = mat->Specular;
+		Color reflection = mat->Reflection;
+		FbxSurfacePhong* pMat = FbxSurfacePhong::Create(pScene, names->Intern(mat->Name));
+		pMat->Diffuse.Set(FbxDouble3(diffuse.R, diffuse.G, diffuse.B));
+		pMat->DiffuseFactor.Set(FbxDouble(diffuse.A));
+		pMat->Ambient.Set(FbxDouble3(ambient.R, ambient.G, ambient.B));
+		pMat->AmbientFactor.Set(FbxDouble(ambient.A));
+		pMat->Emissive.Set(FbxDouble3(emissive.R, emissive.G, emissive.B));
+		pMat->EmissiveFactor.Set(FbxDouble(emissive.A));
+		pMat->Specular.Set(FbxDouble3(specular.R, specular.G, specular.B));
+		pMat->SpecularFactor.Set(FbxDouble(specular.A));
+		pMat->Reflection.Set(FbxDouble3(reflection.R, reflection.G, reflection.B));
+		pMat->ReflectionFactor.Set(FbxDouble(reflection.A));
+		pMat->Shininess.Set(FbxDouble(mat->Shininess));
+		pMat->TransparencyFactor.Set(FbxDouble(mat->Transparency));
+		pMat->ShadingModel.Set(lShadingName);
+		materialIndex->Add(mat->Name, (IntPtr)pMat);
+		return pMat;
+	}
+
 	FbxFileTexture* Fbx::Exporter::ExportTexture(ImportedTexture^ matTex)
 	{
 		FbxFileTexture* pTex = NULL;
@@ -653,63 +1125,122 @@ namespace AssetStudio
 		if (matTex != nullptr)
 		{
 			String^ matTexName = matTex->Name;
-			char* pTexName = NULL;
-			try
+			IntPtr foundTex;
+			if (textureIndex->TryGetValue(matTexName, foundTex))
+			{
+				return (FbxFileTexture*)foundTex.ToPointer();
+			}
+
+			//identical images under different names share one texture and one file
+			array<Byte>^ data = matTex->Data;
+			UInt64 contentHash = 0;
+			if (data != nullptr && data->Length > 0)
 			{
-				pTexName = StringToCharArray(matTexName);
-				int foundTex = -1;
-				for (int i = 0; i < pTextures->GetCount(); i++)
+				pin_ptr<Byte> pData = &data[0];
+				contentHash = HashBytes(pData, data->Length) ^ (UInt64)data->Length;
+				if (textureContentIndex->TryGetValue(contentHash, foundTex))
 				{
-					FbxFileTexture* pTexTemp = pTextures->GetAt(i);
-					if (strcmp(pTexTemp->GetName(), pTexName) == 0)
+					array<Byte>^ foundData = textureSources[foundTex]->Data;
+					bool same;
+					if (foundData == nullptr)
 					{
-						foundTex = i;
-						break;
+						//released under a memory budget, the digest taken before the release decides
+						array<Byte>^ digest;
+						same = textureDigests->TryGetValue(foundTex, digest) && SameDigest(digest, TextureDigest(data));
 					}
-				}
-
-				if (foundTex >= 0)
-				{
-					pTex = pTextures->GetAt(foundTex);
-				}
-				else
-				{
-					pTex = FbxFileTexture::Create(pScene, pTexName);
-					pTex->SetFileName(pTexName);
-					pTex->SetTextureUse(FbxTexture::eStandard);
-					pTex->SetMappingType(FbxTexture::eUV);
-					pTex->SetMaterialUse(FbxFileTexture::eModelMaterial);
-					pTex->SetSwapUV(false);
-					pTex->SetTranslation(0.0, 0.0);
-					pTex->SetScale(1.0, 1.0);
-					pTex->SetRotation(0.0, 0.0);
-					pTextures->Add(pTex);
-
-					String^ path = Path::GetDirectoryName(gcnew String(pExporter->GetFileName().Buffer()));
-					if (path == String::Empty)
+					else
 					{
-						path = ".";
+						pin_ptr<Byte> pFoundData = &foundData[0];
+						same = foundData->Length == data->Length && memcmp(pData, pFoundData, data->Length) == 0;
 					}
-					FileInfo^ file = gcnew FileInfo(path + Path::DirectorySeparatorChar + Path::GetFileName(matTex->Name));
-					DirectoryInfo^ dir = file->Directory;
-					if (!dir->Exists)
+					if (same)
 					{
-						dir->Create();
+						textureIndex->Add(matTexName, foundTex);
+						return (FbxFileTexture*)foundTex.ToPointer();
 					}
-					BinaryWriter^ writer = gcnew BinaryWriter(file->Create());
-					writer->Write(matTex->Data);
-					writer->Close();
 				}
 			}
-			finally
+
+			FileInfo^ file = gcnew FileInfo(Path::Combine(exportDir, Path::GetFileName(matTex->Name)));
+			pTex = FbxFileTexture::Create(pScene, names->Intern(matTexName));
+			pTex->SetFileName(names->Intern(file->FullName));
+			pTex->SetRelativeFileName(names->Intern(file->Name));
+			pTex->SetTextureUse(FbxTexture::eStandard);
+			pTex->SetMappingType(FbxTexture::eUV);
+			pTex->SetMaterialUse(FbxFileTexture::eModelMaterial);
+			pTex->SetSwapUV(false);
+			pTex->SetTranslation(0.0, 0.0);
+			pTex->SetScale(1.0, 1.0);
+			pTex->SetRotation(0.0, 0.0);
+			textureIndex->Add(matTexName, (IntPtr)pTex);
+			bool contentIndexed = data != nullptr && data->Length > 0 && !textureContentIndex->ContainsKey(contentHash);
+			if (contentIndexed)
 			{
-				Marshal::FreeHGlobal((IntPtr)pTexName);
+				textureContentIndex->Add(contentHash, (IntPtr)pTex);
+				textureSources->Add((IntPtr)pTex, matTex);
+			}
+
+			textureWriter->Enqueue(file->FullName, matTex->Data);
+			if (budget->Enabled)
+			{
+				if (contentIndexed)
+				{
+					textureDigests->Add((IntPtr)pTex, TextureDigest(data));
+				}
+				budget->Release(matTex);
 			}
 		}
 
 		return pTex;
 	}
 
+	void Fbx::Exporter::DrainTextures()
+	{
+		if (textureWriter != nullptr)
+		{
+			textureWriter->Drain();
+			Logger::Debug(String::Format("Textures: {0} files, {1} bytes written, {2} unchanged, {3} ms stalled", textureWriter->FilesWritten, textureWriter->BytesWritten, textureWriter->FilesSkipped, (Int64)textureWriter->StallTime.TotalMilliseconds));
+		}
+	}
+
+	void Fbx::Exporter::CollectStatistics(String^ path, ExportStatistics^ statistics)
+	{
+		statistics->Nodes = pScene->GetNodeCount();
+		statistics->Meshes = pScene->GetSrcObjectCount<FbxMesh>();
+		Int64 controlPoints = 0;
+		for (int i = 0; i < statistics->Meshes; i++)
+		{
+			controlPoints += pScene->GetSrcObject<FbxMesh>(i)->GetControlPointsCount();
+		}
+		statistics->ControlPoints = controlPoints;
+		statistics->Clusters = clustersCreated;
+		statistics->SkippedClusters = clustersSkipped;
+		statistics->Shapes = pScene->GetSrcObjectCount<FbxShape>();
+		statistics->Curves = pScene->GetSrcObjectCount<FbxAnimCurve>();
+		Int64 keys = 0;
+		for (int i = 0; i < statistics->Curves; i++)
+		{
+			keys += pScene->GetSrcObject<FbxAnimCurve>(i)->KeyGetCount();
+		}
+		statistics->Keys = keys;
+		statistics->TexturesWritten = textureWriter != nullptr ? textureWriter->FilesWritten : 0;
+		statistics->TexturesSkipped = textureWriter != nullptr ? textureWriter->FilesSkipped : 0;
+		if (textureWriter != nullptr)
+		{
+			statistics->TextureFiles->AddRange(textureWriter->Files);
+		}
+		FileInfo^ file = gcnew FileInfo(path);
+		statistics->BytesOut = (file->Exists ? file->Length : 0) + (textureWriter != nullptr ? textureWriter->BytesWritten : 0);
+		statistics->NodeIndexHits = nodeIndexHits;
+		statistics->NodeIndexMisses = nodeIndexMisses;
+		statistics->InstanceHits = instanceHits;
+		statistics->InstanceMisses = instanceMisses;
+		statistics->OptimizedTriangles = optimizedTriangles;
+		statistics->CacheMissesBefore = cacheMissesBefore;
+		statistics->CacheMissesAfter = cacheMissesAfter;
+		statistics->WeldedVertices = weldedVertices;
+	}
+
 	void Fbx::Exporter::LinkTexture(ImportedMaterialTexture^ texture, FbxFileTexture* pTexture, FbxProperty& prop)
 	{
 		pTexture->SetTranslation(texture->Offset.X, texture->Offset.Y);
@@ -717,7 +1248,37 @@ namespace AssetStudio
 		prop.ConnectSrcObject(pTexture);
 	}
 
-	void Fbx::Exporter::ExportAnimations(bool eulerFilter, float filterPrecision, bool flatInbetween)
+	static void CopyRest(const FbxDouble3& value, float* rest)
+	{
+		rest[0] = (float)value[0];
+		rest[1] = (float)value[1];
+		rest[2] = (float)value[2];
+	}
+
+	//Creates the x, y and z curves of the property only when there are keys for them
+	static bool AddPropertyKeys(FbxProperty& prop, FbxAnimLayer* pAnimLayer, const SceneCurve& keys, FbxAnimCurve** pCurves)
+	{
+		if (keys.Times.empty())
+		{
+			return false;
+		}
+
+		pCurves[0] = prop.GetCurve(pAnimLayer, FBXSDK_CURVENODE_COMPONENT_X, true);
+		pCurves[1] = prop.GetCurve(pAnimLayer, FBXSDK_CURVENODE_COMPONENT_Y, true);
+		pCurves[2] = prop.GetCurve(pAnimLayer, FBXSDK_CURVENODE_COMPONENT_Z, true);
+		for (int c = 0; c < 3; c++)
+		{
+			pCurves[c]->KeyModifyBegin();
+		}
+		AddCurveKeys(pCurves, keys);
+		for (int c = 0; c < 3; c++)
+		{
+			pCurves[c]->KeyModifyEnd();
+		}
+		return true;
+	}
+
+	void Fbx::Exporter::ExportAnimations(const TrackFilter& filter, bool flatInbetween)
 	{
 		auto importedAnimationList = imported->AnimationList;
 		if (importedAnimationList == nullptr)
@@ -725,30 +1286,28 @@ namespace AssetStudio
 			return;
 		}
 
-		FbxAnimCurveFilterUnroll* lFilter = eulerFilter ? new FbxAnimCurveFilterUnroll() : NULL;
-
 		for (int i = 0; i < importedAnimationList->Count; i++)
 		{
 			auto importedAnimation = importedAnimationList[i];
 			FbxString kTakeName;
 			if (importedAnimation->Name)
 			{
-				WITH_MARSHALLED_STRING
-				(
-					pClipName,
-					importedAnimation->Name,
-					kTakeName = FbxString(pClipName);
-				);
+				kTakeName = FbxString(names->Intern(importedAnimation->Name));
 			}
 			else
 			{
 				kTakeName = FbxString("Take") + FbxString(i);
 			}
-			ExportKeyframedAnimation(importedAnimation, kTakeName, lFilter, filterPrecision, flatInbetween);
+			ExportKeyframedAnimation(importedAnimation, kTakeName, filter, flatInbetween);
 		}
 	}
 
-	void Fbx::Exporter::ExportKeyframedAnimation(ImportedKeyframedAnimation^ parser, FbxString& kTakeName, FbxAnimCurveFilterUnroll* eulerFilter, float filterPrecision, bool flatInbetween)
+	void Fbx::Exporter::FilterAnimationTrack(int i)
+	{
+		FilterTrack(pFilteringTracks[i], *pTrackFilter, &pFilteringRests[i * 9]);
+	}
+
+	void Fbx::Exporter::ExportKeyframedAnimation(ImportedKeyframedAnimation^ parser, FbxString& kTakeName, const TrackFilter& filter, bool flatInbetween)
 	{
 		List<ImportedAnimationKeyframedTrack^>^ pAnimationList = parser->TrackList;
 
@@ -757,81 +1316,75 @@ namespace AssetStudio
 		FbxAnimStack* lAnimStack = FbxAnimStack::Create(pScene, lTakeName);
 		FbxAnimLayer* lAnimLayer = FbxAnimLayer::Create(pScene, "Base Layer");
 		lAnimStack->AddMember(lAnimLayer);
-
+		ProfileScope scope(profiler, nullptr, nullptr, parser->Name, "clip");
+
+		//each track is gathered into flat buffers, filtered on the thread pool and handed to the curves in one call per property
+		std::vector<SceneTrack> tracks;
+		std::vector<FbxNode*> nodes;
+		std::vector<float> rests;
+		tracks.reserve(pAnimationList->Count);
+		nodes.reserve(pAnimationList->Count);
+		rests.reserve(pAnimationList->Count * 9);
 		for (int j = 0; j < pAnimationList->Count; j++)
 		{
 			ImportedAnimationKeyframedTrack^ keyframeList = pAnimationList[j];
 			FbxNode* pNode = FindNodeByPath(keyframeList->Path, true);
 			if (pNode != nullptr)
 			{
-				FbxAnimCurve* lCurveSX = pNode->LclScaling.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_X, true);
-				FbxAnimCurve* lCurveSY = pNode->LclScaling.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_Y, true);
-				FbxAnimCurve* lCurveSZ = pNode->LclScaling.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_Z, true);
-				FbxAnimCurve* lCurveRX = pNode->LclRotation.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_X, true);
-				FbxAnimCurve* lCurveRY = pNode->LclRotation.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_Y, true);
-				FbxAnimCurve* lCurveRZ = pNode->LclRotation.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_Z, true);
-				FbxAnimCurve* lCurveTX = pNode->LclTranslation.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_X, true);
-				FbxAnimCurve* lCurveTY = pNode->LclTranslation.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_Y, true);
-				FbxAnimCurve* lCurveTZ = pNode->LclTranslation.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_Z, true);
-
-				lCurveSX->KeyModifyBegin();
-				lCurveSY->KeyModifyBegin();
-				lCurveSZ->KeyModifyBegin();
-				lCurveRX->KeyModifyBegin();
-				lCurveRY->KeyModifyBegin();
-				lCurveRZ->KeyModifyBegin();
-				lCurveTX->KeyModifyBegin();
-				lCurveTY->KeyModifyBegin();
-				lCurveTZ->KeyModifyBegin();
-
-				FbxTime lTime;
-
-				for each (auto Scaling in keyframeList->Scalings)
-				{
-					lTime.SetSecondDouble(Scaling->time);
-
-					lCurveSX->KeySet(lCurveSX->KeyAdd(lTime), lTime, Scaling->value.X);
-					lCurveSY->KeySet(lCurveSY->KeyAdd(lTime), lTime, Scaling->value.Y);
-					lCurveSZ->KeySet(lCurveSZ->KeyAdd(lTime), lTime, Scaling->value.Z);
-				}
-				for each (auto Rotation in keyframeList->Rotations)
-				{
-					lTime.SetSecondDouble(Rotation->time);
-
-					lCurveRX->KeySet(lCurveRX->KeyAdd(lTime), lTime, Rotation->value.X);
-					lCurveRY->KeySet(lCurveRY->KeyAdd(lTime), lTime, Rotation->value.Y);
-					lCurveRZ->KeySet(lCurveRZ->KeyAdd(lTime), lTime, Rotation->value.Z);
-				}
-				for each (auto Translation in keyframeList->Translations)
-				{
-					lTime.SetSecondDouble(Translation->time);
+				tracks.push_back(SceneTrack());
+				SceneTrack& track = tracks.back();
+				track.Frame = j;
+				CopyKeys(keyframeList->Scalings, track.Scalings);
+				CopyKeys(keyframeList->Rotations, track.Rotations);
+				CopyKeys(keyframeList->Translations, track.Translations);
+				nodes.push_back(pNode);
+				rests.resize(rests.size() + 9);
+				float* rest = &rests[rests.size() - 9];
+				CopyRest(pNode->LclScaling.Get(), rest);
+				CopyRest(pNode->LclRotation.Get(), rest + 3);
+				CopyRest(pNode->LclTranslation.Get(), rest + 6);
+			}
+		}
 
-					lCurveTX->KeySet(lCurveTX->KeyAdd(lTime), lTime, Translation->value.X);
-					lCurveTY->KeySet(lCurveTY->KeyAdd(lTime), lTime, Translation->value.Y);
-					lCurveTZ->KeySet(lCurveTZ->KeyAdd(lTime), lTime, Translation->value.Z);
-				}
+		bool reduce = filter.Reduction.Position > 0 || filter.Reduction.Rotation > 0 || filter.Reduction.Scale > 0;
+		size_t keysBefore = 0;
+		size_t keysAfter = 0;
+		for (size_t j = 0; j < tracks.size(); j++)
+		{
+			keysBefore += tracks[j].Scalings.Times.size() + tracks[j].Rotations.Times.size() + tracks[j].Translations.Times.size();
+		}
+		if ((filter.EulerFilter || reduce) && !tracks.empty())
+		{
+			pFilteringTracks = tracks.data();
+			pFilteringRests = rests.data();
+			pTrackFilter = &filter;
+			try
+			{
+				Parallel::For(0, (int)tracks.size(), gcnew Action<int>(this, &Fbx::Exporter::FilterAnimationTrack));
+			}
+			finally
+			{
+				pFilteringTracks = NULL;
+				pFilteringRests = NULL;
+				pTrackFilter = NULL;
+			}
+		}
 
-				lCurveSX->KeyModifyEnd();
-				lCurveSY->KeyModifyEnd();
-				lCurveSZ->KeyModifyEnd();
-				lCurveRX->KeyModifyEnd();
-				lCurveRY->KeyModifyEnd();
-				lCurveRZ->KeyModifyEnd();
-				lCurveTX->KeyModifyEnd();
-				lCurveTY->KeyModifyEnd();
-				lCurveTZ->KeyModifyEnd();
+		for (size_t j = 0; j < tracks.size(); j++)
+		{
+			SceneTrack& track = tracks[j];
+			FbxNode* pNode = nodes[j];
+			keysAfter += track.Scalings.Times.size() + track.Rotations.Times.size() + track.Translations.Times.size();
+
+			FbxAnimCurve* lCurves[3];
+			AddPropertyKeys(pNode->LclScaling, lAnimLayer, track.Scalings, lCurves);
+			AddPropertyKeys(pNode->LclTranslation, lAnimLayer, track.Translations, lCurves);
+			AddPropertyKeys(pNode->LclRotation, lAnimLayer, track.Rotations, lCurves);
+		}
 
-				if (eulerFilter)
-				{
-					FbxAnimCurve* lCurve[3];
-					lCurve[0] = lCurveRX;
-					lCurve[1] = lCurveRY;
-					lCurve[2] = lCurveRZ;
-					eulerFilter->Reset();
-					eulerFilter->SetQualityTolerance(filterPrecision);
-					eulerFilter->Apply(lCurve, 3);
-				}
-			}
+		if (reduce)
+		{
+			Logger::Debug(String::Format("{0}: {1} -> {2} keys ({3:P1})", Utf8ToString(lTakeName), (UInt64)keysBefore, (UInt64)keysAfter, keysBefore > 0 ? (double)keysAfter / keysBefore : 1.0));
 		}
 	}
 
@@ -845,26 +1398,12 @@ namespace AssetStudio
 		for (int meshIdx = 0; meshIdx < imported->MeshList->Count; meshIdx++)
 		{
 			ImportedMesh^ meshList = imported->MeshList[meshIdx];
-			FbxNode* pBaseNode = NULL;
-			for (int nodeIdx = 0; nodeIdx < pMeshNodes->GetCount(); nodeIdx++)
-			{
-				FbxNode* pMeshNode = pMeshNodes->GetAt(nodeIdx);
-				String^ framePath = gcnew String(pMeshNode->GetName());
-				FbxNode* rootNode = pMeshNode;
-				while ((rootNode = rootNode->GetParent()) != pScene->GetRootNode())
-				{
-					framePath = gcnew String(rootNode->GetName()) + "/" + framePath;
-				}
-				if (framePath == meshList->Path)
-				{
-					pBaseNode = pMeshNode;
-					break;
-				}
-			}
-			if (pBaseNode == NULL)
+			IntPtr baseNode;
+			if (meshList->Path == nullptr || !meshNodeIndex->TryGetValue(meshList->Path, baseNode))
 			{
 				continue;
 			}
+			FbxNode* pBaseNode = (FbxNode*)baseNode.ToPointer();
 
 			for each (ImportedMorph^ morph in imported->MorphList)
 			{
@@ -876,30 +1415,45 @@ namespace AssetStudio
 				int meshVertexIndex = 0;
 				for (int meshObjIdx = pBaseNode->GetChildCount() - meshList->SubmeshList->Count; meshObjIdx < meshList->SubmeshList->Count; meshObjIdx++)
 				{
-					List<ImportedVertex^>^ vertList = meshList->SubmeshList[meshObjIdx]->VertexList;
+					ImportedSubmesh^ submesh = meshList->SubmeshList[meshObjIdx];
 					FbxNode* pBaseMeshNode = pBaseNode->GetChild(meshObjIdx);
 					FbxMesh* pBaseMesh = pBaseMeshNode->GetMesh();
 
-					FbxBlendShape* lBlendShape;
-					WITH_MARSHALLED_STRING
-					(
-						pShapeName,
-						morph->ClipName + (meshList->SubmeshList->Count > 1 ? "_" + meshObjIdx : String::Empty) /*+ "_BlendShape"*/,
-						lBlendShape = FbxBlendShape::Create(pScene, pShapeName);
-					);
+					//base positions are converted once and shared by every shape of the submesh
+					std::vector<FbxVector4> basePositions;
+					if (submesh->Positions != nullptr && submesh->Positions->Length > 0)
+					{
+						array<float>^ positions = submesh->Positions;
+						basePositions.resize(positions->Length / 3);
+						for (int j = 0; j < (int)basePositions.size(); j++)
+						{
+							basePositions[j].Set(positions[j * 3], positions[j * 3 + 1], positions[j * 3 + 2], 0);
+						}
+					}
+					else
+					{
+						List<ImportedVertex^>^ vertList = submesh->VertexList;
+						basePositions.resize(vertList->Count);
+						for (int j = 0; j < vertList->Count; j++)
+						{
+							Vector3 coords = vertList[j]->Position;
+							basePositions[j].Set(coords.X, coords.Y, coords.Z, 0);
+						}
+					}
+					int vertexCount = (int)basePositions.size();
+
+					String^ blendShapeName = morph->ClipName + (meshList->SubmeshList->Count > 1 ? String::Concat("_", meshObjIdx) : String::Empty) /*+ "_BlendShape"*/;
+					FbxBlendShape* lBlendShape = FbxBlendShape::Create(pScene, names->Intern(blendShapeName));
 					pBaseMesh->AddDeformer(lBlendShape);
 					List<ImportedMorphKeyframe^>^ keyframes = morph->KeyframeList;
+					std::vector<MorphShape> shapes(keyframes->Count);
 					for (int i = 0; i < morph->Channels->Count; i++)
 					{
 						FbxBlendShapeChannel* lBlendShapeChannel;
 						if (!flatInbetween)
 						{
-							WITH_MARSHALLED_STRING
-							(
-								pChannelName,
-								gcnew String(lBlendShape->GetName()) + "." + keyframes[morph->Channels[i]->Item2]->Name->Substring(0, keyframes[morph->Channels[i]->Item2]->Name->LastIndexOf("_")),
-								lBlendShapeChannel = FbxBlendShapeChannel::Create(pScene, pChannelName);
-							);
+							String^ channelName = keyframes[morph->Channels[i]->Item2]->Name->Substring(0, keyframes[morph->Channels[i]->Item2]->Name->LastIndexOf("_"));
+							lBlendShapeChannel = FbxBlendShapeChannel::Create(pScene, names->Intern(String::Concat(blendShapeName, ".", channelName)));
 							lBlendShapeChannel->DeformPercent = morph->Channels[i]->Item1;
 							lBlendShape->AddBlendShapeChannel(lBlendShapeChannel);
 						}
@@ -912,12 +1466,7 @@ namespace AssetStudio
 							FbxShape* pShape;
 							if (!flatInbetween)
 							{
-								WITH_MARSHALLED_STRING
-								(
-									pMorphShapeName,
-									keyframe->Name,
-									pShape = FbxShape::Create(pScene, pMorphShapeName);
-								);
+								pShape = FbxShape::Create(pScene, names->Intern(keyframe->Name));
 								lBlendShapeChannel->AddTargetShape(pShape, keyframe->Weight);
 							}
 							else
@@ -926,88 +1475,114 @@ namespace AssetStudio
 								lBlendShapeChannel->DeformPercent = morph->Channels[i]->Item1;
 								lBlendShape->AddBlendShapeChannel(lBlendShapeChannel);
 
-								WITH_MARSHALLED_STRING
-								(
-									pMorphShapeName,
-									morph->ClipName + (meshList->SubmeshList->Count > 1 ? "_" + meshObjIdx : String::Empty) + "." + keyframe->Name,
-									pShape = FbxShape::Create(pScene, pMorphShapeName);
-								);
+								String^ shapeName = String::Concat(blendShapeName, ".", keyframe->Name);
+								pShape = FbxShape::Create(pScene, names->Intern(shapeName));
 								lBlendShapeChannel->AddTargetShape(pShape, 100);
 
-								FbxProperty weightProp;
-								WITH_MARSHALLED_STRING
-								(
-									pWeightName,
-									gcnew String(pShape->GetName()) + ".Weight",
-									weightProp = FbxProperty::Create(pBaseMesh, FbxDoubleDT, pWeightName);
-								);
+								FbxProperty weightProp = FbxProperty::Create(pBaseMesh, FbxDoubleDT, names->Intern(String::Concat(shapeName, ".Weight")));
 								weightProp.ModifyFlag(FbxPropertyFlags::eUserDefined, true);
 								weightProp.Set<double>(keyframe->Weight);
 							}
+							shapes[shapeIdx].Shape = pShape;
+						}
+					}
 
-							pShape->InitControlPoints(vertList->Count);
-							FbxVector4* pControlPoints = pShape->GetControlPoints();
-
-							for (int j = 0; j < vertList->Count; j++)
+					//the sparse deltas are read from the managed keyframes in parallel, the FBX SDK is not thread-safe so the shapes are filled afterwards on this thread
+					if (morph->Channels->Count > 0)
+					{
+						morphKeyframes = keyframes;
+						morphChannels = morph->Channels;
+						morphVertexOffset = meshVertexIndex;
+						morphVertexCount = vertexCount;
+						pMorphShapes = &shapes[0];
+						try
+						{
+							if (morph->Channels->Count > 1)
 							{
-								ImportedVertex^ vertex = vertList[j];
-								Vector3 coords = vertex->Position;
-								pControlPoints[j] = FbxVector4(coords.X, coords.Y, coords.Z, 0);
+								Parallel::For(0, morph->Channels->Count, gcnew Action<int>(this, &Fbx::Exporter::PrepareMorphChannel));
 							}
-							List<unsigned short>^ meshIndices = keyframe->MorphedVertexIndices;
-							for (int j = 0; j < meshIndices->Count; j++)
+							else
 							{
-								int controlPointIndex = meshIndices[j] - meshVertexIndex;
-								if (controlPointIndex >= 0 && controlPointIndex < vertList->Count)
-								{
-									Vector3 coords = keyframe->VertexList[j]->Position;
-									pControlPoints[controlPointIndex] = FbxVector4(coords.X, coords.Y, coords.Z, 0);
-								}
+								PrepareMorphChannel(0);
 							}
+						}
+						finally
+						{
+							morphKeyframes = nullptr;
+							morphChannels = nullptr;
+							pMorphShapes = NULL;
+						}
 
-							if (flatInbetween && frameIdx > 0)
+						for (int i = 0; i < morph->Channels->Count; i++)
+						{
+							for (int frameIdx = 0; frameIdx < morph->Channels[i]->Item3; frameIdx++)
 							{
-								int shapeIdx = morph->Channels[i]->Item2 + frameIdx - 1;
-								ImportedMorphKeyframe^ keyframe = keyframes[shapeIdx];
-
-								List<unsigned short>^ meshIndices = keyframe->MorphedVertexIndices;
-								for (int j = 0; j < meshIndices->Count; j++)
-								{
-									int controlPointIndex = meshIndices[j] - meshVertexIndex;
-									if (controlPointIndex >= 0 && controlPointIndex < vertList->Count)
-									{
-										Vector3 coords = keyframe->VertexList[j]->Position - vertList[controlPointIndex]->Position;
-										pControlPoints[controlPointIndex] -= FbxVector4(coords.X, coords.Y, coords.Z, 0);
-									}
-								}
+								int shapeIdx = morph->Channels[i]->Item2 + frameIdx;
+								CommitMorphShape(basePositions, shapes[shapeIdx], flatInbetween && frameIdx > 0 ? &shapes[shapeIdx - 1] : NULL);
 							}
+						}
+					}
 
-							if (morphMask)
+					if (morphMask)
+					{
+						for (int i = 0; i < morph->Channels->Count; i++)
+						{
+							for (int frameIdx = 0; frameIdx < morph->Channels[i]->Item3; frameIdx++)
 							{
+								int shapeIdx = morph->Channels[i]->Item2 + frameIdx;
 								FbxGeometryElementVertexColor* lGeometryElementVertexColor = pBaseMesh->CreateElementVertexColor();
 								lGeometryElementVertexColor->SetMappingMode(FbxGeometryElement::eByControlPoint);
 								lGeometryElementVertexColor->SetReferenceMode(FbxGeometryElement::eDirect);
-								WITH_MARSHALLED_STRING
-								(
-									pColourLayerName, morph->KeyframeList[shapeIdx]->Name,
-									lGeometryElementVertexColor->SetName(pColourLayerName);
-								);
-								for (int j = 0; j < vertList->Count; j++)
-								{
-									lGeometryElementVertexColor->GetDirectArray().Add(FbxColor(1, 1, 1));
-								}
-								for (int j = 0; j < meshIndices->Count; j++)
-								{
-									int controlPointIndex = meshIndices[j] - meshVertexIndex;
-									if (controlPointIndex >= 0 && controlPointIndex < vertList->Count)
-									{
-										lGeometryElementVertexColor->GetDirectArray().SetAt(controlPointIndex, FbxColor(0, 0, 1));
-									}
-								}
+								lGeometryElementVertexColor->SetName(names->Intern(keyframes[shapeIdx]->Name));
+								CommitMorphMask(lGeometryElementVertexColor, vertexCount, shapes[shapeIdx]);
 							}
 						}
 					}
-					meshVertexIndex += meshList->SubmeshList[meshObjIdx]->VertexList->Count;
+					meshVertexIndex += vertexCount;
+				}
+			}
+		}
+
+		if (budget->Enabled)
+		{
+			for each (ImportedMesh^ meshList in imported->MeshList)
+			{
+				for each (ImportedSubmesh^ submesh in meshList->SubmeshList)
+				{
+					budget->Release(submesh);
+				}
+			}
+			if (imported->MorphList != nullptr)
+			{
+				for each (ImportedMorph^ morph in imported->MorphList)
+				{
+					budget->Release(morph);
+				}
+			}
+			budget->OverBudget();
+		}
+	}
+
+	void Fbx::Exporter::PrepareMorphChannel(int i)
+	{
+		Tuple<float, int, int>^ channel = morphChannels[i];
+		for (int frameIdx = 0; frameIdx < channel->Item3; frameIdx++)
+		{
+			int shapeIdx = channel->Item2 + frameIdx;
+			ImportedMorphKeyframe^ keyframe = morphKeyframes[shapeIdx];
+			MorphShape& shape = pMorphShapes[shapeIdx];
+
+			List<int>^ meshIndices = keyframe->MorphedVertexIndices;
+			shape.Indices.reserve(meshIndices->Count);
+			shape.Positions.reserve(meshIndices->Count);
+			for (int j = 0; j < meshIndices->Count; j++)
+			{
+				int controlPointIndex = meshIndices[j] - morphVertexOffset;
+				if (controlPointIndex >= 0 && controlPointIndex < morphVertexCount)
+				{
+					Vector3 coords = keyframe->VertexList[j]->Position;
+					shape.Indices.push_back(controlPointIndex);
+					shape.Positions.push_back(FbxVector4(coords.X, coords.Y, coords.Z, 0));
 				}
 			}
 		}
@@ -0,0 +1,72 @@
+#include <fbxsdk.h>
+#include <stdexcept>
+#include "AssetStudioFBX.h"
+#include "AssetStudioFBXSceneSpill.h"
+
+namespace AssetStudio
+{
+	ExportStatistics^ Gltf::Exporter::Export(String^ path, IImported^ imported, FbxExportOptions^ options)
+	{
+		FileInfo^ file = gcnew FileInfo(path);
+		DirectoryInfo^ dir = file->Directory;
+		if (!dir->Exists)
+		{
+			dir->Create();
+		}
+		path = file->FullName;
+
+		ExportStatistics^ statistics = gcnew ExportStatistics();
+		ExportProfiler^ profiler = gcnew ExportProfiler(statistics, nullptr);
+		MemoryBudget^ budget = gcnew MemoryBudget(options->MemoryBudget, statistics);
+		Scene* scene = new Scene();
+		TextureWriter^ textureWriter = gcnew TextureWriter(16, 2);
+		char* pPath = NULL;
+		try
+		{
+			SceneBuilder^ builder = gcnew SceneBuilder(imported, scene, textureWriter, Path::GetDirectoryName(path), budget);
+			TrackFilter filter = { options->EulerFilter, options->FilterPrecision, { options->PositionTolerance, options->RotationTolerance, options->ScaleTolerance } };
+			GlbWriteStats stats;
+			try
+			{
+				{
+					ProfileScope scope(profiler, "Build");
+					//blend shape inbetweens stay in their channels, every shape becomes a morph target
+					builder->Build(options->AllFrames, options->AllBones, options->Skins, 0, 1, false, filter);
+				}
+				ProfileScope scope(profiler, "Write");
+				pPath = Fbx::StringToCharArray(path);
+				stats = WriteGlb(*scene, pPath);
+			}
+			catch (const std::exception& e)
+			{
+				throw gcnew Exception(gcnew String("Failed to write glTF: ") + gcnew String(e.what()));
+			}
+			{
+				ProfileScope scope(profiler, "Textures");
+				textureWriter->Drain();
+			}
+
+			CollectSceneStatistics(*scene, statistics);
+			statistics->TexturesWritten = textureWriter->FilesWritten;
+			statistics->TexturesSkipped = textureWriter->FilesSkipped;
+			statistics->TextureFiles->AddRange(textureWriter->Files);
+			statistics->BytesOut = (Int64)stats.FileBytes + textureWriter->BytesWritten;
+			statistics->SpilledBytes = scene->Spill != NULL ? (Int64)scene->Spill->Bytes() : 0;
+			Logger::Debug(String::Format("GLB: {0} nodes, {1} meshes, {2} accessors, JSON {3} bytes, binary {4} bytes", stats.Nodes, stats.Meshes, stats.Accessors, stats.JsonBytes, stats.BinaryBytes));
+		}
+		finally
+		{
+			delete textureWriter;
+			delete scene->Spill;
+			delete scene;
+			Marshal::FreeHGlobal((IntPtr)pPath);
+		}
+		profiler->Finish();
+		if (budget->Exceeded)
+		{
+			Logger::Warning(String::Format("{0}: working set went over the memory budget of {1} bytes, peak {2} bytes", Path::GetFileName(path), options->MemoryBudget, statistics->PeakWorkingSet));
+		}
+		Logger::Debug(String::Format("{0}: {1}", Path::GetFileName(path), statistics));
+		return statistics;
+	}
+}
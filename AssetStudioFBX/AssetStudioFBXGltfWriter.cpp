@@ -0,0 +1,954 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+#include "AssetStudioFBXScene.h"
+#include "AssetStudioFBXSceneSpill.h"
+#include "AssetStudioFBXRotation.h"
+
+namespace AssetStudio
+{
+	static const unsigned int GlbMagic = 0x46546c67; //"glTF"
+	static const unsigned int GlbChunkJson = 0x4e4f534a;
+	static const unsigned int GlbChunkBinary = 0x004e4942;
+	//views start on 16 bytes, more than the 4 the format asks for, so a loader can hand them to SIMD code as they are
+	static const size_t GlbViewAlignment = 16;
+
+	enum GltfComponentType
+	{
+		GltfUnsignedShort = 5123,
+		GltfUnsignedInt = 5125,
+		GltfFloat = 5126
+	};
+
+	enum GltfBufferTarget
+	{
+		GltfNoTarget = 0,
+		GltfArrayBuffer = 34962,
+		GltfElementArrayBuffer = 34963
+	};
+
+	//Where the bytes of a view come from when the binary chunk is written. Submesh arrays are looked up only then,
+	//so spilled submeshes are read back one at a time instead of all being held for the JSON.
+	enum GltfViewSource
+	{
+		SourceData,
+		SourcePositions,
+		SourceNormals,
+		SourceTangents,
+		SourceUV0,
+		SourceColours,
+		SourceIndices,
+		SourceWeights
+	};
+
+	struct GltfView
+	{
+		GltfViewSource Source;
+		int Mesh;
+		int Submesh;
+		const void* Data; //SourceData only
+		size_t Length;
+		size_t Offset;
+	};
+
+	static void AppendJsonString(std::string& out, const std::string& value)
+	{
+		out.push_back('"');
+		for (size_t i = 0; i < value.size(); i++)
+		{
+			unsigned char c = (unsigned char)value[i];
+			if (c == '"' || c == '\\')
+			{
+				out.push_back('\\');
+				out.push_back((char)c);
+			}
+			else if (c < 0x20)
+			{
+				char escaped[8];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+				out.append(escaped);
+			}
+			else
+			{
+				out.push_back((char)c);
+			}
+		}
+		out.push_back('"');
+	}
+
+	static void AppendNumber(std::string& out, double value)
+	{
+		char text[32];
+		snprintf(text, sizeof(text), "%.9g", isfinite(value) ? value : 0.0);
+		out.append(text);
+	}
+
+	static void AppendInt(std::string& out, long long value)
+	{
+		char text[24];
+		snprintf(text, sizeof(text), "%lld", value);
+		out.append(text);
+	}
+
+	static void AppendNumbers(std::string& out, const float* values, int count)
+	{
+		out.push_back('[');
+		for (int i = 0; i < count; i++)
+		{
+			if (i > 0)
+			{
+				out.push_back(',');
+			}
+			AppendNumber(out, values[i]);
+		}
+		out.push_back(']');
+	}
+
+	//Relative file names become URIs, everything outside the unreserved set and the path separator is escaped
+	static std::string FileUri(const std::string& fileName)
+	{
+		static const char hex[] = "0123456789ABCDEF";
+		std::string uri;
+		for (size_t i = 0; i < fileName.size(); i++)
+		{
+			unsigned char c = (unsigned char)fileName[i];
+			if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == '~' || c == '/')
+			{
+				uri.push_back((char)c);
+			}
+			else if (c == '\\')
+			{
+				uri.push_back('/');
+			}
+			else
+			{
+				uri.push_back('%');
+				uri.push_back(hex[c >> 4]);
+				uri.push_back(hex[c & 15]);
+			}
+		}
+		return uri;
+	}
+
+	//Comma separated JSON array built one element at a time
+	struct GltfArray
+	{
+		std::string Json;
+		int Count;
+
+		GltfArray() : Count(0)
+		{
+		}
+
+		std::string& Next()
+		{
+			Json.append(Count++ > 0 ? ",{" : "{");
+			return Json;
+		}
+	};
+
+	class GltfWriter
+	{
+	public:
+		GltfWriter(const Scene& scene) : scene(scene), binaryLength(0), textureTransforms(false)
+		{
+		}
+
+		GlbWriteStats Write(const char* path)
+		{
+			Plan();
+			std::string json = Json();
+			while (json.size() % 4 != 0)
+			{
+				json.push_back(' ');
+			}
+			size_t binaryChunk = (binaryLength + 3) / 4 * 4;
+			unsigned long long fileLength = 12 + 8 + json.size() + (binaryChunk > 0 ? 8 + binaryChunk : 0);
+			if (fileLength > 0xffffffffULL)
+			{
+				throw std::runtime_error("GLB files are limited to 4 GB");
+			}
+
+			FILE* file = fopen(path, "wb");
+			if (file == NULL)
+			{
+				throw std::runtime_error(std::string("Failed to open ") + path);
+			}
+			try
+			{
+				setvbuf(file, NULL, _IOFBF, 1 << 20);
+				unsigned int header[3] = { GlbMagic, 2, (unsigned int)fileLength };
+				WriteFile(file, header, sizeof(header));
+				unsigned int jsonHeader[2] = { (unsigned int)json.size(), GlbChunkJson };
+				WriteFile(file, jsonHeader, sizeof(jsonHeader));
+				WriteFile(file, json.data(), json.size());
+				if (binaryChunk > 0)
+				{
+					unsigned int binaryHeader[2] = { (unsigned int)binaryChunk, GlbChunkBinary };
+					WriteFile(file, binaryHeader, sizeof(binaryHeader));
+					WriteBinary(file, binaryChunk);
+				}
+			}
+			catch (...)
+			{
+				fclose(file);
+				throw;
+			}
+			if (fclose(file) != 0)
+			{
+				throw std::runtime_error("Failed to write GLB file");
+			}
+
+			GlbWriteStats stats;
+			stats.FileBytes = fileLength;
+			stats.JsonBytes = json.size();
+			stats.BinaryBytes = binaryChunk;
+			stats.Nodes = nodes.Count;
+			stats.Meshes = meshes.Count;
+			stats.Accessors = accessors.Count;
+			return stats;
+		}
+
+	private:
+		const Scene& scene;
+		std::vector<GltfView> views;
+		std::deque<std::vector<unsigned char> > owned;
+		size_t binaryLength;
+		bool textureTransforms;
+
+		GltfArray nodes;
+		GltfArray meshes;
+		GltfArray accessors;
+		GltfArray skins;
+		GltfArray materials;
+		GltfArray textures;
+		GltfArray images;
+		GltfArray animations;
+		std::string sceneNodes;
+
+		std::vector<std::vector<int> > frameChildren;
+		std::vector<std::vector<std::vector<const SceneMorph*> > > submeshMorphs;
+
+		static void WriteFile(FILE* file, const void* data, size_t length)
+		{
+			if (length > 0 && fwrite(data, 1, length, file) != length)
+			{
+				throw std::runtime_error("Failed to write GLB file");
+			}
+		}
+
+		int AddView(GltfViewSource source, int mesh, int submesh, const void* data, size_t length)
+		{
+			GltfView view = { source, mesh, submesh, data, length, (binaryLength + GlbViewAlignment - 1) / GlbViewAlignment * GlbViewAlignment };
+			binaryLength = view.Offset + length;
+			views.push_back(view);
+			return (int)views.size() - 1;
+		}
+
+		template <typename T> int AddOwnedView(std::vector<T>& values)
+		{
+			owned.push_back(std::vector<unsigned char>());
+			std::vector<unsigned char>& bytes = owned.back();
+			bytes.resize(values.size() * sizeof(T));
+			if (!values.empty())
+			{
+				memcpy(&bytes[0], &values[0], bytes.size());
+			}
+			return AddView(SourceData, -1, -1, bytes.empty() ? NULL : &bytes[0], bytes.size());
+		}
+
+		int AddAccessor(int view, GltfComponentType componentType, size_t count, const char* type, const float* min = NULL, const float* max = NULL, int components = 0)
+		{
+			std::string& json = accessors.Next();
+			if (view >= 0)
+			{
+				json.append("\"bufferView\":");
+				AppendInt(json, view);
+				json.append(",");
+			}
+			json.append("\"componentType\":");
+			AppendInt(json, componentType);
+			json.append(",\"count\":");
+			AppendInt(json, (long long)count);
+			json.append(",\"type\":\"").append(type).append("\"");
+			if (min != NULL)
+			{
+				json.append(",\"min\":");
+				AppendNumbers(json, min, components);
+				json.append(",\"max\":");
+				AppendNumbers(json, max, components);
+			}
+			json.append("}");
+			return accessors.Count - 1;
+		}
+
+		//Zero-filled accessor with the given entries replaced, the natural storage for blend shape deltas
+		int AddSparseAccessor(size_t count, int indexView, int valueView, size_t entries, const float* min, const float* max)
+		{
+			std::string& json = accessors.Next();
+			json.append("\"componentType\":");
+			AppendInt(json, GltfFloat);
+			json.append(",\"count\":");
+			AppendInt(json, (long long)count);
+			json.append(",\"type\":\"VEC3\",\"min\":");
+			AppendNumbers(json, min, 3);
+			json.append(",\"max\":");
+			AppendNumbers(json, max, 3);
+			json.append(",\"sparse\":{\"count\":");
+			AppendInt(json, (long long)entries);
+			json.append(",\"indices\":{\"bufferView\":");
+			AppendInt(json, indexView);
+			json.append(",\"componentType\":");
+			AppendInt(json, GltfUnsignedInt);
+			json.append("},\"values\":{\"bufferView\":");
+			AppendInt(json, valueView);
+			json.append("}}}");
+			return accessors.Count - 1;
+		}
+
+		static void Bounds(const float* values, size_t count, int components, float* min, float* max)
+		{
+			for (int c = 0; c < components; c++)
+			{
+				min[c] = count > 0 ? values[c] : 0;
+				max[c] = min[c];
+			}
+			for (size_t i = 1; i < count; i++)
+			{
+				for (int c = 0; c < components; c++)
+				{
+					float value = values[i * components + c];
+					min[c] = std::min(min[c], value);
+					max[c] = std::max(max[c], value);
+				}
+			}
+		}
+
+		static bool AnyNonZero(const std::vector<float>& values)
+		{
+			for (size_t i = 0; i < values.size(); i++)
+			{
+				if (values[i] != 0)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void Plan()
+		{
+			size_t frameCount = scene.Frames.size();
+			frameChildren.resize(frameCount);
+			for (size_t i = 0; i < frameCount; i++)
+			{
+				if (scene.Frames[i].Parent >= 0)
+				{
+					frameChildren[scene.Frames[i].Parent].push_back((int)i);
+				}
+				else
+				{
+					if (!sceneNodes.empty())
+					{
+						sceneNodes.push_back(',');
+					}
+					AppendInt(sceneNodes, (long long)i);
+				}
+			}
+
+			submeshMorphs.resize(scene.Meshes.size());
+			for (size_t i = 0; i < scene.Meshes.size(); i++)
+			{
+				submeshMorphs[i].resize(scene.Meshes[i].Submeshes.size());
+			}
+			for (size_t i = 0; i < scene.Morphs.size(); i++)
+			{
+				const SceneMorph& morph = scene.Morphs[i];
+				if (morph.Mesh >= 0 && morph.Mesh < (int)scene.Meshes.size() && morph.Submesh >= 0 && morph.Submesh < (int)scene.Meshes[morph.Mesh].Submeshes.size())
+				{
+					submeshMorphs[morph.Mesh][morph.Submesh].push_back(&morph);
+				}
+			}
+
+			//submesh nodes follow the frame nodes, so they can be listed as children before they are written
+			std::vector<std::vector<int> > submeshNodes(frameCount);
+			int nextNode = (int)frameCount;
+			for (size_t i = 0; i < scene.Meshes.size(); i++)
+			{
+				for (size_t j = 0; j < scene.Meshes[i].Submeshes.size(); j++)
+				{
+					submeshNodes[scene.Meshes[i].Frame].push_back(nextNode++);
+				}
+			}
+
+			std::vector<float> eulers(frameCount * 3);
+			std::vector<float> rotations(frameCount * 4);
+			for (size_t i = 0; i < frameCount; i++)
+			{
+				std::copy(scene.Frames[i].LocalRotation, scene.Frames[i].LocalRotation + 3, &eulers[i * 3]);
+			}
+			if (frameCount > 0)
+			{
+				EulersToQuaternion(&eulers[0], &rotations[0], (int)frameCount);
+			}
+			for (size_t i = 0; i < frameCount; i++)
+			{
+				const SceneFrame& frame = scene.Frames[i];
+				std::string& json = nodes.Next();
+				json.append("\"name\":");
+				AppendJsonString(json, frame.Name);
+				json.append(",\"translation\":");
+				AppendNumbers(json, frame.LocalPosition, 3);
+				json.append(",\"rotation\":");
+				AppendNumbers(json, &rotations[i * 4], 4);
+				json.append(",\"scale\":");
+				AppendNumbers(json, frame.LocalScale, 3);
+				if (!frameChildren[i].empty() || !submeshNodes[i].empty())
+				{
+					json.append(",\"children\":[");
+					for (size_t k = 0; k < frameChildren[i].size() + submeshNodes[i].size(); k++)
+					{
+						if (k > 0)
+						{
+							json.push_back(',');
+						}
+						AppendInt(json, k < frameChildren[i].size() ? frameChildren[i][k] : submeshNodes[i][k - frameChildren[i].size()]);
+					}
+					json.append("]");
+				}
+				json.append("}");
+			}
+
+			PlanMeshes();
+			PlanMaterials();
+			PlanAnimations();
+		}
+
+		void PlanMeshes()
+		{
+			std::vector<unsigned short> joints;
+			for (size_t i = 0; i < scene.Meshes.size(); i++)
+			{
+				const SceneMesh& mesh = scene.Meshes[i];
+				int skin = -1;
+				if (!mesh.Bones.empty())
+				{
+					//ImportedBone::Matrix row by row is the column-major inverse bind matrix glTF expects
+					std::vector<float> inverseBinds(mesh.Bones.size() * 16);
+					for (size_t b = 0; b < mesh.Bones.size(); b++)
+					{
+						std::copy(mesh.Bones[b].Matrix, mesh.Bones[b].Matrix + 16, &inverseBinds[b * 16]);
+					}
+					int inverseBindAccessor = AddAccessor(AddOwnedView(inverseBinds), GltfFloat, mesh.Bones.size(), "MAT4");
+					skin = skins.Count;
+					std::string& json = skins.Next();
+					json.append("\"inverseBindMatrices\":");
+					AppendInt(json, inverseBindAccessor);
+					json.append(",\"joints\":[");
+					for (size_t b = 0; b < mesh.Bones.size(); b++)
+					{
+						if (b > 0)
+						{
+							json.push_back(',');
+						}
+						//a bone without a frame stays with the mesh, as the SDK path leaves such clusters out
+						AppendInt(json, mesh.Bones[b].Frame >= 0 ? mesh.Bones[b].Frame : mesh.Frame);
+					}
+					json.append("]}");
+				}
+
+				for (size_t j = 0; j < mesh.Submeshes.size(); j++)
+				{
+					SceneSubmesh loaded;
+					const SceneSubmesh& submesh = ResidentSubmesh(scene, mesh.Submeshes[j], loaded);
+					int count = submesh.VertexCount;
+					int meshIndex = meshes.Count;
+					std::string& json = meshes.Next();
+					json.append("\"name\":");
+					AppendJsonString(json, scene.Frames[mesh.Frame].Name + "_" + std::to_string(j));
+					json.append(",\"primitives\":[{\"attributes\":{");
+
+					float min[4], max[4];
+					size_t positions = std::min(submesh.Positions.size() / 3, (size_t)count);
+					Bounds(positions > 0 ? &submesh.Positions[0] : NULL, positions, 3, min, max);
+					json.append("\"POSITION\":");
+					AppendInt(json, AddAccessor(AddView(SourcePositions, (int)i, (int)j, NULL, positions * 12), GltfFloat, positions, "VEC3", min, max, 3));
+					if (submesh.Normals.size() >= (size_t)count * 3 && count > 0 && AnyNonZero(submesh.Normals))
+					{
+						json.append(",\"NORMAL\":");
+						AppendInt(json, AddAccessor(AddView(SourceNormals, (int)i, (int)j, NULL, (size_t)count * 12), GltfFloat, count, "VEC3"));
+					}
+					if (submesh.Tangents.size() >= (size_t)count * 4 && count > 0 && AnyNonZero(submesh.Tangents))
+					{
+						json.append(",\"TANGENT\":");
+						AppendInt(json, AddAccessor(AddView(SourceTangents, (int)i, (int)j, NULL, (size_t)count * 16), GltfFloat, count, "VEC4"));
+					}
+					if (submesh.UV0.size() >= (size_t)count * 2 && count > 0)
+					{
+						json.append(",\"TEXCOORD_0\":");
+						AppendInt(json, AddAccessor(AddView(SourceUV0, (int)i, (int)j, NULL, (size_t)count * 8), GltfFloat, count, "VEC2"));
+					}
+					if (submesh.Colours.size() >= (size_t)count * 4 && count > 0)
+					{
+						json.append(",\"COLOR_0\":");
+						AppendInt(json, AddAccessor(AddView(SourceColours, (int)i, (int)j, NULL, (size_t)count * 16), GltfFloat, count, "VEC4"));
+					}
+					bool skinned = skin >= 0 && submesh.BoneIndices.size() >= (size_t)count * 4 && submesh.Weights.size() >= (size_t)count * 4 && count > 0;
+					if (skinned)
+					{
+						//the only converted vertex data, joint indices have to be 8 or 16 bit
+						joints.resize((size_t)count * 4);
+						for (size_t k = 0; k < joints.size(); k++)
+						{
+							int bone = submesh.BoneIndices[k];
+							joints[k] = bone >= 0 && bone < (int)mesh.Bones.size() ? (unsigned short)bone : 0;
+						}
+						json.append(",\"JOINTS_0\":");
+						AppendInt(json, AddAccessor(AddOwnedView(joints), GltfUnsignedShort, count, "VEC4"));
+						json.append(",\"WEIGHTS_0\":");
+						AppendInt(json, AddAccessor(AddView(SourceWeights, (int)i, (int)j, NULL, (size_t)count * 16), GltfFloat, count, "VEC4"));
+					}
+					json.append("}");
+
+					size_t indexCount = submesh.Indices.size() / 3 * 3;
+					json.append(",\"indices\":");
+					AppendInt(json, AddAccessor(AddView(SourceIndices, (int)i, (int)j, NULL, indexCount * 4), GltfUnsignedInt, indexCount, "SCALAR"));
+					if (submesh.Material >= 0)
+					{
+						json.append(",\"material\":");
+						AppendInt(json, submesh.Material);
+					}
+
+					std::string targetNames;
+					const std::vector<const SceneMorph*>& morphs = submeshMorphs[i][j];
+					if (!morphs.empty())
+					{
+						json.append(",\"targets\":[");
+						int targets = 0;
+						for (size_t m = 0; m < morphs.size(); m++)
+						{
+							for (size_t c = 0; c < morphs[m]->Channels.size(); c++)
+							{
+								const std::vector<SceneShape>& shapes = morphs[m]->Channels[c].Shapes;
+								for (size_t s = 0; s < shapes.size(); s++)
+								{
+									if (targets++ > 0)
+									{
+										json.push_back(',');
+										targetNames.push_back(',');
+									}
+									json.append("{\"POSITION\":");
+									AppendInt(json, AddShape(shapes[s], count));
+									json.append("}");
+									AppendJsonString(targetNames, shapes[s].Name);
+								}
+							}
+						}
+						json.append("]");
+					}
+					json.append(",\"mode\":4}]");
+					if (!targetNames.empty())
+					{
+						json.append(",\"extras\":{\"targetNames\":[").append(targetNames).append("]}");
+					}
+					json.append("}");
+
+					std::string& node = nodes.Next();
+					node.append("\"name\":");
+					AppendJsonString(node, scene.Frames[mesh.Frame].Name + "_" + std::to_string(j));
+					node.append(",\"mesh\":");
+					AppendInt(node, meshIndex);
+					if (skinned)
+					{
+						node.append(",\"skin\":");
+						AppendInt(node, skin);
+					}
+					node.append("}");
+				}
+			}
+		}
+
+		int AddShape(const SceneShape& shape, int vertexCount)
+		{
+			//sparse indices have to increase, shapes built from sorted vertex lists already do
+			size_t entries = std::min(shape.Indices.size(), shape.Deltas.size() / 3);
+			std::vector<int> order;
+			bool sorted = true;
+			for (size_t k = 0; k < entries; k++)
+			{
+				sorted &= shape.Indices[k] >= 0 && shape.Indices[k] < vertexCount && (k == 0 || shape.Indices[k] > shape.Indices[k - 1]);
+			}
+
+			float min[3] = { 0, 0, 0 };
+			float max[3] = { 0, 0, 0 };
+			int indexView, valueView;
+			if (sorted)
+			{
+				for (size_t k = 0; k < entries; k++)
+				{
+					for (int c = 0; c < 3; c++)
+					{
+						min[c] = std::min(min[c], shape.Deltas[k * 3 + c]);
+						max[c] = std::max(max[c], shape.Deltas[k * 3 + c]);
+					}
+				}
+				indexView = AddView(SourceData, -1, -1, entries > 0 ? &shape.Indices[0] : NULL, entries * 4);
+				valueView = AddView(SourceData, -1, -1, entries > 0 ? &shape.Deltas[0] : NULL, entries * 12);
+			}
+			else
+			{
+				for (size_t k = 0; k < entries; k++)
+				{
+					if (shape.Indices[k] >= 0 && shape.Indices[k] < vertexCount)
+					{
+						order.push_back((int)k);
+					}
+				}
+				std::stable_sort(order.begin(), order.end(), [&shape](int a, int b) { return shape.Indices[a] < shape.Indices[b]; });
+				std::vector<unsigned int> indices;
+				std::vector<float> deltas;
+				for (size_t k = 0; k < order.size(); k++)
+				{
+					const float* delta = &shape.Deltas[order[k] * 3];
+					if (!indices.empty() && indices.back() == (unsigned int)shape.Indices[order[k]])
+					{
+						for (int c = 0; c < 3; c++)
+						{
+							deltas[deltas.size() - 3 + c] += delta[c];
+						}
+						continue;
+					}
+					indices.push_back((unsigned int)shape.Indices[order[k]]);
+					deltas.insert(deltas.end(), delta, delta + 3);
+				}
+				entries = indices.size();
+				for (size_t k = 0; k < entries; k++)
+				{
+					for (int c = 0; c < 3; c++)
+					{
+						min[c] = std::min(min[c], deltas[k * 3 + c]);
+						max[c] = std::max(max[c], deltas[k * 3 + c]);
+					}
+				}
+				indexView = AddOwnedView(indices);
+				valueView = AddOwnedView(deltas);
+			}
+			if (entries == 0)
+			{
+				return AddAccessor(-1, GltfFloat, vertexCount, "VEC3", min, max, 3);
+			}
+			return AddSparseAccessor(vertexCount, indexView, valueView, entries, min, max);
+		}
+
+		void AppendTextureInfo(std::string& json, const char* property, const SceneMaterialTexture& link)
+		{
+			//glTF puts the UV origin top left, the flip is folded into the texture transform instead of rewriting every UV
+			float offset[2] = { link.Offset[0], 1 - link.Offset[1] };
+			float scale[2] = { link.Scale[0], -link.Scale[1] };
+			json.append(",\"").append(property).append("\":{\"index\":");
+			AppendInt(json, link.Texture);
+			json.append(",\"extensions\":{\"KHR_texture_transform\":{\"offset\":");
+			AppendNumbers(json, offset, 2);
+			json.append(",\"scale\":");
+			AppendNumbers(json, scale, 2);
+			json.append("}}}");
+			textureTransforms = true;
+		}
+
+		void PlanMaterials()
+		{
+			for (size_t i = 0; i < scene.Materials.size(); i++)
+			{
+				const SceneMaterial& material = scene.Materials[i];
+				const SceneMaterialTexture* links[4] = { NULL, NULL, NULL, NULL };
+				for (size_t k = 0; k < material.Textures.size(); k++)
+				{
+					const SceneMaterialTexture& link = material.Textures[k];
+					if (link.Texture >= 0 && link.Texture < (int)scene.Textures.size() && link.Dest >= 0 && link.Dest <= 3)
+					{
+						links[link.Dest] = &link;
+					}
+				}
+
+				std::string& json = materials.Next();
+				json.append("\"name\":");
+				AppendJsonString(json, material.Name);
+				json.append(",\"pbrMetallicRoughness\":{\"baseColorFactor\":");
+				float baseColor[4];
+				for (int c = 0; c < 4; c++)
+				{
+					baseColor[c] = std::min(std::max(material.Diffuse[c], 0.0f), 1.0f);
+				}
+				AppendNumbers(json, baseColor, 4);
+				if (links[0] != NULL)
+				{
+					AppendTextureInfo(json, "baseColorTexture", *links[0]);
+				}
+				//phong materials have no metal, specular and bump maps have no glTF core slot
+				json.append(",\"metallicFactor\":0,\"roughnessFactor\":1}");
+				if (links[1] != NULL)
+				{
+					AppendTextureInfo(json, "normalTexture", *links[1]);
+				}
+				float emissive[3];
+				for (int c = 0; c < 3; c++)
+				{
+					emissive[c] = std::min(std::max(material.Emissive[c], 0.0f), 1.0f);
+				}
+				json.append(",\"emissiveFactor\":");
+				AppendNumbers(json, emissive, 3);
+				if (baseColor[3] < 1)
+				{
+					json.append(",\"alphaMode\":\"BLEND\"");
+				}
+				json.append("}");
+			}
+
+			//textures stay next to the file, written by the same texture writer as for FBX
+			for (size_t i = 0; i < scene.Textures.size(); i++)
+			{
+				std::string& image = images.Next();
+				image.append("\"name\":");
+				AppendJsonString(image, scene.Textures[i].Name);
+				image.append(",\"uri\":");
+				AppendJsonString(image, FileUri(scene.Textures[i].RelativeFileName));
+				image.append("}");
+
+				std::string& texture = textures.Next();
+				texture.append("\"sampler\":0,\"source\":");
+				AppendInt(texture, (long long)i);
+				texture.append("}");
+			}
+		}
+
+		//Times and values of a curve with strictly increasing times, as glTF samplers require.
+		//Curves that already qualify are used in place, others are sorted into the buffers and the last of equal times kept.
+		static bool IncreasingKeys(const SceneCurve& curve, std::vector<float>& times, std::vector<float>& values)
+		{
+			size_t keys = std::min(curve.Times.size(), curve.Values.size() / 3);
+			bool increasing = true;
+			for (size_t k = 1; k < keys && increasing; k++)
+			{
+				increasing = curve.Times[k] > curve.Times[k - 1];
+			}
+			if (increasing)
+			{
+				return true;
+			}
+
+			std::vector<size_t> order(keys);
+			for (size_t k = 0; k < keys; k++)
+			{
+				order[k] = k;
+			}
+			std::stable_sort(order.begin(), order.end(), [&curve](size_t a, size_t b) { return curve.Times[a] < curve.Times[b]; });
+			times.clear();
+			values.clear();
+			for (size_t k = 0; k < keys; k++)
+			{
+				const float* value = &curve.Values[order[k] * 3];
+				if (!times.empty() && times.back() == curve.Times[order[k]])
+				{
+					std::copy(value, value + 3, values.end() - 3);
+					continue;
+				}
+				times.push_back(curve.Times[order[k]]);
+				values.insert(values.end(), value, value + 3);
+			}
+			return false;
+		}
+
+		void PlanAnimations()
+		{
+			static const char* paths[3] = { "scale", "rotation", "translation" };
+			std::vector<float> times, values, quaternions;
+			for (size_t i = 0; i < scene.Clips.size(); i++)
+			{
+				const SceneClip& clip = scene.Clips[i];
+				std::string channels, samplers;
+				int samplerCount = 0;
+				for (size_t j = 0; j < clip.Tracks.size(); j++)
+				{
+					const SceneTrack& track = clip.Tracks[j];
+					if (track.Frame < 0 || track.Frame >= (int)scene.Frames.size())
+					{
+						continue;
+					}
+					const SceneCurve* curves[3] = { &track.Scalings, &track.Rotations, &track.Translations };
+					for (int c = 0; c < 3; c++)
+					{
+						const SceneCurve& curve = *curves[c];
+						if (curve.Times.empty() || curve.Values.size() < curve.Times.size() * 3)
+						{
+							continue;
+						}
+						bool inPlace = IncreasingKeys(curve, times, values);
+						const std::vector<float>& keyTimes = inPlace ? curve.Times : times;
+						const std::vector<float>& keyValues = inPlace ? curve.Values : values;
+						size_t keys = inPlace ? curve.Times.size() : times.size();
+
+						float timeMin = keyTimes[0], timeMax = keyTimes[keys - 1];
+						int input = AddAccessor(inPlace ? AddView(SourceData, -1, -1, &keyTimes[0], keys * 4) : AddOwnedView(times), GltfFloat, keys, "SCALAR", &timeMin, &timeMax, 1);
+						int output;
+						if (c == 1)
+						{
+							//euler keys become quaternions, kept in one hemisphere so linear interpolation takes the short way
+							quaternions.resize(keys * 4);
+							EulersToQuaternion(&keyValues[0], &quaternions[0], (int)keys);
+							for (size_t k = 1; k < keys; k++)
+							{
+								float* q = &quaternions[k * 4];
+								const float* p = &quaternions[(k - 1) * 4];
+								if (q[0] * p[0] + q[1] * p[1] + q[2] * p[2] + q[3] * p[3] < 0)
+								{
+									q[0] = -q[0];
+									q[1] = -q[1];
+									q[2] = -q[2];
+									q[3] = -q[3];
+								}
+							}
+							output = AddAccessor(AddOwnedView(quaternions), GltfFloat, keys, "VEC4");
+						}
+						else
+						{
+							output = AddAccessor(inPlace ? AddView(SourceData, -1, -1, &keyValues[0], keys * 12) : AddOwnedView(values), GltfFloat, keys, "VEC3");
+						}
+
+						if (samplerCount > 0)
+						{
+							samplers.push_back(',');
+							channels.push_back(',');
+						}
+						samplers.append("{\"input\":");
+						AppendInt(samplers, input);
+						samplers.append(",\"output\":");
+						AppendInt(samplers, output);
+						samplers.append(",\"interpolation\":\"LINEAR\"}");
+						channels.append("{\"sampler\":");
+						AppendInt(channels, samplerCount++);
+						channels.append(",\"target\":{\"node\":");
+						AppendInt(channels, track.Frame);
+						channels.append(",\"path\":\"").append(paths[c]).append("\"}}");
+					}
+				}
+				if (samplerCount == 0)
+				{
+					continue;
+				}
+				std::string& json = animations.Next();
+				json.append("\"name\":");
+				AppendJsonString(json, clip.Name);
+				json.append(",\"channels\":[").append(channels).append("],\"samplers\":[").append(samplers).append("]}");
+			}
+		}
+
+		static void AppendArray(std::string& json, const char* name, const GltfArray& array)
+		{
+			if (array.Count > 0)
+			{
+				json.append(",\"").append(name).append("\":[").append(array.Json).append("]");
+			}
+		}
+
+		std::string Json()
+		{
+			std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"AssetStudio\"}";
+			if (textureTransforms)
+			{
+				json.append(",\"extensionsUsed\":[\"KHR_texture_transform\"],\"extensionsRequired\":[\"KHR_texture_transform\"]");
+			}
+			json.append(",\"scene\":0,\"scenes\":[{\"nodes\":[").append(sceneNodes).append("]}]");
+			AppendArray(json, "nodes", nodes);
+			AppendArray(json, "meshes", meshes);
+			AppendArray(json, "skins", skins);
+			AppendArray(json, "materials", materials);
+			AppendArray(json, "textures", textures);
+			AppendArray(json, "images", images);
+			if (textures.Count > 0)
+			{
+				json.append(",\"samplers\":[{\"magFilter\":9729,\"minFilter\":9987,\"wrapS\":10497,\"wrapT\":10497}]");
+			}
+			AppendArray(json, "accessors", accessors);
+			AppendArray(json, "animations", animations);
+
+			if (!views.empty())
+			{
+				json.append(",\"bufferViews\":[");
+				for (size_t i = 0; i < views.size(); i++)
+				{
+					json.append(i > 0 ? ",{" : "{");
+					json.append("\"buffer\":0,\"byteOffset\":");
+					AppendInt(json, (long long)views[i].Offset);
+					json.append(",\"byteLength\":");
+					AppendInt(json, (long long)views[i].Length);
+					if (views[i].Source == SourceIndices)
+					{
+						json.append(",\"target\":");
+						AppendInt(json, GltfElementArrayBuffer);
+					}
+					else if (views[i].Source != SourceData)
+					{
+						json.append(",\"target\":");
+						AppendInt(json, GltfArrayBuffer);
+					}
+					json.append("}");
+				}
+				json.append("],\"buffers\":[{\"byteLength\":");
+				AppendInt(json, (long long)((binaryLength + 3) / 4 * 4));
+				json.append("}]");
+			}
+			json.append("}");
+			return json;
+		}
+
+		void WriteBinary(FILE* file, size_t binaryChunk)
+		{
+			static const unsigned char zeros[GlbViewAlignment] = { 0 };
+			size_t position = 0;
+			int loadedMesh = -1, loadedSubmesh = -1;
+			SceneSubmesh loaded;
+			const SceneSubmesh* pSubmesh = NULL;
+			for (size_t i = 0; i < views.size(); i++)
+			{
+				const GltfView& view = views[i];
+				WriteFile(file, zeros, view.Offset - position);
+				position = view.Offset;
+
+				const void* data = view.Data;
+				if (view.Source != SourceData)
+				{
+					//views of one submesh are consecutive, a spilled one is read back once
+					if (view.Mesh != loadedMesh || view.Submesh != loadedSubmesh)
+					{
+						pSubmesh = &ResidentSubmesh(scene, scene.Meshes[view.Mesh].Submeshes[view.Submesh], loaded);
+						loadedMesh = view.Mesh;
+						loadedSubmesh = view.Submesh;
+					}
+					switch (view.Source)
+					{
+					case SourcePositions: data = pSubmesh->Positions.data(); break;
+					case SourceNormals: data = pSubmesh->Normals.data(); break;
+					case SourceTangents: data = pSubmesh->Tangents.data(); break;
+					case SourceUV0: data = pSubmesh->UV0.data(); break;
+					case SourceColours: data = pSubmesh->Colours.data(); break;
+					case SourceIndices: data = pSubmesh->Indices.data(); break;
+					case SourceWeights: data = pSubmesh->Weights.data(); break;
+					default: break;
+					}
+				}
+				WriteFile(file, data, view.Length);
+				position += view.Length;
+			}
+			WriteFile(file, zeros, binaryChunk - position);
+		}
+	};
+
+	GlbWriteStats WriteGlb(const Scene& scene, const char* path)
+	{
+		GltfWriter writer(scene);
+		return writer.Write(path);
+	}
+}
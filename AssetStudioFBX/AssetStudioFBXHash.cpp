@@ -0,0 +1,16 @@
+#include "AssetStudioFBXHash.h"
+
+namespace AssetStudio
+{
+	unsigned long long HashBytes(const void* data, size_t length, unsigned long long seed)
+	{
+		const unsigned char* p = (const unsigned char*)data;
+		unsigned long long hash = seed;
+		for (size_t i = 0; i < length; i++)
+		{
+			hash ^= p[i];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+}
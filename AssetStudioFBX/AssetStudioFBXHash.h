@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace AssetStudio
+{
+	//64-bit FNV-1a, stable across runs and platforms
+	unsigned long long HashBytes(const void* data, size_t length, unsigned long long seed = 14695981039346656037ULL);
+}
@@ -0,0 +1,103 @@
+#include <fbxsdk.h>
+#include "AssetStudioFBX.h"
+
+using namespace System::Diagnostics;
+using namespace System::Security::Cryptography;
+
+namespace AssetStudio
+{
+	MemoryBudget::MemoryBudget(Int64 bytes, ExportStatistics^ statistics)
+	{
+		this->bytes = bytes;
+		this->statistics = statistics;
+		exceeded = false;
+		process = Process::GetCurrentProcess();
+	}
+
+	Int64 MemoryBudget::Sample()
+	{
+		process->Refresh();
+		Int64 workingSet = process->WorkingSet64;
+		statistics->PeakWorkingSet = Math::Max(statistics->PeakWorkingSet, workingSet);
+		return workingSet;
+	}
+
+	bool MemoryBudget::OverBudget()
+	{
+		if (!Enabled || Sample() <= bytes)
+		{
+			return false;
+		}
+		//released arrays are mostly on the large object heap, which only a full collection frees
+		GC::Collect();
+		GC::WaitForPendingFinalizers();
+		if (Sample() <= bytes)
+		{
+			return false;
+		}
+		exceeded = true;
+		return true;
+	}
+
+	void MemoryBudget::Release(ImportedSubmesh^ submesh)
+	{
+		submesh->VertexList = nullptr;
+		submesh->FaceList = nullptr;
+		submesh->Indices = nullptr;
+		submesh->Positions = nullptr;
+		submesh->Normals = nullptr;
+		submesh->UV0 = nullptr;
+		submesh->Tangents = nullptr;
+		submesh->Colours = nullptr;
+		submesh->Weights = nullptr;
+		submesh->BoneIndices = nullptr;
+	}
+
+	array<Byte>^ TextureDigest(array<Byte>^ data)
+	{
+		SHA256^ sha = SHA256::Create();
+		try
+		{
+			return sha->ComputeHash(data);
+		}
+		finally
+		{
+			delete sha;
+		}
+	}
+
+	bool SameDigest(array<Byte>^ a, array<Byte>^ b)
+	{
+		if (a->Length != b->Length)
+		{
+			return false;
+		}
+		for (int i = 0; i < a->Length; i++)
+		{
+			if (a[i] != b[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void MemoryBudget::Release(ImportedTexture^ texture)
+	{
+		texture->Data = nullptr;
+	}
+
+	void MemoryBudget::Release(ImportedMorph^ morph)
+	{
+		if (morph->KeyframeList == nullptr)
+		{
+			return;
+		}
+		for each (ImportedMorphKeyframe^ keyframe in morph->KeyframeList)
+		{
+			keyframe->VertexList = nullptr;
+			keyframe->MorphedVertexIndices = nullptr;
+		}
+		morph->MorphedVertexIndices = nullptr;
+	}
+}
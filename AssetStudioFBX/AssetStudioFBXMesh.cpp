@@ -0,0 +1,358 @@
+#include <fbxsdk.h>
+#include <algorithm>
+#include <string.h>
+#include "AssetStudioFBXMesh.h"
+#include "AssetStudioFBXHash.h"
+#include "AssetStudioFBXMeshOptimizer.h"
+
+namespace AssetStudio
+{
+	template <class T>
+	static void CommitDirectArray(FbxLayerElementArrayTemplate<T>& array, const std::vector<T>& source)
+	{
+		int count = (int)source.size();
+		array.Resize(count);
+		if (count > 0)
+		{
+			T* pDst = array.GetLocked(FbxLayerElementArray::eWriteLock);
+			std::copy(source.begin(), source.end(), pDst);
+			array.Release(&pDst);
+		}
+	}
+
+	void PrepareVertexBuffers(const VertexBuffers& buffers, bool tangents, PreparedSubmesh& prepared)
+	{
+		const int count = buffers.VertexCount;
+		prepared.VertexCount = count;
+
+		prepared.ControlPoints.resize(count);
+		const float* pSrc = buffers.Positions;
+		for (int i = 0; i < count; i++, pSrc += 3)
+		{
+			prepared.ControlPoints[i].Set(pSrc[0], pSrc[1], pSrc[2], 0);
+		}
+
+		prepared.Normals.resize(count);
+		pSrc = buffers.Normals;
+		for (int i = 0; i < count; i++)
+		{
+			if (pSrc != NULL)
+			{
+				prepared.Normals[i].Set(pSrc[0], pSrc[1], pSrc[2], 0);
+				pSrc += 3;
+			}
+			else
+			{
+				prepared.Normals[i].Set(0, 0, 0, 0);
+			}
+		}
+
+		if (buffers.UV0 != NULL)
+		{
+			prepared.UV.resize(count);
+			pSrc = buffers.UV0;
+			for (int i = 0; i < count; i++, pSrc += 2)
+			{
+				prepared.UV[i].Set(pSrc[0], pSrc[1]);
+			}
+		}
+
+		if (tangents)
+		{
+			prepared.Tangents.resize(count);
+			pSrc = buffers.Tangents;
+			for (int i = 0; i < count; i++)
+			{
+				if (pSrc != NULL)
+				{
+					prepared.Tangents[i].Set(pSrc[0], pSrc[1], pSrc[2], pSrc[3]);
+					pSrc += 4;
+				}
+				else
+				{
+					prepared.Tangents[i].Set(0, 0, 0, 0);
+				}
+			}
+		}
+
+		if (buffers.Colours != NULL)
+		{
+			prepared.Colours.resize(count);
+			pSrc = buffers.Colours;
+			for (int i = 0; i < count; i++, pSrc += 4)
+			{
+				prepared.Colours[i].Set(pSrc[0], pSrc[1], pSrc[2], pSrc[3]);
+			}
+		}
+	}
+
+	void CommitVertexBuffers(const PreparedSubmesh& prepared, const VertexElements& elements)
+	{
+		if (elements.ControlPoints != NULL)
+		{
+			std::copy(prepared.ControlPoints.begin(), prepared.ControlPoints.end(), elements.ControlPoints);
+		}
+		if (elements.Normal != NULL)
+		{
+			CommitDirectArray(elements.Normal->GetDirectArray(), prepared.Normals);
+		}
+		if (elements.UV != NULL && !prepared.UV.empty())
+		{
+			CommitDirectArray(elements.UV->GetDirectArray(), prepared.UV);
+		}
+		if (elements.Tangent != NULL)
+		{
+			CommitDirectArray(elements.Tangent->GetDirectArray(), prepared.Tangents);
+		}
+		if (elements.VertexColor != NULL && !prepared.Colours.empty())
+		{
+			CommitDirectArray(elements.VertexColor->GetDirectArray(), prepared.Colours);
+		}
+	}
+
+	void PrepareTriangles(const int* indices, int indexCount, PreparedSubmesh& prepared)
+	{
+		const unsigned int vertexCount = (unsigned int)prepared.VertexCount;
+		const int triangleCount = indexCount / 3;
+		prepared.Polygons.resize(triangleCount * 3);
+		int* pDst = prepared.Polygons.data();
+		int kept = 0;
+		for (int i = 0; i < triangleCount; i++, indices += 3)
+		{
+			//a negative index wraps to a large unsigned value, so one compare covers both ends
+			if ((unsigned int)indices[0] < vertexCount && (unsigned int)indices[1] < vertexCount && (unsigned int)indices[2] < vertexCount)
+			{
+				pDst[kept * 3] = indices[0];
+				pDst[kept * 3 + 1] = indices[1];
+				pDst[kept * 3 + 2] = indices[2];
+				kept++;
+			}
+		}
+		prepared.Polygons.resize(kept * 3);
+		prepared.DroppedTriangles = triangleCount - kept;
+	}
+
+	void CommitTriangles(const PreparedSubmesh& prepared, FbxMesh* pMesh)
+	{
+		const int indexCount = (int)prepared.Polygons.size();
+		pMesh->ReservePolygonCount(pMesh->GetPolygonCount() + indexCount / 3);
+		pMesh->ReservePolygonVertexCount(pMesh->GetPolygonVertexCount() + indexCount);
+		const int* pSrc = prepared.Polygons.data();
+		for (int i = 0; i < indexCount; i += 3)
+		{
+			pMesh->BeginPolygon(0);
+			pMesh->AddPolygon(pSrc[i]);
+			pMesh->AddPolygon(pSrc[i + 1]);
+			pMesh->AddPolygon(pSrc[i + 2]);
+			pMesh->EndPolygon();
+		}
+	}
+
+	static void AddWeldStream(std::vector<WeldStream>& streams, const double* data, int stride, int components, size_t count, int vertexCount)
+	{
+		if (count == (size_t)vertexCount && count > 0)
+		{
+			WeldStream stream = { data, stride, components };
+			streams.push_back(stream);
+		}
+	}
+
+	void OptimizeSubmesh(PreparedSubmesh& prepared, double weldTolerance)
+	{
+		const int vertexCount = prepared.VertexCount;
+		prepared.CacheMissesBefore = CountCacheMisses(prepared.Polygons, vertexCount, AcmrCacheSize);
+		prepared.CacheMissesAfter = prepared.CacheMissesBefore;
+		prepared.WeldedVertices = 0;
+		if (prepared.Polygons.empty())
+		{
+			return;
+		}
+
+		std::vector<int> remap;
+		int count = vertexCount;
+		if (weldTolerance >= 0)
+		{
+			std::vector<WeldStream> streams;
+			std::vector<double> influences;
+			AddWeldStream(streams, prepared.ControlPoints.empty() ? NULL : prepared.ControlPoints[0].mData, 4, 3, prepared.ControlPoints.size(), vertexCount);
+			AddWeldStream(streams, prepared.Normals.empty() ? NULL : prepared.Normals[0].mData, 4, 3, prepared.Normals.size(), vertexCount);
+			AddWeldStream(streams, prepared.UV.empty() ? NULL : prepared.UV[0].mData, 2, 2, prepared.UV.size(), vertexCount);
+			AddWeldStream(streams, prepared.Tangents.empty() ? NULL : prepared.Tangents[0].mData, 4, 4, prepared.Tangents.size(), vertexCount);
+			AddWeldStream(streams, prepared.Colours.empty() ? NULL : &prepared.Colours[0].mRed, 4, 4, prepared.Colours.size(), vertexCount);
+			AddInfluenceStreams(streams, influences, prepared.InfluenceBones, prepared.InfluenceWeights, vertexCount, weldTolerance);
+			count = WeldVertices(streams, vertexCount, weldTolerance, remap);
+			for (size_t i = 0; i < prepared.Polygons.size(); i++)
+			{
+				prepared.Polygons[i] = remap[prepared.Polygons[i]];
+			}
+		}
+
+		OptimizeVertexCache(prepared.Polygons, count);
+		std::vector<int> fetch;
+		int used = OptimizeVertexFetch(prepared.Polygons, count, fetch);
+		if (remap.empty())
+		{
+			remap.swap(fetch);
+		}
+		else
+		{
+			for (int i = 0; i < vertexCount; i++)
+			{
+				remap[i] = fetch[remap[i]];
+			}
+		}
+
+		RemapVertices(prepared.ControlPoints, remap, used);
+		RemapVertices(prepared.Normals, remap, used);
+		RemapVertices(prepared.UV, remap, used);
+		RemapVertices(prepared.Tangents, remap, used);
+		RemapVertices(prepared.Colours, remap, used);
+		RemapVertices(prepared.InfluenceBones, remap, used, 4);
+		RemapVertices(prepared.InfluenceWeights, remap, used, 4);
+
+		prepared.VertexCount = used;
+		prepared.WeldedVertices = vertexCount - used;
+		prepared.CacheMissesAfter = CountCacheMisses(prepared.Polygons, used, AcmrCacheSize);
+	}
+
+	void BucketInfluences(PreparedSubmesh& prepared, int boneCount)
+	{
+		prepared.ClusterStart.clear();
+		prepared.ClusterIndices.clear();
+		prepared.ClusterWeights.clear();
+		const std::vector<int>& bones = prepared.InfluenceBones;
+		if (boneCount > 0 && !bones.empty())
+		{
+			//counting sort of the influences by bone, vertex order is kept inside each bucket
+			std::vector<int>& clusterStart = prepared.ClusterStart;
+			clusterStart.assign(boneCount + 1, 0);
+			for (size_t i = 0; i < bones.size(); i++)
+			{
+				if (bones[i] >= 0 && bones[i] < boneCount)
+				{
+					clusterStart[bones[i] + 1]++;
+				}
+			}
+			for (int b = 0; b < boneCount; b++)
+			{
+				clusterStart[b + 1] += clusterStart[b];
+			}
+			prepared.ClusterIndices.resize(clusterStart[boneCount]);
+			prepared.ClusterWeights.resize(clusterStart[boneCount]);
+			std::vector<int> next(clusterStart.begin(), clusterStart.end() - 1);
+			for (size_t i = 0; i < bones.size(); i++)
+			{
+				if (bones[i] >= 0 && bones[i] < boneCount)
+				{
+					int slot = next[bones[i]]++;
+					prepared.ClusterIndices[slot] = (int)(i / 4);
+					prepared.ClusterWeights[slot] = prepared.InfluenceWeights[i];
+				}
+			}
+		}
+		std::vector<int>().swap(prepared.InfluenceBones);
+		std::vector<double>().swap(prepared.InfluenceWeights);
+	}
+
+	template <class T>
+	static unsigned long long HashVector(const std::vector<T>& source, unsigned long long hash)
+	{
+		unsigned long long count = source.size();
+		hash = HashBytes(&count, sizeof(count), hash);
+		return source.empty() ? hash : HashBytes(source.data(), source.size() * sizeof(T), hash);
+	}
+
+	template <class T>
+	static bool SameDirectArray(FbxLayerElementTemplate<T>* pElement, const std::vector<T>& source)
+	{
+		//a missing element holds nothing
+		if (pElement == NULL)
+		{
+			return source.empty();
+		}
+		FbxLayerElementArrayTemplate<T>& array = pElement->GetDirectArray();
+		if (array.GetCount() != (int)source.size())
+		{
+			return false;
+		}
+		if (source.empty())
+		{
+			return true;
+		}
+		T* pSrc = array.GetLocked(FbxLayerElementArray::eReadLock);
+		bool same = memcmp(pSrc, source.data(), source.size() * sizeof(T)) == 0;
+		array.Release(&pSrc);
+		return same;
+	}
+
+	unsigned long long HashGeometry(const PreparedSubmesh& prepared, bool material)
+	{
+		unsigned long long hash = HashBytes(&material, sizeof(material));
+		hash = HashVector(prepared.ControlPoints, hash);
+		hash = HashVector(prepared.Normals, hash);
+		hash = HashVector(prepared.UV, hash);
+		hash = HashVector(prepared.Tangents, hash);
+		hash = HashVector(prepared.Colours, hash);
+		return HashVector(prepared.Polygons, hash);
+	}
+
+	bool SameGeometry(const PreparedSubmesh& prepared, bool material, FbxMesh* pMesh)
+	{
+		if ((pMesh->GetElementMaterial() != NULL) != material)
+		{
+			return false;
+		}
+		if (pMesh->GetControlPointsCount() != (int)prepared.ControlPoints.size() || pMesh->GetPolygonVertexCount() != (int)prepared.Polygons.size())
+		{
+			return false;
+		}
+		if (!prepared.ControlPoints.empty() && memcmp(pMesh->GetControlPoints(), prepared.ControlPoints.data(), prepared.ControlPoints.size() * sizeof(FbxVector4)) != 0)
+		{
+			return false;
+		}
+		if (!prepared.Polygons.empty() && memcmp(pMesh->GetPolygonVertices(), prepared.Polygons.data(), prepared.Polygons.size() * sizeof(int)) != 0)
+		{
+			return false;
+		}
+		return SameDirectArray(pMesh->GetElementNormal(), prepared.Normals)
+			&& SameDirectArray(pMesh->GetElementUV(), prepared.UV)
+			&& SameDirectArray(pMesh->GetElementTangent(), prepared.Tangents)
+			&& SameDirectArray(pMesh->GetElementVertexColor(), prepared.Colours);
+	}
+
+	void CommitMorphShape(const std::vector<FbxVector4>& base, const MorphShape& shape, const MorphShape* previous)
+	{
+		const int vertexCount = (int)base.size();
+		shape.Shape->InitControlPoints(vertexCount);
+		FbxVector4* pControlPoints = shape.Shape->GetControlPoints();
+		std::copy(base.begin(), base.end(), pControlPoints);
+		for (size_t i = 0; i < shape.Indices.size(); i++)
+		{
+			pControlPoints[shape.Indices[i]] = shape.Positions[i];
+		}
+		if (previous != NULL)
+		{
+			for (size_t i = 0; i < previous->Indices.size(); i++)
+			{
+				int index = previous->Indices[i];
+				pControlPoints[index] -= previous->Positions[i] - base[index];
+			}
+		}
+	}
+
+	void CommitMorphMask(FbxGeometryElementVertexColor* pElement, int vertexCount, const MorphShape& shape)
+	{
+		FbxLayerElementArrayTemplate<FbxColor>& colours = pElement->GetDirectArray();
+		colours.Resize(vertexCount);
+		if (vertexCount > 0)
+		{
+			FbxColor* pDst = colours.GetLocked(FbxLayerElementArray::eWriteLock);
+			std::fill(pDst, pDst + vertexCount, FbxColor(1, 1, 1));
+			for (size_t i = 0; i < shape.Indices.size(); i++)
+			{
+				pDst[shape.Indices[i]] = FbxColor(0, 0, 1);
+			}
+			colours.Release(&pDst);
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+
+namespace AssetStudio
+{
+	struct VertexBuffers
+	{
+		int VertexCount;
+		const float* Positions; //xyz
+		const float* Normals; //xyz
+		const float* UV0; //uv
+		const float* Tangents; //xyzw
+		const float* Colours; //rgba
+	};
+
+	struct VertexElements
+	{
+		FbxVector4* ControlPoints;
+		FbxGeometryElementNormal* Normal;
+		FbxGeometryElementUV* UV;
+		FbxGeometryElementTangent* Tangent;
+		FbxGeometryElementVertexColor* VertexColor;
+	};
+
+	//One submesh converted to SDK types without touching the scene, so submeshes can be prepared in parallel
+	struct PreparedSubmesh
+	{
+		int VertexCount;
+		std::vector<FbxVector4> ControlPoints;
+		std::vector<FbxVector4> Normals;
+		std::vector<FbxVector2> UV;
+		std::vector<FbxVector4> Tangents;
+		std::vector<FbxColor> Colours;
+		std::vector<int> Polygons; //three per triangle
+		int DroppedTriangles; //triangles with an index outside [0, VertexCount)
+		std::vector<int> InfluenceBones; //four per vertex, -1 for an empty slot, empty without skin. Cleared by BucketInfluences.
+		std::vector<double> InfluenceWeights;
+		std::vector<int> ClusterStart; //bone count + 1 offsets into the buckets below, empty without skin
+		std::vector<int> ClusterIndices; //influences bucketed by bone, vertex order inside a bucket
+		std::vector<double> ClusterWeights;
+		long long CacheMissesBefore; //simulated post-transform cache misses, set by OptimizeSubmesh
+		long long CacheMissesAfter;
+		int WeldedVertices; //vertices merged into another one or dropped as unused
+	};
+
+	//One blend shape target, only the morphed control points with their absolute positions. Filled without touching Shape, which is only written by CommitMorphShape.
+	struct MorphShape
+	{
+		FbxShape* Shape;
+		std::vector<int> Indices;
+		std::vector<FbxVector4> Positions;
+
+		MorphShape() : Shape(NULL) {}
+	};
+
+	//Converts the packed buffers. A null Normals or Tangents buffer gives zero vectors, a null UV0 or Colours buffer leaves the element empty.
+	void PrepareVertexBuffers(const VertexBuffers& buffers, bool tangents, PreparedSubmesh& prepared);
+	//Copies every prepared element into its non-null scene element, resizing each direct array once
+	void CommitVertexBuffers(const PreparedSubmesh& prepared, const VertexElements& elements);
+	//Copies a flat triangle index buffer in one pass, dropping every triangle that references a missing vertex
+	void PrepareTriangles(const int* indices, int indexCount, PreparedSubmesh& prepared);
+	//Adds the prepared triangles with the polygon storage reserved up front
+	void CommitTriangles(const PreparedSubmesh& prepared, FbxMesh* pMesh);
+	//Welds vertices that match within weldTolerance, influences included, unless it is negative, then reorders the triangles
+	//for the vertex cache and the vertices in fetch order. Runs before BucketInfluences.
+	void OptimizeSubmesh(PreparedSubmesh& prepared, double weldTolerance);
+	//Moves the per-vertex influences into the cluster buckets of boneCount bones, leaving the buckets empty without skin
+	void BucketInfluences(PreparedSubmesh& prepared, int boneCount);
+	//Hash of the committed geometry, control points, vertex elements and triangles. Skin buckets are not included.
+	unsigned long long HashGeometry(const PreparedSubmesh& prepared, bool material);
+	//Exact comparison of the prepared geometry with a mesh it was committed to, for hash collisions
+	bool SameGeometry(const PreparedSubmesh& prepared, bool material, FbxMesh* pMesh);
+	//Fills the shape with the shared base positions and overwrites its morphed points. A previous inbetween has its offsets subtracted, for flat inbetweens.
+	//Calls into the FBX SDK, so only from the thread that owns the scene.
+	void CommitMorphShape(const std::vector<FbxVector4>& base, const MorphShape& shape, const MorphShape* previous);
+	//Fills a mask layer in one write, white with the morphed points in blue
+	void CommitMorphMask(FbxGeometryElementVertexColor* pElement, int vertexCount, const MorphShape& shape);
+}
@@ -0,0 +1,277 @@
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include "AssetStudioFBXMeshOptimizer.h"
+
+namespace AssetStudio
+{
+	static long long Quantize(double value, double tolerance)
+	{
+		if (tolerance > 0)
+		{
+			return (long long)floor(value / tolerance + 0.5);
+		}
+		long long bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	static unsigned long long HashVertex(const std::vector<WeldStream>& streams, int vertex, double tolerance)
+	{
+		unsigned long long hash = 14695981039346656037ULL;
+		for (size_t s = 0; s < streams.size(); s++)
+		{
+			const double* p = streams[s].Data + (size_t)vertex * streams[s].Stride;
+			for (int c = 0; c < streams[s].Components; c++)
+			{
+				hash = (hash ^ (unsigned long long)Quantize(p[c], tolerance)) * 1099511628211ULL;
+				hash ^= hash >> 29;
+			}
+		}
+		return hash;
+	}
+
+	static bool SameVertex(const std::vector<WeldStream>& streams, int a, int b, double tolerance)
+	{
+		for (size_t s = 0; s < streams.size(); s++)
+		{
+			const double* pa = streams[s].Data + (size_t)a * streams[s].Stride;
+			const double* pb = streams[s].Data + (size_t)b * streams[s].Stride;
+			for (int c = 0; c < streams[s].Components; c++)
+			{
+				if (Quantize(pa[c], tolerance) != Quantize(pb[c], tolerance))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	int WeldVertices(const std::vector<WeldStream>& streams, int vertexCount, double tolerance, std::vector<int>& remap)
+	{
+		remap.resize(vertexCount);
+		//open addressing over the distinct vertices, at most half full
+		size_t tableSize = 1;
+		while (tableSize < (size_t)vertexCount * 2)
+		{
+			tableSize <<= 1;
+		}
+		std::vector<int> table(tableSize, -1);
+		std::vector<int> firstVertex;
+		firstVertex.reserve(vertexCount);
+
+		for (int i = 0; i < vertexCount; i++)
+		{
+			size_t slot = (size_t)HashVertex(streams, i, tolerance) & (tableSize - 1);
+			for (;;)
+			{
+				int distinct = table[slot];
+				if (distinct < 0)
+				{
+					table[slot] = (int)firstVertex.size();
+					remap[i] = (int)firstVertex.size();
+					firstVertex.push_back(i);
+					break;
+				}
+				if (SameVertex(streams, firstVertex[distinct], i, tolerance))
+				{
+					remap[i] = distinct;
+					break;
+				}
+				slot = (slot + 1) & (tableSize - 1);
+			}
+		}
+		return (int)firstVertex.size();
+	}
+
+	namespace
+	{
+		//Tom Forsyth, Linear-Speed Vertex Cache Optimisation
+		const int ForsythCacheSize = 32;
+		const float CacheDecayPower = 1.5f;
+		const float LastTriangleScore = 0.75f;
+		const float ValenceBoostScale = 2.0f;
+		const float ValenceBoostPower = 0.5f;
+
+		float VertexScore(int cachePosition, int remainingTriangles)
+		{
+			if (remainingTriangles == 0)
+			{
+				return -1.0f;
+			}
+			float score = 0.0f;
+			if (cachePosition >= 0)
+			{
+				if (cachePosition < 3)
+				{
+					score = LastTriangleScore;
+				}
+				else
+				{
+					const float scaler = 1.0f / (ForsythCacheSize - 3);
+					score = powf(1.0f - (cachePosition - 3) * scaler, CacheDecayPower);
+				}
+			}
+			return score + ValenceBoostScale * powf((float)remainingTriangles, -ValenceBoostPower);
+		}
+	}
+
+	void OptimizeVertexCache(std::vector<int>& indices, int vertexCount)
+	{
+		const int triangleCount = (int)(indices.size() / 3);
+		if (triangleCount < 2)
+		{
+			return;
+		}
+
+		//triangles of every vertex, the live ones kept at the front of each range
+		std::vector<int> remaining(vertexCount, 0);
+		for (int i = 0; i < triangleCount * 3; i++)
+		{
+			remaining[indices[i]]++;
+		}
+		std::vector<int> adjacencyStart(vertexCount + 1, 0);
+		for (int v = 0; v < vertexCount; v++)
+		{
+			adjacencyStart[v + 1] = adjacencyStart[v] + remaining[v];
+		}
+		std::vector<int> adjacency(triangleCount * 3);
+		std::vector<int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+		for (int t = 0; t < triangleCount; t++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				adjacency[fill[indices[t * 3 + k]]++] = t;
+			}
+		}
+
+		std::vector<int> cachePosition(vertexCount, -1);
+		std::vector<float> vertexScore(vertexCount);
+		for (int v = 0; v < vertexCount; v++)
+		{
+			vertexScore[v] = VertexScore(-1, remaining[v]);
+		}
+		std::vector<char> emitted(triangleCount, 0);
+		int best = 0;
+		float bestScore = -1.0f;
+		for (int t = 0; t < triangleCount; t++)
+		{
+			float score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+			if (score > bestScore)
+			{
+				bestScore = score;
+				best = t;
+			}
+		}
+
+		std::vector<int> output(triangleCount * 3);
+		int cache[ForsythCacheSize + 3];
+		int cacheCount = 0;
+		int scanCursor = 0;
+
+		for (int emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+		{
+			if (best < 0)
+			{
+				//nothing in the cache touches a live triangle, continue with the next one in input order
+				while (emitted[scanCursor])
+				{
+					scanCursor++;
+				}
+				best = scanCursor;
+			}
+
+			const int* tri = &indices[best * 3];
+			memcpy(&output[emittedCount * 3], tri, 3 * sizeof(int));
+			emitted[best] = 1;
+
+			//the triangle's vertices move to the front of the LRU cache, the rest shift back
+			int newCache[ForsythCacheSize + 3];
+			int newCount = 0;
+			for (int k = 0; k < 3; k++)
+			{
+				int v = tri[k];
+				newCache[newCount++] = v;
+				int* pBegin = &adjacency[adjacencyStart[v]];
+				int* pEnd = pBegin + remaining[v];
+				int* pFound = std::find(pBegin, pEnd, best);
+				std::swap(*pFound, *(pEnd - 1));
+				remaining[v]--;
+			}
+			for (int c = 0; c < cacheCount; c++)
+			{
+				int v = cache[c];
+				if (v != tri[0] && v != tri[1] && v != tri[2])
+				{
+					newCache[newCount++] = v;
+				}
+			}
+			for (int c = ForsythCacheSize; c < newCount; c++)
+			{
+				//pushed out of the cache
+				cachePosition[newCache[c]] = -1;
+				vertexScore[newCache[c]] = VertexScore(-1, remaining[newCache[c]]);
+			}
+			cacheCount = std::min(newCount, ForsythCacheSize);
+			memcpy(cache, newCache, cacheCount * sizeof(int));
+
+			for (int c = 0; c < cacheCount; c++)
+			{
+				cachePosition[cache[c]] = c;
+				vertexScore[cache[c]] = VertexScore(c, remaining[cache[c]]);
+			}
+
+			//only triangles of cached vertices changed their score, the best of them goes next
+			best = -1;
+			bestScore = -1.0f;
+			for (int c = 0; c < newCount; c++)
+			{
+				int v = newCache[c];
+				for (int a = adjacencyStart[v], end = adjacencyStart[v] + remaining[v]; a < end; a++)
+				{
+					int t = adjacency[a];
+					float score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+					if (score > bestScore)
+					{
+						bestScore = score;
+						best = t;
+					}
+				}
+			}
+		}
+		indices.swap(output);
+	}
+
+	int OptimizeVertexFetch(std::vector<int>& indices, int vertexCount, std::vector<int>& remap)
+	{
+		remap.assign(vertexCount, -1);
+		int next = 0;
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			int& slot = remap[indices[i]];
+			if (slot < 0)
+			{
+				slot = next++;
+			}
+			indices[i] = slot;
+		}
+		return next;
+	}
+
+	long long CountCacheMisses(const std::vector<int>& indices, int vertexCount, int cacheSize)
+	{
+		//a vertex is still cached while fewer than cacheSize misses happened since it was loaded
+		std::vector<long long> loadedAt(vertexCount, -(long long)cacheSize - 1);
+		long long misses = 0;
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			long long& loaded = loadedAt[indices[i]];
+			if (misses - loaded >= cacheSize)
+			{
+				loaded = misses++;
+			}
+		}
+		return misses;
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+namespace AssetStudio
+{
+	//One per-vertex attribute, Components doubles at the start of every Stride doubles
+	struct WeldStream
+	{
+		const double* Data;
+		int Stride;
+		int Components;
+	};
+
+	//Cache size ACMR is measured with, the common FIFO size of desktop hardware
+	const int AcmrCacheSize = 16;
+
+	//Maps every vertex to the first earlier vertex whose streams all fall into the same grid cells of size tolerance,
+	//or compare equal when tolerance is 0. remap[i] numbers the distinct vertices in first-seen order, their count is returned.
+	int WeldVertices(const std::vector<WeldStream>& streams, int vertexCount, double tolerance, std::vector<int>& remap);
+	//Reorders the triangles for a LRU post-transform cache with Forsyth's linear-speed algorithm, the winding of each triangle is kept
+	void OptimizeVertexCache(std::vector<int>& indices, int vertexCount);
+	//Renumbers the vertices in the order the triangles first use them. Unused vertices map to -1, the used count is returned.
+	int OptimizeVertexFetch(std::vector<int>& indices, int vertexCount, std::vector<int>& remap);
+	//Misses of a FIFO cache of cacheSize vertices over the triangle list, ACMR is this over the triangle count
+	long long CountCacheMisses(const std::vector<int>& indices, int vertexCount, int cacheSize);
+
+	//Moves each value to remap[i] in a buffer of count values, the first vertex mapped to a slot wins. Buffers without one value per vertex are left alone.
+	template <class T>
+	void RemapVertices(std::vector<T>& values, const std::vector<int>& remap, int count)
+	{
+		if (values.size() != remap.size())
+		{
+			return;
+		}
+		std::vector<T> remapped(count);
+		for (size_t i = remap.size(); i-- > 0;)
+		{
+			if (remap[i] >= 0)
+			{
+				remapped[remap[i]] = values[i];
+			}
+		}
+		values.swap(remapped);
+	}
+
+	//RemapVertices for buffers of components values per vertex
+	template <class T>
+	void RemapVertices(std::vector<T>& values, const std::vector<int>& remap, int count, int components)
+	{
+		if (values.size() != remap.size() * components)
+		{
+			return;
+		}
+		std::vector<T> remapped((size_t)count * components);
+		for (size_t i = remap.size(); i-- > 0;)
+		{
+			if (remap[i] >= 0)
+			{
+				for (int c = 0; c < components; c++)
+				{
+					remapped[(size_t)remap[i] * components + c] = values[i * components + c];
+				}
+			}
+		}
+		values.swap(remapped);
+	}
+
+	//Adds four bone indices and weights per vertex to the weld key, kept in storage. Slots without weight count as no bone,
+	//and bone indices are spread wider than any tolerance rounds, so only vertices with the same bones and close weights merge.
+	template <class T>
+	void AddInfluenceStreams(std::vector<WeldStream>& streams, std::vector<double>& storage, const std::vector<int>& bones, const std::vector<T>& weights, int vertexCount, double tolerance)
+	{
+		if (vertexCount <= 0 || bones.size() != (size_t)vertexCount * 4 || weights.size() != bones.size())
+		{
+			return;
+		}
+		const double spread = tolerance + 1;
+		storage.resize(bones.size() * 2);
+		for (size_t v = 0; v < (size_t)vertexCount; v++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				double weight = weights[v * 4 + c];
+				storage[v * 8 + c] = weight > 0 ? bones[v * 4 + c] * spread : -spread;
+				storage[v * 8 + 4 + c] = weight > 0 ? weight : 0;
+			}
+		}
+		WeldStream stream = { storage.data(), 8, 8 };
+		streams.push_back(stream);
+	}
+}
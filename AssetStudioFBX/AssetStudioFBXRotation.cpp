@@ -0,0 +1,300 @@
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include "AssetStudioFBXRotation.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define ROTATION_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+//MSVC accepts the intrinsics anywhere, gcc and clang need the instruction set enabled per function
+#if defined(ROTATION_X86) && !defined(_MSC_VER)
+#define ROTATION_TARGET_PUSH(isa) _Pragma("GCC push_options") _Pragma(isa)
+#define ROTATION_TARGET_POP _Pragma("GCC pop_options")
+#else
+#define ROTATION_TARGET_PUSH(isa)
+#define ROTATION_TARGET_POP
+#endif
+
+namespace AssetStudio
+{
+	namespace RotationScalarPath
+	{
+		typedef double V;
+		static const int Width = 1;
+
+		static inline V Bits(unsigned long long u) { V v; memcpy(&v, &u, sizeof(v)); return v; }
+		static inline unsigned long long Bits(V v) { unsigned long long u; memcpy(&u, &v, sizeof(u)); return u; }
+
+		static inline V Set1(double a) { return a; }
+		static inline V Add(V a, V b) { return a + b; }
+		static inline V Sub(V a, V b) { return a - b; }
+		static inline V Mul(V a, V b) { return a * b; }
+		static inline V Div(V a, V b) { return a / b; }
+		static inline V Sqrt(V a) { return sqrt(a); }
+		static inline V And(V a, V b) { return Bits(Bits(a) & Bits(b)); }
+		static inline V Or(V a, V b) { return Bits(Bits(a) | Bits(b)); }
+		static inline V Xor(V a, V b) { return Bits(Bits(a) ^ Bits(b)); }
+		static inline V AndNot(V a, V b) { return Bits(~Bits(a) & Bits(b)); }
+		static inline V CmpGt(V a, V b) { return a > b ? Bits(~0ULL) : 0.0; }
+		static inline V Blend(V mask, V a, V b) { return (Bits(mask) >> 63) ? a : b; }
+
+		static inline void LoadQuats(const float* q, V& x, V& y, V& z, V& w)
+		{
+			x = q[0];
+			y = q[1];
+			z = q[2];
+			w = q[3];
+		}
+
+		static inline void StoreEulers(float* e, V x, V y, V z)
+		{
+			e[0] = (float)x;
+			e[1] = (float)y;
+			e[2] = (float)z;
+		}
+
+#include "AssetStudioFBXRotationKernel.inl"
+	}
+
+#ifdef ROTATION_X86
+	ROTATION_TARGET_PUSH("GCC target(\"sse4.1\")")
+	namespace RotationSse41Path
+	{
+		typedef __m128d V;
+		static const int Width = 2;
+
+		static inline V Set1(double a) { return _mm_set1_pd(a); }
+		static inline V Add(V a, V b) { return _mm_add_pd(a, b); }
+		static inline V Sub(V a, V b) { return _mm_sub_pd(a, b); }
+		static inline V Mul(V a, V b) { return _mm_mul_pd(a, b); }
+		static inline V Div(V a, V b) { return _mm_div_pd(a, b); }
+		static inline V Sqrt(V a) { return _mm_sqrt_pd(a); }
+		static inline V And(V a, V b) { return _mm_and_pd(a, b); }
+		static inline V Or(V a, V b) { return _mm_or_pd(a, b); }
+		static inline V Xor(V a, V b) { return _mm_xor_pd(a, b); }
+		static inline V AndNot(V a, V b) { return _mm_andnot_pd(a, b); }
+		static inline V CmpGt(V a, V b) { return _mm_cmpgt_pd(a, b); }
+		static inline V Blend(V mask, V a, V b) { return _mm_blendv_pd(b, a, mask); }
+
+		static inline void LoadQuats(const float* q, V& x, V& y, V& z, V& w)
+		{
+			__m128 q0 = _mm_loadu_ps(q);
+			__m128 q1 = _mm_loadu_ps(q + 4);
+			__m128 xy = _mm_unpacklo_ps(q0, q1); //x0 x1 y0 y1
+			__m128 zw = _mm_unpackhi_ps(q0, q1); //z0 z1 w0 w1
+			x = _mm_cvtps_pd(xy);
+			y = _mm_cvtps_pd(_mm_movehl_ps(xy, xy));
+			z = _mm_cvtps_pd(zw);
+			w = _mm_cvtps_pd(_mm_movehl_ps(zw, zw));
+		}
+
+		static inline void StoreEulers(float* e, V x, V y, V z)
+		{
+			__m128 fx = _mm_cvtpd_ps(x);
+			__m128 fy = _mm_cvtpd_ps(y);
+			__m128 fz = _mm_cvtpd_ps(z);
+			__m128 xy = _mm_unpacklo_ps(fx, fy); //x0 y0 x1 y1
+			_mm_storel_pi((__m64*)e, xy);
+			_mm_store_ss(e + 2, fz);
+			_mm_storeh_pi((__m64*)(e + 3), xy);
+			_mm_store_ss(e + 5, _mm_shuffle_ps(fz, fz, _MM_SHUFFLE(1, 1, 1, 1)));
+		}
+
+#include "AssetStudioFBXRotationKernel.inl"
+	}
+	ROTATION_TARGET_POP
+
+	ROTATION_TARGET_PUSH("GCC target(\"avx2\")")
+	namespace RotationAvx2Path
+	{
+		typedef __m256d V;
+		static const int Width = 4;
+
+		static inline V Set1(double a) { return _mm256_set1_pd(a); }
+		static inline V Add(V a, V b) { return _mm256_add_pd(a, b); }
+		static inline V Sub(V a, V b) { return _mm256_sub_pd(a, b); }
+		static inline V Mul(V a, V b) { return _mm256_mul_pd(a, b); }
+		static inline V Div(V a, V b) { return _mm256_div_pd(a, b); }
+		static inline V Sqrt(V a) { return _mm256_sqrt_pd(a); }
+		static inline V And(V a, V b) { return _mm256_and_pd(a, b); }
+		static inline V Or(V a, V b) { return _mm256_or_pd(a, b); }
+		static inline V Xor(V a, V b) { return _mm256_xor_pd(a, b); }
+		static inline V AndNot(V a, V b) { return _mm256_andnot_pd(a, b); }
+		static inline V CmpGt(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+		static inline V Blend(V mask, V a, V b) { return _mm256_blendv_pd(b, a, mask); }
+
+		static inline void LoadQuats(const float* q, V& x, V& y, V& z, V& w)
+		{
+			__m128 q0 = _mm_loadu_ps(q);
+			__m128 q1 = _mm_loadu_ps(q + 4);
+			__m128 q2 = _mm_loadu_ps(q + 8);
+			__m128 q3 = _mm_loadu_ps(q + 12);
+			_MM_TRANSPOSE4_PS(q0, q1, q2, q3);
+			x = _mm256_cvtps_pd(q0);
+			y = _mm256_cvtps_pd(q1);
+			z = _mm256_cvtps_pd(q2);
+			w = _mm256_cvtps_pd(q3);
+		}
+
+		static inline void StoreEulers(float* e, V x, V y, V z)
+		{
+			//x0 x1 x2 x3, y0.., z0.. to x0 y0 z0 x1 y1 z1 ...
+			__m128 fx = _mm256_cvtpd_ps(x);
+			__m128 fy = _mm256_cvtpd_ps(y);
+			__m128 fz = _mm256_cvtpd_ps(z);
+			__m128 xy01 = _mm_unpacklo_ps(fx, fy); //x0 y0 x1 y1
+			__m128 xy23 = _mm_unpackhi_ps(fx, fy); //x2 y2 x3 y3
+			__m128 z0x1 = _mm_shuffle_ps(fz, xy01, _MM_SHUFFLE(2, 2, 0, 0)); //z0 z0 x1 x1
+			__m128 y1z1 = _mm_shuffle_ps(xy01, fz, _MM_SHUFFLE(1, 1, 3, 3)); //y1 y1 z1 z1
+			__m128 z2x3 = _mm_shuffle_ps(fz, xy23, _MM_SHUFFLE(2, 2, 2, 2)); //z2 z2 x3 x3
+			__m128 y3z3 = _mm_shuffle_ps(xy23, fz, _MM_SHUFFLE(3, 3, 3, 3)); //y3 y3 z3 z3
+			_mm_storeu_ps(e, _mm_shuffle_ps(xy01, z0x1, _MM_SHUFFLE(2, 0, 1, 0))); //x0 y0 z0 x1
+			_mm_storeu_ps(e + 4, _mm_shuffle_ps(y1z1, xy23, _MM_SHUFFLE(1, 0, 2, 0))); //y1 z1 x2 y2
+			_mm_storeu_ps(e + 8, _mm_shuffle_ps(z2x3, y3z3, _MM_SHUFFLE(2, 0, 2, 0))); //z2 x3 y3 z3
+		}
+
+#include "AssetStudioFBXRotationKernel.inl"
+	}
+	ROTATION_TARGET_POP
+#endif
+
+	static RotationPath CpuRotationPath()
+	{
+#ifdef ROTATION_X86
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		int maxLeaf = info[0];
+		__cpuid(info, 1);
+		bool sse41 = (info[2] & (1 << 19)) != 0;
+		//AVX registers also need operating system support
+		bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+		bool avx2 = false;
+		if (osAvx && maxLeaf >= 7)
+		{
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+#else
+		__builtin_cpu_init();
+		bool sse41 = __builtin_cpu_supports("sse4.1") != 0;
+		bool avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+		if (avx2)
+		{
+			return RotationAvx2;
+		}
+		if (sse41)
+		{
+			return RotationSse41;
+		}
+#endif
+		return RotationScalar;
+	}
+
+	RotationPath DetectRotationPath()
+	{
+		static const RotationPath path = CpuRotationPath();
+		return path;
+	}
+
+	const char* RotationPathName(RotationPath path)
+	{
+		switch (path)
+		{
+		case RotationAvx2:
+			return "avx2";
+		case RotationSse41:
+			return "sse4.1";
+		default:
+			return "scalar";
+		}
+	}
+
+	void QuaternionsToEuler(const float* quats, float* eulers, int count)
+	{
+		QuaternionsToEuler(quats, eulers, count, DetectRotationPath());
+	}
+
+	void QuaternionsToEuler(const float* quats, float* eulers, int count, RotationPath path)
+	{
+		int done = 0;
+#ifdef ROTATION_X86
+		if (path == RotationAvx2)
+		{
+			done = count & ~3;
+			RotationAvx2Path::QuaternionsToEulerKernel(quats, eulers, done);
+		}
+		else if (path == RotationSse41)
+		{
+			done = count & ~1;
+			RotationSse41Path::QuaternionsToEulerKernel(quats, eulers, done);
+		}
+#endif
+		//the tail runs the same kernel one key at a time
+		RotationScalarPath::QuaternionsToEulerKernel(quats + done * 4, eulers + done * 3, count - done);
+	}
+
+	void EulersToQuaternion(const float* eulers, float* quats, int count)
+	{
+		const double toRadians = 0.017453292519943295769236907684886;
+		for (int i = 0; i < count; i++, eulers += 3, quats += 4)
+		{
+			//rows of FbxAMatrix::SetR for euler XYZ
+			double cx = cos(eulers[0] * toRadians), sx = sin(eulers[0] * toRadians);
+			double cy = cos(eulers[1] * toRadians), sy = sin(eulers[1] * toRadians);
+			double cz = cos(eulers[2] * toRadians), sz = sin(eulers[2] * toRadians);
+			double m[3][3] =
+			{
+				{ cy * cz, cy * sz, -sy },
+				{ sx * sy * cz - cx * sz, sx * sy * sz + cx * cz, sx * cy },
+				{ cx * sy * cz + sx * sz, cx * sy * sz - sx * cz, cx * cy }
+			};
+
+			//FbxAMatrix::GetQ, largest of w, x, y, z first
+			double x, y, z, w;
+			double trace = m[0][0] + m[1][1] + m[2][2];
+			if (trace > 0)
+			{
+				double s = sqrt(trace + 1.0) * 2;
+				w = 0.25 * s;
+				x = (m[1][2] - m[2][1]) / s;
+				y = (m[2][0] - m[0][2]) / s;
+				z = (m[0][1] - m[1][0]) / s;
+			}
+			else if (m[0][0] > m[1][1] && m[0][0] > m[2][2])
+			{
+				double s = sqrt(1.0 + m[0][0] - m[1][1] - m[2][2]) * 2;
+				w = (m[1][2] - m[2][1]) / s;
+				x = 0.25 * s;
+				y = (m[0][1] + m[1][0]) / s;
+				z = (m[2][0] + m[0][2]) / s;
+			}
+			else if (m[1][1] > m[2][2])
+			{
+				double s = sqrt(1.0 + m[1][1] - m[0][0] - m[2][2]) * 2;
+				w = (m[2][0] - m[0][2]) / s;
+				x = (m[0][1] + m[1][0]) / s;
+				y = 0.25 * s;
+				z = (m[1][2] + m[2][1]) / s;
+			}
+			else
+			{
+				double s = sqrt(1.0 + m[2][2] - m[0][0] - m[1][1]) * 2;
+				w = (m[0][1] - m[1][0]) / s;
+				x = (m[2][0] + m[0][2]) / s;
+				y = (m[1][2] + m[2][1]) / s;
+				z = 0.25 * s;
+			}
+			quats[0] = (float)x;
+			quats[1] = (float)y;
+			quats[2] = (float)z;
+			quats[3] = (float)w;
+		}
+	}
+}
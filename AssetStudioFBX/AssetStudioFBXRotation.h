@@ -0,0 +1,25 @@
+#pragma once
+
+namespace AssetStudio
+{
+	enum RotationPath
+	{
+		RotationScalar,
+		RotationSse41,
+		RotationAvx2
+	};
+
+	//Widest path the processor supports, checked once
+	RotationPath DetectRotationPath();
+	const char* RotationPathName(RotationPath path);
+
+	//Quaternions xyzw to euler XYZ in degrees, like FbxAMatrix::SetQ followed by GetR.
+	//Every path computes in double with the same steps, so all paths give the same floats. Each angle is within 1 ulp of the
+	//same steps done with the C library atan2, including keys around the 16 * FLT_EPSILON gimbal threshold, as AssetStudioFBXTest checks.
+	//The distance to the SDK itself is measured by AssetStudioFBXBenchmark when built with the SDK.
+	void QuaternionsToEuler(const float* quats, float* eulers, int count);
+	void QuaternionsToEuler(const float* quats, float* eulers, int count, RotationPath path);
+	//Euler XYZ in degrees to quaternions xyzw, like FbxAMatrix::SetR followed by GetQ.
+	//Scalar only, there is no SIMD path for this direction.
+	void EulersToQuaternion(const float* eulers, float* quats, int count);
+}
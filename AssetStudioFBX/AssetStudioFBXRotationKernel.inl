@@ -0,0 +1,72 @@
+//Quaternion to euler kernel, included once per instruction set by AssetStudioFBXRotation.cpp.
+//The including namespace provides V, Width, Set1, Add, Sub, Mul, Div, Sqrt, And, Or, Xor, AndNot, CmpGt, Blend, LoadQuats and StoreEulers.
+//Blend(mask, a, b) picks a where the sign bit of mask is set, so a compare mask or a negative value can select.
+
+//atan on [0, 1], Cephes rational approximation with its range reduction at 0.66
+static inline V AtanUnit(V t)
+{
+	V one = Set1(1.0);
+	V reduce = CmpGt(t, Set1(0.66));
+	V u = Blend(reduce, Div(Sub(t, one), Add(t, one)), t);
+	V z = Mul(u, u);
+	V p = Set1(-8.750608600031904122785e-1);
+	p = Add(Mul(p, z), Set1(-1.615753718733365076637e1));
+	p = Add(Mul(p, z), Set1(-7.500855792314704667340e1));
+	p = Add(Mul(p, z), Set1(-1.228866684490136173410e2));
+	p = Add(Mul(p, z), Set1(-6.485021904942025371773e1));
+	V q = Add(z, Set1(2.485846490142306297962e1));
+	q = Add(Mul(q, z), Set1(1.650270098316988542046e2));
+	q = Add(Mul(q, z), Set1(4.328810604912902668951e2));
+	q = Add(Mul(q, z), Set1(4.853903996359136964868e2));
+	q = Add(Mul(q, z), Set1(1.945506571482613964425e2));
+	V r = Add(Mul(u, Div(Mul(z, p), q)), u);
+	return Blend(reduce, Add(Set1(7.85398163397448309616e-1), Add(r, Set1(0.5 * 6.123233995736765886130e-17))), r);
+}
+
+static inline V Atan2(V y, V x)
+{
+	V sign = Set1(-0.0);
+	V ax = AndNot(sign, x);
+	V ay = AndNot(sign, y);
+	V swap = CmpGt(ay, ax);
+	V num = Blend(swap, ax, ay);
+	V den = Blend(swap, ay, ax);
+	//atan2(0, 0) is 0 before the quadrant fix, the discarded 0 / 0 lanes raise no exception
+	V r = AtanUnit(Blend(CmpGt(den, Set1(0.0)), Div(num, den), Set1(0.0)));
+	r = Blend(swap, Sub(Set1(1.57079632679489661923), r), r);
+	r = Blend(x, Sub(Set1(3.14159265358979323846), r), r);
+	return Or(r, And(sign, y));
+}
+
+static void QuaternionsToEulerKernel(const float* quats, float* eulers, int count)
+{
+	const V one = Set1(1.0);
+	const V toDegrees = Set1(57.295779513082320876798154814105);
+	const V gimbal = Set1(16.0 * FLT_EPSILON);
+	for (int i = 0; i + Width <= count; i += Width, quats += Width * 4, eulers += Width * 3)
+	{
+		V x, y, z, w;
+		LoadQuats(quats, x, y, z, w);
+
+		//rotation rows as FbxAMatrix::SetQ lays them out
+		V x2 = Add(x, x), y2 = Add(y, y), z2 = Add(z, z);
+		V xx = Mul(x, x2), xy = Mul(x, y2), xz = Mul(x, z2);
+		V yy = Mul(y, y2), yz = Mul(y, z2), zz = Mul(z, z2);
+		V wx = Mul(w, x2), wy = Mul(w, y2), wz = Mul(w, z2);
+		V m00 = Sub(one, Add(yy, zz));
+		V m01 = Add(xy, wz);
+		V m02 = Sub(xz, wy);
+		V m11 = Sub(one, Add(xx, zz));
+		V m12 = Add(yz, wx);
+		V m21 = Sub(yz, wx);
+		V m22 = Sub(one, Add(xx, yy));
+
+		//FbxAMatrix::GetR, with the gimbal lock fallback that leaves z at zero
+		V cy = Sqrt(Add(Mul(m00, m00), Mul(m01, m01)));
+		V locked = CmpGt(gimbal, cy);
+		V rx = Atan2(Blend(locked, Xor(m21, Set1(-0.0)), m12), Blend(locked, m11, m22));
+		V ry = Atan2(Xor(m02, Set1(-0.0)), cy);
+		V rz = Blend(locked, Set1(0.0), Atan2(m01, m00));
+		StoreEulers(eulers, Mul(rx, toDegrees), Mul(ry, toDegrees), Mul(rz, toDegrees));
+	}
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace AssetStudio
+{
+	//SDK-independent copy of IImported, frames are stored parents first
+
+	class SceneSpill;
+
+	enum SceneFrameAttribute
+	{
+		FrameNone,
+		FrameNull,
+		FrameJoint
+	};
+
+	struct SceneFrame
+	{
+		std::string Name;
+		int Parent; //-1 for the root
+		SceneFrameAttribute Attribute;
+		float LocalPosition[3];
+		float LocalRotation[3]; //euler XYZ in degrees
+		float LocalScale[3];
+	};
+
+	struct SceneBone
+	{
+		int Frame;
+		float Matrix[16]; //ImportedBone::Matrix[row, column], row by row
+	};
+
+	struct SceneSubmesh
+	{
+		int VertexCount;
+		std::vector<float> Positions; //xyz
+		std::vector<float> Normals; //xyz
+		std::vector<float> UV0; //uv, empty if absent
+		std::vector<float> Tangents; //xyzw
+		std::vector<float> Colours; //rgba, empty if absent
+		std::vector<int> Indices; //three per triangle
+		std::vector<int> BoneIndices; //four per vertex, empty if not skinned
+		std::vector<float> Weights; //four per vertex
+		int Material; //-1 for none
+		bool Spilled; //the arrays are in Scene::Spill, see SceneSpill::Load
+		long long SpillOffset;
+	};
+
+	struct SceneMesh
+	{
+		int Frame;
+		std::vector<SceneSubmesh> Submeshes;
+		std::vector<SceneBone> Bones;
+	};
+
+	struct SceneMaterialTexture
+	{
+		int Texture;
+		int Dest; //0 diffuse, 1 normal, 2 specular, 3 bump
+		float Offset[2];
+		float Scale[2];
+	};
+
+	struct SceneMaterial
+	{
+		std::string Name;
+		float Diffuse[4];
+		float Ambient[4];
+		float Emissive[4];
+		float Specular[4];
+		float Reflection[4];
+		float Shininess;
+		float Transparency;
+		std::vector<SceneMaterialTexture> Textures;
+	};
+
+	struct SceneTexture
+	{
+		std::string Name;
+		std::string FileName;
+		std::string RelativeFileName;
+		std::vector<unsigned char> Data;
+	};
+
+	struct SceneShape
+	{
+		std::string Name;
+		float Weight;
+		std::vector<int> Indices; //control points of the submesh
+		std::vector<float> Deltas; //xyz offset from the base position per index
+	};
+
+	struct SceneBlendChannel
+	{
+		std::string Name;
+		float DeformPercent;
+		std::vector<SceneShape> Shapes;
+	};
+
+	struct SceneMorph
+	{
+		int Mesh;
+		int Submesh;
+		std::string Name;
+		bool WeightProperties; //flat inbetweens, shape weights become user properties of the mesh
+		std::vector<SceneBlendChannel> Channels;
+	};
+
+	struct SceneCurve
+	{
+		std::vector<float> Times; //seconds
+		std::vector<float> Values; //xyz per key
+		bool Linear; //set by ReduceKeys, the tolerance only holds for straight lines between the kept keys
+
+		SceneCurve() : Linear(false) {}
+	};
+
+	struct SceneTrack
+	{
+		int Frame;
+		SceneCurve Scalings;
+		SceneCurve Rotations;
+		SceneCurve Translations;
+	};
+
+	struct SceneClip
+	{
+		std::string Name;
+		std::vector<SceneTrack> Tracks;
+	};
+
+	struct Scene
+	{
+		std::vector<SceneFrame> Frames;
+		std::vector<SceneMesh> Meshes;
+		std::vector<SceneMaterial> Materials;
+		std::vector<SceneTexture> Textures;
+		std::vector<SceneMorph> Morphs;
+		std::vector<SceneClip> Clips;
+		float ScaleFactor;
+		float BoneSize;
+		SceneSpill* Spill; //owned by whoever built the scene, NULL if nothing was spilled
+	};
+
+	//Sections of the written file, serialization covers the header, definitions, connections, takes and the footer
+	enum SceneStage
+	{
+		StageHierarchy,
+		StageMesh,
+		StageSkin,
+		StageMaterials,
+		StageMorphs,
+		StageAnimation,
+		StageSerialization,
+		SceneStageCount
+	};
+
+	struct SceneWriteStats
+	{
+		unsigned long long FileBytes;
+		unsigned long long ArrayBytes;
+		unsigned long long CompressedArrayBytes;
+		int Objects;
+		double StageSeconds[SceneStageCount];
+	};
+
+	const char* SceneStageName(SceneStage stage);
+
+	//Writes scene as binary FBX 7400 or 7500, throws std::runtime_error on failure
+	SceneWriteStats WriteBinaryFbx(const Scene& scene, const char* path, int version, bool compress);
+
+	struct GlbWriteStats
+	{
+		unsigned long long FileBytes;
+		unsigned long long JsonBytes;
+		unsigned long long BinaryBytes;
+		int Nodes;
+		int Meshes;
+		int Accessors;
+	};
+
+	//Writes scene as binary glTF 2.0, throws std::runtime_error on failure.
+	//Each submesh becomes a node and mesh under its frame like in the FBX file, blend shapes become sparse morph targets,
+	//euler keys are converted to quaternions. Textures are referenced by their relative file name.
+	GlbWriteStats WriteGlb(const Scene& scene, const char* path);
+
+	//Serializes scene with its geometry resident, texture files are referenced by their relative file name only.
+	//Throws std::runtime_error on failure.
+	void WriteSceneSnapshot(const Scene& scene, const char* path);
+	//Reads a snapshot written by WriteSceneSnapshot and checks every index the writers rely on.
+	//Texture file names are relative until the caller resolves them. Throws std::runtime_error on failure or a version mismatch.
+	void ReadSceneSnapshot(const char* path, Scene& scene);
+
+	struct SceneOptimizeStats
+	{
+		long long Triangles;
+		long long CacheMissesBefore;
+		long long CacheMissesAfter;
+		int WeldedVertices;
+	};
+
+	//Welds, reorders for the vertex cache and renumbers one resident submesh like the SDK exporter's optimisation stage.
+	//A negative weldTolerance only reorders. Blend shapes index the vertices, so submeshes with morphs must not be passed in.
+	SceneOptimizeStats OptimizeSceneSubmesh(SceneSubmesh& submesh, double weldTolerance);
+}
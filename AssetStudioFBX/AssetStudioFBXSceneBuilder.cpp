@@ -0,0 +1,829 @@
+#include <fbxsdk.h>
+#include "AssetStudioFBX.h"
+#include "AssetStudioFBXHash.h"
+#include "AssetStudioFBXSceneSpill.h"
+
+namespace AssetStudio
+{
+	static std::string ToUtf8(String^ s)
+	{
+		if (String::IsNullOrEmpty(s))
+		{
+			return std::string();
+		}
+		array<Byte>^ bytes = Text::Encoding::UTF8->GetBytes(s);
+		pin_ptr<Byte> pBytes = &bytes[0];
+		return std::string((const char*)pBytes, bytes->Length);
+	}
+
+	static void CopyFloats(array<float>^ source, int count, std::vector<float>& target)
+	{
+		if (source == nullptr || count <= 0 || source->Length < count)
+		{
+			return;
+		}
+		pin_ptr<float> pSource = &source[0];
+		target.assign((const float*)pSource, (const float*)pSource + count);
+	}
+
+	static void CopyColour(Color colour, float* target)
+	{
+		target[0] = colour.R;
+		target[1] = colour.G;
+		target[2] = colour.B;
+		target[3] = colour.A;
+	}
+
+	void CopyKeys(List<ImportedKeyframe<Vector3>^>^ keys, SceneCurve& curve)
+	{
+		curve.Times.reserve(curve.Times.size() + keys->Count);
+		curve.Values.reserve(curve.Values.size() + keys->Count * 3);
+		for each (ImportedKeyframe<Vector3>^ key in keys)
+		{
+			curve.Times.push_back(key->time);
+			curve.Values.push_back(key->value.X);
+			curve.Values.push_back(key->value.Y);
+			curve.Values.push_back(key->value.Z);
+		}
+	}
+
+	void CollectSceneStatistics(const Scene& scene, ExportStatistics^ statistics)
+	{
+		statistics->Nodes = (int)scene.Frames.size();
+		for (size_t i = 0; i < scene.Meshes.size(); i++)
+		{
+			const std::vector<SceneSubmesh>& submeshes = scene.Meshes[i].Submeshes;
+			statistics->Meshes += (int)submeshes.size();
+			for (size_t j = 0; j < submeshes.size(); j++)
+			{
+				statistics->ControlPoints += submeshes[j].VertexCount;
+			}
+		}
+		for (size_t i = 0; i < scene.Morphs.size(); i++)
+		{
+			for (size_t j = 0; j < scene.Morphs[i].Channels.size(); j++)
+			{
+				statistics->Shapes += (int)scene.Morphs[i].Channels[j].Shapes.size();
+			}
+		}
+		for (size_t i = 0; i < scene.Clips.size(); i++)
+		{
+			const std::vector<SceneTrack>& tracks = scene.Clips[i].Tracks;
+			for (size_t j = 0; j < tracks.size(); j++)
+			{
+				const SceneCurve* curves[3] = { &tracks[j].Scalings, &tracks[j].Rotations, &tracks[j].Translations };
+				for (int c = 0; c < 3; c++)
+				{
+					if (!curves[c]->Times.empty())
+					{
+						statistics->Curves += 3;
+						statistics->Keys += (Int64)curves[c]->Times.size() * 3;
+					}
+				}
+			}
+		}
+	}
+
+	SceneBuilder::SceneBuilder(IImported^ imported, Scene* scene, TextureWriter^ textureWriter, String^ exportDir, MemoryBudget^ budget)
+	{
+		this->imported = imported;
+		this->scene = scene;
+		this->textureWriter = textureWriter;
+		this->exportDir = exportDir;
+		this->budget = budget;
+
+		sceneIndex = gcnew SceneIndex(imported);
+		framePaths = gcnew List<String^>();
+		frameNames = gcnew List<String^>();
+		frameChildren = gcnew List<List<int>^>();
+		nodePathIndex = gcnew Dictionary<String^, int>();
+		nodeNameIndex = gcnew Dictionary<String^, int>();
+		meshIndex = gcnew Dictionary<String^, int>();
+		meshFrames = gcnew List<KeyValuePair<int, ImportedMesh^>>();
+		spilledMeshes = 0;
+		materialIndex = gcnew Dictionary<String^, int>();
+		textureIndex = gcnew Dictionary<String^, int>();
+		textureContentIndex = gcnew Dictionary<UInt64, int>();
+		textureSources = gcnew List<ImportedTexture^>();
+		textureDigests = gcnew Dictionary<int, array<Byte>^>();
+		importedMaterials = gcnew Dictionary<String^, ImportedMaterial^>();
+		importedTextures = gcnew Dictionary<String^, ImportedTexture^>();
+		pFilteringTracks = NULL;
+		pFilteringRests = NULL;
+		pTrackFilter = NULL;
+	}
+
+	void SceneBuilder::Build(bool allFrames, bool allBones, bool skins, float boneSize, float scaleFactor, bool flatInbetween, const TrackFilter& filter)
+	{
+		scene->ScaleFactor = scaleFactor;
+		scene->BoneSize = boneSize;
+
+		HashSet<String^>^ exportFrames = nullptr;
+		if (!allFrames)
+		{
+			exportFrames = sceneIndex->SearchHierarchy();
+			if (!exportFrames)
+			{
+				return;
+			}
+		}
+
+		BuildFrame(imported->RootFrame, -1, exportFrames);
+
+		for (size_t i = 0; i <= scene->Frames.size(); i++)
+		{
+			frameChildren->Add(gcnew List<int>());
+		}
+		for (size_t i = 0; i < scene->Frames.size(); i++)
+		{
+			frameChildren[scene->Frames[i].Parent + 1]->Add((int)i);
+		}
+		IndexNames(0);
+
+		if (imported->MeshList != nullptr)
+		{
+			if (skins)
+			{
+				for (size_t i = 0; i < scene->Frames.size(); i++)
+				{
+					scene->Frames[i].Attribute = allBones || sceneIndex->BonePaths->Contains(framePaths[(int)i]) ? FrameJoint : FrameNull;
+				}
+			}
+
+			for each (ImportedMaterial^ mat in imported->MaterialList)
+			{
+				if (mat->Name != nullptr && !importedMaterials->ContainsKey(mat->Name))
+				{
+					importedMaterials->Add(mat->Name, mat);
+				}
+			}
+			for each (ImportedTexture^ tex in imported->TextureList)
+			{
+				if (tex->Name != nullptr && !importedTextures->ContainsKey(tex->Name))
+				{
+					importedTextures->Add(tex->Name, tex);
+				}
+			}
+
+			//frames sharing a path share the imported mesh, under a budget its source arrays are released after its last use
+			//so the copy in the scene replaces them instead of adding to them
+			Dictionary<ImportedMesh^, int>^ meshUses = gcnew Dictionary<ImportedMesh^, int>();
+			for each (KeyValuePair<int, ImportedMesh^> meshFrame in meshFrames)
+			{
+				int uses;
+				meshUses->TryGetValue(meshFrame.Value, uses);
+				meshUses[meshFrame.Value] = uses + 1;
+			}
+
+			for each (KeyValuePair<int, ImportedMesh^> meshFrame in meshFrames)
+			{
+				BuildMesh(meshFrame.Key, meshFrame.Value, skins);
+				int uses = meshUses[meshFrame.Value] - 1;
+				meshUses[meshFrame.Value] = uses;
+				if (uses == 0 && budget->Enabled)
+				{
+					for each (ImportedSubmesh^ submesh in meshFrame.Value->SubmeshList)
+					{
+						budget->Release(submesh);
+					}
+				}
+				if (budget->Enabled && budget->OverBudget())
+				{
+					SpillMeshes();
+				}
+			}
+			BuildMorphs(flatInbetween);
+			if (imported->MorphList != nullptr && budget->Enabled)
+			{
+				for each (ImportedMorph^ morph in imported->MorphList)
+				{
+					budget->Release(morph);
+				}
+				budget->OverBudget();
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < scene->Frames.size(); i++)
+			{
+				scene->Frames[i].Attribute = FrameJoint;
+			}
+		}
+
+		BuildAnimations(filter);
+	}
+
+	void SceneBuilder::BuildFrame(ImportedFrame^ frame, int parent, HashSet<String^>^ exportFrames)
+	{
+		if (exportFrames != nullptr && !exportFrames->Contains(frame->Name))
+		{
+			return;
+		}
+
+		int index = (int)scene->Frames.size();
+		SceneFrame sceneFrame;
+		sceneFrame.Name = ToUtf8(frame->Name);
+		sceneFrame.Parent = parent;
+		sceneFrame.Attribute = FrameNone;
+		sceneFrame.LocalPosition[0] = frame->LocalPosition.X;
+		sceneFrame.LocalPosition[1] = frame->LocalPosition.Y;
+		sceneFrame.LocalPosition[2] = frame->LocalPosition.Z;
+		sceneFrame.LocalRotation[0] = frame->LocalRotation.X;
+		sceneFrame.LocalRotation[1] = frame->LocalRotation.Y;
+		sceneFrame.LocalRotation[2] = frame->LocalRotation.Z;
+		sceneFrame.LocalScale[0] = frame->LocalScale.X;
+		sceneFrame.LocalScale[1] = frame->LocalScale.Y;
+		sceneFrame.LocalScale[2] = frame->LocalScale.Z;
+		scene->Frames.push_back(sceneFrame);
+
+		String^ framePath = sceneIndex->FramePaths[frame];
+		framePaths->Add(framePath);
+		frameNames->Add(frame->Name);
+		//same first-match rule as the SDK path, see Exporter::ExportFrame
+		int indexedParent;
+		bool parentIndexed = parent < 0 || (nodePathIndex->TryGetValue(framePaths[parent], indexedParent) && indexedParent == parent);
+		if (parentIndexed && !nodePathIndex->ContainsKey(framePath))
+		{
+			nodePathIndex->Add(framePath, index);
+		}
+
+		ImportedMesh^ mesh;
+		if (sceneIndex->FrameMeshes->TryGetValue(frame, mesh))
+		{
+			meshFrames->Add(KeyValuePair<int, ImportedMesh^>(index, mesh));
+		}
+
+		for (int i = 0; i < frame->Count; i++)
+		{
+			BuildFrame(frame[i], index, exportFrames);
+		}
+	}
+
+	void SceneBuilder::IndexNames(int node)
+	{
+		//FbxNode::FindChild order, children before grandchildren
+		List<int>^ nodeChildren = frameChildren[node];
+		for (int i = 0; i < nodeChildren->Count; i++)
+		{
+			String^ childName = frameNames[nodeChildren[i]];
+			if (!nodeNameIndex->ContainsKey(childName))
+			{
+				nodeNameIndex->Add(childName, nodeChildren[i]);
+			}
+		}
+		for (int i = 0; i < nodeChildren->Count; i++)
+		{
+			IndexNames(nodeChildren[i] + 1);
+		}
+	}
+
+	//Same lookup as Exporter::FindNodeByPath
+	int SceneBuilder::FindFrame(String^ path, bool recursive)
+	{
+		int index;
+		if (!recursive)
+		{
+			return nodePathIndex->TryGetValue(path, index) ? index : -1;
+		}
+
+		int slash = path->IndexOf('/');
+		String^ firstName = slash < 0 ? path : path->Substring(0, slash);
+		if (!nodeNameIndex->TryGetValue(firstName, index))
+		{
+			return -1;
+		}
+		if (slash < 0)
+		{
+			return index;
+		}
+		int indexedFrame;
+		if (nodePathIndex->TryGetValue(framePaths[index], indexedFrame) && indexedFrame == index)
+		{
+			int found;
+			return nodePathIndex->TryGetValue(framePaths[index] + path->Substring(slash), found) ? found : -1;
+		}
+		//the first match is shadowed by an earlier sibling with the same path, walk its children instead
+		return FindChildFrame(index, path->Split('/'), 1);
+	}
+
+	//Exporter::FindChildByPath over the scene frames, following the first child with each name
+	int SceneBuilder::FindChildFrame(int frame, array<String^>^ splitPath, int start)
+	{
+		for (int i = start; i < splitPath->Length && frame >= 0; i++)
+		{
+			List<int>^ children = frameChildren[frame + 1];
+			int next = -1;
+			for (int j = 0; j < children->Count && next < 0; j++)
+			{
+				if (String::Equals(frameNames[children[j]], splitPath[i]))
+				{
+					next = children[j];
+				}
+			}
+			frame = next;
+		}
+		return frame;
+	}
+
+	void SceneBuilder::BuildMesh(int frame, ImportedMesh^ importedMesh, bool skins)
+	{
+		if (!meshIndex->ContainsKey(importedMesh->Path))
+		{
+			meshIndex->Add(importedMesh->Path, (int)scene->Meshes.size());
+		}
+		scene->Meshes.push_back(SceneMesh());
+		SceneMesh& mesh = scene->Meshes.back();
+		mesh.Frame = frame;
+
+		List<ImportedBone^>^ boneList = importedMesh->BoneList;
+		if (skins && boneList != nullptr)
+		{
+			for each (ImportedBone^ bone in boneList)
+			{
+				SceneBone sceneBone;
+				sceneBone.Frame = FindFrame(bone->Path, false);
+				Matrix4x4 boneMatrix = bone->Matrix;
+				for (int m = 0; m < 4; m++)
+				{
+					for (int n = 0; n < 4; n++)
+					{
+						sceneBone.Matrix[m * 4 + n] = boneMatrix[m, n];
+					}
+				}
+				mesh.Bones.push_back(sceneBone);
+			}
+		}
+
+		for each (ImportedSubmesh^ importedSubmesh in importedMesh->SubmeshList)
+		{
+			mesh.Submeshes.push_back(SceneSubmesh());
+			SceneSubmesh& submesh = mesh.Submeshes.back();
+			bool packed = importedSubmesh->Positions != nullptr && importedSubmesh->Positions->Length > 0;
+			//VertexList of a packed submesh would be built from the streams, it is only read for a skin without packed influences
+			List<ImportedVertex^>^ vertexList = packed ? nullptr : importedSubmesh->VertexList;
+			int vertexCount = packed ? importedSubmesh->Positions->Length / 3 : vertexList->Count;
+			submesh.VertexCount = vertexCount;
+
+			if (packed)
+			{
+				CopyFloats(importedSubmesh->Positions, vertexCount * 3, submesh.Positions);
+				CopyFloats(importedSubmesh->Normals, vertexCount * 3, submesh.Normals);
+				CopyFloats(importedSubmesh->UV0, vertexCount * 2, submesh.UV0);
+				CopyFloats(importedSubmesh->Tangents, vertexCount * 4, submesh.Tangents);
+				CopyFloats(importedSubmesh->Colours, vertexCount * 4, submesh.Colours);
+			}
+			else
+			{
+				bool hasUV = vertexCount > 0 && vertexList[0]->UV != nullptr;
+				bool vertexColours = vertexCount > 0 && dynamic_cast<ImportedVertexWithColour^>(vertexList[0]) != nullptr;
+				submesh.Positions.resize(vertexCount * 3);
+				submesh.Normals.resize(vertexCount * 3);
+				submesh.Tangents.resize(vertexCount * 4);
+				submesh.UV0.resize(hasUV ? vertexCount * 2 : 0);
+				submesh.Colours.resize(vertexColours ? vertexCount * 4 : 0);
+				for (int j = 0; j < vertexCount; j++)
+				{
+					ImportedVertex^ vertex = vertexList[j];
+					submesh.Positions[j * 3] = vertex->Position.X;
+					submesh.Positions[j * 3 + 1] = vertex->Position.Y;
+					submesh.Positions[j * 3 + 2] = vertex->Position.Z;
+					submesh.Normals[j * 3] = vertex->Normal.X;
+					submesh.Normals[j * 3 + 1] = vertex->Normal.Y;
+					submesh.Normals[j * 3 + 2] = vertex->Normal.Z;
+					submesh.Tangents[j * 4] = vertex->Tangent.X;
+					submesh.Tangents[j * 4 + 1] = vertex->Tangent.Y;
+					submesh.Tangents[j * 4 + 2] = vertex->Tangent.Z;
+					submesh.Tangents[j * 4 + 3] = vertex->Tangent.W;
+					if (hasUV && vertex->UV != nullptr)
+					{
+						submesh.UV0[j * 2] = vertex->UV[0];
+						submesh.UV0[j * 2 + 1] = vertex->UV[1];
+					}
+					if (vertexColours)
+					{
+						ImportedVertexWithColour^ vert = (ImportedVertexWithColour^)vertex;
+						submesh.Colours[j * 4] = vert->Colour.R;
+						submesh.Colours[j * 4 + 1] = vert->Colour.G;
+						submesh.Colours[j * 4 + 2] = vert->Colour.B;
+						submesh.Colours[j * 4 + 3] = vert->Colour.A;
+					}
+				}
+			}
+
+			array<int>^ packedBones = packed ? importedSubmesh->BoneIndices : nullptr;
+			array<float>^ packedWeights = packed ? importedSubmesh->Weights : nullptr;
+			bool packedSkin = vertexCount > 0 && packedBones != nullptr && packedWeights != nullptr && packedBones->Length >= vertexCount * 4 && packedWeights->Length >= vertexCount * 4;
+			if (!mesh.Bones.empty() && !packedSkin && vertexList == nullptr)
+			{
+				vertexList = importedSubmesh->VertexList;
+			}
+			if (!mesh.Bones.empty() && packedSkin)
+			{
+				pin_ptr<int> pBones = &packedBones[0];
+				submesh.BoneIndices.assign((const int*)pBones, (const int*)pBones + vertexCount * 4);
+				CopyFloats(packedWeights, vertexCount * 4, submesh.Weights);
+			}
+			else if (!mesh.Bones.empty() && vertexList != nullptr)
+			{
+				submesh.BoneIndices.assign(vertexCount * 4, -1);
+				submesh.Weights.assign(vertexCount * 4, 0.0f);
+				for (int j = 0; j < vertexList->Count && j < vertexCount; j++)
+				{
+					ImportedVertex^ vertex = vertexList[j];
+					if (vertex->BoneIndices != nullptr)
+					{
+						auto boneIndices = vertex->BoneIndices;
+						auto weights4 = vertex->Weights;
+						for (int k = 0; k < weights4->Length && k < 4; k++)
+						{
+							submesh.BoneIndices[j * 4 + k] = boneIndices[k];
+							submesh.Weights[j * 4 + k] = weights4[k];
+						}
+					}
+				}
+			}
+
+			array<int>^ indices = importedSubmesh->Indices;
+			if (indices == nullptr && importedSubmesh->FaceList != nullptr)
+			{
+				List<ImportedFace^>^ faceList = importedSubmesh->FaceList;
+				indices = gcnew array<int>(faceList->Count * 3);
+				for (int j = 0; j < faceList->Count; j++)
+				{
+					array<int>^ vertexIndices = faceList[j]->VertexIndices;
+					indices[j * 3] = vertexIndices[0];
+					indices[j * 3 + 1] = vertexIndices[1];
+					indices[j * 3 + 2] = vertexIndices[2];
+				}
+			}
+			if (indices != nullptr)
+			{
+				//triangles referencing a missing vertex would make the file unreadable, drop them
+				unsigned int count = (unsigned int)vertexCount;
+				int dropped = 0;
+				submesh.Indices.reserve(indices->Length);
+				for (int j = 0; j + 2 < indices->Length; j += 3)
+				{
+					if ((unsigned int)indices[j] < count && (unsigned int)indices[j + 1] < count && (unsigned int)indices[j + 2] < count)
+					{
+						submesh.Indices.push_back(indices[j]);
+						submesh.Indices.push_back(indices[j + 1]);
+						submesh.Indices.push_back(indices[j + 2]);
+					}
+					else
+					{
+						dropped++;
+					}
+				}
+				if (dropped > 0)
+				{
+					Logger::Warning(String::Format("{0}: dropped {1} triangles with out of range vertex indices", importedMesh->Path, dropped));
+				}
+			}
+
+			submesh.Material = BuildMaterial(importedSubmesh->Material);
+		}
+	}
+
+	void SceneBuilder::SpillMeshes()
+	{
+		if (scene->Spill == NULL)
+		{
+			char* pSpillPath = Fbx::StringToCharArray(Path::GetTempFileName());
+			try
+			{
+				scene->Spill = new SceneSpill(pSpillPath);
+			}
+			finally
+			{
+				Marshal::FreeHGlobal((IntPtr)pSpillPath);
+			}
+		}
+		//everything built so far is finished, only the writer and morphs read it again
+		for (; spilledMeshes < scene->Meshes.size(); spilledMeshes++)
+		{
+			std::vector<SceneSubmesh>& submeshes = scene->Meshes[spilledMeshes].Submeshes;
+			for (size_t i = 0; i < submeshes.size(); i++)
+			{
+				scene->Spill->Store(submeshes[i]);
+			}
+		}
+	}
+
+	int SceneBuilder::BuildMaterial(String^ name)
+	{
+		ImportedMaterial^ mat;
+		if (name == nullptr || !importedMaterials->TryGetValue(name, mat))
+		{
+			return -1;
+		}
+		int index;
+		if (materialIndex->TryGetValue(name, index))
+		{
+			return index;
+		}
+
+		SceneMaterial material;
+		material.Name = ToUtf8(mat->Name);
+		CopyColour(mat->Diffuse, material.Diffuse);
+		CopyColour(mat->Ambient, material.Ambient);
+		CopyColour(mat->Emissive, material.Emissive);
+		CopyColour(mat->Specular, material.Specular);
+		CopyColour(mat->Reflection, material.Reflection);
+		material.Shininess = mat->Shininess;
+		material.Transparency = mat->Transparency;
+
+		for each (ImportedMaterialTexture^ texture in mat->Textures)
+		{
+			int textureIdx = BuildTexture(texture->Name);
+			if (textureIdx >= 0)
+			{
+				SceneMaterialTexture link;
+				link.Texture = textureIdx;
+				link.Dest = texture->Dest;
+				link.Offset[0] = texture->Offset.X;
+				link.Offset[1] = texture->Offset.Y;
+				link.Scale[0] = texture->Scale.X;
+				link.Scale[1] = texture->Scale.Y;
+				material.Textures.push_back(link);
+			}
+		}
+
+		index = (int)scene->Materials.size();
+		scene->Materials.push_back(material);
+		materialIndex->Add(name, index);
+		return index;
+	}
+
+	int SceneBuilder::BuildTexture(String^ name)
+	{
+		ImportedTexture^ matTex;
+		if (String::IsNullOrEmpty(name) || !importedTextures->TryGetValue(name, matTex))
+		{
+			return -1;
+		}
+		int index;
+		if (textureIndex->TryGetValue(name, index))
+		{
+			return index;
+		}
+
+		//identical images under different names share one texture and one file, as in Exporter::ExportTexture
+		array<Byte>^ data = matTex->Data;
+		UInt64 contentHash = 0;
+		if (data != nullptr && data->Length > 0)
+		{
+			pin_ptr<Byte> pData = &data[0];
+			contentHash = HashBytes(pData, data->Length) ^ (UInt64)data->Length;
+			if (textureContentIndex->TryGetValue(contentHash, index))
+			{
+				array<Byte>^ foundData = textureSources[index]->Data;
+				bool same;
+				if (foundData == nullptr)
+				{
+					//released under a memory budget, the digest taken before the release decides
+					array<Byte>^ digest;
+					same = textureDigests->TryGetValue(index, digest) && SameDigest(digest, TextureDigest(data));
+				}
+				else
+				{
+					pin_ptr<Byte> pFoundData = &foundData[0];
+					same = foundData->Length == data->Length && memcmp(pData, pFoundData, data->Length) == 0;
+				}
+				if (same)
+				{
+					textureIndex->Add(name, index);
+					return index;
+				}
+			}
+		}
+
+		FileInfo^ file = gcnew FileInfo(Path::Combine(exportDir, Path::GetFileName(matTex->Name)));
+		SceneTexture texture;
+		texture.Name = ToUtf8(matTex->Name);
+		texture.FileName = ToUtf8(file->FullName);
+		texture.RelativeFileName = ToUtf8(file->Name);
+
+		index = (int)scene->Textures.size();
+		scene->Textures.push_back(texture);
+		textureSources->Add(matTex);
+		textureIndex->Add(name, index);
+		bool contentIndexed = data != nullptr && data->Length > 0 && !textureContentIndex->ContainsKey(contentHash);
+		if (contentIndexed)
+		{
+			textureContentIndex->Add(contentHash, index);
+		}
+
+		textureWriter->Enqueue(file->FullName, matTex->Data);
+		if (budget->Enabled)
+		{
+			if (contentIndexed)
+			{
+				textureDigests->Add(index, TextureDigest(data));
+			}
+			budget->Release(matTex);
+		}
+		return index;
+	}
+
+	void SceneBuilder::BuildMorphs(bool flatInbetween)
+	{
+		if (imported->MorphList == nullptr)
+		{
+			return;
+		}
+
+		std::vector<int> slots;
+		for each (ImportedMesh^ meshList in imported->MeshList)
+		{
+			int meshIdx;
+			if (meshList->Path == nullptr || !meshIndex->TryGetValue(meshList->Path, meshIdx))
+			{
+				continue;
+			}
+
+			for each (ImportedMorph^ morph in imported->MorphList)
+			{
+				if (morph->Path != meshList->Path)
+				{
+					continue;
+				}
+
+				List<ImportedMorphKeyframe^>^ keyframes = morph->KeyframeList;
+				int submeshCount = (int)scene->Meshes[meshIdx].Submeshes.size();
+				int meshVertexIndex = 0;
+				for (int submeshIdx = 0; submeshIdx < submeshCount; submeshIdx++)
+				{
+					SceneSubmesh loaded;
+					const SceneSubmesh& submesh = ResidentSubmesh(*scene, scene->Meshes[meshIdx].Submeshes[submeshIdx], loaded);
+					int vertexCount = submesh.VertexCount;
+					slots.assign(vertexCount, -1);
+
+					String^ blendShapeName = morph->ClipName + (submeshCount > 1 ? String::Concat("_", submeshIdx) : String::Empty);
+					SceneMorph sceneMorph;
+					sceneMorph.Mesh = meshIdx;
+					sceneMorph.Submesh = submeshIdx;
+					sceneMorph.Name = ToUtf8(blendShapeName);
+					sceneMorph.WeightProperties = flatInbetween;
+
+					for (int i = 0; i < morph->Channels->Count; i++)
+					{
+						Tuple<float, int, int>^ channel = morph->Channels[i];
+						if (!flatInbetween)
+						{
+							String^ keyframeName = keyframes[channel->Item2]->Name;
+							int underscore = keyframeName->LastIndexOf("_");
+							SceneBlendChannel sceneChannel;
+							sceneChannel.Name = ToUtf8(blendShapeName + "." + (underscore < 0 ? keyframeName : keyframeName->Substring(0, underscore)));
+							sceneChannel.DeformPercent = channel->Item1;
+							sceneMorph.Channels.push_back(sceneChannel);
+						}
+
+						for (int frameIdx = 0; frameIdx < channel->Item3; frameIdx++)
+						{
+							ImportedMorphKeyframe^ keyframe = keyframes[channel->Item2 + frameIdx];
+							if (flatInbetween)
+							{
+								SceneBlendChannel sceneChannel;
+								sceneChannel.DeformPercent = channel->Item1;
+								sceneMorph.Channels.push_back(sceneChannel);
+							}
+
+							SceneShape shape;
+							shape.Name = ToUtf8(flatInbetween ? blendShapeName + "." + keyframe->Name : keyframe->Name);
+							shape.Weight = keyframe->Weight;
+							AddShapeDeltas(keyframe, submesh, meshVertexIndex, 1, slots, shape);
+							if (flatInbetween && frameIdx > 0)
+							{
+								AddShapeDeltas(keyframes[channel->Item2 + frameIdx - 1], submesh, meshVertexIndex, -1, slots, shape);
+							}
+							for (size_t k = 0; k < shape.Indices.size(); k++)
+							{
+								slots[shape.Indices[k]] = -1;
+							}
+							sceneMorph.Channels.back().Shapes.push_back(shape);
+						}
+					}
+
+					scene->Morphs.push_back(sceneMorph);
+					meshVertexIndex += vertexCount;
+				}
+			}
+		}
+	}
+
+	void SceneBuilder::AddShapeDeltas(ImportedMorphKeyframe^ keyframe, const SceneSubmesh& submesh, int meshVertexIndex, float sign, std::vector<int>& slots, SceneShape& shape)
+	{
+		List<int>^ meshIndices = keyframe->MorphedVertexIndices;
+		for (int j = 0; j < meshIndices->Count; j++)
+		{
+			int controlPointIndex = meshIndices[j] - meshVertexIndex;
+			if (controlPointIndex < 0 || controlPointIndex >= submesh.VertexCount)
+			{
+				continue;
+			}
+
+			int slot = slots[controlPointIndex];
+			if (slot < 0)
+			{
+				slot = (int)shape.Indices.size();
+				slots[controlPointIndex] = slot;
+				shape.Indices.push_back(controlPointIndex);
+				shape.Deltas.resize(shape.Deltas.size() + 3, 0.0f);
+			}
+			Vector3 coords = keyframe->VertexList[j]->Position;
+			const float* base = &submesh.Positions[controlPointIndex * 3];
+			shape.Deltas[slot * 3] += sign * (coords.X - base[0]);
+			shape.Deltas[slot * 3 + 1] += sign * (coords.Y - base[1]);
+			shape.Deltas[slot * 3 + 2] += sign * (coords.Z - base[2]);
+		}
+	}
+
+	void SceneBuilder::FilterAnimationTrack(int i)
+	{
+		FilterTrack(pFilteringTracks[i], *pTrackFilter, &pFilteringRests[i * 9]);
+	}
+
+	void SceneBuilder::BuildAnimations(const TrackFilter& filter)
+	{
+		auto importedAnimationList = imported->AnimationList;
+		if (importedAnimationList == nullptr)
+		{
+			return;
+		}
+
+		for (int i = 0; i < importedAnimationList->Count; i++)
+		{
+			auto importedAnimation = importedAnimationList[i];
+			scene->Clips.push_back(SceneClip());
+			SceneClip& clip = scene->Clips.back();
+			String^ clipName = importedAnimation->Name ? importedAnimation->Name : String::Concat("Take", i);
+			clip.Name = ToUtf8(clipName);
+
+			//tracks resolving to the same node add keys to the same curves, like Exporter::ExportKeyframedAnimation
+			Dictionary<int, int>^ trackIndex = gcnew Dictionary<int, int>();
+			for each (ImportedAnimationKeyframedTrack^ keyframeList in importedAnimation->TrackList)
+			{
+				int frame = FindFrame(keyframeList->Path, true);
+				if (frame < 0)
+				{
+					continue;
+				}
+				int trackIdx;
+				if (!trackIndex->TryGetValue(frame, trackIdx))
+				{
+					trackIdx = (int)clip.Tracks.size();
+					trackIndex->Add(frame, trackIdx);
+					clip.Tracks.push_back(SceneTrack());
+					clip.Tracks.back().Frame = frame;
+				}
+				SceneTrack& track = clip.Tracks[trackIdx];
+				CopyKeys(keyframeList->Scalings, track.Scalings);
+				CopyKeys(keyframeList->Rotations, track.Rotations);
+				CopyKeys(keyframeList->Translations, track.Translations);
+			}
+
+			//filter after merging, so tracks sharing a node are unrolled and reduced as one curve
+			bool reduce = filter.Reduction.Position > 0 || filter.Reduction.Rotation > 0 || filter.Reduction.Scale > 0;
+			if ((filter.EulerFilter || reduce) && !clip.Tracks.empty())
+			{
+				size_t keysBefore = 0;
+				size_t keysAfter = 0;
+				std::vector<float> rests(clip.Tracks.size() * 9);
+				for (size_t j = 0; j < clip.Tracks.size(); j++)
+				{
+					const SceneTrack& track = clip.Tracks[j];
+					const SceneFrame& frame = scene->Frames[track.Frame];
+					std::copy(frame.LocalScale, frame.LocalScale + 3, &rests[j * 9]);
+					std::copy(frame.LocalRotation, frame.LocalRotation + 3, &rests[j * 9 + 3]);
+					std::copy(frame.LocalPosition, frame.LocalPosition + 3, &rests[j * 9 + 6]);
+					keysBefore += track.Scalings.Times.size() + track.Rotations.Times.size() + track.Translations.Times.size();
+				}
+
+				pFilteringTracks = clip.Tracks.data();
+				pFilteringRests = rests.data();
+				pTrackFilter = &filter;
+				try
+				{
+					Parallel::For(0, (int)clip.Tracks.size(), gcnew Action<int>(this, &SceneBuilder::FilterAnimationTrack));
+				}
+				finally
+				{
+					pFilteringTracks = NULL;
+					pFilteringRests = NULL;
+					pTrackFilter = NULL;
+				}
+
+				if (reduce)
+				{
+					for (size_t j = 0; j < clip.Tracks.size(); j++)
+					{
+						const SceneTrack& track = clip.Tracks[j];
+						keysAfter += track.Scalings.Times.size() + track.Rotations.Times.size() + track.Translations.Times.size();
+					}
+					Logger::Debug(String::Format("{0}: {1} -> {2} keys ({3:P1})", clipName, (UInt64)keysBefore, (UInt64)keysAfter, keysBefore > 0 ? (double)keysAfter / keysBefore : 1.0));
+				}
+			}
+		}
+	}
+}
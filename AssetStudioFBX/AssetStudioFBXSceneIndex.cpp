@@ -0,0 +1,112 @@
+#include <fbxsdk.h>
+#include "AssetStudioFBX.h"
+
+namespace AssetStudio
+{
+	SceneIndex::SceneIndex(IImported^ imported)
+	{
+		this->imported = imported;
+		FramePaths = gcnew Dictionary<ImportedFrame^, String^>();
+		FramesByPath = gcnew Dictionary<String^, ImportedFrame^>();
+		MeshesByPath = gcnew Dictionary<String^, ImportedMesh^>();
+		FrameMeshes = gcnew Dictionary<ImportedFrame^, ImportedMesh^>();
+		BonePaths = gcnew HashSet<String^>();
+
+		if (imported->MeshList != nullptr)
+		{
+			for each (ImportedMesh^ mesh in imported->MeshList)
+			{
+				if (mesh->Path != nullptr && !MeshesByPath->ContainsKey(mesh->Path))
+				{
+					MeshesByPath->Add(mesh->Path, mesh);
+				}
+				if (mesh->BoneList != nullptr)
+				{
+					for each (ImportedBone^ bone in mesh->BoneList)
+					{
+						BonePaths->Add(bone->Path);
+					}
+				}
+			}
+		}
+
+		IndexFrame(imported->RootFrame, nullptr);
+	}
+
+	void SceneIndex::IndexFrame(ImportedFrame^ frame, String^ parentPath)
+	{
+		String^ framePath = parentPath == nullptr ? frame->Name : parentPath + "/" + frame->Name;
+		FramePaths->Add(frame, framePath);
+
+		//FindFrameByPath follows the first child with a matching name, so only index paths reachable along first matches
+		ImportedFrame^ indexedParent;
+		bool parentIndexed = parentPath == nullptr || (FramesByPath->TryGetValue(parentPath, indexedParent) && indexedParent == frame->Parent);
+		if (parentIndexed && !FramesByPath->ContainsKey(framePath))
+		{
+			FramesByPath->Add(framePath, frame);
+		}
+
+		ImportedMesh^ mesh;
+		if (MeshesByPath->TryGetValue(framePath, mesh))
+		{
+			FrameMeshes->Add(frame, mesh);
+		}
+
+		for (int i = 0; i < frame->Count; i++)
+		{
+			IndexFrame(frame[i], framePath);
+		}
+	}
+
+	HashSet<String^>^ SceneIndex::SearchHierarchy()
+	{
+		if (imported->MeshList == nullptr || imported->MeshList->Count == 0)
+		{
+			return nullptr;
+		}
+		HashSet<String^>^ exportFrames = gcnew HashSet<String^>();
+		SearchHierarchy(imported->RootFrame, exportFrames);
+		return exportFrames;
+	}
+
+	void SceneIndex::SearchHierarchy(ImportedFrame^ frame, HashSet<String^>^ exportFrames)
+	{
+		ImportedMesh^ meshListSome;
+		if (FrameMeshes->TryGetValue(frame, meshListSome))
+		{
+			ImportedFrame^ parent = frame;
+			while (parent != nullptr)
+			{
+				exportFrames->Add(parent->Name);
+				parent = parent->Parent;
+			}
+
+			List<ImportedBone^>^ boneList = meshListSome->BoneList;
+			if (boneList != nullptr)
+			{
+				for (int i = 0; i < boneList->Count; i++)
+				{
+					String^ boneName = boneList[i]->Path->Substring(boneList[i]->Path->LastIndexOf('/') + 1);
+					if (!exportFrames->Contains(boneName))
+					{
+						ImportedFrame^ boneParent;
+						if (!FramesByPath->TryGetValue(boneList[i]->Path, boneParent))
+						{
+							throw gcnew Exception("Couldn't find path " + boneList[i]->Path);
+						}
+						while (boneParent != nullptr)
+						{
+							exportFrames->Add(boneParent->Name);
+							boneParent = boneParent->Parent;
+						}
+					}
+				}
+			}
+		}
+
+		for (int i = 0; i < frame->Count; i++)
+		{
+			SearchHierarchy(frame[i], exportFrames);
+		}
+	}
+}
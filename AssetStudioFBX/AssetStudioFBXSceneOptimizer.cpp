@@ -0,0 +1,79 @@
+#include "AssetStudioFBXScene.h"
+#include "AssetStudioFBXMeshOptimizer.h"
+
+namespace AssetStudio
+{
+	//Widens one float attribute into doubles behind the ones already in data, the weld works on doubles
+	static void AddWeldStream(std::vector<WeldStream>& streams, std::vector<std::vector<double> >& data, const std::vector<float>& values, int components, int vertexCount)
+	{
+		if (vertexCount <= 0 || values.size() != (size_t)vertexCount * components)
+		{
+			return;
+		}
+		data.push_back(std::vector<double>(values.begin(), values.end()));
+		WeldStream stream = { data.back().data(), components, components };
+		streams.push_back(stream);
+	}
+
+	SceneOptimizeStats OptimizeSceneSubmesh(SceneSubmesh& submesh, double weldTolerance)
+	{
+		const int vertexCount = submesh.VertexCount;
+		SceneOptimizeStats stats = SceneOptimizeStats();
+		stats.Triangles = (long long)submesh.Indices.size() / 3;
+		stats.CacheMissesBefore = CountCacheMisses(submesh.Indices, vertexCount, AcmrCacheSize);
+		stats.CacheMissesAfter = stats.CacheMissesBefore;
+		if (submesh.Indices.empty())
+		{
+			return stats;
+		}
+
+		std::vector<int> remap;
+		int count = vertexCount;
+		if (weldTolerance >= 0)
+		{
+			std::vector<WeldStream> streams;
+			std::vector<std::vector<double> > data;
+			data.reserve(5);
+			std::vector<double> influences;
+			AddWeldStream(streams, data, submesh.Positions, 3, vertexCount);
+			AddWeldStream(streams, data, submesh.Normals, 3, vertexCount);
+			AddWeldStream(streams, data, submesh.UV0, 2, vertexCount);
+			AddWeldStream(streams, data, submesh.Tangents, 4, vertexCount);
+			AddWeldStream(streams, data, submesh.Colours, 4, vertexCount);
+			AddInfluenceStreams(streams, influences, submesh.BoneIndices, submesh.Weights, vertexCount, weldTolerance);
+			count = WeldVertices(streams, vertexCount, weldTolerance, remap);
+			for (size_t i = 0; i < submesh.Indices.size(); i++)
+			{
+				submesh.Indices[i] = remap[submesh.Indices[i]];
+			}
+		}
+
+		OptimizeVertexCache(submesh.Indices, count);
+		std::vector<int> fetch;
+		int used = OptimizeVertexFetch(submesh.Indices, count, fetch);
+		if (remap.empty())
+		{
+			remap.swap(fetch);
+		}
+		else
+		{
+			for (int i = 0; i < vertexCount; i++)
+			{
+				remap[i] = fetch[remap[i]];
+			}
+		}
+
+		RemapVertices(submesh.Positions, remap, used, 3);
+		RemapVertices(submesh.Normals, remap, used, 3);
+		RemapVertices(submesh.UV0, remap, used, 2);
+		RemapVertices(submesh.Tangents, remap, used, 4);
+		RemapVertices(submesh.Colours, remap, used, 4);
+		RemapVertices(submesh.BoneIndices, remap, used, 4);
+		RemapVertices(submesh.Weights, remap, used, 4);
+
+		submesh.VertexCount = used;
+		stats.WeldedVertices = vertexCount - used;
+		stats.CacheMissesAfter = CountCacheMisses(submesh.Indices, used, AcmrCacheSize);
+		return stats;
+	}
+}
@@ -0,0 +1,506 @@
+#include <string.h>
+#include <stdexcept>
+#include "AssetStudioFBXScene.h"
+#include "AssetStudioFBXSceneSpill.h"
+
+#ifdef _MSC_VER
+#define FBX_FSEEK _fseeki64
+#define FBX_FTELL _ftelli64
+#else
+#define FBX_FSEEK fseeko
+#define FBX_FTELL ftello
+#endif
+
+namespace AssetStudio
+{
+	static const char SnapshotMagic[8] = { 'A', 'S', 'S', 'N', 'A', 'P', 0, 0 };
+	static const unsigned int SnapshotVersion = 2;
+
+	//Values are written in the byte order of the machine, every target of this repo is little-endian
+	class SnapshotWriter
+	{
+	public:
+		explicit SnapshotWriter(const char* path)
+		{
+			file = fopen(path, "wb");
+			if (file == NULL)
+			{
+				throw std::runtime_error(std::string("Failed to open ") + path);
+			}
+			setvbuf(file, NULL, _IOFBF, 1 << 20);
+		}
+
+		~SnapshotWriter()
+		{
+			if (file != NULL)
+			{
+				fclose(file);
+			}
+		}
+
+		void Raw(const void* data, size_t length)
+		{
+			if (length > 0 && fwrite(data, 1, length, file) != length)
+			{
+				throw std::runtime_error("Failed to write snapshot");
+			}
+		}
+
+		template <typename T> void Value(T value)
+		{
+			Raw(&value, sizeof(T));
+		}
+
+		void Count(size_t count)
+		{
+			Value((unsigned long long)count);
+		}
+
+		void String(const std::string& value)
+		{
+			Count(value.size());
+			Raw(value.data(), value.size());
+		}
+
+		template <typename T> void Array(const std::vector<T>& values)
+		{
+			Count(values.size());
+			Raw(values.data(), values.size() * sizeof(T));
+		}
+
+		void Close()
+		{
+			int result = fclose(file);
+			file = NULL;
+			if (result != 0)
+			{
+				throw std::runtime_error("Failed to write snapshot");
+			}
+		}
+
+	private:
+		FILE* file;
+
+		SnapshotWriter(const SnapshotWriter&);
+		SnapshotWriter& operator=(const SnapshotWriter&);
+	};
+
+	//Every count is checked against the bytes left in the file, so a truncated or damaged snapshot fails instead of allocating garbage sizes
+	class SnapshotReader
+	{
+	public:
+		explicit SnapshotReader(const char* path)
+		{
+			file = fopen(path, "rb");
+			if (file == NULL)
+			{
+				throw std::runtime_error(std::string("Failed to open ") + path);
+			}
+			setvbuf(file, NULL, _IOFBF, 1 << 20);
+			FBX_FSEEK(file, 0, SEEK_END);
+			remaining = (unsigned long long)FBX_FTELL(file);
+			FBX_FSEEK(file, 0, SEEK_SET);
+		}
+
+		~SnapshotReader()
+		{
+			fclose(file);
+		}
+
+		void Raw(void* data, size_t length)
+		{
+			if (length > remaining || (length > 0 && fread(data, 1, length, file) != length))
+			{
+				throw std::runtime_error("Snapshot is truncated");
+			}
+			remaining -= length;
+		}
+
+		template <typename T> T Value()
+		{
+			T value;
+			Raw(&value, sizeof(T));
+			return value;
+		}
+
+		size_t Count(size_t elementSize)
+		{
+			unsigned long long count = Value<unsigned long long>();
+			if (count > remaining / (elementSize > 0 ? elementSize : 1))
+			{
+				throw std::runtime_error("Snapshot is truncated");
+			}
+			return (size_t)count;
+		}
+
+		std::string String()
+		{
+			std::string value(Count(1), '\0');
+			if (!value.empty())
+			{
+				Raw(&value[0], value.size());
+			}
+			return value;
+		}
+
+		template <typename T> void Array(std::vector<T>& values)
+		{
+			values.resize(Count(sizeof(T)));
+			Raw(values.data(), values.size() * sizeof(T));
+		}
+
+		bool AtEnd() const { return remaining == 0; }
+
+	private:
+		FILE* file;
+		unsigned long long remaining;
+
+		SnapshotReader(const SnapshotReader&);
+		SnapshotReader& operator=(const SnapshotReader&);
+	};
+
+	static void WriteCurve(SnapshotWriter& writer, const SceneCurve& curve)
+	{
+		writer.Array(curve.Times);
+		writer.Array(curve.Values);
+		writer.Value(curve.Linear);
+	}
+
+	static void ReadCurve(SnapshotReader& reader, SceneCurve& curve)
+	{
+		reader.Array(curve.Times);
+		reader.Array(curve.Values);
+		curve.Linear = reader.Value<bool>();
+	}
+
+	static void CheckIndex(int index, size_t count, bool optional, const char* what)
+	{
+		if (index >= (int)count || index < (optional ? -1 : 0))
+		{
+			throw std::runtime_error(std::string("Snapshot has an invalid ") + what + " index");
+		}
+	}
+
+	//The writers index with these without checking, a damaged snapshot must not get that far
+	static void ValidateScene(const Scene& scene)
+	{
+		for (size_t i = 0; i < scene.Meshes.size(); i++)
+		{
+			const SceneMesh& mesh = scene.Meshes[i];
+			CheckIndex(mesh.Frame, scene.Frames.size(), false, "frame");
+			for (size_t j = 0; j < mesh.Bones.size(); j++)
+			{
+				CheckIndex(mesh.Bones[j].Frame, scene.Frames.size(), false, "bone frame");
+			}
+			for (size_t j = 0; j < mesh.Submeshes.size(); j++)
+			{
+				const SceneSubmesh& submesh = mesh.Submeshes[j];
+				size_t vertexCount = submesh.VertexCount > 0 ? (size_t)submesh.VertexCount : 0;
+				CheckIndex(submesh.Material, scene.Materials.size(), true, "material");
+				if (submesh.Positions.size() != vertexCount * 3 || submesh.Indices.size() % 3 != 0 ||
+					(!submesh.BoneIndices.empty() && (submesh.BoneIndices.size() != vertexCount * 4 || submesh.Weights.size() != vertexCount * 4)))
+				{
+					throw std::runtime_error("Snapshot submesh arrays do not match its vertex count");
+				}
+				for (size_t k = 0; k < submesh.Indices.size(); k++)
+				{
+					CheckIndex(submesh.Indices[k], vertexCount, false, "vertex");
+				}
+				for (size_t k = 0; k < submesh.BoneIndices.size(); k++)
+				{
+					CheckIndex(submesh.BoneIndices[k], mesh.Bones.size(), true, "bone");
+				}
+			}
+		}
+		for (size_t i = 0; i < scene.Materials.size(); i++)
+		{
+			for (size_t j = 0; j < scene.Materials[i].Textures.size(); j++)
+			{
+				CheckIndex(scene.Materials[i].Textures[j].Texture, scene.Textures.size(), true, "texture");
+			}
+		}
+		for (size_t i = 0; i < scene.Morphs.size(); i++)
+		{
+			const SceneMorph& morph = scene.Morphs[i];
+			CheckIndex(morph.Mesh, scene.Meshes.size(), false, "morph mesh");
+			CheckIndex(morph.Submesh, scene.Meshes[morph.Mesh].Submeshes.size(), false, "morph submesh");
+			int vertexCount = scene.Meshes[morph.Mesh].Submeshes[morph.Submesh].VertexCount;
+			for (size_t j = 0; j < morph.Channels.size(); j++)
+			{
+				for (size_t k = 0; k < morph.Channels[j].Shapes.size(); k++)
+				{
+					const SceneShape& shape = morph.Channels[j].Shapes[k];
+					if (shape.Deltas.size() != shape.Indices.size() * 3)
+					{
+						throw std::runtime_error("Snapshot shape deltas do not match its indices");
+					}
+					for (size_t v = 0; v < shape.Indices.size(); v++)
+					{
+						CheckIndex(shape.Indices[v], (size_t)vertexCount, false, "shape vertex");
+					}
+				}
+			}
+		}
+		for (size_t i = 0; i < scene.Clips.size(); i++)
+		{
+			for (size_t j = 0; j < scene.Clips[i].Tracks.size(); j++)
+			{
+				const SceneTrack& track = scene.Clips[i].Tracks[j];
+				CheckIndex(track.Frame, scene.Frames.size(), false, "track frame");
+				const SceneCurve* curves[3] = { &track.Scalings, &track.Rotations, &track.Translations };
+				for (int c = 0; c < 3; c++)
+				{
+					if (curves[c]->Values.size() != curves[c]->Times.size() * 3)
+					{
+						throw std::runtime_error("Snapshot curve values do not match its keys");
+					}
+				}
+			}
+		}
+	}
+
+	void WriteSceneSnapshot(const Scene& scene, const char* path)
+	{
+		SnapshotWriter writer(path);
+		writer.Raw(SnapshotMagic, sizeof(SnapshotMagic));
+		writer.Value(SnapshotVersion);
+		writer.Value(scene.ScaleFactor);
+		writer.Value(scene.BoneSize);
+
+		writer.Count(scene.Frames.size());
+		for (size_t i = 0; i < scene.Frames.size(); i++)
+		{
+			const SceneFrame& frame = scene.Frames[i];
+			writer.String(frame.Name);
+			writer.Value(frame.Parent);
+			writer.Value((int)frame.Attribute);
+			writer.Raw(frame.LocalPosition, sizeof(frame.LocalPosition));
+			writer.Raw(frame.LocalRotation, sizeof(frame.LocalRotation));
+			writer.Raw(frame.LocalScale, sizeof(frame.LocalScale));
+		}
+
+		writer.Count(scene.Meshes.size());
+		for (size_t i = 0; i < scene.Meshes.size(); i++)
+		{
+			const SceneMesh& mesh = scene.Meshes[i];
+			writer.Value(mesh.Frame);
+			writer.Array(mesh.Bones);
+			writer.Count(mesh.Submeshes.size());
+			for (size_t j = 0; j < mesh.Submeshes.size(); j++)
+			{
+				//spilled geometry is read back one submesh at a time and written resident
+				SceneSubmesh loaded;
+				const SceneSubmesh& submesh = ResidentSubmesh(scene, mesh.Submeshes[j], loaded);
+				writer.Value(submesh.VertexCount);
+				writer.Value(submesh.Material);
+				writer.Array(submesh.Positions);
+				writer.Array(submesh.Normals);
+				writer.Array(submesh.UV0);
+				writer.Array(submesh.Tangents);
+				writer.Array(submesh.Colours);
+				writer.Array(submesh.Indices);
+				writer.Array(submesh.BoneIndices);
+				writer.Array(submesh.Weights);
+			}
+		}
+
+		writer.Count(scene.Materials.size());
+		for (size_t i = 0; i < scene.Materials.size(); i++)
+		{
+			const SceneMaterial& material = scene.Materials[i];
+			writer.String(material.Name);
+			writer.Raw(material.Diffuse, sizeof(material.Diffuse));
+			writer.Raw(material.Ambient, sizeof(material.Ambient));
+			writer.Raw(material.Emissive, sizeof(material.Emissive));
+			writer.Raw(material.Specular, sizeof(material.Specular));
+			writer.Raw(material.Reflection, sizeof(material.Reflection));
+			writer.Value(material.Shininess);
+			writer.Value(material.Transparency);
+			writer.Array(material.Textures);
+		}
+
+		//texture files stay next to the snapshot, only their names are stored
+		writer.Count(scene.Textures.size());
+		for (size_t i = 0; i < scene.Textures.size(); i++)
+		{
+			writer.String(scene.Textures[i].Name);
+			writer.String(scene.Textures[i].RelativeFileName);
+		}
+
+		writer.Count(scene.Morphs.size());
+		for (size_t i = 0; i < scene.Morphs.size(); i++)
+		{
+			const SceneMorph& morph = scene.Morphs[i];
+			writer.Value(morph.Mesh);
+			writer.Value(morph.Submesh);
+			writer.String(morph.Name);
+			writer.Value(morph.WeightProperties);
+			writer.Count(morph.Channels.size());
+			for (size_t j = 0; j < morph.Channels.size(); j++)
+			{
+				const SceneBlendChannel& channel = morph.Channels[j];
+				writer.String(channel.Name);
+				writer.Value(channel.DeformPercent);
+				writer.Count(channel.Shapes.size());
+				for (size_t k = 0; k < channel.Shapes.size(); k++)
+				{
+					const SceneShape& shape = channel.Shapes[k];
+					writer.String(shape.Name);
+					writer.Value(shape.Weight);
+					writer.Array(shape.Indices);
+					writer.Array(shape.Deltas);
+				}
+			}
+		}
+
+		writer.Count(scene.Clips.size());
+		for (size_t i = 0; i < scene.Clips.size(); i++)
+		{
+			const SceneClip& clip = scene.Clips[i];
+			writer.String(clip.Name);
+			writer.Count(clip.Tracks.size());
+			for (size_t j = 0; j < clip.Tracks.size(); j++)
+			{
+				const SceneTrack& track = clip.Tracks[j];
+				writer.Value(track.Frame);
+				WriteCurve(writer, track.Scalings);
+				WriteCurve(writer, track.Rotations);
+				WriteCurve(writer, track.Translations);
+			}
+		}
+		writer.Close();
+	}
+
+	void ReadSceneSnapshot(const char* path, Scene& scene)
+	{
+		SnapshotReader reader(path);
+		char magic[sizeof(SnapshotMagic)];
+		reader.Raw(magic, sizeof(magic));
+		if (memcmp(magic, SnapshotMagic, sizeof(magic)) != 0)
+		{
+			throw std::runtime_error(std::string(path) + " is not a scene snapshot");
+		}
+		unsigned int version = reader.Value<unsigned int>();
+		if (version != SnapshotVersion)
+		{
+			throw std::runtime_error(std::string(path) + " has snapshot version " + std::to_string(version) + ", expected " + std::to_string(SnapshotVersion));
+		}
+
+		scene = Scene();
+		scene.ScaleFactor = reader.Value<float>();
+		scene.BoneSize = reader.Value<float>();
+
+		scene.Frames.resize(reader.Count(sizeof(int) * 2));
+		for (size_t i = 0; i < scene.Frames.size(); i++)
+		{
+			SceneFrame& frame = scene.Frames[i];
+			frame.Name = reader.String();
+			frame.Parent = reader.Value<int>();
+			frame.Attribute = (SceneFrameAttribute)reader.Value<int>();
+			reader.Raw(frame.LocalPosition, sizeof(frame.LocalPosition));
+			reader.Raw(frame.LocalRotation, sizeof(frame.LocalRotation));
+			reader.Raw(frame.LocalScale, sizeof(frame.LocalScale));
+			if (frame.Parent >= (int)i || frame.Parent < -1)
+			{
+				throw std::runtime_error("Snapshot frames are not stored parents first");
+			}
+		}
+
+		scene.Meshes.resize(reader.Count(sizeof(int)));
+		for (size_t i = 0; i < scene.Meshes.size(); i++)
+		{
+			SceneMesh& mesh = scene.Meshes[i];
+			mesh.Frame = reader.Value<int>();
+			reader.Array(mesh.Bones);
+			mesh.Submeshes.resize(reader.Count(sizeof(int) * 2));
+			for (size_t j = 0; j < mesh.Submeshes.size(); j++)
+			{
+				SceneSubmesh& submesh = mesh.Submeshes[j];
+				submesh.VertexCount = reader.Value<int>();
+				submesh.Material = reader.Value<int>();
+				reader.Array(submesh.Positions);
+				reader.Array(submesh.Normals);
+				reader.Array(submesh.UV0);
+				reader.Array(submesh.Tangents);
+				reader.Array(submesh.Colours);
+				reader.Array(submesh.Indices);
+				reader.Array(submesh.BoneIndices);
+				reader.Array(submesh.Weights);
+				submesh.Spilled = false;
+				submesh.SpillOffset = 0;
+			}
+		}
+
+		scene.Materials.resize(reader.Count(sizeof(float) * 22));
+		for (size_t i = 0; i < scene.Materials.size(); i++)
+		{
+			SceneMaterial& material = scene.Materials[i];
+			material.Name = reader.String();
+			reader.Raw(material.Diffuse, sizeof(material.Diffuse));
+			reader.Raw(material.Ambient, sizeof(material.Ambient));
+			reader.Raw(material.Emissive, sizeof(material.Emissive));
+			reader.Raw(material.Specular, sizeof(material.Specular));
+			reader.Raw(material.Reflection, sizeof(material.Reflection));
+			material.Shininess = reader.Value<float>();
+			material.Transparency = reader.Value<float>();
+			reader.Array(material.Textures);
+		}
+
+		scene.Textures.resize(reader.Count(sizeof(unsigned long long) * 2));
+		for (size_t i = 0; i < scene.Textures.size(); i++)
+		{
+			SceneTexture& texture = scene.Textures[i];
+			texture.Name = reader.String();
+			texture.RelativeFileName = reader.String();
+			texture.FileName = texture.RelativeFileName;
+		}
+
+		scene.Morphs.resize(reader.Count(sizeof(int) * 2));
+		for (size_t i = 0; i < scene.Morphs.size(); i++)
+		{
+			SceneMorph& morph = scene.Morphs[i];
+			morph.Mesh = reader.Value<int>();
+			morph.Submesh = reader.Value<int>();
+			morph.Name = reader.String();
+			morph.WeightProperties = reader.Value<bool>();
+			morph.Channels.resize(reader.Count(sizeof(unsigned long long)));
+			for (size_t j = 0; j < morph.Channels.size(); j++)
+			{
+				SceneBlendChannel& channel = morph.Channels[j];
+				channel.Name = reader.String();
+				channel.DeformPercent = reader.Value<float>();
+				channel.Shapes.resize(reader.Count(sizeof(unsigned long long)));
+				for (size_t k = 0; k < channel.Shapes.size(); k++)
+				{
+					SceneShape& shape = channel.Shapes[k];
+					shape.Name = reader.String();
+					shape.Weight = reader.Value<float>();
+					reader.Array(shape.Indices);
+					reader.Array(shape.Deltas);
+				}
+			}
+		}
+
+		scene.Clips.resize(reader.Count(sizeof(unsigned long long)));
+		for (size_t i = 0; i < scene.Clips.size(); i++)
+		{
+			SceneClip& clip = scene.Clips[i];
+			clip.Name = reader.String();
+			clip.Tracks.resize(reader.Count(sizeof(int)));
+			for (size_t j = 0; j < clip.Tracks.size(); j++)
+			{
+				SceneTrack& track = clip.Tracks[j];
+				track.Frame = reader.Value<int>();
+				ReadCurve(reader, track.Scalings);
+				ReadCurve(reader, track.Rotations);
+				ReadCurve(reader, track.Translations);
+			}
+		}
+
+		if (!reader.AtEnd())
+		{
+			throw std::runtime_error(std::string(path) + " has data after the scene");
+		}
+		ValidateScene(scene);
+	}
+}
@@ -0,0 +1,112 @@
+#include <stdexcept>
+#include "AssetStudioFBXSceneSpill.h"
+
+#ifdef _MSC_VER
+#define FBX_FSEEK _fseeki64
+#else
+#define FBX_FSEEK fseeko
+#endif
+
+namespace AssetStudio
+{
+	SceneSpill::SceneSpill(const char* path) : path(path), end(0)
+	{
+		file = fopen(path, "w+b");
+		if (file == NULL)
+		{
+			throw std::runtime_error(std::string("Failed to open ") + path);
+		}
+		setvbuf(file, NULL, _IOFBF, 1 << 20);
+	}
+
+	SceneSpill::~SceneSpill()
+	{
+		fclose(file);
+		remove(path.c_str());
+	}
+
+	void SceneSpill::Seek(long long offset)
+	{
+		if (FBX_FSEEK(file, offset, SEEK_SET) != 0)
+		{
+			throw std::runtime_error("Failed to seek in spill file");
+		}
+	}
+
+	template <typename T> void SceneSpill::Write(std::vector<T>& values)
+	{
+		unsigned long long count = values.size();
+		if (fwrite(&count, sizeof(count), 1, file) != 1 || (count > 0 && fwrite(values.data(), sizeof(T), values.size(), file) != values.size()))
+		{
+			throw std::runtime_error("Failed to write spill file");
+		}
+		end += (long long)(sizeof(count) + count * sizeof(T));
+		//swap instead of clear, so the memory is actually returned
+		std::vector<T>().swap(values);
+	}
+
+	template <typename T> void SceneSpill::Read(std::vector<T>& values)
+	{
+		unsigned long long count;
+		if (fread(&count, sizeof(count), 1, file) != 1)
+		{
+			throw std::runtime_error("Failed to read spill file");
+		}
+		values.resize((size_t)count);
+		if (count > 0 && fread(values.data(), sizeof(T), values.size(), file) != values.size())
+		{
+			throw std::runtime_error("Failed to read spill file");
+		}
+	}
+
+	void SceneSpill::Store(SceneSubmesh& submesh)
+	{
+		if (submesh.Spilled)
+		{
+			return;
+		}
+		Seek(end);
+		submesh.SpillOffset = end;
+		Write(submesh.Positions);
+		Write(submesh.Normals);
+		Write(submesh.UV0);
+		Write(submesh.Tangents);
+		Write(submesh.Colours);
+		Write(submesh.Indices);
+		Write(submesh.BoneIndices);
+		Write(submesh.Weights);
+		submesh.Spilled = true;
+	}
+
+	void SceneSpill::Load(const SceneSubmesh& submesh, SceneSubmesh& target)
+	{
+		//reads and writes share the stream, the seek also flushes pending writes
+		Seek(submesh.SpillOffset);
+		target.VertexCount = submesh.VertexCount;
+		target.Material = submesh.Material;
+		target.Spilled = false;
+		target.SpillOffset = 0;
+		Read(target.Positions);
+		Read(target.Normals);
+		Read(target.UV0);
+		Read(target.Tangents);
+		Read(target.Colours);
+		Read(target.Indices);
+		Read(target.BoneIndices);
+		Read(target.Weights);
+	}
+
+	const SceneSubmesh& ResidentSubmesh(const Scene& scene, const SceneSubmesh& submesh, SceneSubmesh& loaded)
+	{
+		if (!submesh.Spilled)
+		{
+			return submesh;
+		}
+		if (scene.Spill == NULL)
+		{
+			throw std::runtime_error("Spilled submesh without a spill file");
+		}
+		scene.Spill->Load(submesh, loaded);
+		return loaded;
+	}
+}
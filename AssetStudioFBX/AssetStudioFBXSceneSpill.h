@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdio.h>
+#include "AssetStudioFBXScene.h"
+
+namespace AssetStudio
+{
+	//Temporary file holding the geometry of finished submeshes, so a large scene does not have to stay resident until it is written.
+	//The file is deleted when the spill is destroyed. Throws std::runtime_error on I/O failure.
+	class SceneSpill
+	{
+	public:
+		explicit SceneSpill(const char* path);
+		~SceneSpill();
+
+		//Appends the arrays of submesh to the file and frees them, VertexCount and Material stay
+		void Store(SceneSubmesh& submesh);
+		//Reads a stored submesh back into target, the spilled submesh itself is left as it is
+		void Load(const SceneSubmesh& submesh, SceneSubmesh& target);
+
+		unsigned long long Bytes() const { return (unsigned long long)end; }
+
+	private:
+		FILE* file;
+		std::string path;
+		long long end;
+
+		SceneSpill(const SceneSpill&);
+		SceneSpill& operator=(const SceneSpill&);
+
+		void Seek(long long offset);
+		template <typename T> void Write(std::vector<T>& values);
+		template <typename T> void Read(std::vector<T>& values);
+	};
+
+	//The submesh itself, or its arrays read back into loaded when they were spilled
+	const SceneSubmesh& ResidentSubmesh(const Scene& scene, const SceneSubmesh& submesh, SceneSubmesh& loaded);
+}
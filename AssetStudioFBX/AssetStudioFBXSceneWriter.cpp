@@ -0,0 +1,1346 @@
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include "AssetStudioFBXScene.h"
+#include "AssetStudioFBXBinaryWriter.h"
+#include "AssetStudioFBXSceneSpill.h"
+
+namespace AssetStudio
+{
+	//FileId, CreationTime and the footer id have to agree, these are the values used by other SDK-free writers
+	static const unsigned char FileId[16] = { 0x28, 0xb3, 0x2a, 0xeb, 0xb6, 0x24, 0xcc, 0xc2, 0xbf, 0xc8, 0xb0, 0x2a, 0xa9, 0x2b, 0xfc, 0xf1 };
+	static const unsigned char FooterId[16] = { 0xfa, 0xbc, 0xab, 0x09, 0xd0, 0xc8, 0xd4, 0x66, 0xb1, 0x76, 0xfb, 0x83, 0x1c, 0xf7, 0x26, 0x7e };
+	static const char CreationTime[] = "1970-01-01 10:00:00:000";
+	static const double KTimeSecond = 46186158000.0;
+	static const long long FirstObjectId = 1000000;
+
+	//Same storage as FbxAMatrix, translation in the last row
+	struct SceneMatrix
+	{
+		double m[4][4];
+	};
+
+	static SceneMatrix Identity()
+	{
+		SceneMatrix r;
+		memset(&r, 0, sizeof(r));
+		for (int i = 0; i < 4; i++)
+		{
+			r.m[i][i] = 1;
+		}
+		return r;
+	}
+
+	//FbxAMatrix operator*, b is applied first
+	static SceneMatrix Multiply(const SceneMatrix& a, const SceneMatrix& b)
+	{
+		SceneMatrix r;
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				double sum = 0;
+				for (int k = 0; k < 4; k++)
+				{
+					sum += b.m[i][k] * a.m[k][j];
+				}
+				r.m[i][j] = sum;
+			}
+		}
+		return r;
+	}
+
+	static SceneMatrix Inverse(const SceneMatrix& a)
+	{
+		double t[4][8];
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				t[i][j] = a.m[i][j];
+				t[i][j + 4] = i == j ? 1 : 0;
+			}
+		}
+		for (int c = 0; c < 4; c++)
+		{
+			int pivot = c;
+			for (int r = c + 1; r < 4; r++)
+			{
+				if (fabs(t[r][c]) > fabs(t[pivot][c]))
+				{
+					pivot = r;
+				}
+			}
+			if (t[pivot][c] == 0)
+			{
+				return Identity();
+			}
+			if (pivot != c)
+			{
+				for (int j = 0; j < 8; j++)
+				{
+					std::swap(t[c][j], t[pivot][j]);
+				}
+			}
+			double scale = 1 / t[c][c];
+			for (int j = 0; j < 8; j++)
+			{
+				t[c][j] *= scale;
+			}
+			for (int r = 0; r < 4; r++)
+			{
+				if (r != c && t[r][c] != 0)
+				{
+					double factor = t[r][c];
+					for (int j = 0; j < 8; j++)
+					{
+						t[r][j] -= factor * t[c][j];
+					}
+				}
+			}
+		}
+		SceneMatrix r;
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				r.m[i][j] = t[i][j + 4];
+			}
+		}
+		return r;
+	}
+
+	//T * R * S with euler XYZ rotation, matching FbxNode::EvaluateGlobalTransform without pivots
+	static SceneMatrix LocalTransform(const SceneFrame& frame)
+	{
+		const double toRadians = 3.14159265358979323846 / 180;
+		double cx = cos(frame.LocalRotation[0] * toRadians), sx = sin(frame.LocalRotation[0] * toRadians);
+		double cy = cos(frame.LocalRotation[1] * toRadians), sy = sin(frame.LocalRotation[1] * toRadians);
+		double cz = cos(frame.LocalRotation[2] * toRadians), sz = sin(frame.LocalRotation[2] * toRadians);
+
+		//rows are the rotated axes, Rz * Ry * Rx transposed
+		double rotation[3][3] =
+		{
+			{ cy * cz, cy * sz, -sy },
+			{ sx * sy * cz - cx * sz, sx * sy * sz + cx * cz, sx * cy },
+			{ cx * sy * cz + sx * sz, cx * sy * sz - sx * cz, cx * cy }
+		};
+
+		SceneMatrix r = Identity();
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				r.m[i][j] = rotation[i][j] * frame.LocalScale[i];
+			}
+			r.m[3][i] = frame.LocalPosition[i];
+		}
+		return r;
+	}
+
+	static long long ToKTime(float seconds)
+	{
+		double ticks = seconds * KTimeSecond;
+		return (long long)(ticks < 0 ? ticks - 0.5 : ticks + 0.5);
+	}
+
+	static std::string ObjectName(const std::string& name, const char* objectClass)
+	{
+		std::string result(name);
+		result.push_back('\0');
+		result.push_back('\x01');
+		result.append(objectClass);
+		return result;
+	}
+
+	struct SceneCluster
+	{
+		int Bone;
+		std::vector<int> Indices;
+		std::vector<double> Weights;
+	};
+
+	struct SceneConnection
+	{
+		long long Child;
+		long long Parent;
+		const char* Property;
+	};
+
+	//Adds the time until it goes out of scope to one stage, and takes it off an enclosing stage when given
+	class StageClock
+	{
+	public:
+		StageClock(double* stageSeconds, SceneStage stage, int enclosing = -1) : stageSeconds(stageSeconds), stage(stage), enclosing(enclosing), start(std::chrono::steady_clock::now())
+		{
+		}
+
+		~StageClock()
+		{
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			stageSeconds[stage] += seconds;
+			if (enclosing >= 0)
+			{
+				stageSeconds[enclosing] -= seconds;
+			}
+		}
+
+	private:
+		double* stageSeconds;
+		SceneStage stage;
+		int enclosing;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	class SceneWriter
+	{
+	public:
+		SceneWriter(const Scene& scene, FbxBinaryWriter& writer, double* stageSeconds) : scene(scene), writer(writer), stageSeconds(stageSeconds), nextId(FirstObjectId), objects(0)
+		{
+		}
+
+		int Write()
+		{
+			Plan();
+			WriteHeader();
+			WriteGlobalSettings();
+			WriteDefinitions();
+
+			writer.BeginNode("Objects");
+			{
+				StageClock clock(stageSeconds, StageHierarchy);
+				WriteFrames();
+			}
+			{
+				StageClock clock(stageSeconds, StageMesh);
+				WriteMeshes();
+			}
+			{
+				StageClock clock(stageSeconds, StageMaterials);
+				WriteMaterials();
+			}
+			{
+				StageClock clock(stageSeconds, StageAnimation);
+				WriteAnimations();
+			}
+			writer.EndNode();
+
+			WriteConnections();
+			WriteTakes();
+			return objects;
+		}
+
+	private:
+		const Scene& scene;
+		FbxBinaryWriter& writer;
+		double* stageSeconds;
+		long long nextId;
+		int objects;
+
+		std::vector<long long> frameIds;
+		std::vector<SceneMatrix> frameGlobals;
+		std::vector<bool> frameHasChildren;
+		std::vector<std::vector<long long> > submeshIds;
+		std::vector<int> clusterCounts;
+		std::vector<SceneCluster> clusters;
+		std::vector<std::vector<std::vector<const SceneMorph*> > > submeshMorphs;
+		std::vector<long long> materialIds;
+		std::vector<long long> textureIds;
+		std::vector<const SceneMaterialTexture*> textureLinks;
+		std::vector<SceneConnection> connections;
+		std::vector<long long> clipStart;
+		std::vector<long long> clipStop;
+
+		int modelCount;
+		int attributeCount;
+		int geometryCount;
+		int deformerCount;
+		int curveNodeCount;
+		int curveCount;
+
+		long long NewId()
+		{
+			objects++;
+			return nextId++;
+		}
+
+		void Connect(long long child, long long parent, const char* property = NULL)
+		{
+			SceneConnection connection = { child, parent, property };
+			connections.push_back(connection);
+		}
+
+		static bool HasKeys(const SceneCurve& curve)
+		{
+			return !curve.Times.empty() && curve.Values.size() >= curve.Times.size() * 3;
+		}
+
+		//Counts the influences per bone and returns the number of bones with any, those get a cluster
+		static int CountInfluences(const SceneMesh& mesh, const SceneSubmesh& submesh, std::vector<int>& counts)
+		{
+			counts.assign(mesh.Bones.size(), 0);
+			if (submesh.BoneIndices.size() < (size_t)submesh.VertexCount * 4 || submesh.Weights.size() < (size_t)submesh.VertexCount * 4)
+			{
+				return 0;
+			}
+			int clusterCount = 0;
+			for (int v = 0; v < submesh.VertexCount; v++)
+			{
+				for (int k = 0; k < 4; k++)
+				{
+					int bone = submesh.BoneIndices[v * 4 + k];
+					float weight = submesh.Weights[v * 4 + k];
+					if (bone < 0 || bone >= (int)counts.size() || !(weight > 0) || mesh.Bones[bone].Frame < 0)
+					{
+						continue;
+					}
+					if (counts[bone]++ == 0)
+					{
+						clusterCount++;
+					}
+				}
+			}
+			return clusterCount;
+		}
+
+		//Counting sort of the influences by bone, vertex order is kept inside each cluster
+		void BuildClusters(const SceneMesh& mesh, const SceneSubmesh& submesh)
+		{
+			clusters.clear();
+			if (CountInfluences(mesh, submesh, clusterCounts) == 0)
+			{
+				return;
+			}
+			//counts becomes the cluster index
+			for (size_t b = 0; b < clusterCounts.size(); b++)
+			{
+				if (clusterCounts[b] > 0)
+				{
+					SceneCluster cluster;
+					cluster.Bone = (int)b;
+					cluster.Indices.reserve(clusterCounts[b]);
+					cluster.Weights.reserve(clusterCounts[b]);
+					clusterCounts[b] = (int)clusters.size();
+					clusters.push_back(cluster);
+				}
+			}
+			for (int v = 0; v < submesh.VertexCount; v++)
+			{
+				for (int k = 0; k < 4; k++)
+				{
+					int bone = submesh.BoneIndices[v * 4 + k];
+					float weight = submesh.Weights[v * 4 + k];
+					if (bone < 0 || bone >= (int)clusterCounts.size() || !(weight > 0) || mesh.Bones[bone].Frame < 0)
+					{
+						continue;
+					}
+					SceneCluster& cluster = clusters[clusterCounts[bone]];
+					cluster.Indices.push_back(v);
+					cluster.Weights.push_back(weight);
+				}
+			}
+		}
+
+		void Plan()
+		{
+			size_t frameCount = scene.Frames.size();
+			frameIds.resize(frameCount);
+			frameGlobals.resize(frameCount);
+			frameHasChildren.assign(frameCount, false);
+			modelCount = (int)frameCount;
+			attributeCount = 0;
+			for (size_t i = 0; i < frameCount; i++)
+			{
+				const SceneFrame& frame = scene.Frames[i];
+				SceneMatrix local = LocalTransform(frame);
+				frameGlobals[i] = frame.Parent < 0 ? local : Multiply(frameGlobals[frame.Parent], local);
+				if (frame.Parent >= 0)
+				{
+					frameHasChildren[frame.Parent] = true;
+				}
+				if (frame.Attribute != FrameNone)
+				{
+					attributeCount++;
+				}
+			}
+
+			materialIds.assign(scene.Materials.size(), 0);
+			textureIds.assign(scene.Textures.size(), 0);
+			textureLinks.assign(scene.Textures.size(), NULL);
+			geometryCount = 0;
+			deformerCount = 0;
+
+			submeshMorphs.resize(scene.Meshes.size());
+			for (size_t i = 0; i < scene.Meshes.size(); i++)
+			{
+				submeshMorphs[i].resize(scene.Meshes[i].Submeshes.size());
+			}
+			for (size_t i = 0; i < scene.Morphs.size(); i++)
+			{
+				const SceneMorph& morph = scene.Morphs[i];
+				if (morph.Mesh >= 0 && morph.Mesh < (int)scene.Meshes.size() && morph.Submesh >= 0 && morph.Submesh < (int)scene.Meshes[morph.Mesh].Submeshes.size())
+				{
+					submeshMorphs[morph.Mesh][morph.Submesh].push_back(&morph);
+					deformerCount++;
+					for (size_t j = 0; j < morph.Channels.size(); j++)
+					{
+						deformerCount++;
+						geometryCount += (int)morph.Channels[j].Shapes.size();
+					}
+				}
+			}
+
+			std::vector<int> counts;
+			submeshIds.resize(scene.Meshes.size());
+			for (size_t i = 0; i < scene.Meshes.size(); i++)
+			{
+				const SceneMesh& mesh = scene.Meshes[i];
+				submeshIds[i].resize(mesh.Submeshes.size());
+				modelCount += (int)mesh.Submeshes.size();
+				geometryCount += (int)mesh.Submeshes.size();
+
+				for (size_t j = 0; j < mesh.Submeshes.size(); j++)
+				{
+					const SceneSubmesh& submesh = mesh.Submeshes[j];
+					if (submesh.Material >= 0)
+					{
+						materialIds[submesh.Material] = -1;
+						const SceneMaterial& material = scene.Materials[submesh.Material];
+						for (size_t k = 0; k < material.Textures.size(); k++)
+						{
+							const SceneMaterialTexture& link = material.Textures[k];
+							if (link.Texture >= 0 && link.Dest >= 0 && link.Dest <= 3)
+							{
+								textureIds[link.Texture] = -1;
+								//the texture object is shared, so the last link decides its offset and scale
+								textureLinks[link.Texture] = &link;
+							}
+						}
+					}
+
+					if (!mesh.Bones.empty())
+					{
+						//clusters are built again when the skin is written, only their number is needed here
+						SceneSubmesh loaded;
+						int clusterCount = CountInfluences(mesh, ResidentSubmesh(scene, submesh, loaded), counts);
+						if (clusterCount > 0)
+						{
+							deformerCount += 1 + clusterCount;
+						}
+					}
+				}
+			}
+
+			curveNodeCount = 0;
+			curveCount = 0;
+			clipStart.resize(scene.Clips.size());
+			clipStop.resize(scene.Clips.size());
+			for (size_t i = 0; i < scene.Clips.size(); i++)
+			{
+				long long start = 0, stop = 0;
+				bool first = true;
+				const SceneClip& clip = scene.Clips[i];
+				for (size_t j = 0; j < clip.Tracks.size(); j++)
+				{
+					const SceneTrack& track = clip.Tracks[j];
+					if (track.Frame < 0)
+					{
+						continue;
+					}
+					const SceneCurve* curves[3] = { &track.Scalings, &track.Rotations, &track.Translations };
+					for (int c = 0; c < 3; c++)
+					{
+						if (!HasKeys(*curves[c]))
+						{
+							continue;
+						}
+						curveNodeCount++;
+						curveCount += 3;
+						for (size_t k = 0; k < curves[c]->Times.size(); k++)
+						{
+							long long time = ToKTime(curves[c]->Times[k]);
+							if (first || time < start)
+							{
+								start = time;
+							}
+							if (first || time > stop)
+							{
+								stop = time;
+							}
+							first = false;
+						}
+					}
+				}
+				clipStart[i] = start;
+				clipStop[i] = stop;
+			}
+		}
+
+		void BeginObject(const char* type, long long id, const std::string& name, const char* objectClass, const char* subclass)
+		{
+			writer.BeginNode(type);
+			writer.AddInt64(id);
+			writer.AddString(ObjectName(name, objectClass));
+			writer.AddString(subclass);
+		}
+
+		void BeginP(const char* name, const char* type, const char* label, const char* flags)
+		{
+			writer.BeginNode("P");
+			writer.AddString(name);
+			writer.AddString(type);
+			writer.AddString(label);
+			writer.AddString(flags);
+		}
+
+		void PInt(const char* name, int value)
+		{
+			BeginP(name, "int", "Integer", "");
+			writer.AddInt32(value);
+			writer.EndNode();
+		}
+
+		void PEnum(const char* name, int value)
+		{
+			BeginP(name, "enum", "", "");
+			writer.AddInt32(value);
+			writer.EndNode();
+		}
+
+		void PBool(const char* name, bool value)
+		{
+			BeginP(name, "bool", "", "");
+			writer.AddInt32(value ? 1 : 0);
+			writer.EndNode();
+		}
+
+		void PDouble(const char* name, double value, const char* flags = "")
+		{
+			BeginP(name, "double", "Number", flags);
+			writer.AddDouble(value);
+			writer.EndNode();
+		}
+
+		void PNumber(const char* name, double value)
+		{
+			BeginP(name, "Number", "", "A");
+			writer.AddDouble(value);
+			writer.EndNode();
+		}
+
+		void PString(const char* name, const std::string& value)
+		{
+			BeginP(name, "KString", "", "");
+			writer.AddString(value);
+			writer.EndNode();
+		}
+
+		void PTime(const char* name, long long value)
+		{
+			BeginP(name, "KTime", "Time", "");
+			writer.AddInt64(value);
+			writer.EndNode();
+		}
+
+		void PTriple(const char* name, const char* type, const char* label, double x, double y, double z)
+		{
+			BeginP(name, type, label, "A");
+			writer.AddDouble(x);
+			writer.AddDouble(y);
+			writer.AddDouble(z);
+			writer.EndNode();
+		}
+
+		void Int32Node(const char* name, int value)
+		{
+			writer.BeginNode(name);
+			writer.AddInt32(value);
+			writer.EndNode();
+		}
+
+		void StringNode(const char* name, const std::string& value)
+		{
+			writer.BeginNode(name);
+			writer.AddString(value);
+			writer.EndNode();
+		}
+
+		void DoubleArrayNode(const char* name, const std::vector<double>& values)
+		{
+			writer.BeginNode(name);
+			writer.AddArray(values.empty() ? NULL : &values[0], values.size());
+			writer.EndNode();
+		}
+
+		void IntArrayNode(const char* name, const std::vector<int>& values)
+		{
+			writer.BeginNode(name);
+			writer.AddArray(values.empty() ? NULL : &values[0], values.size());
+			writer.EndNode();
+		}
+
+		void MatrixNode(const char* name, const SceneMatrix& matrix)
+		{
+			writer.BeginNode(name);
+			writer.AddArray(&matrix.m[0][0], 16);
+			writer.EndNode();
+		}
+
+		void WriteHeader()
+		{
+			writer.BeginNode("FBXHeaderExtension");
+			Int32Node("FBXHeaderVersion", 1003);
+			Int32Node("FBXVersion", writer.Version());
+			Int32Node("EncryptionType", 0);
+			writer.BeginNode("CreationTimeStamp");
+			Int32Node("Version", 1000);
+			Int32Node("Year", 1970);
+			Int32Node("Month", 1);
+			Int32Node("Day", 1);
+			Int32Node("Hour", 10);
+			Int32Node("Minute", 0);
+			Int32Node("Second", 0);
+			Int32Node("Millisecond", 0);
+			writer.EndNode();
+			StringNode("Creator", "AssetStudio");
+			writer.EndNode();
+
+			writer.BeginNode("FileId");
+			writer.AddRaw(FileId, sizeof(FileId));
+			writer.EndNode();
+			StringNode("CreationTime", CreationTime);
+			StringNode("Creator", "AssetStudio");
+		}
+
+		void WriteGlobalSettings()
+		{
+			long long start = 0, stop = 0;
+			for (size_t i = 0; i < scene.Clips.size(); i++)
+			{
+				start = i == 0 ? clipStart[i] : std::min(start, clipStart[i]);
+				stop = i == 0 ? clipStop[i] : std::max(stop, clipStop[i]);
+			}
+
+			writer.BeginNode("GlobalSettings");
+			Int32Node("Version", 1000);
+			writer.BeginNode("Properties70");
+			PInt("UpAxis", 1);
+			PInt("UpAxisSign", 1);
+			PInt("FrontAxis", 2);
+			PInt("FrontAxisSign", 1);
+			PInt("CoordAxis", 0);
+			PInt("CoordAxisSign", 1);
+			PInt("OriginalUpAxis", -1);
+			PInt("OriginalUpAxisSign", 1);
+			PDouble("UnitScaleFactor", scene.ScaleFactor);
+			PDouble("OriginalUnitScaleFactor", scene.ScaleFactor);
+			BeginP("AmbientColor", "ColorRGB", "Color", "");
+			writer.AddDouble(0);
+			writer.AddDouble(0);
+			writer.AddDouble(0);
+			writer.EndNode();
+			PString("DefaultCamera", "Producer Perspective");
+			PEnum("TimeMode", 6);
+			PTime("TimeSpanStart", start);
+			PTime("TimeSpanStop", stop);
+			PDouble("CustomFrameRate", -1);
+			writer.EndNode();
+			writer.EndNode();
+
+			writer.BeginNode("Documents");
+			Int32Node("Count", 1);
+			writer.BeginNode("Document");
+			writer.AddInt64(nextId++);
+			writer.AddString("Scene");
+			writer.AddString("Scene");
+			writer.BeginNode("Properties70");
+			BeginP("SourceObject", "object", "", "");
+			writer.EndNode();
+			PString("ActiveAnimStackName", scene.Clips.empty() ? std::string() : scene.Clips[0].Name);
+			writer.EndNode();
+			writer.BeginNode("RootNode");
+			writer.AddInt64(0);
+			writer.EndNode();
+			writer.EndNode();
+			writer.EndNode();
+
+			writer.BeginNode("References");
+			writer.EndNode();
+		}
+
+		void Definition(const char* type, int count)
+		{
+			if (count > 0)
+			{
+				writer.BeginNode("ObjectType");
+				writer.AddString(type);
+				Int32Node("Count", count);
+				writer.EndNode();
+			}
+		}
+
+		void WriteDefinitions()
+		{
+			int materialCount = 0, textureCount = 0;
+			for (size_t i = 0; i < materialIds.size(); i++)
+			{
+				materialCount += materialIds[i] != 0 ? 1 : 0;
+			}
+			for (size_t i = 0; i < textureIds.size(); i++)
+			{
+				textureCount += textureIds[i] != 0 ? 1 : 0;
+			}
+			int clipCount = (int)scene.Clips.size();
+
+			writer.BeginNode("Definitions");
+			Int32Node("Version", 100);
+			Int32Node("Count", 1 + modelCount + attributeCount + geometryCount + materialCount + textureCount + deformerCount + clipCount * 2 + curveNodeCount + curveCount);
+			Definition("GlobalSettings", 1);
+			Definition("Model", modelCount);
+			Definition("NodeAttribute", attributeCount);
+			Definition("Geometry", geometryCount);
+			Definition("Material", materialCount);
+			Definition("Texture", textureCount);
+			Definition("Deformer", deformerCount);
+			Definition("AnimationStack", clipCount);
+			Definition("AnimationLayer", clipCount);
+			Definition("AnimationCurveNode", curveNodeCount);
+			Definition("AnimationCurve", curveCount);
+			writer.EndNode();
+		}
+
+		void BeginModel(long long id, const std::string& name, const char* type)
+		{
+			BeginObject("Model", id, name, "Model", type);
+			Int32Node("Version", 232);
+		}
+
+		void WriteFrames()
+		{
+			for (size_t i = 0; i < scene.Frames.size(); i++)
+			{
+				const SceneFrame& frame = scene.Frames[i];
+				long long id = NewId();
+				frameIds[i] = id;
+				Connect(id, frame.Parent < 0 ? 0 : frameIds[frame.Parent]);
+
+				BeginModel(id, frame.Name, frame.Attribute == FrameJoint ? "LimbNode" : "Null");
+				writer.BeginNode("Properties70");
+				PEnum("InheritType", 1);
+				PTriple("Lcl Translation", "Lcl Translation", "", frame.LocalPosition[0], frame.LocalPosition[1], frame.LocalPosition[2]);
+				PTriple("Lcl Rotation", "Lcl Rotation", "", frame.LocalRotation[0], frame.LocalRotation[1], frame.LocalRotation[2]);
+				PTriple("Lcl Scaling", "Lcl Scaling", "", frame.LocalScale[0], frame.LocalScale[1], frame.LocalScale[2]);
+				writer.EndNode();
+				StringNode("Culling", "CullingOff");
+				writer.EndNode();
+
+				if (frame.Attribute == FrameNone)
+				{
+					continue;
+				}
+
+				long long attributeId = NewId();
+				Connect(attributeId, id);
+				if (frame.Attribute == FrameJoint)
+				{
+					BeginObject("NodeAttribute", attributeId, std::string(), "NodeAttribute", "LimbNode");
+					writer.BeginNode("Properties70");
+					PDouble("Size", scene.BoneSize);
+					writer.EndNode();
+					StringNode("TypeFlags", "Skeleton");
+				}
+				else
+				{
+					BeginObject("NodeAttribute", attributeId, std::string(), "NodeAttribute", "Null");
+					writer.BeginNode("Properties70");
+					if (frameHasChildren[i])
+					{
+						PEnum("Look", 0);
+					}
+					writer.EndNode();
+					StringNode("TypeFlags", "Null");
+				}
+				writer.EndNode();
+			}
+		}
+
+		void BeginLayerElement(const char* type, const char* mapping, const char* reference)
+		{
+			writer.BeginNode(type);
+			writer.AddInt32(0);
+			Int32Node("Version", 101);
+			StringNode("Name", "");
+			StringNode("MappingInformationType", mapping);
+			StringNode("ReferenceInformationType", reference);
+		}
+
+		void LayerEntry(const char* type)
+		{
+			writer.BeginNode("LayerElement");
+			StringNode("Type", type);
+			Int32Node("TypedIndex", 0);
+			writer.EndNode();
+		}
+
+		//Widens count vectors of stride floats to components doubles, missing sources become zeros
+		static void Widen(const std::vector<float>& source, int count, int stride, int components, std::vector<double>& target)
+		{
+			target.assign((size_t)count * components, 0);
+			if (source.size() < (size_t)count * stride)
+			{
+				return;
+			}
+			for (int i = 0; i < count; i++)
+			{
+				for (int c = 0; c < components; c++)
+				{
+					target[(size_t)i * components + c] = source[(size_t)i * stride + c];
+				}
+			}
+		}
+
+		void WriteMeshes()
+		{
+			std::vector<double> buffer;
+			std::vector<int> polygons;
+			SceneSubmesh loaded;
+
+			for (size_t i = 0; i < scene.Meshes.size(); i++)
+			{
+				const SceneMesh& mesh = scene.Meshes[i];
+				const std::string& frameName = scene.Frames[mesh.Frame].Name;
+				long long frameId = frameIds[mesh.Frame];
+				const SceneMatrix& meshMatrix = frameGlobals[mesh.Frame];
+
+				for (size_t j = 0; j < mesh.Submeshes.size(); j++)
+				{
+					const SceneSubmesh& submesh = ResidentSubmesh(scene, mesh.Submeshes[j], loaded);
+					int count = submesh.VertexCount;
+					std::string suffix = "_" + std::to_string(j);
+
+					bool hasTexture = false;
+					if (submesh.Material >= 0)
+					{
+						const SceneMaterial& material = scene.Materials[submesh.Material];
+						for (size_t k = 0; k < material.Textures.size(); k++)
+						{
+							hasTexture |= material.Textures[k].Texture >= 0 && material.Textures[k].Dest >= 0 && material.Textures[k].Dest <= 3;
+						}
+					}
+
+					long long modelId = NewId();
+					submeshIds[i][j] = modelId;
+					Connect(modelId, frameId);
+					BeginModel(modelId, frameName + suffix, "Mesh");
+					writer.BeginNode("Properties70");
+					PEnum("InheritType", 1);
+					writer.EndNode();
+					if (hasTexture)
+					{
+						writer.BeginNode("Shading");
+						writer.AddBool(true);
+						writer.EndNode();
+					}
+					StringNode("Culling", "CullingOff");
+					writer.EndNode();
+
+					long long geometryId = NewId();
+					Connect(geometryId, modelId);
+					BeginObject("Geometry", geometryId, std::string(), "Geometry", "Mesh");
+					writer.BeginNode("Properties70");
+					const std::vector<const SceneMorph*>& morphs = submeshMorphs[i][j];
+					for (size_t m = 0; m < morphs.size(); m++)
+					{
+						if (!morphs[m]->WeightProperties)
+						{
+							continue;
+						}
+						for (size_t c = 0; c < morphs[m]->Channels.size(); c++)
+						{
+							const SceneBlendChannel& channel = morphs[m]->Channels[c];
+							for (size_t s = 0; s < channel.Shapes.size(); s++)
+							{
+								std::string name = channel.Shapes[s].Name + ".Weight";
+								PDouble(name.c_str(), channel.Shapes[s].Weight, "U");
+							}
+						}
+					}
+					writer.EndNode();
+					Int32Node("GeometryVersion", 124);
+
+					Widen(submesh.Positions, count, 3, 3, buffer);
+					DoubleArrayNode("Vertices", buffer);
+
+					size_t indexCount = submesh.Indices.size() / 3 * 3;
+					polygons.assign(submesh.Indices.begin(), submesh.Indices.begin() + indexCount);
+					for (size_t k = 2; k < indexCount; k += 3)
+					{
+						polygons[k] = ~polygons[k];
+					}
+					IntArrayNode("PolygonVertexIndex", polygons);
+
+					BeginLayerElement("LayerElementNormal", "ByVertice", "Direct");
+					Widen(submesh.Normals, count, 3, 3, buffer);
+					DoubleArrayNode("Normals", buffer);
+					writer.EndNode();
+
+					BeginLayerElement("LayerElementTangent", "ByVertice", "Direct");
+					Widen(submesh.Tangents, count, 4, 3, buffer);
+					DoubleArrayNode("Tangents", buffer);
+					writer.EndNode();
+
+					bool hasColours = submesh.Colours.size() >= (size_t)count * 4 && count > 0;
+					if (hasColours)
+					{
+						BeginLayerElement("LayerElementColor", "ByVertice", "Direct");
+						Widen(submesh.Colours, count, 4, 4, buffer);
+						DoubleArrayNode("Colors", buffer);
+						writer.EndNode();
+					}
+
+					bool hasUV = submesh.UV0.size() >= (size_t)count * 2 && count > 0;
+					if (hasUV)
+					{
+						BeginLayerElement("LayerElementUV", "ByVertice", "Direct");
+						Widen(submesh.UV0, count, 2, 2, buffer);
+						DoubleArrayNode("UV", buffer);
+						writer.EndNode();
+					}
+
+					if (submesh.Material >= 0)
+					{
+						BeginLayerElement("LayerElementMaterial", "AllSame", "IndexToDirect");
+						int materialIndex = 0;
+						writer.BeginNode("Materials");
+						writer.AddArray(&materialIndex, 1);
+						writer.EndNode();
+						writer.EndNode();
+					}
+
+					writer.BeginNode("Layer");
+					writer.AddInt32(0);
+					Int32Node("Version", 100);
+					LayerEntry("LayerElementNormal");
+					LayerEntry("LayerElementTangent");
+					if (hasColours)
+					{
+						LayerEntry("LayerElementColor");
+					}
+					if (hasUV)
+					{
+						LayerEntry("LayerElementUV");
+					}
+					if (submesh.Material >= 0)
+					{
+						LayerEntry("LayerElementMaterial");
+					}
+					writer.EndNode();
+					writer.EndNode();
+
+					if (submesh.Material >= 0)
+					{
+						if (materialIds[submesh.Material] == -1)
+						{
+							materialIds[submesh.Material] = NewId();
+						}
+						Connect(materialIds[submesh.Material], modelId);
+					}
+
+					WriteSkin(mesh, submesh, meshMatrix, geometryId);
+					for (size_t m = 0; m < morphs.size(); m++)
+					{
+						WriteMorph(*morphs[m], count, geometryId);
+					}
+				}
+			}
+		}
+
+		void WriteSkin(const SceneMesh& mesh, const SceneSubmesh& submesh, const SceneMatrix& meshMatrix, long long geometryId)
+		{
+			if (mesh.Bones.empty())
+			{
+				return;
+			}
+			StageClock clock(stageSeconds, StageSkin, StageMesh);
+			BuildClusters(mesh, submesh);
+			if (clusters.empty())
+			{
+				return;
+			}
+
+			long long skinId = NewId();
+			Connect(skinId, geometryId);
+			BeginObject("Deformer", skinId, std::string(), "Deformer", "Skin");
+			Int32Node("Version", 101);
+			writer.BeginNode("Link_DeformAcuracy");
+			writer.AddDouble(50);
+			writer.EndNode();
+			writer.EndNode();
+
+			for (size_t k = 0; k < clusters.size(); k++)
+			{
+				const SceneCluster& cluster = clusters[k];
+				const SceneBone& bone = mesh.Bones[cluster.Bone];
+
+				SceneMatrix boneMatrix;
+				for (int m = 0; m < 4; m++)
+				{
+					for (int n = 0; n < 4; n++)
+					{
+						boneMatrix.m[m][n] = bone.Matrix[m * 4 + n];
+					}
+				}
+				//SetTransformMatrix(mesh) and SetTransformLink(mesh * bone^-1) as in the SDK path,
+				//the file stores Transform relative to the link, which leaves the bone matrix
+				SceneMatrix link = Multiply(meshMatrix, Inverse(boneMatrix));
+				SceneMatrix transform = Multiply(Inverse(link), meshMatrix);
+
+				long long clusterId = NewId();
+				Connect(clusterId, skinId);
+				Connect(frameIds[bone.Frame], clusterId);
+				BeginObject("Deformer", clusterId, scene.Frames[bone.Frame].Name + "Cluster", "SubDeformer", "Cluster");
+				Int32Node("Version", 100);
+				writer.BeginNode("UserData");
+				writer.AddString("");
+				writer.AddString("");
+				writer.EndNode();
+				IntArrayNode("Indexes", cluster.Indices);
+				DoubleArrayNode("Weights", cluster.Weights);
+				MatrixNode("Transform", transform);
+				MatrixNode("TransformLink", link);
+				writer.EndNode();
+			}
+		}
+
+		void WriteMorph(const SceneMorph& morph, int vertexCount, long long geometryId)
+		{
+			StageClock clock(stageSeconds, StageMorphs, StageMesh);
+			std::vector<int> indices;
+			std::vector<double> deltas;
+			std::vector<double> normals;
+			std::vector<double> fullWeights;
+
+			long long blendShapeId = NewId();
+			Connect(blendShapeId, geometryId);
+			BeginObject("Deformer", blendShapeId, morph.Name, "Deformer", "BlendShape");
+			Int32Node("Version", 100);
+			writer.EndNode();
+
+			for (size_t c = 0; c < morph.Channels.size(); c++)
+			{
+				const SceneBlendChannel& channel = morph.Channels[c];
+				long long channelId = NewId();
+				Connect(channelId, blendShapeId);
+
+				fullWeights.resize(channel.Shapes.size());
+				for (size_t s = 0; s < channel.Shapes.size(); s++)
+				{
+					fullWeights[s] = morph.WeightProperties ? 100 : channel.Shapes[s].Weight;
+				}
+				BeginObject("Deformer", channelId, channel.Name, "SubDeformer", "BlendShapeChannel");
+				Int32Node("Version", 100);
+				writer.BeginNode("DeformPercent");
+				writer.AddDouble(channel.DeformPercent);
+				writer.EndNode();
+				DoubleArrayNode("FullWeights", fullWeights);
+				writer.EndNode();
+
+				for (size_t s = 0; s < channel.Shapes.size(); s++)
+				{
+					const SceneShape& shape = channel.Shapes[s];
+					indices.clear();
+					deltas.clear();
+					for (size_t k = 0; k < shape.Indices.size() && k * 3 + 2 < shape.Deltas.size(); k++)
+					{
+						if (shape.Indices[k] < 0 || shape.Indices[k] >= vertexCount)
+						{
+							continue;
+						}
+						indices.push_back(shape.Indices[k]);
+						deltas.push_back(shape.Deltas[k * 3]);
+						deltas.push_back(shape.Deltas[k * 3 + 1]);
+						deltas.push_back(shape.Deltas[k * 3 + 2]);
+					}
+					normals.assign(deltas.size(), 0);
+
+					long long shapeId = NewId();
+					Connect(shapeId, channelId);
+					BeginObject("Geometry", shapeId, shape.Name, "Geometry", "Shape");
+					Int32Node("Version", 100);
+					IntArrayNode("Indexes", indices);
+					DoubleArrayNode("Vertices", deltas);
+					DoubleArrayNode("Normals", normals);
+					writer.EndNode();
+				}
+			}
+		}
+
+		void WriteMaterials()
+		{
+			static const char* destProperties[4] = { "DiffuseColor", "NormalMap", "SpecularColor", "Bump" };
+
+			for (size_t i = 0; i < scene.Textures.size(); i++)
+			{
+				if (textureIds[i] == 0)
+				{
+					continue;
+				}
+				const SceneTexture& texture = scene.Textures[i];
+				const SceneMaterialTexture* link = textureLinks[i];
+				textureIds[i] = NewId();
+
+				BeginObject("Texture", textureIds[i], texture.Name, "Texture", "");
+				StringNode("Type", "TextureVideoClip");
+				Int32Node("Version", 202);
+				StringNode("TextureName", ObjectName(texture.Name, "Texture"));
+				writer.BeginNode("Properties70");
+				BeginP("UseMaterial", "bool", "", "");
+				writer.AddInt32(1);
+				writer.EndNode();
+				PTriple("Translation", "Vector", "", link->Offset[0], link->Offset[1], 0);
+				PTriple("Scaling", "Vector", "", link->Scale[0], link->Scale[1], 1);
+				writer.EndNode();
+				StringNode("FileName", texture.FileName);
+				StringNode("RelativeFilename", texture.RelativeFileName);
+				writer.EndNode();
+			}
+
+			for (size_t i = 0; i < scene.Materials.size(); i++)
+			{
+				if (materialIds[i] == 0)
+				{
+					continue;
+				}
+				const SceneMaterial& material = scene.Materials[i];
+
+				BeginObject("Material", materialIds[i], material.Name, "Material", "");
+				Int32Node("Version", 102);
+				StringNode("ShadingModel", "phong");
+				Int32Node("MultiLayer", 0);
+				writer.BeginNode("Properties70");
+				PString("ShadingModel", "Phong");
+				PTriple("DiffuseColor", "Color", "", material.Diffuse[0], material.Diffuse[1], material.Diffuse[2]);
+				PNumber("DiffuseFactor", material.Diffuse[3]);
+				PTriple("AmbientColor", "Color", "", material.Ambient[0], material.Ambient[1], material.Ambient[2]);
+				PNumber("AmbientFactor", material.Ambient[3]);
+				PTriple("EmissiveColor", "Color", "", material.Emissive[0], material.Emissive[1], material.Emissive[2]);
+				PNumber("EmissiveFactor", material.Emissive[3]);
+				PTriple("SpecularColor", "Color", "", material.Specular[0], material.Specular[1], material.Specular[2]);
+				PNumber("SpecularFactor", material.Specular[3]);
+				PTriple("ReflectionColor", "Color", "", material.Reflection[0], material.Reflection[1], material.Reflection[2]);
+				PNumber("ReflectionFactor", material.Reflection[3]);
+				PNumber("Shininess", material.Shininess);
+				PNumber("ShininessExponent", material.Shininess);
+				PNumber("TransparencyFactor", material.Transparency);
+				writer.EndNode();
+				writer.EndNode();
+
+				for (size_t k = 0; k < material.Textures.size(); k++)
+				{
+					const SceneMaterialTexture& link = material.Textures[k];
+					if (link.Texture >= 0 && link.Dest >= 0 && link.Dest <= 3)
+					{
+						Connect(textureIds[link.Texture], materialIds[i], destProperties[link.Dest]);
+					}
+				}
+			}
+		}
+
+		void WriteCurve(const SceneCurve& curve, int component, long long curveNodeId, const char* property)
+		{
+			//the SDK keeps keys sorted and KeyAdd on an existing time overwrites it, so the last value wins
+			size_t count = curve.Times.size();
+			std::vector<size_t> order(count);
+			for (size_t k = 0; k < count; k++)
+			{
+				order[k] = k;
+			}
+			std::stable_sort(order.begin(), order.end(), [&curve](size_t a, size_t b) { return ToKTime(curve.Times[a]) < ToKTime(curve.Times[b]); });
+
+			std::vector<long long> times;
+			std::vector<float> values;
+			times.reserve(count);
+			values.reserve(count);
+			for (size_t k = 0; k < count; k++)
+			{
+				long long time = ToKTime(curve.Times[order[k]]);
+				float value = curve.Values[order[k] * 3 + component];
+				if (!times.empty() && times.back() == time)
+				{
+					values.back() = value;
+				}
+				else
+				{
+					times.push_back(time);
+					values.push_back(value);
+				}
+			}
+
+			long long curveId = NewId();
+			Connect(curveId, curveNodeId, property);
+			BeginObject("AnimationCurve", curveId, std::string(), "AnimCurve", "");
+			writer.BeginNode("Default");
+			writer.AddDouble(values[0]);
+			writer.EndNode();
+			Int32Node("KeyVer", 4009);
+			writer.BeginNode("KeyTime");
+			writer.AddArray(&times[0], times.size());
+			writer.EndNode();
+			writer.BeginNode("KeyValueFloat");
+			writer.AddArray(&values[0], values.size());
+			writer.EndNode();
+			//cubic interpolation with auto tangents, the KeySet defaults, or linear for a reduced curve like AddCurveKeys
+			int flags = curve.Linear ? 0x00000004 : 0x00000108;
+			writer.BeginNode("KeyAttrFlags");
+			writer.AddArray(&flags, 1);
+			writer.EndNode();
+			float data[4] = { 0, 0, 0, 0 };
+			int weights = 0x0d050d05; //right and next-left tangent weights of 0.3333, packed as by the SDK
+			memcpy(&data[2], &weights, 4);
+			writer.BeginNode("KeyAttrDataFloat");
+			writer.AddArray(data, 4);
+			writer.EndNode();
+			int refCount = (int)times.size();
+			writer.BeginNode("KeyAttrRefCount");
+			writer.AddArray(&refCount, 1);
+			writer.EndNode();
+			writer.EndNode();
+		}
+
+		void WriteAnimations()
+		{
+			static const char* nodeNames[3] = { "S", "R", "T" };
+			static const char* nodeProperties[3] = { "Lcl Scaling", "Lcl Rotation", "Lcl Translation" };
+
+			for (size_t i = 0; i < scene.Clips.size(); i++)
+			{
+				const SceneClip& clip = scene.Clips[i];
+				long long stackId = NewId();
+				long long layerId = NewId();
+				Connect(layerId, stackId);
+
+				BeginObject("AnimationStack", stackId, clip.Name, "AnimStack", "");
+				writer.BeginNode("Properties70");
+				PTime("LocalStart", clipStart[i]);
+				PTime("LocalStop", clipStop[i]);
+				PTime("ReferenceStart", clipStart[i]);
+				PTime("ReferenceStop", clipStop[i]);
+				writer.EndNode();
+				writer.EndNode();
+
+				BeginObject("AnimationLayer", layerId, "Base Layer", "AnimLayer", "");
+				writer.EndNode();
+
+				for (size_t j = 0; j < clip.Tracks.size(); j++)
+				{
+					const SceneTrack& track = clip.Tracks[j];
+					if (track.Frame < 0)
+					{
+						continue;
+					}
+					const SceneCurve* curves[3] = { &track.Scalings, &track.Rotations, &track.Translations };
+					for (int c = 0; c < 3; c++)
+					{
+						const SceneCurve& curve = *curves[c];
+						if (!HasKeys(curve))
+						{
+							continue;
+						}
+
+						long long curveNodeId = NewId();
+						Connect(curveNodeId, layerId);
+						Connect(curveNodeId, frameIds[track.Frame], nodeProperties[c]);
+						BeginObject("AnimationCurveNode", curveNodeId, nodeNames[c], "AnimCurveNode", "");
+						writer.BeginNode("Properties70");
+						PNumber("d|X", curve.Values[0]);
+						PNumber("d|Y", curve.Values[1]);
+						PNumber("d|Z", curve.Values[2]);
+						writer.EndNode();
+						writer.EndNode();
+
+						WriteCurve(curve, 0, curveNodeId, "d|X");
+						WriteCurve(curve, 1, curveNodeId, "d|Y");
+						WriteCurve(curve, 2, curveNodeId, "d|Z");
+					}
+				}
+			}
+		}
+
+		void WriteConnections()
+		{
+			writer.BeginNode("Connections");
+			for (size_t i = 0; i < connections.size(); i++)
+			{
+				const SceneConnection& connection = connections[i];
+				writer.BeginNode("C");
+				writer.AddString(connection.Property != NULL ? "OP" : "OO");
+				writer.AddInt64(connection.Child);
+				writer.AddInt64(connection.Parent);
+				if (connection.Property != NULL)
+				{
+					writer.AddString(connection.Property);
+				}
+				writer.EndNode();
+			}
+			writer.EndNode();
+		}
+
+		void WriteTakes()
+		{
+			writer.BeginNode("Takes");
+			StringNode("Current", "");
+			for (size_t i = 0; i < scene.Clips.size(); i++)
+			{
+				writer.BeginNode("Take");
+				writer.AddString(scene.Clips[i].Name);
+				StringNode("FileName", scene.Clips[i].Name + ".tak");
+				writer.BeginNode("LocalTime");
+				writer.AddInt64(clipStart[i]);
+				writer.AddInt64(clipStop[i]);
+				writer.EndNode();
+				writer.BeginNode("ReferenceTime");
+				writer.AddInt64(clipStart[i]);
+				writer.AddInt64(clipStop[i]);
+				writer.EndNode();
+				writer.EndNode();
+			}
+			writer.EndNode();
+		}
+	};
+
+	SceneWriteStats WriteBinaryFbx(const Scene& scene, const char* path, int version, bool compress)
+	{
+		if (version != 7400 && version != 7500)
+		{
+			throw std::runtime_error("Unsupported FBX version");
+		}
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		SceneWriteStats stats;
+		std::fill(stats.StageSeconds, stats.StageSeconds + SceneStageCount, 0.0);
+		FbxBinaryWriter writer(path, version, compress);
+		SceneWriter sceneWriter(scene, writer, stats.StageSeconds);
+		stats.Objects = sceneWriter.Write();
+		writer.Finish(FooterId);
+		stats.FileBytes = writer.BytesWritten();
+		stats.ArrayBytes = writer.ArrayBytes();
+		stats.CompressedArrayBytes = writer.CompressedArrayBytes();
+
+		//whatever the sections did not account for is serialization
+		double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		for (int i = 0; i < StageSerialization; i++)
+		{
+			total -= stats.StageSeconds[i];
+		}
+		stats.StageSeconds[StageSerialization] = std::max(total, 0.0);
+		return stats;
+	}
+
+	const char* SceneStageName(SceneStage stage)
+	{
+		static const char* names[SceneStageCount] = { "hierarchy", "mesh", "skin", "materials", "morphs", "animation", "serialization" };
+		return stage >= 0 && stage < SceneStageCount ? names[stage] : "unknown";
+	}
+}
@@ -0,0 +1,59 @@
+#include <fbxsdk.h>
+#include <fbxsdk/fileio/fbxiosettings.h>
+#include "AssetStudioFBX.h"
+
+using namespace System::Diagnostics;
+
+namespace AssetStudio
+{
+	Fbx::Session::Session()
+	{
+		pSdkManager = NULL;
+		pScene = NULL;
+		exports = 0;
+		warmStartup = TimeSpan::Zero;
+
+		Stopwatch^ stopwatch = Stopwatch::StartNew();
+		FbxManager* pManager = NULL;
+		FbxScene* pNewScene = NULL;
+		Init(&pManager, &pNewScene);
+		InitExportSettings(pManager);
+		pSdkManager = pManager;
+		pScene = pNewScene;
+		coldStartup = stopwatch->Elapsed;
+	}
+
+	Fbx::Session::~Session()
+	{
+		this->!Session();
+	}
+
+	Fbx::Session::!Session()
+	{
+		if (pScene != NULL)
+		{
+			pScene->Destroy();
+			pScene = NULL;
+		}
+		if (pSdkManager != NULL)
+		{
+			pSdkManager->Destroy();
+			pSdkManager = NULL;
+		}
+	}
+
+	ExportStatistics^ Fbx::Session::Export(String^ path, IImported^ imported, FbxExportOptions^ options)
+	{
+		if (pSdkManager == NULL)
+		{
+			throw gcnew ObjectDisposedException("Fbx::Session");
+		}
+		ExportStatistics^ statistics = Exporter::Export(path, imported, options, this);
+		TimeSpan startup;
+		statistics->StageTimes->TryGetValue("Startup", startup);
+		exports++;
+		warmStartup += startup;
+		Logger::Debug(String::Format("{0}: startup {1:F2} ms warm, a cold export adds {2:F2} ms", Path::GetFileName(path), startup.TotalMilliseconds, coldStartup.TotalMilliseconds));
+		return statistics;
+	}
+}
@@ -0,0 +1,94 @@
+#include <fbxsdk.h>
+#include <vcclr.h>
+#include "AssetStudioFBX.h"
+
+namespace AssetStudio
+{
+	static const int ArenaBlockSize = 64 * 1024;
+
+	String^ Utf8ToString(const char* s)
+	{
+		if (s == NULL || *s == 0)
+		{
+			return String::Empty;
+		}
+		int length = (int)strlen(s);
+		return Text::Encoding::UTF8->GetString((Byte*)s, length);
+	}
+
+	StringArena::StringArena()
+	{
+		strings = gcnew Dictionary<String^, IntPtr>();
+		pBlocks = new std::vector<char*>();
+		pNext = NULL;
+		remaining = 0;
+		bytes = 0;
+	}
+
+	StringArena::~StringArena()
+	{
+		this->!StringArena();
+	}
+
+	StringArena::!StringArena()
+	{
+		if (pBlocks != NULL)
+		{
+			for (size_t i = 0; i < pBlocks->size(); i++)
+			{
+				delete[] (*pBlocks)[i];
+			}
+			delete pBlocks;
+			pBlocks = NULL;
+		}
+		pNext = NULL;
+		remaining = 0;
+	}
+
+	char* StringArena::Allocate(int size)
+	{
+		if (size > ArenaBlockSize / 4)
+		{
+			//long strings get a block of their own and leave the current one open
+			char* pBlock = new char[size];
+			pBlocks->push_back(pBlock);
+			return pBlock;
+		}
+		if (size > remaining)
+		{
+			pNext = new char[ArenaBlockSize];
+			pBlocks->push_back(pNext);
+			remaining = ArenaBlockSize;
+		}
+		char* p = pNext;
+		pNext += size;
+		remaining -= size;
+		return p;
+	}
+
+	const char* StringArena::Intern(String^ s)
+	{
+		if (s == nullptr)
+		{
+			s = String::Empty;
+		}
+		IntPtr found;
+		if (strings->TryGetValue(s, found))
+		{
+			return (const char*)found.ToPointer();
+		}
+
+		Text::Encoding^ utf8 = Text::Encoding::UTF8;
+		int length = utf8->GetByteCount(s);
+		char* p = Allocate(length + 1);
+		if (length > 0)
+		{
+			pin_ptr<const wchar_t> pChars = PtrToStringChars(s);
+			utf8->GetBytes((wchar_t*)pChars, s->Length, (Byte*)p, length);
+		}
+		p[length] = 0;
+		strings->Add(s, (IntPtr)p);
+		bytes += length + 1;
+		return p;
+	}
+}
@@ -0,0 +1,157 @@
+#include <fbxsdk.h>
+#include "AssetStudioFBX.h"
+
+using namespace System::Diagnostics;
+
+namespace AssetStudio
+{
+	TextureWriter::TextureWriter(int capacity, int threadCount)
+	{
+		queue = gcnew BlockingCollection<KeyValuePair<String^, array<Byte>^>>(capacity);
+		error = nullptr;
+		filesWritten = 0;
+		filesSkipped = 0;
+		bytesWritten = 0;
+		stallTime = TimeSpan::Zero;
+		files = gcnew ConcurrentQueue<String^>();
+
+		threads = gcnew array<Thread^>(threadCount);
+		for (int i = 0; i < threadCount; i++)
+		{
+			threads[i] = gcnew Thread(gcnew ThreadStart(this, &TextureWriter::Run));
+			threads[i]->IsBackground = true;
+			threads[i]->Start();
+		}
+	}
+
+	TextureWriter::~TextureWriter()
+	{
+		Join();
+	}
+
+	void TextureWriter::Enqueue(String^ path, array<Byte>^ data)
+	{
+		KeyValuePair<String^, array<Byte>^> item(path, data);
+		if (!queue->TryAdd(item))
+		{
+			//queue is full, block the exporter until an I/O thread catches up
+			Stopwatch^ stall = Stopwatch::StartNew();
+			queue->Add(item);
+			stallTime += stall->Elapsed;
+		}
+	}
+
+	void TextureWriter::Drain()
+	{
+		Join();
+		if (error != nullptr)
+		{
+			throw gcnew Exception("Failed to write texture", error);
+		}
+	}
+
+	void TextureWriter::Join()
+	{
+		if (!queue->IsAddingCompleted)
+		{
+			queue->CompleteAdding();
+		}
+		for (int i = 0; i < threads->Length; i++)
+		{
+			threads[i]->Join();
+		}
+	}
+
+	static bool SameContent(FileInfo^ file, array<Byte>^ data)
+	{
+		if (!file->Exists || file->Length != data->Length)
+		{
+			return false;
+		}
+		array<Byte>^ existing;
+		try
+		{
+			existing = File::ReadAllBytes(file->FullName);
+		}
+		catch (IOException^)
+		{
+			//another export is replacing the file, writing it again is safe
+			return false;
+		}
+		if (data->Length == 0)
+		{
+			return true;
+		}
+		pin_ptr<Byte> pExisting = &existing[0];
+		pin_ptr<Byte> pData = &data[0];
+		return memcmp(pExisting, pData, data->Length) == 0;
+	}
+
+	//Renames temp over path. Other writers exporting into the same folder may create, replace or read path in between,
+	//so a failed attempt is retried, the last rename wins like a plain write would.
+	static void MoveIntoPlace(String^ temp, String^ path)
+	{
+		for (int attempt = 0; ; attempt++)
+		{
+			try
+			{
+				if (File::Exists(path))
+				{
+					File::Replace(temp, path, nullptr, true);
+				}
+				else
+				{
+					File::Move(temp, path);
+				}
+				return;
+			}
+			catch (IOException^)
+			{
+				if (attempt >= 4)
+				{
+					throw;
+				}
+				Thread::Sleep(10 << attempt);
+			}
+		}
+	}
+
+	void TextureWriter::Run()
+	{
+		for each (KeyValuePair<String^, array<Byte>^> item in queue->GetConsumingEnumerable())
+		{
+			try
+			{
+				//an unchanged file keeps its timestamp, so repeated exports into the same folder do not touch it
+				if (item.Value != nullptr && SameContent(gcnew FileInfo(item.Key), item.Value))
+				{
+					Interlocked::Increment(filesSkipped);
+					files->Enqueue(item.Key);
+					continue;
+				}
+				Directory::CreateDirectory(Path::GetDirectoryName(item.Key));
+				//exports sharing an output folder can write the same texture at the same time, none of them may see a partial file
+				String^ temp = item.Key + "." + Guid::NewGuid().ToString("N") + ".part";
+				try
+				{
+					File::WriteAllBytes(temp, item.Value);
+					MoveIntoPlace(temp, item.Key);
+				}
+				finally
+				{
+					if (File::Exists(temp))
+					{
+						File::Delete(temp);
+					}
+				}
+				Interlocked::Increment(filesWritten);
+				files->Enqueue(item.Key);
+				Interlocked::Add(bytesWritten, (Int64)item.Value->Length);
+			}
+			catch (Exception^ e)
+			{
+				Interlocked::CompareExchange<Exception^>(error, e, nullptr);
+			}
+		}
+	}
+}
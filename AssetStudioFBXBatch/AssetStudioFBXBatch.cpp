@@ -0,0 +1,744 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "AssetStudioFBXHash.h"
+#include "AssetStudioFBXScene.h"
+#include "AssetStudioFBXBatchJournal.h"
+#include "AssetStudioFBXBatchPool.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#define FBX_STAT _stat64
+#define FBX_STAT_STRUCT struct _stat64
+#define FBX_MKDIR(path) _mkdir(path)
+#else
+#define FBX_STAT stat
+#define FBX_STAT_STRUCT struct stat
+#define FBX_MKDIR(path) mkdir(path, 0777)
+#endif
+
+using namespace AssetStudio;
+
+enum BatchFormat
+{
+	FormatFbx,
+	FormatGlb
+};
+
+//Export options of a job, set by the manifest lines before it
+struct BatchOptions
+{
+	BatchFormat Format;
+	int Version; //7400 or 7500
+	bool Compress;
+	bool Optimize;
+	double WeldTolerance; //negative only reorders for the vertex cache
+};
+
+struct BatchJob
+{
+	std::string Snapshot;
+	std::string Output;
+	BatchOptions Options;
+	int Line;
+	long long Bytes; //of the snapshot, larger jobs are started first
+	std::string Key; //changes with the paths, the options and the snapshot file
+};
+
+struct DriverOptions
+{
+	std::string Manifest;
+	std::string Journal;
+	int Threads;
+	int SplitVertices;
+	bool Restart;
+};
+
+static void Usage()
+{
+	fprintf(stderr, "Usage: AssetStudioFBXBatch <manifest> [options]\n");
+	fprintf(stderr, "  --threads <count>, defaults to one per hardware thread\n");
+	fprintf(stderr, "  --split-vertices <count>, vertices per mesh optimisation task, defaults to 65536\n");
+	fprintf(stderr, "  --journal <file>, defaults to <manifest>.journal\n");
+	fprintf(stderr, "  --restart, ignore the journal of an earlier run\n\n");
+	fprintf(stderr, "Manifest lines, options apply to the jobs after them:\n");
+	fprintf(stderr, "  format fbx|glb\n  version 7400|7500\n  compress on|off\n  optimize on|off\n  weld <tolerance>, negative disables welding\n");
+	fprintf(stderr, "  job <snapshot> <output>\n");
+	fprintf(stderr, "Relative paths are resolved against the manifest directory, paths with spaces are quoted, # starts a comment.\n");
+}
+
+static bool ParseOptions(int argc, char* argv[], DriverOptions& options)
+{
+	options.Threads = 0;
+	options.SplitVertices = 65536;
+	options.Restart = false;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			options.Threads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--split-vertices") == 0 && i + 1 < argc)
+		{
+			options.SplitVertices = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc)
+		{
+			options.Journal = argv[++i];
+		}
+		else if (strcmp(argv[i], "--restart") == 0)
+		{
+			options.Restart = true;
+		}
+		else if (argv[i][0] != '-' && options.Manifest.empty())
+		{
+			options.Manifest = argv[i];
+		}
+		else
+		{
+			return false;
+		}
+	}
+	if (options.Journal.empty())
+	{
+		options.Journal = options.Manifest + ".journal";
+	}
+	options.SplitVertices = std::max(options.SplitVertices, 1);
+	return !options.Manifest.empty();
+}
+
+static double Seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool IsSeparator(char c)
+{
+#ifdef _WIN32
+	return c == '/' || c == '\\';
+#else
+	return c == '/';
+#endif
+}
+
+static bool IsAbsolute(const std::string& path)
+{
+	if (!path.empty() && IsSeparator(path[0]))
+	{
+		return true;
+	}
+#ifdef _WIN32
+	return path.size() > 1 && path[1] == ':';
+#else
+	return false;
+#endif
+}
+
+static std::string DirectoryOf(const std::string& path)
+{
+	for (size_t i = path.size(); i-- > 0;)
+	{
+		if (IsSeparator(path[i]))
+		{
+			return path.substr(0, i + 1);
+		}
+	}
+	return std::string();
+}
+
+static std::string Combine(const std::string& directory, const std::string& path)
+{
+	return directory.empty() || IsAbsolute(path) ? path : directory + path;
+}
+
+static bool Stat(const std::string& path, FBX_STAT_STRUCT& info)
+{
+	return FBX_STAT(path.c_str(), &info) == 0;
+}
+
+static void CreateDirectories(const std::string& directory)
+{
+	for (size_t i = 1; i <= directory.size(); i++)
+	{
+		if (i == directory.size() || IsSeparator(directory[i]))
+		{
+			std::string parent = directory.substr(0, i);
+			FBX_STAT_STRUCT info;
+			if (!Stat(parent, info) && FBX_MKDIR(parent.c_str()) != 0 && !Stat(parent, info))
+			{
+				throw std::runtime_error("Failed to create " + parent);
+			}
+		}
+	}
+}
+
+//Moves a finished temporary file over target, readers of target never see a partly written file
+static void ReplaceFile(const std::string& source, const std::string& target)
+{
+#ifdef _WIN32
+	remove(target.c_str());
+#endif
+	if (rename(source.c_str(), target.c_str()) != 0)
+	{
+		remove(source.c_str());
+		throw std::runtime_error("Failed to move " + source + " to " + target);
+	}
+}
+
+static void CopyFileTo(const std::string& source, const std::string& target, const std::string& temporary)
+{
+	FILE* input = fopen(source.c_str(), "rb");
+	if (input == NULL)
+	{
+		throw std::runtime_error("Failed to open " + source);
+	}
+	FILE* output = fopen(temporary.c_str(), "wb");
+	if (output == NULL)
+	{
+		fclose(input);
+		throw std::runtime_error("Failed to open " + temporary);
+	}
+	std::vector<char> buffer(1 << 20);
+	size_t read;
+	bool failed = false;
+	while (!failed && (read = fread(buffer.data(), 1, buffer.size(), input)) > 0)
+	{
+		failed = fwrite(buffer.data(), 1, read, output) != read;
+	}
+	failed |= ferror(input) != 0;
+	fclose(input);
+	failed |= fclose(output) != 0;
+	if (failed)
+	{
+		remove(temporary.c_str());
+		throw std::runtime_error("Failed to copy " + source);
+	}
+	ReplaceFile(temporary, target);
+}
+
+//Splits a manifest line into words, double quotes group words with spaces and # outside quotes ends the line
+static std::vector<std::string> Tokenize(const std::string& line)
+{
+	std::vector<std::string> tokens;
+	size_t i = 0;
+	while (i < line.size())
+	{
+		while (i < line.size() && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r'))
+		{
+			i++;
+		}
+		if (i == line.size() || line[i] == '#')
+		{
+			break;
+		}
+		std::string token;
+		if (line[i] == '"')
+		{
+			size_t end = line.find('"', i + 1);
+			if (end == std::string::npos)
+			{
+				throw std::runtime_error("unterminated quote");
+			}
+			token = line.substr(i + 1, end - i - 1);
+			i = end + 1;
+		}
+		else
+		{
+			while (i < line.size() && line[i] != ' ' && line[i] != '\t' && line[i] != '\r')
+			{
+				token.push_back(line[i++]);
+			}
+		}
+		tokens.push_back(token);
+	}
+	return tokens;
+}
+
+static bool ParseSwitch(const std::string& value)
+{
+	if (value == "on")
+	{
+		return true;
+	}
+	if (value == "off")
+	{
+		return false;
+	}
+	throw std::runtime_error("expected on or off, found " + value);
+}
+
+static std::string JobKey(const BatchJob& job, const FBX_STAT_STRUCT& info)
+{
+	unsigned long long hash = HashBytes(job.Snapshot.data(), job.Snapshot.size() + 1);
+	hash = HashBytes(job.Output.data(), job.Output.size() + 1, hash);
+	hash = HashBytes(&job.Options.Format, sizeof(job.Options.Format), hash);
+	hash = HashBytes(&job.Options.Version, sizeof(job.Options.Version), hash);
+	hash = HashBytes(&job.Options.Compress, sizeof(job.Options.Compress), hash);
+	hash = HashBytes(&job.Options.Optimize, sizeof(job.Options.Optimize), hash);
+	hash = HashBytes(&job.Options.WeldTolerance, sizeof(job.Options.WeldTolerance), hash);
+	long long size = (long long)info.st_size;
+	long long modified = (long long)info.st_mtime;
+	hash = HashBytes(&size, sizeof(size), hash);
+	hash = HashBytes(&modified, sizeof(modified), hash);
+	char key[17];
+	snprintf(key, sizeof(key), "%016llx", hash);
+	return key;
+}
+
+//Throws std::runtime_error with the line number on the first error, every snapshot must exist
+static std::vector<BatchJob> ReadManifest(const std::string& path)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == NULL)
+	{
+		throw std::runtime_error("Failed to open " + path);
+	}
+	std::string directory = DirectoryOf(path);
+	BatchOptions options = { FormatFbx, 7500, true, false, -1 };
+	std::vector<BatchJob> jobs;
+	std::set<std::string> outputs;
+	std::string line;
+	int lineNumber = 0;
+	bool more = true;
+	while (more)
+	{
+		line.clear();
+		int c;
+		while ((c = fgetc(file)) != EOF && c != '\n')
+		{
+			line.push_back((char)c);
+		}
+		more = c != EOF;
+		lineNumber++;
+		try
+		{
+			std::vector<std::string> tokens = Tokenize(line);
+			if (tokens.empty())
+			{
+				continue;
+			}
+			const std::string& command = tokens[0];
+			if (tokens.size() != (command == "job" ? 3u : 2u))
+			{
+				throw std::runtime_error("wrong number of arguments for " + command);
+			}
+			if (command == "format")
+			{
+				if (tokens[1] != "fbx" && tokens[1] != "glb")
+				{
+					throw std::runtime_error("unknown format " + tokens[1]);
+				}
+				options.Format = tokens[1] == "glb" ? FormatGlb : FormatFbx;
+			}
+			else if (command == "version")
+			{
+				options.Version = atoi(tokens[1].c_str());
+				if (options.Version != 7400 && options.Version != 7500)
+				{
+					throw std::runtime_error("version must be 7400 or 7500");
+				}
+			}
+			else if (command == "compress")
+			{
+				options.Compress = ParseSwitch(tokens[1]);
+			}
+			else if (command == "optimize")
+			{
+				options.Optimize = ParseSwitch(tokens[1]);
+			}
+			else if (command == "weld")
+			{
+				options.WeldTolerance = atof(tokens[1].c_str());
+			}
+			else if (command == "job")
+			{
+				BatchJob job;
+				job.Snapshot = Combine(directory, tokens[1]);
+				job.Output = Combine(directory, tokens[2]);
+				job.Options = options;
+				job.Line = lineNumber;
+				FBX_STAT_STRUCT info;
+				if (!Stat(job.Snapshot, info))
+				{
+					throw std::runtime_error("snapshot " + job.Snapshot + " does not exist");
+				}
+				if (!outputs.insert(job.Output).second)
+				{
+					throw std::runtime_error("output " + job.Output + " is written by an earlier job");
+				}
+				job.Bytes = (long long)info.st_size;
+				job.Key = JobKey(job, info);
+				jobs.push_back(job);
+			}
+			else
+			{
+				throw std::runtime_error("unknown command " + command);
+			}
+		}
+		catch (const std::runtime_error& e)
+		{
+			fclose(file);
+			throw std::runtime_error(path + "(" + std::to_string(lineNumber) + "): " + e.what());
+		}
+	}
+	fclose(file);
+	return jobs;
+}
+
+//Shared by every stage of every job
+struct BatchRun
+{
+	TaskPool* Pool;
+	BatchJournal* Journal;
+	int SplitVertices;
+	int Total;
+	std::atomic<int> Finished;
+	std::atomic<int> Failed;
+	std::atomic<long long> Triangles;
+	std::atomic<long long> CacheMissesBefore;
+	std::atomic<long long> CacheMissesAfter;
+	std::mutex Output;
+};
+
+//One job in flight. Stages run as separate pool tasks, Pending counts the tasks of the current stage
+//and whichever task finishes last starts the next stage.
+struct JobRun
+{
+	const BatchJob* Job;
+	Scene Loaded;
+	std::atomic<int> Pending;
+	std::mutex Lock;
+	std::string Error;
+	SceneOptimizeStats Optimized;
+	std::chrono::steady_clock::time_point Start;
+};
+
+static void Fail(JobRun* run, const char* what)
+{
+	std::lock_guard<std::mutex> lock(run->Lock);
+	if (run->Error.empty())
+	{
+		run->Error = what;
+	}
+}
+
+static void FinishStage(BatchRun* batch, JobRun* run)
+{
+	const BatchJob& job = *run->Job;
+	if (run->Error.empty())
+	{
+		try
+		{
+			batch->Journal->MarkDone(job.Key, job.Output);
+		}
+		catch (const std::exception& e)
+		{
+			Fail(run, e.what());
+		}
+	}
+
+	int finished = ++batch->Finished;
+	{
+		std::lock_guard<std::mutex> lock(batch->Output);
+		if (run->Error.empty())
+		{
+			printf("[%d/%d] %s %.2f s", finished, batch->Total, job.Output.c_str(), Seconds(run->Start));
+			if (run->Optimized.Triangles > 0)
+			{
+				printf(", ACMR %.3f -> %.3f, %d vertices welded", (double)run->Optimized.CacheMissesBefore / run->Optimized.Triangles,
+					(double)run->Optimized.CacheMissesAfter / run->Optimized.Triangles, run->Optimized.WeldedVertices);
+			}
+			printf("\n");
+			fflush(stdout);
+		}
+		else
+		{
+			batch->Failed++;
+			fprintf(stderr, "[%d/%d] %s, manifest line %d, failed: %s\n", finished, batch->Total, job.Output.c_str(), job.Line, run->Error.c_str());
+		}
+	}
+	batch->Triangles += run->Optimized.Triangles;
+	batch->CacheMissesBefore += run->Optimized.CacheMissesBefore;
+	batch->CacheMissesAfter += run->Optimized.CacheMissesAfter;
+	delete run;
+}
+
+static void EndTask(BatchRun* batch, JobRun* run)
+{
+	if (--run->Pending == 0)
+	{
+		FinishStage(batch, run);
+	}
+}
+
+//A missing texture is reported but does not fail the job, the FBX exporter behaves the same when a texture cannot be written
+static void CopyTexturesStage(BatchRun* batch, JobRun* run)
+{
+	std::string sourceDirectory = DirectoryOf(run->Job->Snapshot);
+	int failed = 0;
+	std::string firstError;
+	for (size_t i = 0; i < run->Loaded.Textures.size(); i++)
+	{
+		const SceneTexture& texture = run->Loaded.Textures[i];
+		std::string source = Combine(sourceDirectory, texture.RelativeFileName);
+		if (source == texture.FileName)
+		{
+			continue;
+		}
+		try
+		{
+			//jobs sharing an output directory may copy the same texture at the same time
+			CopyFileTo(source, texture.FileName, texture.FileName + "." + run->Job->Key + ".part");
+		}
+		catch (const std::exception& e)
+		{
+			if (failed++ == 0)
+			{
+				firstError = e.what();
+			}
+		}
+	}
+	if (failed > 0)
+	{
+		std::lock_guard<std::mutex> lock(batch->Output);
+		fprintf(stderr, "%s: %d of %d textures not copied, %s\n", run->Job->Output.c_str(), failed, (int)run->Loaded.Textures.size(), firstError.c_str());
+	}
+	EndTask(batch, run);
+}
+
+static void WriteStage(BatchRun* batch, JobRun* run)
+{
+	const BatchJob& job = *run->Job;
+	try
+	{
+		CreateDirectories(DirectoryOf(job.Output));
+	}
+	catch (const std::exception& e)
+	{
+		Fail(run, e.what());
+		run->Pending = 1;
+		EndTask(batch, run);
+		return;
+	}
+	//the textures are copied by another worker while this one writes the scene
+	run->Pending = run->Loaded.Textures.empty() ? 1 : 2;
+	if (!run->Loaded.Textures.empty())
+	{
+		batch->Pool->Submit([batch, run] { CopyTexturesStage(batch, run); });
+	}
+
+	{
+		std::string temporary = job.Output + ".part";
+		try
+		{
+			if (job.Options.Format == FormatGlb)
+			{
+				WriteGlb(run->Loaded, temporary.c_str());
+			}
+			else
+			{
+				WriteBinaryFbx(run->Loaded, temporary.c_str(), job.Options.Version, job.Options.Compress);
+			}
+			ReplaceFile(temporary, job.Output);
+		}
+		catch (const std::exception& e)
+		{
+			remove(temporary.c_str());
+			Fail(run, e.what());
+		}
+	}
+	EndTask(batch, run);
+}
+
+static void OptimizeStage(BatchRun* batch, JobRun* run, std::vector<std::pair<int, int> > submeshes)
+{
+	SceneOptimizeStats total = SceneOptimizeStats();
+	try
+	{
+		for (size_t i = 0; i < submeshes.size(); i++)
+		{
+			SceneSubmesh& submesh = run->Loaded.Meshes[submeshes[i].first].Submeshes[submeshes[i].second];
+			SceneOptimizeStats stats = OptimizeSceneSubmesh(submesh, run->Job->Options.WeldTolerance);
+			total.Triangles += stats.Triangles;
+			total.CacheMissesBefore += stats.CacheMissesBefore;
+			total.CacheMissesAfter += stats.CacheMissesAfter;
+			total.WeldedVertices += stats.WeldedVertices;
+		}
+	}
+	catch (const std::exception& e)
+	{
+		Fail(run, e.what());
+	}
+	{
+		std::lock_guard<std::mutex> lock(run->Lock);
+		run->Optimized.Triangles += total.Triangles;
+		run->Optimized.CacheMissesBefore += total.CacheMissesBefore;
+		run->Optimized.CacheMissesAfter += total.CacheMissesAfter;
+		run->Optimized.WeldedVertices += total.WeldedVertices;
+	}
+	if (--run->Pending == 0)
+	{
+		if (run->Error.empty())
+		{
+			WriteStage(batch, run);
+		}
+		else
+		{
+			FinishStage(batch, run);
+		}
+	}
+}
+
+//Reads the snapshot and splits the mesh optimisation into tasks of about SplitVertices vertices,
+//so other workers can steal the submeshes of a large scene instead of waiting for one thread to get through it
+static void LoadStage(BatchRun* batch, JobRun* run)
+{
+	const BatchJob& job = *run->Job;
+	run->Start = std::chrono::steady_clock::now();
+	std::vector<std::vector<std::pair<int, int> > > groups;
+	try
+	{
+		ReadSceneSnapshot(job.Snapshot.c_str(), run->Loaded);
+		std::string outputDirectory = DirectoryOf(job.Output);
+		for (size_t i = 0; i < run->Loaded.Textures.size(); i++)
+		{
+			SceneTexture& texture = run->Loaded.Textures[i];
+			texture.FileName = Combine(outputDirectory, texture.RelativeFileName);
+		}
+
+		if (job.Options.Optimize)
+		{
+			//blend shapes index the vertices, the SDK exporter leaves morphed meshes alone as well
+			std::set<std::pair<int, int> > morphed;
+			for (size_t i = 0; i < run->Loaded.Morphs.size(); i++)
+			{
+				morphed.insert(std::make_pair(run->Loaded.Morphs[i].Mesh, run->Loaded.Morphs[i].Submesh));
+			}
+			int vertices = 0;
+			for (size_t i = 0; i < run->Loaded.Meshes.size(); i++)
+			{
+				for (size_t j = 0; j < run->Loaded.Meshes[i].Submeshes.size(); j++)
+				{
+					std::pair<int, int> submesh((int)i, (int)j);
+					if (morphed.count(submesh) != 0)
+					{
+						continue;
+					}
+					if (groups.empty() || vertices >= batch->SplitVertices)
+					{
+						groups.push_back(std::vector<std::pair<int, int> >());
+						vertices = 0;
+					}
+					groups.back().push_back(submesh);
+					vertices += run->Loaded.Meshes[i].Submeshes[j].VertexCount;
+				}
+			}
+		}
+	}
+	catch (const std::exception& e)
+	{
+		Fail(run, e.what());
+		run->Pending = 1;
+		EndTask(batch, run);
+		return;
+	}
+
+	if (groups.empty())
+	{
+		WriteStage(batch, run);
+		return;
+	}
+	run->Pending = (int)groups.size();
+	for (size_t i = 0; i < groups.size(); i++)
+	{
+		std::vector<std::pair<int, int> > group;
+		group.swap(groups[i]);
+		batch->Pool->Submit([batch, run, group] { OptimizeStage(batch, run, group); });
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	DriverOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		Usage();
+		return 2;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<BatchJob> jobs;
+	std::unique_ptr<BatchJournal> journal;
+	try
+	{
+		jobs = ReadManifest(options.Manifest);
+		journal.reset(new BatchJournal(options.Journal.c_str(), options.Restart));
+	}
+	catch (const std::exception& e)
+	{
+		fprintf(stderr, "%s\n", e.what());
+		return 2;
+	}
+
+	//a job counts as done only while its output is still there
+	std::vector<const BatchJob*> pending;
+	for (size_t i = 0; i < jobs.size(); i++)
+	{
+		FBX_STAT_STRUCT info;
+		if (!journal->IsDone(jobs[i].Key) || !Stat(jobs[i].Output, info))
+		{
+			pending.push_back(&jobs[i]);
+		}
+	}
+	//largest first, a big scene started last would leave the other workers idle at the end
+	std::stable_sort(pending.begin(), pending.end(), [](const BatchJob* a, const BatchJob* b) { return a->Bytes > b->Bytes; });
+
+	BatchRun batch;
+	batch.Journal = journal.get();
+	batch.SplitVertices = options.SplitVertices;
+	batch.Total = (int)pending.size();
+	batch.Finished = 0;
+	batch.Failed = 0;
+	batch.Triangles = 0;
+	batch.CacheMissesBefore = 0;
+	batch.CacheMissesAfter = 0;
+	int threads;
+	unsigned long long steals;
+	{
+		TaskPool pool(options.Threads);
+		batch.Pool = &pool;
+		threads = pool.Threads();
+		printf("%d jobs, %d already done, %d threads\n", (int)jobs.size(), (int)(jobs.size() - pending.size()), threads);
+		fflush(stdout);
+		for (size_t i = 0; i < pending.size(); i++)
+		{
+			JobRun* run = new JobRun();
+			run->Job = pending[i];
+			run->Pending = 0;
+			run->Optimized = SceneOptimizeStats();
+			pool.Submit([&batch, run] { LoadStage(&batch, run); });
+		}
+		pool.Wait();
+		steals = pool.Steals();
+	}
+
+	printf("%d exported, %d failed, %d skipped in %.2f s, %llu tasks stolen", batch.Total - (int)batch.Failed, (int)batch.Failed,
+		(int)(jobs.size() - pending.size()), Seconds(start), steals);
+	if (batch.Triangles > 0)
+	{
+		printf(", ACMR %.3f -> %.3f", (double)batch.CacheMissesBefore / batch.Triangles, (double)batch.CacheMissesAfter / batch.Triangles);
+	}
+	printf("\n");
+	return batch.Failed > 0 ? 1 : 0;
+}
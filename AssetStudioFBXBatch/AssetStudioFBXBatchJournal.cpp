@@ -0,0 +1,73 @@
+#include <stdexcept>
+#include "AssetStudioFBXBatchJournal.h"
+
+#ifdef _WIN32
+#include <io.h>
+#define FBX_FSYNC(file) _commit(_fileno(file))
+#else
+#include <unistd.h>
+#define FBX_FSYNC(file) fsync(fileno(file))
+#endif
+
+namespace AssetStudio
+{
+	BatchJournal::BatchJournal(const char* path, bool restart)
+	{
+		bool torn = false;
+		FILE* existing = restart ? NULL : fopen(path, "rb");
+		if (existing != NULL)
+		{
+			std::string line;
+			int c;
+			while ((c = fgetc(existing)) != EOF)
+			{
+				if (c != '\n')
+				{
+					line.push_back((char)c);
+					continue;
+				}
+				//only complete lines count, the key is the second field
+				if (line.compare(0, 5, "done ") == 0)
+				{
+					size_t end = line.find(' ', 5);
+					done.insert(line.substr(5, end == std::string::npos ? std::string::npos : end - 5));
+				}
+				line.clear();
+			}
+			torn = !line.empty();
+			fclose(existing);
+		}
+
+		file = fopen(path, restart ? "wb" : "ab");
+		if (file == NULL)
+		{
+			throw std::runtime_error(std::string("Failed to open ") + path);
+		}
+		//a torn line from a crash would otherwise run into the next record
+		if (torn)
+		{
+			fputc('\n', file);
+			fflush(file);
+		}
+	}
+
+	BatchJournal::~BatchJournal()
+	{
+		fclose(file);
+	}
+
+	bool BatchJournal::IsDone(const std::string& key) const
+	{
+		return done.find(key) != done.end();
+	}
+
+	void BatchJournal::MarkDone(const std::string& key, const std::string& output)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		fprintf(file, "done %s %s\n", key.c_str(), output.c_str());
+		if (fflush(file) != 0 || FBX_FSYNC(file) != 0)
+		{
+			throw std::runtime_error("Failed to write the journal");
+		}
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdio.h>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace AssetStudio
+{
+	//Append-only record of finished jobs, one "done <key> <output>" line each. Every line is flushed to disk before
+	//MarkDone returns, so after a crash the journal lists exactly the outputs that were completely written.
+	//A torn last line is ignored when the journal is read back. Throws std::runtime_error if the file cannot be opened.
+	class BatchJournal
+	{
+	public:
+		//restart discards the records of an earlier run
+		BatchJournal(const char* path, bool restart);
+		~BatchJournal();
+
+		//Whether an earlier run finished key, records added by this run are not included
+		bool IsDone(const std::string& key) const;
+		//Safe to call from several threads
+		void MarkDone(const std::string& key, const std::string& output);
+
+	private:
+		FILE* file;
+		std::set<std::string> done;
+		std::mutex lock;
+
+		BatchJournal(const BatchJournal&);
+		BatchJournal& operator=(const BatchJournal&);
+	};
+}
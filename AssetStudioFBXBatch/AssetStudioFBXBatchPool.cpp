@@ -0,0 +1,141 @@
+#include "AssetStudioFBXBatchPool.h"
+
+namespace AssetStudio
+{
+	//the pool and index of the worker running on this thread, so Submit knows which deque is its own
+	static thread_local TaskPool* currentPool = NULL;
+	static thread_local int currentWorker = -1;
+
+	TaskPool::TaskPool(int threads) : queued(0), outstanding(0), steals(0), stopping(false)
+	{
+		if (threads <= 0)
+		{
+			threads = (int)std::thread::hardware_concurrency();
+		}
+		if (threads <= 0)
+		{
+			threads = 1;
+		}
+		workers.reserve(threads);
+		for (int i = 0; i < threads; i++)
+		{
+			workers.push_back(new Worker());
+		}
+		for (int i = 0; i < threads; i++)
+		{
+			workers[i]->Thread = std::thread(&TaskPool::Run, this, i);
+		}
+	}
+
+	TaskPool::~TaskPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepLock);
+			stopping = true;
+		}
+		wake.notify_all();
+		//workers still running look into the deques of the others, so none is freed before all have stopped
+		for (size_t i = 0; i < workers.size(); i++)
+		{
+			workers[i]->Thread.join();
+		}
+		for (size_t i = 0; i < workers.size(); i++)
+		{
+			delete workers[i];
+		}
+	}
+
+	void TaskPool::Submit(std::function<void()> task)
+	{
+		outstanding++;
+		if (currentPool == this)
+		{
+			Worker* worker = workers[currentWorker];
+			std::lock_guard<std::mutex> lock(worker->Lock);
+			worker->Tasks.push_back(std::move(task));
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(sharedLock);
+			shared.push_back(std::move(task));
+		}
+		queued++;
+		//taking the lock orders this after a sleeping worker's check of queued, so the wakeup cannot be lost
+		{
+			std::lock_guard<std::mutex> lock(sleepLock);
+		}
+		wake.notify_one();
+	}
+
+	void TaskPool::Wait()
+	{
+		std::unique_lock<std::mutex> lock(sleepLock);
+		idle.wait(lock, [this] { return outstanding == 0; });
+	}
+
+	bool TaskPool::Take(int index, std::function<void()>& task)
+	{
+		{
+			Worker* own = workers[index];
+			std::lock_guard<std::mutex> lock(own->Lock);
+			if (!own->Tasks.empty())
+			{
+				task = std::move(own->Tasks.back());
+				own->Tasks.pop_back();
+				return true;
+			}
+		}
+		const int count = (int)workers.size();
+		for (int i = 1; i < count; i++)
+		{
+			Worker* victim = workers[(index + i) % count];
+			std::lock_guard<std::mutex> lock(victim->Lock);
+			if (!victim->Tasks.empty())
+			{
+				task = std::move(victim->Tasks.front());
+				victim->Tasks.pop_front();
+				steals++;
+				return true;
+			}
+		}
+		std::lock_guard<std::mutex> lock(sharedLock);
+		if (!shared.empty())
+		{
+			task = std::move(shared.front());
+			shared.pop_front();
+			return true;
+		}
+		return false;
+	}
+
+	void TaskPool::Run(int index)
+	{
+		currentPool = this;
+		currentWorker = index;
+		std::function<void()> task;
+		for (;;)
+		{
+			if (Take(index, task))
+			{
+				queued--;
+				task();
+				task = nullptr;
+				if (--outstanding == 0)
+				{
+					std::lock_guard<std::mutex> lock(sleepLock);
+					idle.notify_all();
+				}
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(sleepLock);
+			if (stopping)
+			{
+				return;
+			}
+			if (queued == 0)
+			{
+				wake.wait(lock);
+			}
+		}
+	}
+}
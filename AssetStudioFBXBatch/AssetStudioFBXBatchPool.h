@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace AssetStudio
+{
+	//Work-stealing thread pool. Tasks submitted from a worker go to the back of that worker's own deque and are run newest first,
+	//idle workers steal the oldest task of another worker. Tasks submitted from outside go to a shared queue, which is only read
+	//once nothing can be stolen, so workers finish the stages of scenes already loaded before they load new ones.
+	//Tasks must not throw.
+	class TaskPool
+	{
+	public:
+		//threads <= 0 uses one per hardware thread
+		explicit TaskPool(int threads);
+		~TaskPool();
+
+		void Submit(std::function<void()> task);
+		//Blocks until every submitted task has finished, including the ones submitted by tasks
+		void Wait();
+
+		int Threads() const { return (int)workers.size(); }
+		unsigned long long Steals() const { return steals; }
+
+	private:
+		struct Worker
+		{
+			std::mutex Lock;
+			std::deque<std::function<void()> > Tasks;
+			std::thread Thread;
+		};
+
+		std::vector<Worker*> workers;
+		std::mutex sharedLock;
+		std::deque<std::function<void()> > shared;
+		std::mutex sleepLock;
+		std::condition_variable wake;
+		std::condition_variable idle;
+		std::atomic<long long> queued;
+		std::atomic<long long> outstanding;
+		std::atomic<unsigned long long> steals;
+		bool stopping;
+
+		TaskPool(const TaskPool&);
+		TaskPool& operator=(const TaskPool&);
+
+		void Run(int index);
+		bool Take(int index, std::function<void()>& task);
+	};
+}
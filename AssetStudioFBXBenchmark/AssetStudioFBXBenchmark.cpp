@@ -0,0 +1,924 @@
+#include <math.h>
+#include <float.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "AssetStudioFBXMeshOptimizer.h"
+#include "AssetStudioFBXRotation.h"
+#include "AssetStudioFBXScene.h"
+#include "AssetStudioFBXSceneSpill.h"
+#ifdef BENCHMARK_FBXSDK
+#include <fbxsdk.h>
+#include "AssetStudioFBXMesh.h"
+#endif
+
+using namespace AssetStudio;
+
+//Size of the synthetic scene, every count can be set from the command line
+struct BenchmarkOptions
+{
+	int Frames;
+	int Meshes;
+	int Submeshes; //per mesh
+	int Vertices; //per submesh
+	int Bones; //per mesh, 0 leaves the meshes unskinned
+	int Influences; //bones per vertex, 1 to 4
+	int Materials;
+	int Textures;
+	int Shapes; //per submesh
+	int Clips;
+	int Keys; //per track and channel
+	int RotationKeys;
+	int Repeat;
+	int Version;
+	bool Compress;
+	bool Spill; //geometry is written from a spill file, as in a memory-budgeted export
+	std::string Output;
+	std::string Json;
+	std::string Snapshot; //also written as a scene snapshot, an input for AssetStudioFBXBatch
+};
+
+static const struct
+{
+	const char* Name;
+	int BenchmarkOptions::* Value;
+}
+IntOptions[] =
+{
+	{ "--frames", &BenchmarkOptions::Frames },
+	{ "--meshes", &BenchmarkOptions::Meshes },
+	{ "--submeshes", &BenchmarkOptions::Submeshes },
+	{ "--vertices", &BenchmarkOptions::Vertices },
+	{ "--bones", &BenchmarkOptions::Bones },
+	{ "--influences", &BenchmarkOptions::Influences },
+	{ "--materials", &BenchmarkOptions::Materials },
+	{ "--textures", &BenchmarkOptions::Textures },
+	{ "--shapes", &BenchmarkOptions::Shapes },
+	{ "--clips", &BenchmarkOptions::Clips },
+	{ "--keys", &BenchmarkOptions::Keys },
+	{ "--rotation-keys", &BenchmarkOptions::RotationKeys },
+	{ "--repeat", &BenchmarkOptions::Repeat },
+	{ "--version", &BenchmarkOptions::Version },
+};
+
+static void Usage()
+{
+	fprintf(stderr, "Usage: AssetStudioFBXBenchmark [options]\n");
+	for (size_t i = 0; i < sizeof(IntOptions) / sizeof(IntOptions[0]); i++)
+	{
+		fprintf(stderr, "  %s <count>\n", IntOptions[i].Name);
+	}
+	fprintf(stderr, "  --uncompressed\n  --spill\n  --output <file.fbx>\n  --json <file.json>, defaults to stdout\n  --snapshot <file>\n");
+}
+
+static bool ParseOptions(int argc, char* argv[], BenchmarkOptions& options)
+{
+	options.Frames = 256;
+	options.Meshes = 8;
+	options.Submeshes = 4;
+	options.Vertices = 20000;
+	options.Bones = 64;
+	options.Influences = 4;
+	options.Materials = 16;
+	options.Textures = 32;
+	options.Shapes = 4;
+	options.Clips = 2;
+	options.Keys = 600;
+	options.RotationKeys = 1000000;
+	options.Repeat = 5;
+	options.Version = 7500;
+	options.Compress = true;
+	options.Spill = false;
+	options.Output = "AssetStudioFBXBenchmark.fbx";
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool known = false;
+		for (size_t k = 0; k < sizeof(IntOptions) / sizeof(IntOptions[0]) && !known; k++)
+		{
+			if (strcmp(argv[i], IntOptions[k].Name) == 0 && i + 1 < argc)
+			{
+				options.*IntOptions[k].Value = atoi(argv[++i]);
+				known = true;
+			}
+		}
+		if (known)
+		{
+			continue;
+		}
+		if (strcmp(argv[i], "--uncompressed") == 0)
+		{
+			options.Compress = false;
+		}
+		else if (strcmp(argv[i], "--spill") == 0)
+		{
+			options.Spill = true;
+		}
+		else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+		{
+			options.Output = argv[++i];
+		}
+		else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+		{
+			options.Json = argv[++i];
+		}
+		else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc)
+		{
+			options.Snapshot = argv[++i];
+		}
+		else
+		{
+			return false;
+		}
+	}
+	options.Frames = std::max(options.Frames, 1);
+	options.Influences = std::min(std::max(options.Influences, 1), 4);
+	options.Repeat = std::max(options.Repeat, 1);
+	return options.Version == 7400 || options.Version == 7500;
+}
+
+//Live and peak bytes on the heap, counted by the global operator new below so the memory a writer adds on top of the scene can be reported
+static std::atomic<long long> heapLive(0);
+static std::atomic<long long> heapPeak(0);
+
+void* operator new(size_t size)
+{
+	//the size is kept in front of the block, 16 bytes keep the alignment malloc gives
+	void* block = malloc(size + 16);
+	if (block == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	*(size_t*)block = size;
+	long long live = heapLive += (long long)size;
+	long long peak = heapPeak;
+	while (live > peak && !heapPeak.compare_exchange_weak(peak, live))
+	{
+	}
+	return (char*)block + 16;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	if (p != NULL)
+	{
+		char* block = (char*)p - 16;
+		heapLive -= (long long)*(size_t*)block;
+		free(block);
+	}
+}
+
+void operator delete[](void* p) noexcept
+{
+	operator delete(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	operator delete(p);
+}
+
+//Restarts the peak at the current live bytes and returns them
+static long long ResetHeapPeak()
+{
+	long long live = heapLive;
+	heapPeak = live;
+	return live;
+}
+
+static double Seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double PerSecond(double amount, double seconds)
+{
+	return seconds > 0 ? amount / seconds : 0;
+}
+
+//Frames form a four-way tree below the root
+static void BuildFrames(const BenchmarkOptions& options, Scene& scene)
+{
+	scene.Frames.resize(options.Frames);
+	for (int i = 0; i < options.Frames; i++)
+	{
+		SceneFrame& frame = scene.Frames[i];
+		frame.Name = "Frame" + std::to_string(i);
+		frame.Parent = i == 0 ? -1 : (i - 1) / 4;
+		frame.Attribute = i == 0 ? FrameNone : FrameNull;
+		for (int c = 0; c < 3; c++)
+		{
+			frame.LocalPosition[c] = c == 1 ? 1.0f : 0.0f;
+			frame.LocalRotation[c] = 0;
+			frame.LocalScale[c] = 1;
+		}
+	}
+}
+
+static void BuildMeshes(const BenchmarkOptions& options, Scene& scene)
+{
+	srand(1);
+	scene.Meshes.resize(options.Meshes);
+	for (int m = 0; m < options.Meshes; m++)
+	{
+		SceneMesh& mesh = scene.Meshes[m];
+		mesh.Frame = m % options.Frames;
+		mesh.Bones.resize(options.Bones);
+		for (int b = 0; b < options.Bones; b++)
+		{
+			SceneBone& bone = mesh.Bones[b];
+			bone.Frame = b % options.Frames;
+			memset(bone.Matrix, 0, sizeof(bone.Matrix));
+			for (int k = 0; k < 4; k++)
+			{
+				bone.Matrix[k * 5] = 1;
+			}
+			bone.Matrix[13] = -(float)b;
+		}
+
+		mesh.Submeshes.resize(options.Submeshes);
+		for (int s = 0; s < options.Submeshes; s++)
+		{
+			SceneSubmesh& submesh = mesh.Submeshes[s];
+			int count = options.Vertices;
+			int width = std::max((int)sqrt((double)count), 2);
+			submesh.VertexCount = count;
+			submesh.Positions.resize(count * 3);
+			submesh.Normals.resize(count * 3);
+			submesh.UV0.resize(count * 2);
+			submesh.Tangents.resize(count * 4);
+			for (int v = 0; v < count; v++)
+			{
+				float x = (float)(v % width);
+				float z = (float)(v / width);
+				submesh.Positions[v * 3] = x;
+				submesh.Positions[v * 3 + 1] = rand() / (float)RAND_MAX;
+				submesh.Positions[v * 3 + 2] = z;
+				submesh.Normals[v * 3 + 1] = 1;
+				submesh.UV0[v * 2] = x / width;
+				submesh.UV0[v * 2 + 1] = z / width;
+				submesh.Tangents[v * 4] = 1;
+				submesh.Tangents[v * 4 + 3] = 1;
+			}
+			//two triangles per grid cell
+			for (int v = 0; v + width + 1 < count; v++)
+			{
+				if (v % width == width - 1)
+				{
+					continue;
+				}
+				int quad[6] = { v, v + width, v + 1, v + 1, v + width, v + width + 1 };
+				submesh.Indices.insert(submesh.Indices.end(), quad, quad + 6);
+			}
+			if (options.Bones > 0)
+			{
+				submesh.BoneIndices.resize(count * 4);
+				submesh.Weights.resize(count * 4);
+				for (int v = 0; v < count; v++)
+				{
+					for (int k = 0; k < options.Influences; k++)
+					{
+						submesh.BoneIndices[v * 4 + k] = (v + k * 7) % options.Bones;
+						submesh.Weights[v * 4 + k] = 1.0f / options.Influences;
+					}
+				}
+			}
+			submesh.Material = options.Materials > 0 ? (m * options.Submeshes + s) % options.Materials : -1;
+
+			for (int k = 0; k < options.Shapes; k++)
+			{
+				//each shape moves every fourth vertex, starting at a different one
+				SceneMorph morph;
+				morph.Mesh = m;
+				morph.Submesh = s;
+				morph.Name = "Morph" + std::to_string(m) + "_" + std::to_string(s) + "_" + std::to_string(k);
+				morph.WeightProperties = false;
+				morph.Channels.resize(1);
+				SceneBlendChannel& channel = morph.Channels[0];
+				channel.Name = "Channel" + std::to_string(k);
+				channel.DeformPercent = 0;
+				channel.Shapes.resize(1);
+				SceneShape& shape = channel.Shapes[0];
+				shape.Name = "Shape" + std::to_string(k);
+				shape.Weight = 100;
+				for (int v = k % 4; v < count; v += 4)
+				{
+					shape.Indices.push_back(v);
+					shape.Deltas.push_back(0);
+					shape.Deltas.push_back(0.1f * (k + 1));
+					shape.Deltas.push_back(0);
+				}
+				scene.Morphs.push_back(morph);
+			}
+		}
+	}
+}
+
+static void BuildMaterials(const BenchmarkOptions& options, Scene& scene)
+{
+	scene.Textures.resize(options.Textures);
+	for (int t = 0; t < options.Textures; t++)
+	{
+		SceneTexture& texture = scene.Textures[t];
+		texture.Name = "Texture" + std::to_string(t) + ".png";
+		texture.FileName = texture.Name;
+		texture.RelativeFileName = texture.Name;
+	}
+
+	scene.Materials.resize(options.Materials);
+	for (int i = 0; i < options.Materials; i++)
+	{
+		SceneMaterial& material = scene.Materials[i];
+		material.Name = "Material" + std::to_string(i);
+		for (int c = 0; c < 4; c++)
+		{
+			material.Diffuse[c] = 0.8f;
+			material.Ambient[c] = 0.2f;
+			material.Emissive[c] = 0;
+			material.Specular[c] = 0.5f;
+			material.Reflection[c] = 0;
+		}
+		material.Shininess = 20;
+		material.Transparency = 0;
+		for (int dest = 0; dest < 2 && options.Textures > 0; dest++)
+		{
+			SceneMaterialTexture link = { (i * 2 + dest) % options.Textures, dest, { 0, 0 }, { 1, 1 } };
+			material.Textures.push_back(link);
+		}
+	}
+}
+
+//Every frame gets scaling, rotation and translation keys at 30 fps in every clip
+static void BuildClips(const BenchmarkOptions& options, Scene& scene)
+{
+	scene.Clips.resize(options.Clips);
+	for (int i = 0; i < options.Clips; i++)
+	{
+		SceneClip& clip = scene.Clips[i];
+		clip.Name = "Clip" + std::to_string(i);
+		clip.Tracks.resize(options.Keys > 0 ? options.Frames : 0);
+		for (size_t j = 0; j < clip.Tracks.size(); j++)
+		{
+			SceneTrack& track = clip.Tracks[j];
+			track.Frame = (int)j;
+			SceneCurve* curves[3] = { &track.Scalings, &track.Rotations, &track.Translations };
+			for (int c = 0; c < 3; c++)
+			{
+				curves[c]->Times.resize(options.Keys);
+				curves[c]->Values.resize(options.Keys * 3);
+				for (int k = 0; k < options.Keys; k++)
+				{
+					float time = k / 30.0f;
+					curves[c]->Times[k] = time;
+					curves[c]->Values[k * 3] = (c == 0 ? 1.0f : 0.0f) + 0.1f * sinf(time + j);
+					curves[c]->Values[k * 3 + 1] = (c == 0 ? 1.0f : 0.0f) + 0.1f * cosf(time * 2 + j);
+					curves[c]->Values[k * 3 + 2] = (c == 0 ? 1.0f : 0.0f) + (c == 1 ? 10.0f * time : 0.0f);
+				}
+			}
+		}
+	}
+}
+
+//Reference conversion with the C library, the same steps as FbxAMatrix::SetQ and GetR
+static void ReferenceQuaternionToEuler(const float* q, float* e)
+{
+	double x = q[0], y = q[1], z = q[2], w = q[3];
+	double x2 = x + x, y2 = y + y, z2 = z + z;
+	double xx = x * x2, xy = x * y2, xz = x * z2, yy = y * y2, yz = y * z2, zz = z * z2;
+	double wx = w * x2, wy = w * y2, wz = w * z2;
+	double m00 = 1 - (yy + zz), m01 = xy + wz, m02 = xz - wy;
+	double m11 = 1 - (xx + zz), m12 = yz + wx, m21 = yz - wx, m22 = 1 - (xx + yy);
+	double cy = sqrt(m00 * m00 + m01 * m01);
+	double rx, rz;
+	if (cy > 16 * FLT_EPSILON)
+	{
+		rx = atan2(m12, m22);
+		rz = atan2(m01, m00);
+	}
+	else
+	{
+		rx = atan2(-m21, m11);
+		rz = 0;
+	}
+	double ry = atan2(-m02, cy);
+	const double toDegrees = 57.295779513082320876798154814105;
+	e[0] = (float)(rx * toDegrees);
+	e[1] = (float)(ry * toDegrees);
+	e[2] = (float)(rz * toDegrees);
+}
+
+static long long UlpDistance(float a, float b)
+{
+	int ia, ib;
+	memcpy(&ia, &a, sizeof(ia));
+	memcpy(&ib, &b, sizeof(ib));
+	long long la = ia < 0 ? (long long)INT_MIN - ia : ia;
+	long long lb = ib < 0 ? (long long)INT_MIN - ib : ib;
+	return la > lb ? la - lb : lb - la;
+}
+
+static long long MaxUlpDistance(const std::vector<float>& a, const std::vector<float>& b)
+{
+	long long worst = 0;
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		worst = std::max(worst, UlpDistance(a[i], b[i]));
+	}
+	return worst;
+}
+
+#ifdef BENCHMARK_FBXSDK
+//The same calls as the per-key Fbx::QuaternionToEuler, which is managed and cannot be called from here
+static void SdkQuaternionToEuler(const float* q, float* e)
+{
+	FbxAMatrix lMatrixRot;
+	lMatrixRot.SetQ(FbxQuaternion(q[0], q[1], q[2], q[3]));
+	FbxVector4 lEuler = lMatrixRot.GetR();
+	e[0] = (float)lEuler[0];
+	e[1] = (float)lEuler[1];
+	e[2] = (float)lEuler[2];
+}
+#endif
+
+static void BenchmarkRotations(FILE* json, int keyCount, int repeat)
+{
+	std::vector<float> quats(keyCount * 4);
+	srand(1);
+	for (int i = 0; i < keyCount; i++)
+	{
+		double q[4];
+		double length = 0;
+		for (int k = 0; k < 4; k++)
+		{
+			q[k] = rand() / (double)RAND_MAX * 2 - 1;
+			length += q[k] * q[k];
+		}
+		length = sqrt(length);
+		for (int k = 0; k < 4; k++)
+		{
+			quats[i * 4 + k] = (float)(q[k] / length);
+		}
+	}
+
+	//keys near gimbal lock, cos(y) from 0 to 4 times the 16 * FLT_EPSILON threshold where the conversion switches branch
+	const int gimbalCount = 4096;
+	std::vector<float> gimbalEulers(gimbalCount * 3);
+	for (int i = 0; i < gimbalCount; i++)
+	{
+		double offset = asin(4.0 * 16 * FLT_EPSILON * i / gimbalCount) * 57.295779513082320876798154814105;
+		gimbalEulers[i * 3] = (float)(rand() / (double)RAND_MAX * 360 - 180);
+		gimbalEulers[i * 3 + 1] = (float)((i & 1) ? 90 - offset : offset - 90);
+		gimbalEulers[i * 3 + 2] = (float)(rand() / (double)RAND_MAX * 360 - 180);
+	}
+	std::vector<float> gimbalQuats(gimbalCount * 4);
+	EulersToQuaternion(gimbalEulers.data(), gimbalQuats.data(), gimbalCount);
+
+	std::vector<float> reference(keyCount * 3);
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeat; r++)
+	{
+		for (int i = 0; i < keyCount; i++)
+		{
+			ReferenceQuaternionToEuler(&quats[i * 4], &reference[i * 3]);
+		}
+	}
+	fprintf(json, "  \"rotations\": {\n    \"keys\": %d,\n    \"gimbal_keys\": %d,\n    \"reference_keys_per_second\": %.0f,\n", keyCount, gimbalCount, PerSecond((double)keyCount * repeat, Seconds(start)));
+	std::vector<float> gimbalReference(gimbalCount * 3);
+	for (int i = 0; i < gimbalCount; i++)
+	{
+		ReferenceQuaternionToEuler(&gimbalQuats[i * 4], &gimbalReference[i * 3]);
+	}
+#ifdef BENCHMARK_FBXSDK
+	std::vector<float> sdk(keyCount * 3);
+	std::vector<float> gimbalSdk(gimbalCount * 3);
+	for (int i = 0; i < keyCount; i++)
+	{
+		SdkQuaternionToEuler(&quats[i * 4], &sdk[i * 3]);
+	}
+	for (int i = 0; i < gimbalCount; i++)
+	{
+		SdkQuaternionToEuler(&gimbalQuats[i * 4], &gimbalSdk[i * 3]);
+	}
+#endif
+
+	std::vector<float> eulers(keyCount * 3);
+	std::vector<float> gimbalResults(gimbalCount * 3);
+	fprintf(json, "    \"paths\": [");
+	for (int path = RotationScalar; path <= DetectRotationPath(); path++)
+	{
+		start = std::chrono::steady_clock::now();
+		for (int r = 0; r < repeat; r++)
+		{
+			QuaternionsToEuler(quats.data(), eulers.data(), keyCount, (RotationPath)path);
+		}
+		double seconds = Seconds(start);
+		QuaternionsToEuler(gimbalQuats.data(), gimbalResults.data(), gimbalCount, (RotationPath)path);
+
+		fprintf(json, "%s\n      { \"path\": \"%s\", \"keys_per_second\": %.0f, \"max_ulp\": %lld, \"gimbal_max_ulp\": %lld", path > RotationScalar ? "," : "", RotationPathName((RotationPath)path), PerSecond((double)keyCount * repeat, seconds),
+			MaxUlpDistance(eulers, reference), MaxUlpDistance(gimbalResults, gimbalReference));
+#ifdef BENCHMARK_FBXSDK
+		fprintf(json, ", \"sdk_max_ulp\": %lld, \"sdk_gimbal_max_ulp\": %lld", MaxUlpDistance(eulers, sdk), MaxUlpDistance(gimbalResults, gimbalSdk));
+#endif
+		fprintf(json, " }");
+	}
+	fprintf(json, "\n    ],\n");
+
+	std::vector<float> back(keyCount * 4);
+	start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeat; r++)
+	{
+		EulersToQuaternion(reference.data(), back.data(), keyCount);
+	}
+	fprintf(json, "    \"euler_to_quaternion_keys_per_second\": %.0f\n  }", PerSecond((double)keyCount * repeat, Seconds(start)));
+}
+
+//Welds and reorders a grid of split vertices in shuffled triangle order, the layout Unity meshes often arrive in
+static void BenchmarkMeshOptimizer(FILE* json, int vertexCount, int repeat)
+{
+	int width = std::max((int)sqrt((double)vertexCount), 2);
+	std::vector<int> grid;
+	for (int v = 0; v + width + 1 < vertexCount; v++)
+	{
+		if (v % width == width - 1)
+		{
+			continue;
+		}
+		int quad[6] = { v, v + width, v + 1, v + 1, v + width, v + width + 1 };
+		grid.insert(grid.end(), quad, quad + 6);
+	}
+	int triangleCount = (int)grid.size() / 3;
+	srand(1);
+	for (int t = triangleCount - 1; t > 0; t--)
+	{
+		int other = rand() % (t + 1);
+		std::swap_ranges(grid.begin() + t * 3, grid.begin() + t * 3 + 3, grid.begin() + other * 3);
+	}
+
+	//every corner gets its own vertex, position xyz and normal xyz with a stride of four like FbxVector4
+	int splitCount = triangleCount * 3;
+	std::vector<double> positions(splitCount * 4);
+	std::vector<double> normals(splitCount * 4);
+	std::vector<int> split(splitCount);
+	for (int i = 0; i < splitCount; i++)
+	{
+		positions[i * 4] = grid[i] % width;
+		positions[i * 4 + 2] = grid[i] / width;
+		normals[i * 4 + 1] = 1;
+		split[i] = i;
+	}
+	std::vector<WeldStream> streams;
+	WeldStream position = { positions.data(), 4, 3 };
+	WeldStream normal = { normals.data(), 4, 3 };
+	streams.push_back(position);
+	streams.push_back(normal);
+
+	long long missesBefore = CountCacheMisses(split, splitCount, AcmrCacheSize);
+	double best[3] = { DBL_MAX, DBL_MAX, DBL_MAX };
+	std::vector<int> indices, remap, fetch;
+	int welded = 0, used = 0;
+	for (int r = 0; r < repeat; r++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		welded = WeldVertices(streams, splitCount, 1e-6, remap);
+		indices.resize(splitCount);
+		for (int i = 0; i < splitCount; i++)
+		{
+			indices[i] = remap[split[i]];
+		}
+		best[0] = std::min(best[0], Seconds(start));
+		start = std::chrono::steady_clock::now();
+		OptimizeVertexCache(indices, welded);
+		best[1] = std::min(best[1], Seconds(start));
+		start = std::chrono::steady_clock::now();
+		used = OptimizeVertexFetch(indices, welded, fetch);
+		best[2] = std::min(best[2], Seconds(start));
+	}
+	long long missesAfter = CountCacheMisses(indices, used, AcmrCacheSize);
+
+	fprintf(json, "  \"mesh_optimizer\": {\n    \"triangles\": %d,\n    \"vertices_in\": %d,\n    \"vertices_out\": %d,\n", triangleCount, splitCount, used);
+	fprintf(json, "    \"acmr_before\": %.3f,\n    \"acmr_after\": %.3f,\n", (double)missesBefore / triangleCount, (double)missesAfter / triangleCount);
+	fprintf(json, "    \"weld_seconds\": %.6f,\n    \"cache_seconds\": %.6f,\n    \"fetch_seconds\": %.6f,\n", best[0], best[1], best[2]);
+	fprintf(json, "    \"triangles_per_second\": %.0f\n  }", PerSecond(triangleCount, best[0] + best[1] + best[2]));
+}
+
+#ifdef BENCHMARK_FBXSDK
+//Builds the frames and geometry of the scene with the FBX SDK the way Fbx::Exporter does and saves it, returns the seconds taken.
+//The manager is created beforehand, as an export session keeps it.
+static double WriteGeometryWithSdk(FbxManager* pManager, const Scene& scene, const char* path)
+{
+	auto start = std::chrono::steady_clock::now();
+	FbxScene* pScene = FbxScene::Create(pManager, "");
+	std::vector<FbxNode*> nodes(scene.Frames.size());
+	for (size_t i = 0; i < scene.Frames.size(); i++)
+	{
+		const SceneFrame& frame = scene.Frames[i];
+		FbxNode* pNode = FbxNode::Create(pScene, frame.Name.c_str());
+		pNode->LclTranslation.Set(FbxDouble3(frame.LocalPosition[0], frame.LocalPosition[1], frame.LocalPosition[2]));
+		pNode->LclRotation.Set(FbxDouble3(frame.LocalRotation[0], frame.LocalRotation[1], frame.LocalRotation[2]));
+		pNode->LclScaling.Set(FbxDouble3(frame.LocalScale[0], frame.LocalScale[1], frame.LocalScale[2]));
+		(frame.Parent < 0 ? pScene->GetRootNode() : nodes[frame.Parent])->AddChild(pNode);
+		nodes[i] = pNode;
+	}
+
+	for (size_t i = 0; i < scene.Meshes.size(); i++)
+	{
+		const SceneMesh& mesh = scene.Meshes[i];
+		for (size_t j = 0; j < mesh.Submeshes.size(); j++)
+		{
+			const SceneSubmesh& submesh = mesh.Submeshes[j];
+			VertexBuffers buffers;
+			buffers.VertexCount = submesh.VertexCount;
+			buffers.Positions = submesh.Positions.data();
+			buffers.Normals = submesh.Normals.empty() ? NULL : submesh.Normals.data();
+			buffers.UV0 = submesh.UV0.empty() ? NULL : submesh.UV0.data();
+			buffers.Tangents = submesh.Tangents.empty() ? NULL : submesh.Tangents.data();
+			buffers.Colours = submesh.Colours.empty() ? NULL : submesh.Colours.data();
+			PreparedSubmesh prepared;
+			PrepareVertexBuffers(buffers, true, prepared);
+			PrepareTriangles(submesh.Indices.data(), (int)submesh.Indices.size(), prepared);
+
+			FbxMesh* pMesh = FbxMesh::Create(pScene, "");
+			pMesh->InitControlPoints(prepared.VertexCount);
+			VertexElements elements = {};
+			elements.ControlPoints = pMesh->GetControlPoints();
+			elements.Normal = pMesh->CreateElementNormal();
+			elements.Normal->SetMappingMode(FbxGeometryElement::eByControlPoint);
+			elements.Normal->SetReferenceMode(FbxGeometryElement::eDirect);
+			elements.UV = pMesh->CreateElementUV("");
+			elements.UV->SetMappingMode(FbxGeometryElement::eByControlPoint);
+			elements.UV->SetReferenceMode(FbxGeometryElement::eDirect);
+			elements.Tangent = pMesh->CreateElementTangent();
+			elements.Tangent->SetMappingMode(FbxGeometryElement::eByControlPoint);
+			elements.Tangent->SetReferenceMode(FbxGeometryElement::eDirect);
+			if (!prepared.Colours.empty())
+			{
+				elements.VertexColor = pMesh->CreateElementVertexColor();
+				elements.VertexColor->SetMappingMode(FbxGeometryElement::eByControlPoint);
+				elements.VertexColor->SetReferenceMode(FbxGeometryElement::eDirect);
+			}
+			CommitVertexBuffers(prepared, elements);
+			CommitTriangles(prepared, pMesh);
+
+			FbxNode* pMeshNode = FbxNode::Create(pScene, (scene.Frames[mesh.Frame].Name + "_" + std::to_string(j)).c_str());
+			pMeshNode->SetNodeAttribute(pMesh);
+			nodes[mesh.Frame]->AddChild(pMeshNode);
+		}
+	}
+
+	FbxExporter* pExporter = FbxExporter::Create(pManager, "");
+	if (!pExporter->Initialize(path, pManager->GetIOPluginRegistry()->GetNativeWriterFormat(), pManager->GetIOSettings()) || !pExporter->Export(pScene))
+	{
+		std::string error = pExporter->GetStatus().GetErrorString();
+		pExporter->Destroy();
+		pScene->Destroy();
+		throw std::runtime_error("FBX SDK export failed: " + error);
+	}
+	pExporter->Destroy();
+	pScene->Destroy();
+	return Seconds(start);
+}
+
+//The frames and geometry of the scene written by the SDK and by WriteBinaryFbx, the part of an export both can do.
+//Skin, blend shapes, materials and animation are left out, the SDK path would need the managed exporter for them.
+static void BenchmarkSdk(FILE* json, const Scene& scene, const BenchmarkOptions& options)
+{
+	Scene geometry = Scene();
+	geometry.ScaleFactor = scene.ScaleFactor;
+	geometry.BoneSize = scene.BoneSize;
+	geometry.Frames = scene.Frames;
+	geometry.Meshes = scene.Meshes;
+	for (size_t i = 0; i < geometry.Meshes.size(); i++)
+	{
+		geometry.Meshes[i].Bones.clear();
+		for (size_t j = 0; j < geometry.Meshes[i].Submeshes.size(); j++)
+		{
+			SceneSubmesh& submesh = geometry.Meshes[i].Submeshes[j];
+			submesh.BoneIndices.clear();
+			submesh.Weights.clear();
+			submesh.Material = -1;
+		}
+	}
+
+	std::string sdkPath = options.Output + ".sdk.fbx";
+	FbxManager* pManager = FbxManager::Create();
+	pManager->SetIOSettings(FbxIOSettings::Create(pManager, IOSROOT));
+	double sdkSeconds = 0;
+	double writerSeconds = 0;
+	try
+	{
+		for (int r = 0; r < options.Repeat; r++)
+		{
+			double seconds = WriteGeometryWithSdk(pManager, geometry, sdkPath.c_str());
+			sdkSeconds = r == 0 ? seconds : std::min(sdkSeconds, seconds);
+			auto start = std::chrono::steady_clock::now();
+			WriteBinaryFbx(geometry, options.Output.c_str(), options.Version, options.Compress);
+			seconds = Seconds(start);
+			writerSeconds = r == 0 ? seconds : std::min(writerSeconds, seconds);
+		}
+	}
+	catch (...)
+	{
+		pManager->Destroy();
+		throw;
+	}
+	pManager->Destroy();
+	remove(sdkPath.c_str());
+	remove(options.Output.c_str());
+
+	fprintf(json, "  \"sdk_geometry\": {\n    \"sdk_seconds\": %.6f,\n    \"writer_seconds\": %.6f,\n    \"speedup\": %.2f\n  },\n",
+		sdkSeconds, writerSeconds, writerSeconds > 0 ? sdkSeconds / writerSeconds : 0.0);
+}
+#endif
+
+//Writes the scene repeat times and keeps the fastest time of every stage
+static void BenchmarkStages(FILE* json, const BenchmarkOptions& options)
+{
+	auto start = std::chrono::steady_clock::now();
+	Scene scene = Scene();
+	scene.ScaleFactor = 1;
+	scene.BoneSize = 0;
+	BuildFrames(options, scene);
+	BuildMeshes(options, scene);
+	BuildMaterials(options, scene);
+	BuildClips(options, scene);
+	double generateSeconds = Seconds(start);
+
+	std::string spillPath = options.Output + ".spill";
+	SceneSpill* spill = NULL;
+	if (options.Spill)
+	{
+		spill = new SceneSpill(spillPath.c_str());
+		scene.Spill = spill;
+		for (size_t i = 0; i < scene.Meshes.size(); i++)
+		{
+			for (size_t j = 0; j < scene.Meshes[i].Submeshes.size(); j++)
+			{
+				spill->Store(scene.Meshes[i].Submeshes[j]);
+			}
+		}
+	}
+	unsigned long long spillBytes = spill != NULL ? spill->Bytes() : 0;
+
+	//everything on the heap now is the scene, the peak during a write is what the writer adds to it
+	long long sceneHeapBytes = ResetHeapPeak();
+	long long writeHeapBytes = 0;
+	SceneWriteStats best = SceneWriteStats();
+	double bestTotal = 0;
+	for (int r = 0; r < options.Repeat; r++)
+	{
+		start = std::chrono::steady_clock::now();
+		SceneWriteStats stats = WriteBinaryFbx(scene, options.Output.c_str(), options.Version, options.Compress);
+		double total = Seconds(start);
+		writeHeapBytes = std::max(writeHeapBytes, (long long)heapPeak - sceneHeapBytes);
+		if (r == 0)
+		{
+			best = stats;
+			bestTotal = total;
+		}
+		for (int i = 0; i < SceneStageCount; i++)
+		{
+			best.StageSeconds[i] = std::min(best.StageSeconds[i], stats.StageSeconds[i]);
+		}
+		bestTotal = std::min(bestTotal, total);
+	}
+	remove(options.Output.c_str());
+
+	//the same scene as binary glTF, for comparison with the FBX writer
+	std::string glbPath = options.Output + ".glb";
+	GlbWriteStats glb = GlbWriteStats();
+	double glbTotal = 0;
+	ResetHeapPeak();
+	for (int r = 0; r < options.Repeat; r++)
+	{
+		start = std::chrono::steady_clock::now();
+		glb = WriteGlb(scene, glbPath.c_str());
+		double total = Seconds(start);
+		glbTotal = r == 0 ? total : std::min(glbTotal, total);
+	}
+	long long glbHeapBytes = (long long)heapPeak - sceneHeapBytes;
+	remove(glbPath.c_str());
+#ifdef BENCHMARK_FBXSDK
+	if (!options.Spill)
+	{
+		BenchmarkSdk(json, scene, options);
+	}
+#endif
+	if (!options.Snapshot.empty())
+	{
+		WriteSceneSnapshot(scene, options.Snapshot.c_str());
+	}
+	delete spill;
+
+	double vertices = (double)options.Meshes * options.Submeshes * options.Vertices;
+	double skinned = options.Bones > 0 ? vertices : 0;
+	double morphVertices = 0;
+	for (size_t i = 0; i < scene.Morphs.size(); i++)
+	{
+		morphVertices += (double)scene.Morphs[i].Channels[0].Shapes[0].Indices.size();
+	}
+	double keys = (double)options.Clips * (options.Keys > 0 ? options.Frames : 0) * 3 * options.Keys;
+	double megabytes = best.FileBytes / (1024.0 * 1024.0);
+
+	//amount of work of every stage and the unit its throughput is given in
+	struct
+	{
+		double Amount;
+		const char* Unit;
+	}
+	work[SceneStageCount] =
+	{
+		{ (double)options.Frames, "frames_per_second" },
+		{ vertices, "vertices_per_second" },
+		{ skinned, "vertices_per_second" },
+		{ (double)(options.Materials + options.Textures), "objects_per_second" },
+		{ morphVertices, "vertices_per_second" },
+		{ keys, "keys_per_second" },
+		{ megabytes, "megabytes_per_second" },
+	};
+
+	fprintf(json, "  \"scene\": {\n");
+	fprintf(json, "    \"frames\": %d,\n    \"meshes\": %d,\n    \"submeshes\": %d,\n    \"vertices\": %.0f,\n    \"bones\": %d,\n    \"influences\": %d,\n",
+		options.Frames, options.Meshes, options.Meshes * options.Submeshes, vertices, options.Bones, options.Influences);
+	fprintf(json, "    \"materials\": %d,\n    \"textures\": %d,\n    \"morph_vertices\": %.0f,\n    \"clips\": %d,\n    \"keys\": %.0f,\n",
+		options.Materials, options.Textures, morphVertices, options.Clips, keys);
+	fprintf(json, "    \"version\": %d,\n    \"compressed\": %s,\n    \"spill_bytes\": %llu,\n    \"generate_seconds\": %.6f\n  },\n", options.Version, options.Compress ? "true" : "false", spillBytes, generateSeconds);
+
+	//source data of a streaming export is released as it is copied, so the peak of an export is about the scene plus the writer's part
+	fprintf(json, "  \"memory\": {\n    \"scene_heap_bytes\": %lld,\n    \"write_peak_heap_bytes\": %lld,\n    \"write_peak_vs_scene\": %.4f,\n    \"glb_peak_heap_bytes\": %lld,\n    \"glb_peak_vs_scene\": %.4f\n  },\n",
+		sceneHeapBytes, writeHeapBytes, sceneHeapBytes > 0 ? (double)writeHeapBytes / sceneHeapBytes : 0.0, glbHeapBytes, sceneHeapBytes > 0 ? (double)glbHeapBytes / sceneHeapBytes : 0.0);
+
+	fprintf(json, "  \"stages\": {");
+	for (int i = 0; i < SceneStageCount; i++)
+	{
+		double seconds = best.StageSeconds[i];
+		fprintf(json, "%s\n    \"%s\": { \"seconds\": %.6f, \"%s\": %.1f }", i > 0 ? "," : "", SceneStageName((SceneStage)i), seconds, work[i].Unit, PerSecond(work[i].Amount, seconds));
+	}
+	fprintf(json, "\n  },\n");
+
+	fprintf(json, "  \"total\": {\n    \"seconds\": %.6f,\n    \"objects\": %d,\n    \"file_bytes\": %llu,\n    \"array_bytes\": %llu,\n    \"compressed_array_bytes\": %llu,\n",
+		bestTotal, best.Objects, best.FileBytes, best.ArrayBytes, best.CompressedArrayBytes);
+	fprintf(json, "    \"vertices_per_second\": %.1f,\n    \"keys_per_second\": %.1f,\n    \"megabytes_per_second\": %.1f\n  },\n",
+		PerSecond(vertices, bestTotal), PerSecond(keys, bestTotal), PerSecond(megabytes, bestTotal));
+
+	double glbMegabytes = glb.FileBytes / (1024.0 * 1024.0);
+	fprintf(json, "  \"glb\": {\n    \"seconds\": %.6f,\n    \"file_bytes\": %llu,\n    \"json_bytes\": %llu,\n    \"binary_bytes\": %llu,\n    \"accessors\": %d,\n",
+		glbTotal, glb.FileBytes, glb.JsonBytes, glb.BinaryBytes, glb.Accessors);
+	fprintf(json, "    \"vertices_per_second\": %.1f,\n    \"megabytes_per_second\": %.1f,\n    \"time_vs_fbx\": %.3f,\n    \"size_vs_fbx\": %.3f\n  },\n",
+		PerSecond(vertices, glbTotal), PerSecond(glbMegabytes, glbTotal), bestTotal > 0 ? glbTotal / bestTotal : 0.0, best.FileBytes > 0 ? (double)glb.FileBytes / best.FileBytes : 0.0);
+}
+
+int main(int argc, char* argv[])
+{
+	BenchmarkOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		Usage();
+		return 2;
+	}
+
+	FILE* json = options.Json.empty() ? stdout : fopen(options.Json.c_str(), "w");
+	if (json == NULL)
+	{
+		fprintf(stderr, "Cannot open %s\n", options.Json.c_str());
+		return 1;
+	}
+
+	int result = 0;
+	fprintf(json, "{\n");
+	try
+	{
+		BenchmarkStages(json, options);
+		BenchmarkRotations(json, options.RotationKeys, options.Repeat);
+		fprintf(json, ",\n");
+		BenchmarkMeshOptimizer(json, options.Vertices, options.Repeat);
+	}
+	catch (const std::exception& e)
+	{
+		fprintf(stderr, "%s\n", e.what());
+		result = 1;
+	}
+	fprintf(json, "\n}\n");
+	if (json != stdout)
+	{
+		fclose(json);
+	}
+	return result;
+}
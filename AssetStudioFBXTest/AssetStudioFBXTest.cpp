@@ -0,0 +1,753 @@
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include "AssetStudioFBXAnimation.h"
+#include "AssetStudioFBXRotation.h"
+#include "AssetStudioFBXScene.h"
+
+using namespace AssetStudio;
+
+//Writes a small scene with every writer and reads the files back, returns non-zero if anything does not round-trip
+
+static int failures = 0;
+
+static void Check(bool condition, const std::string& what)
+{
+	if (!condition)
+	{
+		fprintf(stderr, "FAILED: %s\n", what.c_str());
+		failures++;
+	}
+}
+
+static std::vector<unsigned char> ReadFile(const char* path)
+{
+	std::vector<unsigned char> data;
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		throw std::runtime_error(std::string("Cannot open ") + path);
+	}
+	unsigned char buffer[65536];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		data.insert(data.end(), buffer, buffer + read);
+	}
+	fclose(file);
+	return data;
+}
+
+//Two frames, one skinned grid submesh with every vertex stream, a blend shape, a textured material and one clip
+static void BuildScene(Scene& scene)
+{
+	scene.Frames.resize(2);
+	for (int i = 0; i < 2; i++)
+	{
+		SceneFrame& frame = scene.Frames[i];
+		frame.Name = i == 0 ? "Root" : "Joint";
+		frame.Parent = i - 1;
+		frame.Attribute = i == 0 ? FrameNone : FrameJoint;
+		for (int c = 0; c < 3; c++)
+		{
+			frame.LocalPosition[c] = (float)(i * (c + 1));
+			frame.LocalRotation[c] = 15.0f * i;
+			frame.LocalScale[c] = 1;
+		}
+	}
+
+	scene.Meshes.resize(1);
+	SceneMesh& mesh = scene.Meshes[0];
+	mesh.Frame = 0;
+	mesh.Bones.resize(1);
+	mesh.Bones[0].Frame = 1;
+	memset(mesh.Bones[0].Matrix, 0, sizeof(mesh.Bones[0].Matrix));
+	for (int k = 0; k < 4; k++)
+	{
+		mesh.Bones[0].Matrix[k * 5] = 1;
+	}
+
+	mesh.Submeshes.resize(1);
+	SceneSubmesh& submesh = mesh.Submeshes[0];
+	//a grid large enough for the writer to compress its arrays
+	const int width = 8;
+	const int count = width * width;
+	submesh.VertexCount = count;
+	submesh.Positions.resize(count * 3);
+	submesh.Normals.resize(count * 3);
+	submesh.UV0.resize(count * 2);
+	submesh.Tangents.resize(count * 4);
+	submesh.Colours.resize(count * 4);
+	submesh.BoneIndices.resize(count * 4);
+	submesh.Weights.resize(count * 4);
+	for (int v = 0; v < count; v++)
+	{
+		submesh.Positions[v * 3] = (float)(v % width);
+		submesh.Positions[v * 3 + 1] = (float)(v / width);
+		submesh.Positions[v * 3 + 2] = 0.125f * (v % 3);
+		submesh.Normals[v * 3 + 2] = -1;
+		submesh.UV0[v * 2] = (float)(v % width) / width;
+		submesh.UV0[v * 2 + 1] = (float)(v / width) / width;
+		submesh.Tangents[v * 4] = 1;
+		submesh.Tangents[v * 4 + 3] = -1;
+		submesh.Colours[v * 4] = (float)v / count;
+		submesh.Colours[v * 4 + 3] = 1;
+		submesh.Weights[v * 4] = 1;
+	}
+	for (int v = 0; v + width + 1 < count; v++)
+	{
+		if (v % width != width - 1)
+		{
+			int quad[6] = { v, v + width, v + 1, v + 1, v + width, v + width + 1 };
+			submesh.Indices.insert(submesh.Indices.end(), quad, quad + 6);
+		}
+	}
+	submesh.Material = 0;
+	submesh.Spilled = false;
+	submesh.SpillOffset = 0;
+
+	scene.Textures.resize(1);
+	scene.Textures[0].Name = "Texture.png";
+	scene.Textures[0].FileName = "Texture.png";
+	scene.Textures[0].RelativeFileName = "Texture.png";
+
+	scene.Materials.resize(1);
+	SceneMaterial& material = scene.Materials[0];
+	material.Name = "Material";
+	for (int c = 0; c < 4; c++)
+	{
+		material.Diffuse[c] = 0.8f;
+		material.Ambient[c] = 0.2f;
+		material.Emissive[c] = 0;
+		material.Specular[c] = 0.5f;
+		material.Reflection[c] = 0;
+	}
+	material.Shininess = 20;
+	material.Transparency = 0;
+	SceneMaterialTexture link = { 0, 0, { 0, 0 }, { 1, 1 } };
+	material.Textures.push_back(link);
+
+	scene.Morphs.resize(1);
+	SceneMorph& morph = scene.Morphs[0];
+	morph.Mesh = 0;
+	morph.Submesh = 0;
+	morph.Name = "Morph";
+	morph.WeightProperties = false;
+	morph.Channels.resize(1);
+	morph.Channels[0].Name = "Channel";
+	morph.Channels[0].DeformPercent = 0;
+	morph.Channels[0].Shapes.resize(1);
+	SceneShape& shape = morph.Channels[0].Shapes[0];
+	shape.Name = "Shape";
+	shape.Weight = 100;
+	shape.Indices.push_back(3);
+	shape.Deltas.push_back(0);
+	shape.Deltas.push_back(0);
+	shape.Deltas.push_back(0.25f);
+
+	scene.Clips.resize(1);
+	SceneClip& clip = scene.Clips[0];
+	clip.Name = "Clip";
+	clip.Tracks.resize(1);
+	SceneTrack& track = clip.Tracks[0];
+	track.Frame = 1;
+	SceneCurve* curves[3] = { &track.Scalings, &track.Rotations, &track.Translations };
+	for (int c = 0; c < 3; c++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			curves[c]->Times.push_back(k / 30.0f);
+			for (int axis = 0; axis < 3; axis++)
+			{
+				curves[c]->Values.push_back((c == 0 ? 1.0f : 0.0f) + 0.5f * k * (axis + 1));
+			}
+		}
+	}
+	track.Rotations.Linear = true;
+
+	scene.ScaleFactor = 1;
+	scene.BoneSize = 0;
+	scene.Spill = NULL;
+}
+
+//One parsed FBX record, array properties are inflated into Arrays
+struct FbxRecord
+{
+	std::string Name;
+	std::vector<std::string> Strings;
+	std::vector<std::vector<unsigned char> > Arrays;
+	std::vector<FbxRecord> Children;
+	int CompressedArrays;
+
+	const FbxRecord* Child(const char* name) const
+	{
+		for (size_t i = 0; i < Children.size(); i++)
+		{
+			if (Children[i].Name == name)
+			{
+				return &Children[i];
+			}
+		}
+		return NULL;
+	}
+};
+
+class FbxReader
+{
+public:
+	FbxReader(const std::vector<unsigned char>& data, int version) : data(data), wide(version >= 7500), position(27) {}
+
+	//Reads one record and its children, returns false on the null record that closes a list
+	bool Read(FbxRecord& record)
+	{
+		unsigned long long end = Offset();
+		unsigned long long properties = Offset();
+		unsigned long long propertyBytes = Offset();
+		unsigned char nameLength = Byte();
+		if (end == 0)
+		{
+			return false;
+		}
+		record.Name = std::string((const char*)Take(nameLength), nameLength);
+		record.CompressedArrays = 0;
+		size_t propertyStart = position;
+		for (unsigned long long i = 0; i < properties; i++)
+		{
+			ReadProperty(record);
+		}
+		Check(position - propertyStart == propertyBytes, record.Name + " property list length");
+		if (position < end)
+		{
+			FbxRecord child;
+			while (Read(child))
+			{
+				record.Children.push_back(child);
+				child = FbxRecord();
+			}
+		}
+		Check(position == end, record.Name + " end offset");
+		position = (size_t)end;
+		return true;
+	}
+
+private:
+	const std::vector<unsigned char>& data;
+	bool wide;
+	size_t position;
+
+	const unsigned char* Take(size_t length)
+	{
+		if (position + length > data.size())
+		{
+			throw std::runtime_error("FBX record runs past the end of the file");
+		}
+		const unsigned char* p = &data[position];
+		position += length;
+		return p;
+	}
+
+	unsigned char Byte()
+	{
+		return *Take(1);
+	}
+
+	unsigned int UInt32()
+	{
+		unsigned int value;
+		memcpy(&value, Take(4), 4);
+		return value;
+	}
+
+	unsigned long long Offset()
+	{
+		unsigned long long value = 0;
+		memcpy(&value, Take(wide ? 8 : 4), wide ? 8 : 4);
+		return value;
+	}
+
+	void ReadProperty(FbxRecord& record)
+	{
+		char type = (char)Byte();
+		switch (type)
+		{
+		case 'C': Take(1); break;
+		case 'Y': Take(2); break;
+		case 'I': case 'F': Take(4); break;
+		case 'D': case 'L': Take(8); break;
+		case 'S': case 'R':
+		{
+			unsigned int length = UInt32();
+			const char* p = (const char*)Take(length);
+			record.Strings.push_back(std::string(p, length));
+			break;
+		}
+		case 'f': case 'i': ReadArray(record, 4); break;
+		case 'd': case 'l': ReadArray(record, 8); break;
+		case 'b': ReadArray(record, 1); break;
+		default:
+			throw std::runtime_error(std::string("Unknown FBX property type in ") + record.Name);
+		}
+	}
+
+	void ReadArray(FbxRecord& record, size_t elementSize)
+	{
+		unsigned int count = UInt32();
+		unsigned int encoding = UInt32();
+		unsigned int length = UInt32();
+		const unsigned char* p = Take(length);
+		std::vector<unsigned char> values(count * elementSize);
+		if (encoding == 1)
+		{
+			uLongf inflated = (uLongf)values.size();
+			Check(uncompress(values.empty() ? NULL : &values[0], &inflated, p, length) == Z_OK && inflated == values.size(), record.Name + " inflates");
+			record.CompressedArrays++;
+		}
+		else
+		{
+			Check(encoding == 0 && length == values.size(), record.Name + " raw array length");
+			if (!values.empty())
+			{
+				memcpy(&values[0], p, values.size());
+			}
+		}
+		record.Arrays.push_back(values);
+	}
+};
+
+template<class T>
+static std::vector<T> ArrayOf(const FbxRecord* record)
+{
+	std::vector<T> values;
+	if (record != NULL && !record->Arrays.empty() && !record->Arrays[0].empty())
+	{
+		values.resize(record->Arrays[0].size() / sizeof(T));
+		memcpy(&values[0], &record->Arrays[0][0], values.size() * sizeof(T));
+	}
+	return values;
+}
+
+static int CountCompressed(const FbxRecord& record)
+{
+	int compressed = record.CompressedArrays;
+	for (size_t i = 0; i < record.Children.size(); i++)
+	{
+		compressed += CountCompressed(record.Children[i]);
+	}
+	return compressed;
+}
+
+static void TestFbx(const Scene& scene, int version, bool compress)
+{
+	std::string label = "fbx " + std::to_string(version) + (compress ? " compressed" : "");
+	std::string path = "AssetStudioFBXTest-" + std::to_string(version) + (compress ? "c" : "") + ".fbx";
+	SceneWriteStats stats = WriteBinaryFbx(scene, path.c_str(), version, compress);
+	std::vector<unsigned char> data = ReadFile(path.c_str());
+	remove(path.c_str());
+
+	Check(stats.FileBytes == data.size(), label + " reported size");
+	Check(data.size() > 27 && memcmp(&data[0], "Kaydara FBX Binary  \0\x1a\0", 23) == 0, label + " magic");
+	unsigned int fileVersion;
+	memcpy(&fileVersion, &data[23], 4);
+	Check(fileVersion == (unsigned int)version, label + " version");
+
+	FbxReader reader(data, version);
+	std::vector<FbxRecord> top;
+	FbxRecord record;
+	while (reader.Read(record))
+	{
+		top.push_back(record);
+		record = FbxRecord();
+	}
+	FbxRecord document;
+	document.Children = top;
+	Check(document.Child("FBXHeaderExtension") != NULL, label + " header extension");
+	Check(document.Child("Connections") != NULL, label + " connections");
+	const FbxRecord* objects = document.Child("Objects");
+	Check(objects != NULL, label + " objects");
+	if (objects == NULL)
+	{
+		return;
+	}
+
+	int meshes = 0, shapes = 0, curves = 0;
+	for (size_t i = 0; i < objects->Children.size(); i++)
+	{
+		const FbxRecord& object = objects->Children[i];
+		if (object.Name == "AnimationCurve")
+		{
+			curves++;
+		}
+		if (object.Name != "Geometry" || object.Strings.empty())
+		{
+			continue;
+		}
+		if (object.Strings.back() == "Shape")
+		{
+			shapes++;
+			std::vector<double> deltas = ArrayOf<double>(object.Child("Vertices"));
+			std::vector<int> indexes = ArrayOf<int>(object.Child("Indexes"));
+			Check(indexes.size() == 1 && indexes[0] == 3 && deltas.size() == 3 && deltas[2] == 0.25, label + " shape deltas");
+			continue;
+		}
+		meshes++;
+		const SceneSubmesh& submesh = scene.Meshes[0].Submeshes[0];
+		std::vector<double> vertices = ArrayOf<double>(object.Child("Vertices"));
+		bool same = vertices.size() == submesh.Positions.size();
+		for (size_t k = 0; same && k < vertices.size(); k++)
+		{
+			same = vertices[k] == (double)submesh.Positions[k];
+		}
+		Check(same, label + " vertices");
+		std::vector<int> polygons = ArrayOf<int>(object.Child("PolygonVertexIndex"));
+		same = polygons.size() == submesh.Indices.size();
+		for (size_t k = 0; same && k < polygons.size(); k++)
+		{
+			same = polygons[k] == (k % 3 == 2 ? ~submesh.Indices[k] : submesh.Indices[k]);
+		}
+		Check(same, label + " polygon vertex index");
+		const FbxRecord* normals = object.Child("LayerElementNormal");
+		std::vector<double> normalValues = ArrayOf<double>(normals != NULL ? normals->Child("Normals") : NULL);
+		Check(normalValues.size() == submesh.Normals.size() && normalValues[2] == -1, label + " normals");
+		Check(object.Child("LayerElementUV") != NULL && object.Child("LayerElementColor") != NULL, label + " uv and colour layers");
+	}
+	Check(meshes == 1, label + " mesh geometry count");
+	Check(shapes == 1, label + " shape geometry count");
+	Check(curves > 0, label + " animation curves");
+	Check(!compress || CountCompressed(document) > 0, label + " compressed arrays");
+	Check(compress || CountCompressed(document) == 0, label + " uncompressed arrays");
+}
+
+static void TestGlb(const Scene& scene)
+{
+	const char* path = "AssetStudioFBXTest.glb";
+	GlbWriteStats stats = WriteGlb(scene, path);
+	std::vector<unsigned char> data = ReadFile(path);
+	remove(path);
+
+	unsigned int header[5];
+	Check(data.size() >= sizeof(header) && stats.FileBytes == data.size(), "glb reported size");
+	if (data.size() < sizeof(header))
+	{
+		return;
+	}
+	memcpy(header, &data[0], sizeof(header));
+	Check(header[0] == 0x46546c67 && header[1] == 2 && header[2] == data.size(), "glb header");
+	//JSON chunk then the BIN chunk, both padded to four bytes
+	Check(header[4] == 0x4e4f534a && header[3] % 4 == 0 && 20 + (size_t)header[3] + 8 <= data.size(), "glb json chunk");
+	if (20 + (size_t)header[3] + 8 > data.size())
+	{
+		return;
+	}
+	std::string json((const char*)&data[20], header[3]);
+	Check(json.compare(0, 35, "{\"asset\":{\"version\":\"2.0\",\"generato") == 0, "glb asset");
+	Check(json.find("\"Texture.png\"") != std::string::npos && json.find("\"Clip\"") != std::string::npos, "glb names");
+	unsigned int chunk[2];
+	memcpy(chunk, &data[20 + header[3]], sizeof(chunk));
+	Check(chunk[1] == 0x004e4942 && 28 + (size_t)header[3] + chunk[0] == data.size(), "glb bin chunk");
+}
+
+static void TestSnapshot(const Scene& scene)
+{
+	const char* path = "AssetStudioFBXTest.snap";
+	WriteSceneSnapshot(scene, path);
+	Scene read;
+	read.Spill = NULL;
+	ReadSceneSnapshot(path, read);
+	remove(path);
+
+	Check(read.Frames.size() == scene.Frames.size() && read.Frames[1].Name == "Joint" && read.Frames[1].Parent == 0
+		&& read.Frames[1].Attribute == FrameJoint && read.Frames[1].LocalPosition[2] == 3, "snapshot frames");
+	const SceneSubmesh& a = scene.Meshes[0].Submeshes[0];
+	const SceneSubmesh& b = read.Meshes[0].Submeshes[0];
+	Check(b.VertexCount == a.VertexCount && b.Material == a.Material && b.Positions == a.Positions && b.Normals == a.Normals
+		&& b.UV0 == a.UV0 && b.Tangents == a.Tangents && b.Colours == a.Colours && b.Indices == a.Indices
+		&& b.BoneIndices == a.BoneIndices && b.Weights == a.Weights, "snapshot submesh");
+	Check(read.Meshes[0].Bones.size() == 1 && read.Meshes[0].Bones[0].Frame == 1, "snapshot bones");
+	Check(read.Materials.size() == 1 && read.Materials[0].Name == "Material" && read.Materials[0].Textures.size() == 1, "snapshot materials");
+	Check(read.Textures.size() == 1 && read.Textures[0].RelativeFileName == "Texture.png", "snapshot textures");
+	Check(read.Morphs.size() == 1 && read.Morphs[0].Channels[0].Shapes[0].Deltas == scene.Morphs[0].Channels[0].Shapes[0].Deltas, "snapshot morphs");
+	const SceneTrack& track = read.Clips[0].Tracks[0];
+	Check(track.Rotations.Linear && !track.Translations.Linear && track.Translations.Values == scene.Clips[0].Tracks[0].Translations.Values, "snapshot curves");
+}
+
+static void TestWeld()
+{
+	//two triangles over four corners, both copies of corner 1 are bound to bone 0 with a stray bone in an empty slot,
+	//the copies of corner 2 are bound to different bones
+	const float corners[4][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 } };
+	const int corner[6] = { 0, 1, 2, 1, 3, 2 };
+	const int bone[6] = { 0, 0, 0, 0, 1, 1 };
+	SceneSubmesh submesh = SceneSubmesh();
+	submesh.VertexCount = 6;
+	submesh.Material = -1;
+	for (int v = 0; v < 6; v++)
+	{
+		submesh.Positions.insert(submesh.Positions.end(), corners[corner[v]], corners[corner[v]] + 3);
+		submesh.Indices.push_back(v);
+		int influences[4] = { bone[v], v == 3 ? 5 : 0, 0, 0 };
+		float weights[4] = { 1, 0, 0, 0 };
+		submesh.BoneIndices.insert(submesh.BoneIndices.end(), influences, influences + 4);
+		submesh.Weights.insert(submesh.Weights.end(), weights, weights + 4);
+	}
+	SceneSubmesh welded = submesh;
+	SceneOptimizeStats stats = OptimizeSceneSubmesh(welded, 0.001);
+	Check(welded.VertexCount == 5 && stats.WeldedVertices == 1, "weld merges only equal influences");
+	bool kept = welded.BoneIndices.size() == 20 && welded.Weights.size() == 20 && welded.Indices.size() == 6;
+	for (size_t i = 0; kept && i < welded.Indices.size(); i++)
+	{
+		int source = corner[i], target = welded.Indices[i];
+		kept = welded.Positions[target * 3] == corners[source][0] && welded.Positions[target * 3 + 1] == corners[source][1]
+			&& welded.BoneIndices[target * 4] == bone[i] && welded.Weights[target * 4] == 1;
+	}
+	Check(kept, "weld keeps influences with their vertices");
+
+	SceneSubmesh exact = submesh;
+	OptimizeSceneSubmesh(exact, 0);
+	Check(exact.VertexCount == 5, "exact weld merges only equal influences");
+	exact = submesh;
+	const int split[4] = { 0, 3, 0, 0 };
+	const float first[4] = { 0.6f, 0.4f, 0, 0 }, second[4] = { 0.6004f, 0.3996f, 0, 0 };
+	std::copy(split, split + 4, &exact.BoneIndices[4]);
+	std::copy(split, split + 4, &exact.BoneIndices[12]);
+	std::copy(first, first + 4, &exact.Weights[4]);
+	std::copy(second, second + 4, &exact.Weights[12]);
+	OptimizeSceneSubmesh(exact, 0.01);
+	Check(exact.VertexCount == 5, "weld merges close weights");
+	exact = submesh;
+	exact.BoneIndices[12] = 1;
+	OptimizeSceneSubmesh(exact, 0.5);
+	Check(exact.VertexCount == 6, "weld never merges neighbouring bones");
+}
+
+//The same steps as FbxAMatrix::SetQ and GetR with the C library, what QuaternionsToEuler promises to stay within 1 ulp of
+static void ReferenceQuaternionToEuler(const float* q, float* e)
+{
+	double x = q[0], y = q[1], z = q[2], w = q[3];
+	double x2 = x + x, y2 = y + y, z2 = z + z;
+	double xx = x * x2, xy = x * y2, xz = x * z2, yy = y * y2, yz = y * z2, zz = z * z2;
+	double wx = w * x2, wy = w * y2, wz = w * z2;
+	double m00 = 1 - (yy + zz), m01 = xy + wz, m02 = xz - wy;
+	double m11 = 1 - (xx + zz), m12 = yz + wx, m21 = yz - wx, m22 = 1 - (xx + yy);
+	double cy = sqrt(m00 * m00 + m01 * m01);
+	bool locked = !(cy > 16 * FLT_EPSILON);
+	double rx = locked ? atan2(-m21, m11) : atan2(m12, m22);
+	double ry = atan2(-m02, cy);
+	double rz = locked ? 0 : atan2(m01, m00);
+	const double toDegrees = 57.295779513082320876798154814105;
+	e[0] = (float)(rx * toDegrees);
+	e[1] = (float)(ry * toDegrees);
+	e[2] = (float)(rz * toDegrees);
+}
+
+static long long UlpDistance(float a, float b)
+{
+	int ia, ib;
+	memcpy(&ia, &a, sizeof(ia));
+	memcpy(&ib, &b, sizeof(ib));
+	long long la = ia < 0 ? (long long)INT_MIN - ia : ia;
+	long long lb = ib < 0 ? (long long)INT_MIN - ib : ib;
+	return la > lb ? la - lb : lb - la;
+}
+
+static void TestRotations()
+{
+	//random keys, then keys with cos(y) from 0 to 4 times the gimbal threshold. The count leaves a tail for every SIMD width.
+	const int randomCount = 4093, gimbalCount = 1024, count = randomCount + gimbalCount;
+	std::vector<float> quats(count * 4);
+	unsigned int seed = 12345;
+	for (int i = 0; i < randomCount; i++)
+	{
+		double q[4], length = 0;
+		for (int c = 0; c < 4; c++)
+		{
+			seed = seed * 1664525 + 1013904223;
+			q[c] = seed / 2147483648.0 - 1;
+			length += q[c] * q[c];
+		}
+		for (int c = 0; c < 4; c++)
+		{
+			quats[i * 4 + c] = (float)(q[c] / sqrt(length));
+		}
+	}
+	std::vector<float> gimbalEulers(gimbalCount * 3);
+	for (int i = 0; i < gimbalCount; i++)
+	{
+		double offset = asin(4.0 * 16 * FLT_EPSILON * i / gimbalCount) * 57.295779513082320876798154814105;
+		gimbalEulers[i * 3] = (float)(i % 360 - 180);
+		gimbalEulers[i * 3 + 1] = (float)((i & 1) ? 90 - offset : offset - 90);
+		gimbalEulers[i * 3 + 2] = (float)(i * 7 % 360 - 180);
+	}
+	EulersToQuaternion(gimbalEulers.data(), &quats[randomCount * 4], gimbalCount);
+
+	std::vector<float> reference(count * 3);
+	for (int i = 0; i < count; i++)
+	{
+		ReferenceQuaternionToEuler(&quats[i * 4], &reference[i * 3]);
+	}
+	std::vector<float> scalar(count * 3);
+	QuaternionsToEuler(quats.data(), scalar.data(), count, RotationScalar);
+	long long worst = 0;
+	for (size_t i = 0; i < scalar.size(); i++)
+	{
+		worst = std::max(worst, UlpDistance(scalar[i], reference[i]));
+	}
+	Check(worst <= 1, "rotations within 1 ulp of the reference, " + std::to_string(worst) + " ulp");
+
+	for (int path = RotationSse41; path <= DetectRotationPath(); path++)
+	{
+		std::string name = RotationPathName((RotationPath)path);
+		//every length up to two widths past a whole block, with a guard key after the end
+		bool same = true;
+		for (int length = count - 9; length <= count; length++)
+		{
+			std::vector<float> eulers(count * 3 + 3, 12345.0f);
+			QuaternionsToEuler(quats.data(), eulers.data(), length, (RotationPath)path);
+			same = same && memcmp(eulers.data(), scalar.data(), length * 3 * sizeof(float)) == 0 && eulers[length * 3] == 12345.0f;
+		}
+		Check(same, name + " rotations bit-identical to the scalar path");
+	}
+}
+
+static void AddKey(SceneCurve& curve, float time, float x, float y, float z)
+{
+	curve.Times.push_back(time);
+	curve.Values.push_back(x);
+	curve.Values.push_back(y);
+	curve.Values.push_back(z);
+}
+
+static void TestKeyReduction()
+{
+	SceneCurve unsorted;
+	AddKey(unsorted, 0.2f, 1, 1, 1);
+	AddKey(unsorted, 0.1f, 2, 2, 2);
+	AddKey(unsorted, 0.2f, 3, 3, 3);
+	AddKey(unsorted, 0, 4, 4, 4);
+	SortKeys(unsorted);
+	Check(unsorted.Times == std::vector<float>({ 0, 0.1f, 0.2f }) && unsorted.Values == std::vector<float>({ 4, 4, 4, 2, 2, 2, 3, 3, 3 }),
+		"sorted keys merge equal times, the last key wins");
+
+	//a sine on x, a straight line on y and a constant on z
+	const float tolerance = 0.05f;
+	SceneCurve original;
+	for (int i = 0; i < 300; i++)
+	{
+		float t = i / 30.0f;
+		AddKey(original, t, 10 * sinf(t * 3), 2 * t - 1, 5);
+	}
+	SceneCurve reduced = original;
+	ReduceKeys(reduced, tolerance, NULL);
+	bool within = reduced.Linear && reduced.Times.size() > 2 && reduced.Times.size() < original.Times.size() / 2
+		&& reduced.Times.front() == original.Times.front() && reduced.Times.back() == original.Times.back();
+	size_t segment = 0;
+	for (size_t i = 0; within && i < original.Times.size(); i++)
+	{
+		float t = original.Times[i];
+		while (segment + 2 < reduced.Times.size() && reduced.Times[segment + 1] < t)
+		{
+			segment++;
+		}
+		float t0 = reduced.Times[segment], t1 = reduced.Times[segment + 1];
+		for (int c = 0; c < 3; c++)
+		{
+			float v0 = reduced.Values[segment * 3 + c], v1 = reduced.Values[segment * 3 + 3 + c];
+			float line = v0 + (v1 - v0) * (t - t0) / (t1 - t0);
+			within = within && fabsf(line - original.Values[i * 3 + c]) <= tolerance * 1.001f;
+		}
+	}
+	Check(within, "dropped keys within tolerance of the kept lines");
+
+	SceneCurve unreduced = original;
+	ReduceKeys(unreduced, 0, NULL);
+	Check(unreduced.Times == original.Times && unreduced.Values == original.Values && !unreduced.Linear, "zero tolerance keeps every key");
+
+	const float rest[3] = { 1, 2, 3 };
+	SceneCurve atRest, constant;
+	for (int i = 0; i < 10; i++)
+	{
+		AddKey(atRest, i / 30.0f, 1 + ((i & 1) ? 0.02f : -0.02f), 2, 3);
+		AddKey(constant, i / 30.0f, 1, 2, 4);
+	}
+	ReduceKeys(atRest, tolerance, rest);
+	ReduceKeys(constant, tolerance, rest);
+	Check(atRest.Times.empty() && atRest.Values.empty(), "constant curve at rest removed");
+	Check(constant.Times.size() == 1 && constant.Values == std::vector<float>({ 1, 2, 4 }), "constant curve away from rest keeps one key");
+}
+
+static float Wrap(float angle)
+{
+	return angle - 360.0f * floorf((angle + 180.0f) / 360.0f);
+}
+
+static void TestUnroll()
+{
+	//a rotation winding past a full turn, stored wrapped to [-180, 180) and every other key as its (x + 180, 180 - y, z + 180) twin
+	SceneCurve curve;
+	std::vector<float> expected;
+	for (int i = 0; i < 120; i++)
+	{
+		float x = 4.0f * i, y = 20 * sinf(i / 10.0f), z = -3.0f * i;
+		expected.insert(expected.end(), { x, y, z });
+		if (i & 1)
+		{
+			AddKey(curve, i / 30.0f, Wrap(x + 180), Wrap(180 - y), Wrap(z + 180));
+		}
+		else
+		{
+			AddKey(curve, i / 30.0f, Wrap(x), Wrap(y), Wrap(z));
+		}
+	}
+	UnrollEulers(curve, 0.25f);
+	bool continuous = true;
+	for (size_t i = 0; i < expected.size(); i++)
+	{
+		continuous = continuous && fabsf(curve.Values[i] - expected[i]) < 1e-3f;
+	}
+	Check(continuous, "unrolled wraps and flips into the continuous curve");
+
+	//the wrapped twin of 180.1 is only 0.2 degrees closer, within 0.25 but not within 0.1
+	SceneCurve close;
+	AddKey(close, 0, 0, 0, 0);
+	AddKey(close, 1, 0, 0, 180.1f);
+	SceneCurve precise = close;
+	UnrollEulers(close, 0.25f);
+	UnrollEulers(precise, 0.1f);
+	Check(close.Values[5] == 180.1f, "unroll leaves changes within precision");
+	Check(fabsf(precise.Values[5] + 179.9f) < 1e-3f, "unroll takes changes past precision");
+}
+
+int main()
+{
+	Scene scene;
+	BuildScene(scene);
+	try
+	{
+		TestFbx(scene, 7400, false);
+		TestFbx(scene, 7400, true);
+		TestFbx(scene, 7500, false);
+		TestFbx(scene, 7500, true);
+		TestGlb(scene);
+		TestSnapshot(scene);
+		TestWeld();
+		TestRotations();
+		TestKeyReduction();
+		TestUnroll();
+	}
+	catch (const std::exception& e)
+	{
+		fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+	if (failures == 0)
+	{
+		printf("All checks passed\n");
+	}
+	return failures == 0 ? 0 : 1;
+}
@@ -38,6 +38,12 @@
             this.tobmp = new System.Windows.Forms.RadioButton();
             this.converttexture = new System.Windows.Forms.CheckBox();
             this.groupBox2 = new System.Windows.Forms.GroupBox();
+            this.scaleTolerance = new System.Windows.Forms.NumericUpDown();
+            this.label8 = new System.Windows.Forms.Label();
+            this.rotationTolerance = new System.Windows.Forms.NumericUpDown();
+            this.label7 = new System.Windows.Forms.Label();
+            this.positionTolerance = new System.Windows.Forms.NumericUpDown();
+            this.label6 = new System.Windows.Forms.Label();
             this.scaleFactor = new System.Windows.Forms.NumericUpDown();
             this.label5 = new System.Windows.Forms.Label();
             this.fbxFormat = new System.Windows.Forms.ComboBox();
@@ -56,6 +62,9 @@
             this.groupBox1.SuspendLayout();
             this.panel1.SuspendLayout();
             this.groupBox2.SuspendLayout();
+            ((System.ComponentModel.ISupportInitialize)(this.scaleTolerance)).BeginInit();
+            ((System.ComponentModel.ISupportInitialize)(this.rotationTolerance)).BeginInit();
+            ((System.ComponentModel.ISupportInitialize)(this.positionTolerance)).BeginInit();
             ((System.ComponentModel.ISupportInitialize)(this.scaleFactor)).BeginInit();
             ((System.ComponentModel.ISupportInitialize)(this.boneSize)).BeginInit();
             ((System.ComponentModel.ISupportInitialize)(this.filterPrecision)).BeginInit();
@@ -63,7 +72,7 @@
             // 
             // OKbutton
             // 
-            this.OKbutton.Location = new System.Drawing.Point(321, 267);
+            this.OKbutton.Location = new System.Drawing.Point(321, 348);
             this.OKbutton.Name = "OKbutton";
             this.OKbutton.Size = new System.Drawing.Size(75, 21);
             this.OKbutton.TabIndex = 6;
@@ -74,7 +83,7 @@
             // Cancel
             // 
             this.Cancel.DialogResult = System.Windows.Forms.DialogResult.Cancel;
-            this.Cancel.Location = new System.Drawing.Point(402, 267);
+            this.Cancel.Location = new System.Drawing.Point(402, 348);
             this.Cancel.Name = "Cancel";
             this.Cancel.Size = new System.Drawing.Size(75, 21);
             this.Cancel.TabIndex = 7;
@@ -164,6 +173,12 @@
             // groupBox2
             // 
             this.groupBox2.AutoSize = true;
+            this.groupBox2.Controls.Add(this.scaleTolerance);
+            this.groupBox2.Controls.Add(this.label8);
+            this.groupBox2.Controls.Add(this.rotationTolerance);
+            this.groupBox2.Controls.Add(this.label7);
+            this.groupBox2.Controls.Add(this.positionTolerance);
+            this.groupBox2.Controls.Add(this.label6);
             this.groupBox2.Controls.Add(this.scaleFactor);
             this.groupBox2.Controls.Add(this.label5);
             this.groupBox2.Controls.Add(this.fbxFormat);
@@ -181,11 +196,80 @@
             this.groupBox2.Controls.Add(this.eulerFilter);
             this.groupBox2.Location = new System.Drawing.Point(12, 12);
             this.groupBox2.Name = "groupBox2";
-            this.groupBox2.Size = new System.Drawing.Size(214, 276);
+            this.groupBox2.Size = new System.Drawing.Size(214, 357);
             this.groupBox2.TabIndex = 11;
             this.groupBox2.TabStop = false;
             this.groupBox2.Text = "Fbx";
             // 
+            // scaleTolerance
+            // 
+            this.scaleTolerance.DecimalPlaces = 3;
+            this.scaleTolerance.Increment = new decimal(new int[] {
+            1,
+            0,
+            0,
+            196608});
+            this.scaleTolerance.Location = new System.Drawing.Point(127, 317);
+            this.scaleTolerance.Name = "scaleTolerance";
+            this.scaleTolerance.Size = new System.Drawing.Size(60, 21);
+            this.scaleTolerance.TabIndex = 26;
+            this.scaleTolerance.TextAlign = System.Windows.Forms.HorizontalAlignment.Center;
+            // 
+            // label8
+            // 
+            this.label8.AutoSize = true;
+            this.label8.Location = new System.Drawing.Point(4, 319);
+            this.label8.Name = "label8";
+            this.label8.Size = new System.Drawing.Size(89, 12);
+            this.label8.TabIndex = 25;
+            this.label8.Text = "ScaleTolerance";
+            // 
+            // rotationTolerance
+            // 
+            this.rotationTolerance.DecimalPlaces = 2;
+            this.rotationTolerance.Increment = new decimal(new int[] {
+            1,
+            0,
+            0,
+            131072});
+            this.rotationTolerance.Location = new System.Drawing.Point(127, 290);
+            this.rotationTolerance.Name = "rotationTolerance";
+            this.rotationTolerance.Size = new System.Drawing.Size(60, 21);
+            this.rotationTolerance.TabIndex = 24;
+            this.rotationTolerance.TextAlign = System.Windows.Forms.HorizontalAlignment.Center;
+            // 
+            // label7
+            // 
+            this.label7.AutoSize = true;
+            this.label7.Location = new System.Drawing.Point(4, 292);
+            this.label7.Name = "label7";
+            this.label7.Size = new System.Drawing.Size(107, 12);
+            this.label7.TabIndex = 23;
+            this.label7.Text = "RotationTolerance";
+            // 
+            // positionTolerance
+            // 
+            this.positionTolerance.DecimalPlaces = 3;
+            this.positionTolerance.Increment = new decimal(new int[] {
+            1,
+            0,
+            0,
+            196608});
+            this.positionTolerance.Location = new System.Drawing.Point(127, 263);
+            this.positionTolerance.Name = "positionTolerance";
+            this.positionTolerance.Size = new System.Drawing.Size(60, 21);
+            this.positionTolerance.TabIndex = 22;
+            this.positionTolerance.TextAlign = System.Windows.Forms.HorizontalAlignment.Center;
+            // 
+            // label6
+            // 
+            this.label6.AutoSize = true;
+            this.label6.Location = new System.Drawing.Point(4, 265);
+            this.label6.Name = "label6";
+            this.label6.Size = new System.Drawing.Size(107, 12);
+            this.label6.TabIndex = 21;
+            this.label6.Text = "PositionTolerance";
+            // 
             // scaleFactor
             // 
             this.scaleFactor.DecimalPlaces = 2;
@@ -370,7 +454,7 @@
             this.AutoScaleDimensions = new System.Drawing.SizeF(6F, 12F);
             this.AutoScaleMode = System.Windows.Forms.AutoScaleMode.Font;
             this.CancelButton = this.Cancel;
-            this.ClientSize = new System.Drawing.Size(490, 301);
+            this.ClientSize = new System.Drawing.Size(490, 382);
             this.Controls.Add(this.groupBox2);
             this.Controls.Add(this.groupBox1);
             this.Controls.Add(this.Cancel);
@@ -389,6 +473,9 @@
             this.panel1.PerformLayout();
             this.groupBox2.ResumeLayout(false);
             this.groupBox2.PerformLayout();
+            ((System.ComponentModel.ISupportInitialize)(this.scaleTolerance)).EndInit();
+            ((System.ComponentModel.ISupportInitialize)(this.rotationTolerance)).EndInit();
+            ((System.ComponentModel.ISupportInitialize)(this.positionTolerance)).EndInit();
             ((System.ComponentModel.ISupportInitialize)(this.scaleFactor)).EndInit();
             ((System.ComponentModel.ISupportInitialize)(this.boneSize)).EndInit();
             ((System.ComponentModel.ISupportInitialize)(this.filterPrecision)).EndInit();
@@ -423,5 +510,11 @@
         private System.Windows.Forms.Label label4;
         private System.Windows.Forms.NumericUpDown scaleFactor;
         private System.Windows.Forms.Label label5;
+        private System.Windows.Forms.NumericUpDown positionTolerance;
+        private System.Windows.Forms.Label label6;
+        private System.Windows.Forms.NumericUpDown rotationTolerance;
+        private System.Windows.Forms.Label label7;
+        private System.Windows.Forms.NumericUpDown scaleTolerance;
+        private System.Windows.Forms.Label label8;
     }
 }
\ No newline at end of file
@@ -28,6 +28,9 @@ namespace AssetStudioGUI
             }
             eulerFilter.Checked = (bool)Properties.Settings.Default["eulerFilter"];
             filterPrecision.Value = (decimal)Properties.Settings.Default["filterPrecision"];
+            positionTolerance.Value = (decimal)Properties.Settings.Default["positionTolerance"];
+            rotationTolerance.Value = (decimal)Properties.Settings.Default["rotationTolerance"];
+            scaleTolerance.Value = (decimal)Properties.Settings.Default["scaleTolerance"];
             allFrames.Checked = (bool)Properties.Settings.Default["allFrames"];
             allBones.Checked = (bool)Properties.Settings.Default["allBones"];
             skins.Checked = (bool)Properties.Settings.Default["skins"];
@@ -58,6 +61,9 @@ namespace AssetStudioGUI
             }
             Properties.Settings.Default["eulerFilter"] = eulerFilter.Checked;
             Properties.Settings.Default["filterPrecision"] = filterPrecision.Value;
+            Properties.Settings.Default["positionTolerance"] = positionTolerance.Value;
+            Properties.Settings.Default["rotationTolerance"] = rotationTolerance.Value;
+            Properties.Settings.Default["scaleTolerance"] = scaleTolerance.Value;
             Properties.Settings.Default["allFrames"] = allFrames.Checked;
             Properties.Settings.Default["allBones"] = allBones.Checked;
             Properties.Settings.Default["skins"] = skins.Checked;
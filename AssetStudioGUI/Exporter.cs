@@ -311,17 +311,23 @@ namespace AssetStudioGUI
 
         private static bool ExportFbx(IImported convert, string exportPath)
         {
-            var eulerFilter = (bool)Properties.Settings.Default["eulerFilter"];
-            var filterPrecision = (float)(decimal)Properties.Settings.Default["filterPrecision"];
-            var allFrames = (bool)Properties.Settings.Default["allFrames"];
-            var allBones = (bool)Properties.Settings.Default["allBones"];
-            var skins = (bool)Properties.Settings.Default["skins"];
-            var boneSize = (int)(decimal)Properties.Settings.Default["boneSize"];
-            var scaleFactor = (float)(decimal)Properties.Settings.Default["scaleFactor"];
-            var flatInbetween = (bool)Properties.Settings.Default["flatInbetween"];
-            var fbxVersion = (int)Properties.Settings.Default["fbxVersion"];
-            var fbxFormat = (int)Properties.Settings.Default["fbxFormat"];
-            ModelExporter.ExportFbx(exportPath, convert, eulerFilter, filterPrecision, allFrames, allBones, skins, boneSize, scaleFactor, flatInbetween, fbxVersion, fbxFormat == 1);
+            var options = new FbxExportOptions
+            {
+                EulerFilter = (bool)Properties.Settings.Default["eulerFilter"],
+                FilterPrecision = (float)(decimal)Properties.Settings.Default["filterPrecision"],
+                PositionTolerance = (float)(decimal)Properties.Settings.Default["positionTolerance"],
+                RotationTolerance = (float)(decimal)Properties.Settings.Default["rotationTolerance"],
+                ScaleTolerance = (float)(decimal)Properties.Settings.Default["scaleTolerance"],
+                AllFrames = (bool)Properties.Settings.Default["allFrames"],
+                AllBones = (bool)Properties.Settings.Default["allBones"],
+                Skins = (bool)Properties.Settings.Default["skins"],
+                BoneSize = (int)(decimal)Properties.Settings.Default["boneSize"],
+                ScaleFactor = (float)(decimal)Properties.Settings.Default["scaleFactor"],
+                FlatInbetween = (bool)Properties.Settings.Default["flatInbetween"],
+                VersionIndex = (int)Properties.Settings.Default["fbxVersion"],
+                IsAscii = (int)Properties.Settings.Default["fbxFormat"] == 1
+            };
+            ModelExporter.ExportFbx(exportPath, convert, options);
             return true;
         }
     }
@@ -0,0 +1,408 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+using System.Security.Cryptography;
+using System.Text;
+
+namespace AssetStudio
+{
+    //Lets repeated exports skip models whose IImported content and export options have not changed.
+    //The hash of both is kept in a manifest next to the output, with the length and SHA-256 of every file the export left there.
+    public static class ExportCache
+    {
+        //Changes whenever the exporter writes something different for the same input, so older manifests stop matching
+        private const int FormatVersion = 3;
+        public const string ManifestExtension = ".manifest";
+
+        //SHA-256 over imported in list and hierarchy order, floats by their bits, followed by every option
+        public static string ComputeHash(IImported imported, params object[] options)
+        {
+            using (var sha = SHA256.Create())
+            {
+                using (var stream = new CryptoStream(Stream.Null, sha, CryptoStreamMode.Write))
+                {
+                    var writer = new HashWriter(stream);
+                    writer.Write(FormatVersion);
+                    writer.Write(options.Length);
+                    foreach (var option in options)
+                    {
+                        writer.WriteOption(option);
+                    }
+                    writer.WriteImported(imported);
+                    writer.Flush();
+                    stream.FlushFinalBlock();
+                    return ToHex(sha.Hash);
+                }
+            }
+        }
+
+        //True when the manifest of path records hash and every file it lists still has its recorded length and SHA-256
+        public static bool IsUpToDate(string path, string hash)
+        {
+            var manifestPath = path + ManifestExtension;
+            if (!File.Exists(manifestPath))
+            {
+                return false;
+            }
+            var directory = Path.GetDirectoryName(Path.GetFullPath(path));
+            var lines = File.ReadAllLines(manifestPath);
+            if (lines.Length < 2 || lines[0] != "hash " + hash)
+            {
+                return false;
+            }
+            for (int i = 1; i < lines.Length; i++)
+            {
+                //file <length> <sha256> <name>, the name may contain spaces
+                var parts = lines[i].Split(new[] { ' ' }, 4);
+                long length;
+                if (parts.Length != 4 || parts[0] != "file" || !long.TryParse(parts[1], NumberStyles.None, CultureInfo.InvariantCulture, out length))
+                {
+                    return false;
+                }
+                var file = new FileInfo(Path.Combine(directory, parts[3]));
+                if (!file.Exists || file.Length != length || FileHash(file) != parts[2])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        //Removes the manifest before an export, so an export that fails halfway is never taken as up to date
+        public static void Invalidate(string path)
+        {
+            File.Delete(path + ManifestExtension);
+        }
+
+        //Records hash with path and the texture files the export wrote or found unchanged, ExportStatistics.TextureFiles
+        public static void WriteManifest(string path, string hash, IEnumerable<string> textureFiles)
+        {
+            var output = new FileInfo(path);
+            var lines = new List<string> { "hash " + hash, FileLine(output, output.DirectoryName) };
+            var names = new HashSet<string>(StringComparer.OrdinalIgnoreCase) { output.FullName };
+            if (textureFiles != null)
+            {
+                foreach (var textureFile in textureFiles)
+                {
+                    var file = new FileInfo(textureFile);
+                    if (file.Exists && names.Add(file.FullName))
+                    {
+                        lines.Add(FileLine(file, output.DirectoryName));
+                    }
+                }
+            }
+            var manifestPath = path + ManifestExtension;
+            var temporaryPath = manifestPath + ".tmp";
+            File.WriteAllLines(temporaryPath, lines.ToArray());
+            File.Delete(manifestPath);
+            File.Move(temporaryPath, manifestPath);
+        }
+
+        //Files in directory are recorded by name, so the output folder can be moved with its manifest
+        private static string FileLine(FileInfo file, string directory)
+        {
+            var name = string.Equals(file.DirectoryName, directory, StringComparison.OrdinalIgnoreCase) ? file.Name : file.FullName;
+            return "file " + file.Length.ToString(CultureInfo.InvariantCulture) + " " + FileHash(file) + " " + name;
+        }
+
+        private static string FileHash(FileInfo file)
+        {
+            using (var sha = SHA256.Create())
+            {
+                using (var stream = file.OpenRead())
+                {
+                    return ToHex(sha.ComputeHash(stream));
+                }
+            }
+        }
+
+        private static string ToHex(byte[] bytes)
+        {
+            var sb = new StringBuilder(bytes.Length * 2);
+            foreach (var b in bytes)
+            {
+                sb.Append(b.ToString("x2"));
+            }
+            return sb.ToString();
+        }
+
+        private class HashWriter : BinaryWriter
+        {
+            private byte[] buffer = new byte[64 * 1024];
+
+            public HashWriter(Stream output) : base(output, Encoding.UTF8) { }
+
+            public void WriteOption(object option)
+            {
+                if (option == null)
+                {
+                    Write((byte)0);
+                }
+                else if (option is bool)
+                {
+                    Write((byte)1);
+                    Write((bool)option);
+                }
+                else if (option is int)
+                {
+                    Write((byte)2);
+                    Write((int)option);
+                }
+                else if (option is long)
+                {
+                    Write((byte)3);
+                    Write((long)option);
+                }
+                else if (option is float)
+                {
+                    Write((byte)4);
+                    Write((float)option);
+                }
+                else if (option is string)
+                {
+                    Write((byte)5);
+                    Write((string)option);
+                }
+                else
+                {
+                    throw new ArgumentException($"Unsupported export option type {option.GetType()}");
+                }
+            }
+
+            public void WriteImported(IImported imported)
+            {
+                WriteFrame(imported.RootFrame);
+                WriteList(imported.MeshList, WriteMesh);
+                WriteList(imported.MaterialList, WriteMaterial);
+                WriteList(imported.TextureList, WriteTexture);
+                WriteList(imported.AnimationList, WriteAnimation);
+                WriteList(imported.MorphList, WriteMorph);
+            }
+
+            private void WriteList<T>(List<T> list, Action<T> write)
+            {
+                if (list == null)
+                {
+                    Write(-1);
+                    return;
+                }
+                Write(list.Count);
+                foreach (var item in list)
+                {
+                    write(item);
+                }
+            }
+
+            private void WriteString(string value)
+            {
+                Write(value != null);
+                if (value != null)
+                {
+                    Write(value);
+                }
+            }
+
+            private void WriteArray(float[] values)
+            {
+                if (values == null)
+                {
+                    Write(-1);
+                    return;
+                }
+                Write(values.Length);
+                WriteBlock(values, values.Length * sizeof(float));
+            }
+
+            private void WriteArray(int[] values)
+            {
+                if (values == null)
+                {
+                    Write(-1);
+                    return;
+                }
+                Write(values.Length);
+                WriteBlock(values, values.Length * sizeof(int));
+            }
+
+            private void WriteArray(byte[] values)
+            {
+                if (values == null)
+                {
+                    Write(-1);
+                    return;
+                }
+                Write(values.Length);
+                Write(values);
+            }
+
+            private void WriteBlock(Array values, int byteCount)
+            {
+                for (int offset = 0; offset < byteCount; offset += buffer.Length)
+                {
+                    int count = Math.Min(buffer.Length, byteCount - offset);
+                    Buffer.BlockCopy(values, offset, buffer, 0, count);
+                    Write(buffer, 0, count);
+                }
+            }
+
+            private void Write(Vector2 v)
+            {
+                Write(v.X);
+                Write(v.Y);
+            }
+
+            private void Write(Vector3 v)
+            {
+                Write(v.X);
+                Write(v.Y);
+                Write(v.Z);
+            }
+
+            private void Write(Vector4 v)
+            {
+                Write(v.X);
+                Write(v.Y);
+                Write(v.Z);
+                Write(v.W);
+            }
+
+            private void Write(Color c)
+            {
+                Write(c.R);
+                Write(c.G);
+                Write(c.B);
+                Write(c.A);
+            }
+
+            private void WriteFrame(ImportedFrame frame)
+            {
+                Write(frame != null);
+                if (frame == null)
+                {
+                    return;
+                }
+                WriteString(frame.Name);
+                Write(frame.LocalRotation);
+                Write(frame.LocalPosition);
+                Write(frame.LocalScale);
+                Write(frame.Count);
+                for (int i = 0; i < frame.Count; i++)
+                {
+                    WriteFrame(frame[i]);
+                }
+            }
+
+            private void WriteMesh(ImportedMesh mesh)
+            {
+                WriteString(mesh.Path);
+                WriteList(mesh.SubmeshList, WriteSubmesh);
+                WriteList(mesh.BoneList, bone =>
+                {
+                    WriteString(bone.Path);
+                    for (int i = 0; i < 16; i++)
+                    {
+                        Write(bone.Matrix[i]);
+                    }
+                });
+            }
+
+            private void WriteSubmesh(ImportedSubmesh submesh)
+            {
+                //VertexList and FaceList are derived from the packed streams and Indices when those are set, reading them would only build them
+                WriteList(submesh.Positions == null ? submesh.VertexList : null, WriteVertex);
+                WriteList(submesh.Indices == null ? submesh.FaceList : null, face => WriteArray(face.VertexIndices));
+                WriteArray(submesh.Indices);
+                WriteString(submesh.Material);
+                WriteArray(submesh.Positions);
+                WriteArray(submesh.Normals);
+                WriteArray(submesh.UV0);
+                WriteArray(submesh.Tangents);
+                WriteArray(submesh.Colours);
+                WriteArray(submesh.Weights);
+                WriteArray(submesh.BoneIndices);
+            }
+
+            private void WriteVertex(ImportedVertex vertex)
+            {
+                Write(vertex.Position);
+                WriteArray(vertex.Weights);
+                WriteArray(vertex.BoneIndices);
+                Write(vertex.Normal);
+                WriteArray(vertex.UV);
+                Write(vertex.Tangent);
+                var colour = vertex as ImportedVertexWithColour;
+                Write(colour != null);
+                if (colour != null)
+                {
+                    Write(colour.Colour);
+                }
+            }
+
+            private void WriteMaterial(ImportedMaterial material)
+            {
+                WriteString(material.Name);
+                Write(material.Diffuse);
+                Write(material.Ambient);
+                Write(material.Specular);
+                Write(material.Emissive);
+                Write(material.Reflection);
+                Write(material.Shininess);
+                Write(material.Transparency);
+                WriteList(material.Textures, texture =>
+                {
+                    WriteString(texture.Name);
+                    Write(texture.Dest);
+                    Write(texture.Offset);
+                    Write(texture.Scale);
+                });
+            }
+
+            private void WriteTexture(ImportedTexture texture)
+            {
+                WriteString(texture.Name);
+                WriteArray(texture.Data);
+            }
+
+            private void WriteAnimation(ImportedKeyframedAnimation animation)
+            {
+                WriteString(animation.Name);
+                WriteList(animation.TrackList, track =>
+                {
+                    WriteString(track.Path);
+                    WriteList(track.Scalings, WriteKeyframe);
+                    WriteList(track.Rotations, WriteKeyframe);
+                    WriteList(track.Translations, WriteKeyframe);
+                });
+            }
+
+            private void WriteKeyframe(ImportedKeyframe<Vector3> keyframe)
+            {
+                Write(keyframe.time);
+                Write(keyframe.value);
+                Write(keyframe.inSlope);
+                Write(keyframe.outSlope);
+            }
+
+            private void WriteMorph(ImportedMorph morph)
+            {
+                WriteString(morph.Path);
+                WriteString(morph.ClipName);
+                WriteList(morph.Channels, channel =>
+                {
+                    Write(channel.Item1);
+                    Write(channel.Item2);
+                    Write(channel.Item3);
+                });
+                WriteList(morph.KeyframeList, keyframe =>
+                {
+                    WriteString(keyframe.Name);
+                    WriteList(keyframe.VertexList, WriteVertex);
+                    WriteList(keyframe.MorphedVertexIndices, Write);
+                    Write(keyframe.Weight);
+                });
+                WriteList(morph.MorphedVertexIndices, Write);
+            }
+        }
+    }
+}
@@ -21,6 +21,9 @@ namespace AssetStudio
         private Dictionary<uint, string> bonePathHash = new Dictionary<uint, string>();
         private Dictionary<Texture2D, string> textureNameDictionary = new Dictionary<Texture2D, string>();
         private Dictionary<Transform, ImportedFrame> transformDictionary = new Dictionary<Transform, ImportedFrame>();
+        //rotation keys waiting for their batch quaternion to euler conversion
+        private List<ImportedKeyframe<Vector3>> pendingRotationKeys = new List<ImportedKeyframe<Vector3>>();
+        private List<Quaternion> pendingRotations = new List<Quaternion>();
 
         public ModelConverter(GameObject m_GameObject)
         {
@@ -277,18 +280,28 @@ namespace AssetStudio
                 }
                 ImportedMaterial iMat = ConvertMaterial(mat);
                 iSubmesh.Material = iMat.Name;
-                iSubmesh.VertexList = new List<ImportedVertex>((int)submesh.vertexCount);
                 var vertexColours = mesh.m_Colors != null && (mesh.m_Colors.Length == mesh.m_VertexCount * 3 || mesh.m_Colors.Length == mesh.m_VertexCount * 4);
+                var hasUV = (mesh.m_UV0 != null && mesh.m_UV0.Length == mesh.m_VertexCount * 2) || (mesh.m_UV1 != null && mesh.m_UV1.Length == mesh.m_VertexCount * 2);
+                var skinned = mesh.m_Skin?.Length > 0;
+                iSubmesh.Positions = new float[submesh.vertexCount * 3];
+                iSubmesh.Normals = new float[submesh.vertexCount * 3];
+                iSubmesh.UV0 = hasUV ? new float[submesh.vertexCount * 2] : null;
+                iSubmesh.Tangents = new float[submesh.vertexCount * 4];
+                iSubmesh.Colours = vertexColours ? new float[submesh.vertexCount * 4] : null;
+                iSubmesh.Weights = skinned ? new float[submesh.vertexCount * 4] : null;
+                iSubmesh.BoneIndices = skinned ? new int[submesh.vertexCount * 4] : null;
                 for (var j = mesh.m_SubMeshes[i].firstVertex; j < mesh.m_SubMeshes[i].firstVertex + mesh.m_SubMeshes[i].vertexCount; j++)
                 {
-                    var iVertex = vertexColours ? new ImportedVertexWithColour() : new ImportedVertex();
+                    var v = (int)(j - mesh.m_SubMeshes[i].firstVertex);
                     //Vertices
                     int c = 3;
                     if (mesh.m_Vertices.Length == mesh.m_VertexCount * 4)
                     {
                         c = 4;
                     }
-                    iVertex.Position = new Vector3(-mesh.m_Vertices[j * c], mesh.m_Vertices[j * c + 1], mesh.m_Vertices[j * c + 2]);
+                    iSubmesh.Positions[v * 3] = -mesh.m_Vertices[j * c];
+                    iSubmesh.Positions[v * 3 + 1] = mesh.m_Vertices[j * c + 1];
+                    iSubmesh.Positions[v * 3 + 2] = mesh.m_Vertices[j * c + 2];
                     //Normals
                     if (mesh.m_Normals?.Length > 0)
                     {
@@ -300,59 +313,61 @@ namespace AssetStudio
                         {
                             c = 4;
                         }
-                        iVertex.Normal = new Vector3(-mesh.m_Normals[j * c], mesh.m_Normals[j * c + 1], mesh.m_Normals[j * c + 2]);
+                        iSubmesh.Normals[v * 3] = -mesh.m_Normals[j * c];
+                        iSubmesh.Normals[v * 3 + 1] = mesh.m_Normals[j * c + 1];
+                        iSubmesh.Normals[v * 3 + 2] = mesh.m_Normals[j * c + 2];
                     }
                     //Colors
                     if (vertexColours)
                     {
                         if (mesh.m_Colors.Length == mesh.m_VertexCount * 3)
                         {
-                            ((ImportedVertexWithColour)iVertex).Colour = new Color(mesh.m_Colors[j * 3], mesh.m_Colors[j * 3 + 1], mesh.m_Colors[j * 3 + 2], 1.0f);
+                            iSubmesh.Colours[v * 4] = mesh.m_Colors[j * 3];
+                            iSubmesh.Colours[v * 4 + 1] = mesh.m_Colors[j * 3 + 1];
+                            iSubmesh.Colours[v * 4 + 2] = mesh.m_Colors[j * 3 + 2];
+                            iSubmesh.Colours[v * 4 + 3] = 1.0f;
                         }
                         else
                         {
-                            ((ImportedVertexWithColour)iVertex).Colour = new Color(mesh.m_Colors[j * 4], mesh.m_Colors[j * 4 + 1], mesh.m_Colors[j * 4 + 2], mesh.m_Colors[j * 4 + 3]);
+                            Array.Copy(mesh.m_Colors, j * 4, iSubmesh.Colours, v * 4, 4);
                         }
                     }
                     //UV
                     if (mesh.m_UV0 != null && mesh.m_UV0.Length == mesh.m_VertexCount * 2)
                     {
-                        iVertex.UV = new[] { mesh.m_UV0[j * 2], mesh.m_UV0[j * 2 + 1] };
+                        Array.Copy(mesh.m_UV0, j * 2, iSubmesh.UV0, v * 2, 2);
                     }
                     else if (mesh.m_UV1 != null && mesh.m_UV1.Length == mesh.m_VertexCount * 2)
                     {
-                        iVertex.UV = new[] { mesh.m_UV1[j * 2], mesh.m_UV1[j * 2 + 1] };
+                        Array.Copy(mesh.m_UV1, j * 2, iSubmesh.UV0, v * 2, 2);
                     }
                     //Tangent
                     if (mesh.m_Tangents != null && mesh.m_Tangents.Length == mesh.m_VertexCount * 4)
                     {
-                        iVertex.Tangent = new Vector4(-mesh.m_Tangents[j * 4], mesh.m_Tangents[j * 4 + 1], mesh.m_Tangents[j * 4 + 2], -mesh.m_Tangents[j * 4 + 3]);
+                        iSubmesh.Tangents[v * 4] = -mesh.m_Tangents[j * 4];
+                        iSubmesh.Tangents[v * 4 + 1] = mesh.m_Tangents[j * 4 + 1];
+                        iSubmesh.Tangents[v * 4 + 2] = mesh.m_Tangents[j * 4 + 2];
+                        iSubmesh.Tangents[v * 4 + 3] = -mesh.m_Tangents[j * 4 + 3];
                     }
                     //BoneInfluence
-                    if (mesh.m_Skin?.Length > 0)
+                    if (skinned)
                     {
                         var inf = mesh.m_Skin[j];
-                        iVertex.BoneIndices = new int[4];
-                        iVertex.Weights = new float[4];
                         for (var k = 0; k < 4; k++)
                         {
-                            iVertex.BoneIndices[k] = inf.boneIndex[k];
-                            iVertex.Weights[k] = inf.weight[k];
+                            iSubmesh.BoneIndices[v * 4 + k] = inf.boneIndex[k];
+                            iSubmesh.Weights[v * 4 + k] = inf.weight[k];
                         }
                     }
-                    iSubmesh.VertexList.Add(iVertex);
                 }
                 //Face
-                iSubmesh.FaceList = new List<ImportedFace>(numFaces);
+                iSubmesh.Indices = new int[numFaces * 3];
                 var end = firstFace + numFaces;
-                for (int f = firstFace; f < end; f++)
+                for (int f = firstFace, k = 0; f < end; f++, k += 3)
                 {
-                    var face = new ImportedFace();
-                    face.VertexIndices = new int[3];
-                    face.VertexIndices[0] = (int)(mesh.m_Indices[f * 3 + 2] - submesh.firstVertex);
-                    face.VertexIndices[1] = (int)(mesh.m_Indices[f * 3 + 1] - submesh.firstVertex);
-                    face.VertexIndices[2] = (int)(mesh.m_Indices[f * 3] - submesh.firstVertex);
-                    iSubmesh.FaceList.Add(face);
+                    iSubmesh.Indices[k] = (int)(mesh.m_Indices[f * 3 + 2] - submesh.firstVertex);
+                    iSubmesh.Indices[k + 1] = (int)(mesh.m_Indices[f * 3 + 1] - submesh.firstVertex);
+                    iSubmesh.Indices[k + 2] = (int)(mesh.m_Indices[f * 3] - submesh.firstVertex);
                 }
                 firstFace = end;
                 iMesh.SubmeshList.Add(iSubmesh);
@@ -427,17 +442,17 @@ namespace AssetStudio
                                 keyframe.Name = BlendShapeNameExtension(mesh, i) + "_" + frameIdx;
                                 int shapeIdx = mesh.m_Shapes.channels[i].frameIndex + frameIdx;
                                 keyframe.VertexList = new List<ImportedVertex>((int)mesh.m_Shapes.shapes[shapeIdx].vertexCount);
-                                keyframe.MorphedVertexIndices = new List<ushort>((int)mesh.m_Shapes.shapes[shapeIdx].vertexCount);
+                                keyframe.MorphedVertexIndices = new List<int>((int)mesh.m_Shapes.shapes[shapeIdx].vertexCount);
                                 keyframe.Weight = shapeIdx < mesh.m_Shapes.fullWeights.Length ? mesh.m_Shapes.fullWeights[shapeIdx] : 100f;
                                 int lastVertIndex = (int)(mesh.m_Shapes.shapes[shapeIdx].firstVertex + mesh.m_Shapes.shapes[shapeIdx].vertexCount);
                                 for (int j = (int)mesh.m_Shapes.shapes[shapeIdx].firstVertex; j < lastVertIndex; j++)
                                 {
                                     var morphVert = mesh.m_Shapes.vertices[j];
-                                    ImportedVertex vert = GetSourceVertex(iMesh.SubmeshList, (int)morphVert.index);
+                                    Vector3 sourcePos = GetSourcePosition(iMesh.SubmeshList, (int)morphVert.index);
                                     ImportedVertex destVert = new ImportedVertex();
                                     Vector3 morphPos = morphVert.vertex;
                                     morphPos.X *= -1;
-                                    destVert.Position = vert.Position + morphPos;
+                                    destVert.Position = sourcePos + morphPos;
                                     Vector3 morphNormal = morphVert.normal;
                                     morphNormal.X *= -1;
                                     destVert.Normal = morphNormal;
@@ -445,7 +460,7 @@ namespace AssetStudio
                                     morphTangent.X *= -1;
                                     destVert.Tangent = morphTangent;
                                     keyframe.VertexList.Add(destVert);
-                                    keyframe.MorphedVertexIndices.Add((ushort)morphVert.index);
+                                    keyframe.MorphedVertexIndices.Add((int)morphVert.index);
                                 }
 
                                 morph.KeyframeList.Add(keyframe);
@@ -696,12 +711,18 @@ namespace AssetStudio
                             times[i] = t * 0.01f;
                         }
                         var quats = m_CompressedRotationCurve.m_Values.UnpackQuats();
-
+                        var converted = new Quaternion[numKeys];
                         for (int i = 0; i < numKeys; i++)
                         {
                             var quat = quats[i];
-                            var value = Fbx.QuaternionToEuler(new Quaternion(quat.X, -quat.Y, -quat.Z, quat.W));
-                            track.Rotations.Add(new ImportedKeyframe<Vector3>(times[i], value));
+                            converted[i] = new Quaternion(quat.X, -quat.Y, -quat.Z, quat.W);
+                        }
+                        var values = new Vector3[numKeys];
+                        Fbx.QuaternionToEuler(converted, values, numKeys);
+
+                        for (int i = 0; i < numKeys; i++)
+                        {
+                            track.Rotations.Add(new ImportedKeyframe<Vector3>(times[i], values[i]));
                         }
                     }
                     foreach (var m_RotationCurve in animationClip.m_RotationCurves)
@@ -709,8 +730,10 @@ namespace AssetStudio
                         var track = iAnim.FindTrack(m_RotationCurve.path);
                         foreach (var m_Curve in m_RotationCurve.curve.m_Curve)
                         {
-                            var value = Fbx.QuaternionToEuler(new Quaternion(m_Curve.value.X, -m_Curve.value.Y, -m_Curve.value.Z, m_Curve.value.W));
-                            track.Rotations.Add(new ImportedKeyframe<Vector3>(m_Curve.time, value));
+                            var keyframe = new ImportedKeyframe<Vector3>(m_Curve.time, Vector3.Zero);
+                            track.Rotations.Add(keyframe);
+                            pendingRotationKeys.Add(keyframe);
+                            pendingRotations.Add(new Quaternion(m_Curve.value.X, -m_Curve.value.Y, -m_Curve.value.Z, m_Curve.value.W));
                         }
                     }
                     foreach (var m_PositionCurve in animationClip.m_PositionCurves)
@@ -791,7 +814,25 @@ namespace AssetStudio
                         }
                     }
                 }
+                ConvertPendingRotations();
+            }
+        }
+
+        private void ConvertPendingRotations()
+        {
+            var count = pendingRotations.Count;
+            if (count == 0)
+            {
+                return;
             }
+            var values = new Vector3[count];
+            Fbx.QuaternionToEuler(pendingRotations.ToArray(), values, count);
+            for (int i = 0; i < count; i++)
+            {
+                pendingRotationKeys[i].value = values[i];
+            }
+            pendingRotationKeys.Clear();
+            pendingRotations.Clear();
         }
 
         private void ReadCurveData(ImportedKeyframedAnimation iAnim, AnimationClipBindingConstant m_ClipBindingConstant, int index, float time, float[] data, int offset, ref int curveIndex)
@@ -816,14 +857,16 @@ namespace AssetStudio
                     )));
                     break;
                 case 2:
-                    var value = Fbx.QuaternionToEuler(new Quaternion
+                    var keyframe = new ImportedKeyframe<Vector3>(time, Vector3.Zero);
+                    track.Rotations.Add(keyframe);
+                    pendingRotationKeys.Add(keyframe);
+                    pendingRotations.Add(new Quaternion
                     (
                         data[curveIndex++ + offset],
                         -data[curveIndex++ + offset],
                         -data[curveIndex++ + offset],
                         data[curveIndex++ + offset]
                     ));
-                    track.Rotations.Add(new ImportedKeyframe<Vector3>(time, value));
                     break;
                 case 3:
                     track.Scalings.Add(new ImportedKeyframe<Vector3>(time, new Vector3
@@ -884,18 +927,19 @@ namespace AssetStudio
             return name;
         }
 
-        private static ImportedVertex GetSourceVertex(List<ImportedSubmesh> submeshList, int morphVertIndex)
+        private static Vector3 GetSourcePosition(List<ImportedSubmesh> submeshList, int morphVertIndex)
         {
             foreach (var submesh in submeshList)
             {
-                var vertList = submesh.VertexList;
-                if (morphVertIndex < vertList.Count)
+                var positions = submesh.Positions;
+                var vertexCount = positions.Length / 3;
+                if (morphVertIndex < vertexCount)
                 {
-                    return vertList[morphVertIndex];
+                    return new Vector3(positions[morphVertIndex * 3], positions[morphVertIndex * 3 + 1], positions[morphVertIndex * 3 + 2]);
                 }
-                morphVertIndex -= vertList.Count;
+                morphVertIndex -= vertexCount;
             }
-            return null;
+            throw new IndexOutOfRangeException();
         }
 
         private void CreateBonePathHash(Transform m_Transform)
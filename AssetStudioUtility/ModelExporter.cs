@@ -1,10 +1,101 @@
-﻿namespace AssetStudio
+﻿using System;
+using System.Collections.Generic;
+using System.Threading.Tasks;
+
+namespace AssetStudio
 {
     public static class ModelExporter
     {
         public static void ExportFbx(string path, IImported imported, bool eulerFilter, float filterPrecision, bool allFrames, bool allBones, bool skins, float boneSize, float scaleFactor, bool flatInbetween, int versionIndex, bool isAscii)
         {
-            Fbx.Exporter.Export(path, imported, eulerFilter, filterPrecision, allFrames, allBones, skins, boneSize, scaleFactor, flatInbetween, versionIndex, isAscii);
+            var options = new FbxExportOptions
+            {
+                EulerFilter = eulerFilter,
+                FilterPrecision = filterPrecision,
+                AllFrames = allFrames,
+                AllBones = allBones,
+                Skins = skins,
+                BoneSize = boneSize,
+                ScaleFactor = scaleFactor,
+                FlatInbetween = flatInbetween,
+                VersionIndex = versionIndex,
+                IsAscii = isAscii
+            };
+            ExportFbx(path, imported, options);
+        }
+
+        //A memory budget releases the mesh, texture and morph data of imported once it is exported, imported cannot be exported again afterwards.
+        //ExportStatistics.PeakWorkingSet reports how close the export came, AcmrBefore and AcmrAfter the effect of OptimizeMeshes.
+        public static ExportStatistics ExportFbx(string path, IImported imported, FbxExportOptions options)
+        {
+            return Fbx.Exporter.Export(path, imported, options);
+        }
+
+        //Exports through a long-lived session that keeps the SDK manager warm, for many small models in a row on one thread
+        public static ExportStatistics ExportFbx(Fbx.Session session, string path, IImported imported, FbxExportOptions options)
+        {
+            return session.Export(path, imported, options);
+        }
+
+        //Exports only when the content of imported or an option differs from the manifest the last export left next to path,
+        //or a file listed there is gone or changed. Returns null when the export was skipped. Call before imported is exported elsewhere,
+        //a memory-budgeted export releases the data the hash is computed from. The SDK stamps every file with its creation time,
+        //use ExportFbxBinaryIncremental where the output has to be byte-identical between runs.
+        public static ExportStatistics ExportFbxIncremental(string path, IImported imported, FbxExportOptions options)
+        {
+            var hash = ExportCache.ComputeHash(imported, "fbx", options.EulerFilter, options.FilterPrecision, options.PositionTolerance, options.RotationTolerance, options.ScaleTolerance, options.AllFrames, options.AllBones, options.Skins, options.BoneSize, options.ScaleFactor, options.FlatInbetween, options.VersionIndex, options.IsAscii, options.OptimizeMeshes, options.WeldTolerance);
+            if (ExportCache.IsUpToDate(path, hash))
+                return null;
+            ExportCache.Invalidate(path);
+            var statistics = ExportFbx(path, imported, options);
+            ExportCache.WriteManifest(path, hash, statistics.TextureFiles);
+            return statistics;
+        }
+
+        //With a memory budget the binary writer releases the meshes and morphs of imported once copied, so imported cannot be exported again,
+        //and over the budget it also moves finished geometry to a temporary file until the FBX is written.
+        public static ExportStatistics ExportFbxBinary(string path, IImported imported, FbxExportOptions options)
+        {
+            return Fbx.Exporter.ExportBinary(path, imported, options);
+        }
+
+        //The binary writer output is byte-identical for the same input, so a skipped export leaves exactly the file a new one would write
+        public static ExportStatistics ExportFbxBinaryIncremental(string path, IImported imported, FbxExportOptions options)
+        {
+            var hash = ExportCache.ComputeHash(imported, "fbx-binary", options.EulerFilter, options.FilterPrecision, options.PositionTolerance, options.RotationTolerance, options.ScaleTolerance, options.AllFrames, options.AllBones, options.Skins, options.BoneSize, options.ScaleFactor, options.FlatInbetween, options.VersionIndex);
+            if (ExportCache.IsUpToDate(path, hash))
+                return null;
+            ExportCache.Invalidate(path);
+            var statistics = ExportFbxBinary(path, imported, options);
+            ExportCache.WriteManifest(path, hash, statistics.TextureFiles);
+            return statistics;
+        }
+
+        //Binary glTF from the same scene as ExportFbxBinary, textures are written next to the .glb.
+        //A memory budget releases the data of imported like it does for ExportFbxBinary.
+        public static ExportStatistics ExportGlb(string path, IImported imported, FbxExportOptions options)
+        {
+            return Gltf.Exporter.Export(path, imported, options);
+        }
+
+        //Scene snapshot for the AssetStudioFBXBatch command-line driver, which picks the format and optimisation per job
+        public static ExportStatistics ExportSnapshot(string path, IImported imported, FbxExportOptions options)
+        {
+            return Fbx.Exporter.ExportSnapshot(path, imported, options);
+        }
+
+        //Every job gets the same options, leave TracePath null as the jobs would overwrite each other's trace
+        public static void ExportFbx(IList<string> paths, IList<IImported> importedList, FbxExportOptions options, int maxDegreeOfParallelism = -1)
+        {
+            if (paths.Count != importedList.Count)
+                throw new ArgumentException("Each export path needs exactly one imported model.");
+            //Every worker keeps one session, so its FbxManager and FbxScene are created once, and only writes below its own absolute path
+            var parallelOptions = new ParallelOptions { MaxDegreeOfParallelism = maxDegreeOfParallelism > 0 ? maxDegreeOfParallelism : Environment.ProcessorCount };
+            Parallel.For(0, paths.Count, parallelOptions, () => new Fbx.Session(), (i, state, session) =>
+            {
+                session.Export(paths[i], importedList[i], options);
+                return session;
+            }, session => session.Dispose());
         }
     }
 }